@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+
+#define LOG_TAG "CamComm-MDDelta"
+#include <log/log.h>
+
+#include <string.h>
+
+#include "CameraMetadataDelta.h"
+
+namespace android {
+namespace hardware {
+namespace camera {
+namespace common {
+namespace helper {
+
+namespace {
+
+constexpr uint32_t kPacketMagic = 0x4c444d43;  // "CMDL"
+constexpr uint8_t kPacketVersion = 1;
+
+enum PacketType : uint8_t {
+    KEYFRAME = 0,
+    DELTA = 1,
+};
+
+enum EntryOp : uint8_t {
+    ENTRY_UPDATE = 0,
+    ENTRY_ERASE = 1,
+};
+
+struct PacketHeader {
+    uint32_t magic;
+    uint8_t type;
+    uint8_t version;
+    uint16_t reserved;
+    uint32_t sequence;
+    uint32_t entryCount;  // DELTA only
+};
+static_assert(sizeof(PacketHeader) == 16, "PacketHeader must be packed");
+
+struct EntryHeader {
+    uint32_t tag;
+    uint8_t op;
+    uint8_t type;
+    uint16_t reserved;
+    uint32_t count;
+};
+static_assert(sizeof(EntryHeader) == 12, "EntryHeader must be packed");
+
+bool entriesEqual(const camera_metadata_ro_entry& a, const camera_metadata_ro_entry& b) {
+    return a.type == b.type && a.count == b.count &&
+           memcmp(a.data.u8, b.data.u8, a.count * camera_metadata_type_size[a.type]) == 0;
+}
+
+void appendEntry(EntryOp op, const camera_metadata_ro_entry& entry, std::vector<uint8_t>* out) {
+    size_t dataSize =
+            (op == ENTRY_UPDATE) ? entry.count * camera_metadata_type_size[entry.type] : 0;
+    EntryHeader header = {
+            .tag = entry.tag,
+            .op = op,
+            .type = entry.type,
+            .reserved = 0,
+            .count = (op == ENTRY_UPDATE) ? static_cast<uint32_t>(entry.count) : 0,
+    };
+    size_t offset = out->size();
+    out->resize(offset + sizeof(header) + dataSize);
+    memcpy(out->data() + offset, &header, sizeof(header));
+    if (dataSize > 0) {
+        memcpy(out->data() + offset + sizeof(header), entry.data.u8, dataSize);
+    }
+}
+
+}  // anonymous namespace
+
+MetadataDeltaEncoder::MetadataDeltaEncoder(uint32_t keyframeInterval)
+    : mKeyframeInterval(keyframeInterval) {}
+
+void MetadataDeltaEncoder::requestKeyframe() {
+    mKeyframeRequested = true;
+}
+
+status_t MetadataDeltaEncoder::encodeKeyframe(const camera_metadata_t* metadata,
+                                              std::vector<uint8_t>* out) {
+    size_t metadataSize = get_camera_metadata_compact_size(metadata);
+    out->resize(sizeof(PacketHeader) + metadataSize);
+    // The payload offset keeps camera_metadata_t aligned as long as out->data() is
+    if (copy_camera_metadata(out->data() + sizeof(PacketHeader), metadataSize, metadata) ==
+        nullptr) {
+        ALOGE("%s: failed to copy %zu bytes of metadata", __FUNCTION__, metadataSize);
+        out->clear();
+        return NO_MEMORY;
+    }
+
+    PacketHeader header = {
+            .magic = kPacketMagic,
+            .type = KEYFRAME,
+            .version = kPacketVersion,
+            .reserved = 0,
+            .sequence = mSequence,
+            .entryCount = 0,
+    };
+    memcpy(out->data(), &header, sizeof(header));
+
+    mPrevious = metadata;
+    mPrevious.sort();
+    mFramesSinceKeyframe = 0;
+    mKeyframeRequested = false;
+    return OK;
+}
+
+status_t MetadataDeltaEncoder::encode(const camera_metadata_t* metadata,
+                                      std::vector<uint8_t>* out) {
+    if (metadata == nullptr || out == nullptr) {
+        return BAD_VALUE;
+    }
+
+    mSequence++;
+    if (mKeyframeRequested || mPrevious.isEmpty() ||
+        mFramesSinceKeyframe + 1 >= mKeyframeInterval) {
+        return encodeKeyframe(metadata, out);
+    }
+
+    CameraMetadata current;
+    current = metadata;
+    current.sort();
+
+    out->resize(sizeof(PacketHeader));
+    uint32_t entryCount = 0;
+    const camera_metadata_t* cur = current.getAndLock();
+    const camera_metadata_t* prev = mPrevious.getAndLock();
+
+    // Added or changed entries
+    size_t count = get_camera_metadata_entry_count(cur);
+    for (size_t i = 0; i < count; i++) {
+        camera_metadata_ro_entry entry, prevEntry;
+        get_camera_metadata_ro_entry(cur, i, &entry);
+        if (find_camera_metadata_ro_entry(prev, entry.tag, &prevEntry) != OK ||
+            !entriesEqual(entry, prevEntry)) {
+            appendEntry(ENTRY_UPDATE, entry, out);
+            entryCount++;
+        }
+    }
+
+    // Removed entries
+    count = get_camera_metadata_entry_count(prev);
+    for (size_t i = 0; i < count; i++) {
+        camera_metadata_ro_entry prevEntry, entry;
+        get_camera_metadata_ro_entry(prev, i, &prevEntry);
+        if (find_camera_metadata_ro_entry(cur, prevEntry.tag, &entry) != OK) {
+            appendEntry(ENTRY_ERASE, prevEntry, out);
+            entryCount++;
+        }
+    }
+
+    mPrevious.unlock(prev);
+    current.unlock(cur);
+
+    if (out->size() >= get_camera_metadata_compact_size(metadata)) {
+        // Nothing to gain over a full copy
+        return encodeKeyframe(metadata, out);
+    }
+
+    PacketHeader header = {
+            .magic = kPacketMagic,
+            .type = DELTA,
+            .version = kPacketVersion,
+            .reserved = 0,
+            .sequence = mSequence,
+            .entryCount = entryCount,
+    };
+    memcpy(out->data(), &header, sizeof(header));
+
+    mPrevious.swap(current);
+    mFramesSinceKeyframe++;
+    ALOGV("%s: delta #%u: %u entries, %zu bytes", __FUNCTION__, mSequence, entryCount,
+          out->size());
+    return OK;
+}
+
+void MetadataDeltaDecoder::reset() {
+    mSynced = false;
+    mSequence = 0;
+    mCurrent.clear();
+}
+
+status_t MetadataDeltaDecoder::decode(const uint8_t* data, size_t size, CameraMetadata* out) {
+    if (data == nullptr || out == nullptr || size < sizeof(uint32_t)) {
+        return BAD_VALUE;
+    }
+
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    const uint8_t* metadata = data;
+    size_t metadataSize = size;
+    if (magic == kPacketMagic) {
+        if (size < sizeof(PacketHeader)) {
+            ALOGE("%s: truncated packet (%zu bytes)", __FUNCTION__, size);
+            return BAD_VALUE;
+        }
+        PacketHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.version != kPacketVersion) {
+            ALOGE("%s: unsupported packet version %u", __FUNCTION__, header.version);
+            return BAD_VALUE;
+        }
+
+        if (header.type == DELTA) {
+            if (!mSynced || header.sequence != mSequence + 1) {
+                ALOGW("%s: delta #%u does not follow #%u, waiting for keyframe", __FUNCTION__,
+                      header.sequence, mSequence);
+                mSynced = false;
+                return INVALID_OPERATION;
+            }
+            status_t res = applyDelta(data + sizeof(header), size - sizeof(header),
+                                      header.entryCount);
+            if (res != OK) {
+                mSynced = false;
+                return res;
+            }
+            mSequence = header.sequence;
+            *out = mCurrent;
+            return OK;
+        } else if (header.type != KEYFRAME) {
+            ALOGE("%s: unknown packet type %u", __FUNCTION__, header.type);
+            return BAD_VALUE;
+        }
+        metadata = data + sizeof(header);
+        metadataSize = size - sizeof(header);
+        mSequence = header.sequence;
+        mSynced = true;
+    } else {
+        // Plain camera_metadata_t from a producer that does not encode deltas
+        mSynced = false;
+    }
+
+    // validate_camera_metadata_structure rejects unaligned buffers
+    std::vector<uint64_t> aligned;
+    if (reinterpret_cast<uintptr_t>(metadata) % alignof(uint64_t) != 0) {
+        aligned.resize((metadataSize + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        memcpy(aligned.data(), metadata, metadataSize);
+        metadata = reinterpret_cast<const uint8_t*>(aligned.data());
+    }
+    const camera_metadata_t* buffer = reinterpret_cast<const camera_metadata_t*>(metadata);
+    if (validate_camera_metadata_structure(buffer, &metadataSize) != OK) {
+        ALOGE("%s: invalid keyframe metadata", __FUNCTION__);
+        mSynced = false;
+        return BAD_VALUE;
+    }
+    mCurrent = buffer;
+    mCurrent.sort();
+    *out = mCurrent;
+    return OK;
+}
+
+status_t MetadataDeltaDecoder::applyDelta(const uint8_t* data, size_t size, uint32_t entryCount) {
+    size_t offset = 0;
+    for (uint32_t i = 0; i < entryCount; i++) {
+        EntryHeader header;
+        if (size - offset < sizeof(header)) {
+            ALOGE("%s: truncated entry header %u/%u", __FUNCTION__, i, entryCount);
+            return BAD_VALUE;
+        }
+        memcpy(&header, data + offset, sizeof(header));
+        offset += sizeof(header);
+
+        status_t res;
+        if (header.op == ENTRY_ERASE) {
+            res = mCurrent.erase(header.tag);
+        } else if (header.op == ENTRY_UPDATE && header.type < NUM_TYPES) {
+            size_t dataSize =
+                    static_cast<size_t>(header.count) * camera_metadata_type_size[header.type];
+            if (size - offset < dataSize) {
+                ALOGE("%s: truncated data for tag 0x%x", __FUNCTION__, header.tag);
+                return BAD_VALUE;
+            }
+            camera_metadata_ro_entry entry = {
+                    .index = 0,
+                    .tag = header.tag,
+                    .type = header.type,
+                    .count = header.count,
+            };
+            entry.data.u8 = data + offset;
+            res = mCurrent.update(entry);
+            offset += dataSize;
+        } else {
+            ALOGE("%s: bad entry op %u type %u", __FUNCTION__, header.op, header.type);
+            return BAD_VALUE;
+        }
+        if (res != OK) {
+            ALOGE("%s: failed to apply tag 0x%x: %d", __FUNCTION__, header.tag, res);
+            return res;
+        }
+    }
+    mCurrent.sort();
+    return OK;
+}
+
+}  // namespace helper
+}  // namespace common
+}  // namespace camera
+}  // namespace hardware
+}  // namespace android
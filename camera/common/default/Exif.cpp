@@ -23,6 +23,8 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdint.h>
+#include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -618,7 +620,7 @@ bool ExifUtilsImpl::setMeteringMode(uint16_t metering_mode) {
     return true;
 }
 
-bool ExifUtilsImpl::setOrientation(uint16_t orientation) {
+static uint16_t getExifOrientation(uint16_t orientation) {
     /*
      * Orientation value:
      *  1      2      3      4      5          6          7          8
@@ -643,7 +645,11 @@ bool ExifUtilsImpl::setOrientation(uint16_t orientation) {
         default:
             break;
     }
-    SET_SHORT(EXIF_IFD_0, EXIF_TAG_ORIENTATION, value);
+    return value;
+}
+
+bool ExifUtilsImpl::setOrientation(uint16_t orientation) {
+    SET_SHORT(EXIF_IFD_0, EXIF_TAG_ORIENTATION, getExifOrientation(orientation));
     return true;
 }
 
@@ -1034,6 +1040,452 @@ bool ExifUtilsImpl::setFromMetadata(const CameraMetadata& metadata, const size_t
     return true;
 }
 
+namespace {
+
+// exif_data_save_data() output starts with the Exif header, offsets in the IFDs are relative to
+// the TIFF header that follows it.
+constexpr size_t kExifHeaderSize = 6;
+constexpr size_t kIfdEntrySize = 12;
+constexpr size_t kMaxApp1Length = 65533;
+constexpr size_t kMaxTemplates = 8;
+constexpr size_t kDateTimeSize = 20;
+constexpr size_t kSubsecTimeSize = 4;
+constexpr size_t kGpsDateStampSize = 11;
+
+constexpr uint16_t kTagExifIfdPointer = 0x8769;
+constexpr uint16_t kTagGpsIfdPointer = 0x8825;
+
+uint16_t readShort(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+}
+
+uint32_t readLong(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// A parsed view of the IFDs written by exif_data_save_data() in Intel byte order.
+class TiffReader {
+  public:
+    TiffReader(const uint8_t* app1, size_t length)
+        : tiff_(app1 + kExifHeaderSize),
+          size_(length > kExifHeaderSize ? length - kExifHeaderSize : 0) {}
+
+    bool valid() const { return size_ >= 8 && tiff_[0] == 'I' && tiff_[1] == 'I'; }
+
+    uint32_t ifd0() const { return readLong(tiff_ + 4); }
+
+    uint32_t nextIfd(uint32_t ifd) const {
+        if (!entriesInBounds(ifd)) {
+            return 0;
+        }
+        size_t next = ifd + 2 + readShort(tiff_ + ifd) * kIfdEntrySize;
+        return next + 4 <= size_ ? readLong(tiff_ + next) : 0;
+    }
+
+    // Returns the offset of the IFD referenced by pointerTag in ifd, or 0.
+    uint32_t subIfd(uint32_t ifd, uint16_t pointerTag) const {
+        size_t offset = findValue(ifd, pointerTag, EXIF_FORMAT_LONG, 1);
+        return offset == 0 ? 0 : readLong(tiff_ - kExifHeaderSize + offset);
+    }
+
+    // Returns the offset of the value of tag from the start of the APP1 buffer, or 0 if the tag
+    // is not in ifd with the given format and component count.
+    size_t findValue(uint32_t ifd, uint16_t tag, ExifFormat format, uint32_t components) const {
+        if (ifd == 0 || !entriesInBounds(ifd)) {
+            return 0;
+        }
+        uint16_t count = readShort(tiff_ + ifd);
+        for (uint16_t i = 0; i < count; i++) {
+            const uint8_t* entry = tiff_ + ifd + 2 + i * kIfdEntrySize;
+            if (readShort(entry) != tag) {
+                continue;
+            }
+            if (readShort(entry + 2) != format || readLong(entry + 4) != components) {
+                return 0;
+            }
+            size_t valueSize = exif_format_get_size(format) * components;
+            size_t valueOffset = valueSize <= 4 ? entry + 8 - tiff_ : readLong(entry + 8);
+            if (valueOffset + valueSize > size_) {
+                return 0;
+            }
+            return kExifHeaderSize + valueOffset;
+        }
+        return 0;
+    }
+
+  private:
+    bool entriesInBounds(uint32_t ifd) const {
+        return ifd + 2 <= size_ && ifd + 2 + readShort(tiff_ + ifd) * kIfdEntrySize <= size_;
+    }
+
+    const uint8_t* tiff_;
+    size_t size_;
+};
+
+}  // anonymous namespace
+
+class ExifTemplateImpl : public ExifTemplate {
+  public:
+    ExifTemplateImpl(const std::string& make, const std::string& model);
+
+    virtual ~ExifTemplateImpl();
+
+    virtual bool generateApp1(const CameraMetadata& metadata, const size_t imageWidth,
+                              const size_t imageHeight, const void* thumbnail_buffer,
+                              uint32_t size);
+
+    virtual const uint8_t* getApp1Buffer();
+
+    virtual unsigned int getApp1Length();
+
+  protected:
+    // A serialized APP1 segment without thumbnail data, and where to patch per-shot fields.
+    // Offsets are from the start of |data| and 0 when the field is absent.
+    struct Template {
+        std::vector<uint8_t> data;
+        size_t dateTime[3] = {};
+        size_t subsecTime[3] = {};
+        size_t orientation = 0;
+        size_t exposureTime = 0;
+        size_t gpsLatitudeRef = 0;
+        size_t gpsLatitude = 0;
+        size_t gpsLongitudeRef = 0;
+        size_t gpsLongitude = 0;
+        size_t gpsAltitudeRef = 0;
+        size_t gpsAltitude = 0;
+        size_t gpsDateStamp = 0;
+        size_t gpsTimeStamp = 0;
+        size_t thumbnailLength = 0;
+    };
+
+    // Key covering everything setFromMetadata() writes that is not patched per shot.
+    static std::string getTemplateKey(const CameraMetadata& metadata, size_t imageWidth,
+                                      size_t imageHeight, bool hasThumbnail);
+
+    // Builds a template with ExifUtils. Returns false if the capture can't be templated.
+    bool buildTemplate(const CameraMetadata& metadata, size_t imageWidth, size_t imageHeight,
+                       bool hasThumbnail, Template* tmpl);
+
+    // Patches the per-shot fields of |tmpl| into |app1_buffer_|.
+    bool patchTemplate(const Template& tmpl, const CameraMetadata& metadata,
+                       const void* thumbnail_buffer, uint32_t size);
+
+    // Generates the APP1 segment the same way callers did before templates existed.
+    bool generateWithExifUtils(const CameraMetadata& metadata, size_t imageWidth,
+                               size_t imageHeight, const void* thumbnail_buffer, uint32_t size);
+
+    const std::string make_;
+    const std::string model_;
+    // Templates keyed by getTemplateKey(), most recently used first. nullptr marks a key
+    // that can't be templated.
+    std::list<std::pair<std::string, std::unique_ptr<Template>>> templates_;
+    std::vector<uint8_t> app1_buffer_;
+};
+
+ExifTemplate* ExifTemplate::create(const std::string& make, const std::string& model) {
+    return new ExifTemplateImpl(make, model);
+}
+
+ExifTemplate::~ExifTemplate() {}
+
+ExifTemplateImpl::ExifTemplateImpl(const std::string& make, const std::string& model)
+    : make_(make), model_(model) {}
+
+ExifTemplateImpl::~ExifTemplateImpl() {}
+
+const uint8_t* ExifTemplateImpl::getApp1Buffer() {
+    return app1_buffer_.data();
+}
+
+unsigned int ExifTemplateImpl::getApp1Length() {
+    return app1_buffer_.size();
+}
+
+std::string ExifTemplateImpl::getTemplateKey(const CameraMetadata& metadata, size_t imageWidth,
+                                             size_t imageHeight, bool hasThumbnail) {
+    // Tags whose values end up in the template as is
+    static const uint32_t kValueTags[] = {
+            ANDROID_LENS_FOCAL_LENGTH,    ANDROID_JPEG_GPS_PROCESSING_METHOD,
+            ANDROID_LENS_APERTURE,        ANDROID_FLASH_INFO_AVAILABLE,
+            ANDROID_CONTROL_AWB_MODE,
+    };
+    // Tags whose values are patched per shot, only their presence changes the layout. The
+    // exposure time changes on almost every shot under auto-exposure.
+    static const uint32_t kPresenceTags[] = {
+            ANDROID_JPEG_GPS_COORDINATES,
+            ANDROID_JPEG_GPS_TIMESTAMP,
+            ANDROID_JPEG_ORIENTATION,
+            ANDROID_SENSOR_EXPOSURE_TIME,
+    };
+
+    std::string key;
+    auto append = [&key](const void* data, size_t size) {
+        key.append(static_cast<const char*>(data), size);
+    };
+    uint32_t dims[] = {static_cast<uint32_t>(imageWidth), static_cast<uint32_t>(imageHeight),
+                       hasThumbnail};
+    append(dims, sizeof(dims));
+    for (uint32_t tag : kValueTags) {
+        camera_metadata_ro_entry entry = metadata.find(tag);
+        uint32_t count = entry.count;
+        append(&count, sizeof(count));
+        if (entry.count > 0) {
+            append(entry.data.u8, entry.count * camera_metadata_type_size[entry.type]);
+        }
+    }
+    for (uint32_t tag : kPresenceTags) {
+        uint32_t count = metadata.find(tag).count;
+        append(&count, sizeof(count));
+    }
+    return key;
+}
+
+bool ExifTemplateImpl::buildTemplate(const CameraMetadata& metadata, size_t imageWidth,
+                                     size_t imageHeight, bool hasThumbnail, Template* tmpl) {
+    std::unique_ptr<ExifUtils> utils(ExifUtils::create());
+    const uint8_t thumbnailPlaceholder = 0;
+    if (!utils->initialize() || !utils->setFromMetadata(metadata, imageWidth, imageHeight) ||
+        !utils->setMake(make_) || !utils->setModel(model_) ||
+        !utils->generateApp1(hasThumbnail ? &thumbnailPlaceholder : nullptr,
+                             hasThumbnail ? sizeof(thumbnailPlaceholder) : 0)) {
+        return false;
+    }
+
+    const uint8_t* app1 = utils->getApp1Buffer();
+    size_t length = utils->getApp1Length();
+    TiffReader reader(app1, length);
+    if (!reader.valid()) {
+        ALOGE("%s: unexpected APP1 layout", __FUNCTION__);
+        return false;
+    }
+
+    uint32_t ifd0 = reader.ifd0();
+    uint32_t exifIfd = reader.subIfd(ifd0, kTagExifIfdPointer);
+    tmpl->dateTime[0] =
+            reader.findValue(ifd0, EXIF_TAG_DATE_TIME, EXIF_FORMAT_ASCII, kDateTimeSize);
+    tmpl->dateTime[1] = reader.findValue(exifIfd, EXIF_TAG_DATE_TIME_ORIGINAL, EXIF_FORMAT_ASCII,
+                                         kDateTimeSize);
+    tmpl->dateTime[2] = reader.findValue(exifIfd, EXIF_TAG_DATE_TIME_DIGITIZED, EXIF_FORMAT_ASCII,
+                                         kDateTimeSize);
+    tmpl->subsecTime[0] = reader.findValue(exifIfd, EXIF_TAG_SUB_SEC_TIME, EXIF_FORMAT_ASCII,
+                                           kSubsecTimeSize);
+    tmpl->subsecTime[1] = reader.findValue(exifIfd, EXIF_TAG_SUB_SEC_TIME_ORIGINAL,
+                                           EXIF_FORMAT_ASCII, kSubsecTimeSize);
+    tmpl->subsecTime[2] = reader.findValue(exifIfd, EXIF_TAG_SUB_SEC_TIME_DIGITIZED,
+                                           EXIF_FORMAT_ASCII, kSubsecTimeSize);
+    for (int i = 0; i < 3; i++) {
+        if (tmpl->dateTime[i] == 0 || tmpl->subsecTime[i] == 0) {
+            ALOGE("%s: date/time tags not found in APP1", __FUNCTION__);
+            return false;
+        }
+    }
+
+    if (metadata.exists(ANDROID_JPEG_ORIENTATION)) {
+        tmpl->orientation = reader.findValue(ifd0, EXIF_TAG_ORIENTATION, EXIF_FORMAT_SHORT, 1);
+        if (tmpl->orientation == 0) {
+            ALOGE("%s: orientation tag not found in APP1", __FUNCTION__);
+            return false;
+        }
+    }
+
+    if (metadata.exists(ANDROID_SENSOR_EXPOSURE_TIME)) {
+        tmpl->exposureTime =
+                reader.findValue(exifIfd, EXIF_TAG_EXPOSURE_TIME, EXIF_FORMAT_RATIONAL, 1);
+        if (tmpl->exposureTime == 0) {
+            ALOGE("%s: exposure time tag not found in APP1", __FUNCTION__);
+            return false;
+        }
+    }
+
+    uint32_t gpsIfd = reader.subIfd(ifd0, kTagGpsIfdPointer);
+    if (metadata.exists(ANDROID_JPEG_GPS_COORDINATES)) {
+        tmpl->gpsLatitudeRef = reader.findValue(
+                gpsIfd, static_cast<ExifTag>(EXIF_TAG_GPS_LATITUDE_REF), EXIF_FORMAT_ASCII, 2);
+        tmpl->gpsLatitude = reader.findValue(
+                gpsIfd, static_cast<ExifTag>(EXIF_TAG_GPS_LATITUDE), EXIF_FORMAT_RATIONAL, 3);
+        tmpl->gpsLongitudeRef = reader.findValue(
+                gpsIfd, static_cast<ExifTag>(EXIF_TAG_GPS_LONGITUDE_REF), EXIF_FORMAT_ASCII, 2);
+        tmpl->gpsLongitude = reader.findValue(
+                gpsIfd, static_cast<ExifTag>(EXIF_TAG_GPS_LONGITUDE), EXIF_FORMAT_RATIONAL, 3);
+        tmpl->gpsAltitudeRef = reader.findValue(
+                gpsIfd, static_cast<ExifTag>(EXIF_TAG_GPS_ALTITUDE_REF), EXIF_FORMAT_BYTE, 1);
+        tmpl->gpsAltitude = reader.findValue(
+                gpsIfd, static_cast<ExifTag>(EXIF_TAG_GPS_ALTITUDE), EXIF_FORMAT_RATIONAL, 1);
+        if (!tmpl->gpsLatitudeRef || !tmpl->gpsLatitude || !tmpl->gpsLongitudeRef ||
+            !tmpl->gpsLongitude || !tmpl->gpsAltitudeRef || !tmpl->gpsAltitude) {
+            ALOGE("%s: GPS position tags not found in APP1", __FUNCTION__);
+            return false;
+        }
+    }
+    if (metadata.exists(ANDROID_JPEG_GPS_TIMESTAMP)) {
+        tmpl->gpsDateStamp =
+                reader.findValue(gpsIfd, static_cast<ExifTag>(EXIF_TAG_GPS_DATE_STAMP),
+                                 EXIF_FORMAT_ASCII, kGpsDateStampSize);
+        tmpl->gpsTimeStamp = reader.findValue(
+                gpsIfd, static_cast<ExifTag>(EXIF_TAG_GPS_TIME_STAMP), EXIF_FORMAT_RATIONAL, 3);
+        if (!tmpl->gpsDateStamp || !tmpl->gpsTimeStamp) {
+            ALOGE("%s: GPS timestamp tags not found in APP1", __FUNCTION__);
+            return false;
+        }
+    }
+
+    size_t dataLength = length;
+    if (hasThumbnail) {
+        uint32_t ifd1 = reader.nextIfd(ifd0);
+        size_t thumbnailOffset =
+                reader.findValue(ifd1, EXIF_TAG_JPEG_INTERCHANGE_FORMAT, EXIF_FORMAT_LONG, 1);
+        tmpl->thumbnailLength = reader.findValue(ifd1, EXIF_TAG_JPEG_INTERCHANGE_FORMAT_LENGTH,
+                                                 EXIF_FORMAT_LONG, 1);
+        // The thumbnail can only be swapped in place if libexif put it at the very end
+        if (thumbnailOffset == 0 || tmpl->thumbnailLength == 0 ||
+            kExifHeaderSize + readLong(app1 + thumbnailOffset) + sizeof(thumbnailPlaceholder) !=
+                    length) {
+            ALOGE("%s: thumbnail is not at the end of APP1", __FUNCTION__);
+            return false;
+        }
+        dataLength -= sizeof(thumbnailPlaceholder);
+    }
+
+    tmpl->data.assign(app1, app1 + dataLength);
+    return true;
+}
+
+bool ExifTemplateImpl::patchTemplate(const Template& tmpl, const CameraMetadata& metadata,
+                                     const void* thumbnail_buffer, uint32_t size) {
+    if (tmpl.data.size() + size > kMaxApp1Length) {
+        ALOGE("%s: The size of APP1 segment is too large", __FUNCTION__);
+        return false;
+    }
+
+    struct timespec tp;
+    struct tm time_info;
+    if (clock_gettime(CLOCK_REALTIME, &tp) == -1) {
+        return false;
+    }
+    localtime_r(&tp.tv_sec, &time_info);
+    char dateTime[kDateTimeSize];
+    char subsecTime[kSubsecTimeSize];
+    if (snprintf(dateTime, sizeof(dateTime), "%04i:%02i:%02i %02i:%02i:%02i",
+                 time_info.tm_year + 1900, time_info.tm_mon + 1, time_info.tm_mday,
+                 time_info.tm_hour, time_info.tm_min, time_info.tm_sec) != kDateTimeSize - 1 ||
+        snprintf(subsecTime, sizeof(subsecTime), "%03ld", tp.tv_nsec / 1000000) < 0) {
+        ALOGW("%s: Input time is invalid", __FUNCTION__);
+        return false;
+    }
+
+    app1_buffer_.resize(tmpl.data.size() + size);
+    uint8_t* app1 = app1_buffer_.data();
+    memcpy(app1, tmpl.data.data(), tmpl.data.size());
+
+    for (int i = 0; i < 3; i++) {
+        memcpy(app1 + tmpl.dateTime[i], dateTime, kDateTimeSize);
+        memcpy(app1 + tmpl.subsecTime[i], subsecTime, kSubsecTimeSize);
+    }
+
+    if (tmpl.orientation) {
+        camera_metadata_ro_entry entry = metadata.find(ANDROID_JPEG_ORIENTATION);
+        exif_set_short(app1 + tmpl.orientation, EXIF_BYTE_ORDER_INTEL,
+                       getExifOrientation(entry.data.i32[0]));
+    }
+
+    if (tmpl.exposureTime) {
+        // Same truncation of the int64_t nanoseconds as ExifUtils::setExposureTime()
+        camera_metadata_ro_entry entry = metadata.find(ANDROID_SENSOR_EXPOSURE_TIME);
+        exif_set_rational(app1 + tmpl.exposureTime, EXIF_BYTE_ORDER_INTEL,
+                          {static_cast<ExifLong>(entry.data.i64[0]), 1000000000u});
+    }
+
+    if (tmpl.gpsLatitude) {
+        camera_metadata_ro_entry entry = metadata.find(ANDROID_JPEG_GPS_COORDINATES);
+        double latitude = entry.data.d[0];
+        double longitude = entry.data.d[1];
+        double altitude = entry.data.d[2];
+        memcpy(app1 + tmpl.gpsLatitudeRef, latitude >= 0 ? "N" : "S", 2);
+        setLatitudeOrLongitudeData(app1 + tmpl.gpsLatitude, fabs(latitude));
+        memcpy(app1 + tmpl.gpsLongitudeRef, longitude >= 0 ? "E" : "W", 2);
+        setLatitudeOrLongitudeData(app1 + tmpl.gpsLongitude, fabs(longitude));
+        app1[tmpl.gpsAltitudeRef] = altitude >= 0 ? 0 : 1;
+        exif_set_rational(app1 + tmpl.gpsAltitude, EXIF_BYTE_ORDER_INTEL,
+                          {static_cast<ExifLong>(fabs(altitude) * 1000), 1000});
+    }
+
+    if (tmpl.gpsDateStamp) {
+        camera_metadata_ro_entry entry = metadata.find(ANDROID_JPEG_GPS_TIMESTAMP);
+        time_t timestamp = static_cast<time_t>(entry.data.i64[0]);
+        char dateStamp[kGpsDateStampSize];
+        if (!gmtime_r(&timestamp, &time_info) ||
+            snprintf(dateStamp, sizeof(dateStamp), "%04i:%02i:%02i", time_info.tm_year + 1900,
+                     time_info.tm_mon + 1, time_info.tm_mday) != kGpsDateStampSize - 1) {
+            ALOGE("%s: Time tranformation failed.", __FUNCTION__);
+            return false;
+        }
+        memcpy(app1 + tmpl.gpsDateStamp, dateStamp, kGpsDateStampSize);
+        uint8_t* timeStamp = app1 + tmpl.gpsTimeStamp;
+        exif_set_rational(timeStamp, EXIF_BYTE_ORDER_INTEL,
+                          {static_cast<ExifLong>(time_info.tm_hour), 1});
+        exif_set_rational(timeStamp + sizeof(ExifRational), EXIF_BYTE_ORDER_INTEL,
+                          {static_cast<ExifLong>(time_info.tm_min), 1});
+        exif_set_rational(timeStamp + 2 * sizeof(ExifRational), EXIF_BYTE_ORDER_INTEL,
+                          {static_cast<ExifLong>(time_info.tm_sec), 1});
+    }
+
+    if (tmpl.thumbnailLength) {
+        exif_set_long(app1 + tmpl.thumbnailLength, EXIF_BYTE_ORDER_INTEL, size);
+        memcpy(app1 + tmpl.data.size(), thumbnail_buffer, size);
+    }
+    return true;
+}
+
+bool ExifTemplateImpl::generateWithExifUtils(const CameraMetadata& metadata, size_t imageWidth,
+                                             size_t imageHeight, const void* thumbnail_buffer,
+                                             uint32_t size) {
+    std::unique_ptr<ExifUtils> utils(ExifUtils::create());
+    utils->initialize();
+    utils->setFromMetadata(metadata, imageWidth, imageHeight);
+    utils->setMake(make_);
+    utils->setModel(model_);
+    if (!utils->generateApp1(thumbnail_buffer, size)) {
+        return false;
+    }
+    const uint8_t* app1 = utils->getApp1Buffer();
+    app1_buffer_.assign(app1, app1 + utils->getApp1Length());
+    return true;
+}
+
+bool ExifTemplateImpl::generateApp1(const CameraMetadata& metadata, const size_t imageWidth,
+                                    const size_t imageHeight, const void* thumbnail_buffer,
+                                    uint32_t size) {
+    bool hasThumbnail = thumbnail_buffer != nullptr && size > 0;
+    std::string key = getTemplateKey(metadata, imageWidth, imageHeight, hasThumbnail);
+
+    auto it = templates_.begin();
+    while (it != templates_.end() && it->first != key) {
+        it++;
+    }
+    if (it != templates_.end()) {
+        templates_.splice(templates_.begin(), templates_, it);
+    } else {
+        std::unique_ptr<Template> tmpl = std::make_unique<Template>();
+        if (!buildTemplate(metadata, imageWidth, imageHeight, hasThumbnail, tmpl.get())) {
+            ALOGV("%s: %zux%zu capture can't be templated", __FUNCTION__, imageWidth,
+                  imageHeight);
+            tmpl.reset();
+        }
+        templates_.emplace_front(std::move(key), std::move(tmpl));
+        if (templates_.size() > kMaxTemplates) {
+            templates_.pop_back();
+        }
+    }
+
+    const std::unique_ptr<Template>& tmpl = templates_.front().second;
+    if (tmpl != nullptr &&
+        patchTemplate(*tmpl, metadata, hasThumbnail ? thumbnail_buffer : nullptr,
+                      hasThumbnail ? size : 0)) {
+        return true;
+    }
+    return generateWithExifUtils(metadata, imageWidth, imageHeight, thumbnail_buffer, size);
+}
+
 }  // namespace helper
 }  // namespace common
 }  // namespace camera
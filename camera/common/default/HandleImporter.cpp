@@ -33,7 +33,10 @@ using aidl::android::hardware::graphics::common::PlaneLayoutComponent;
 using aidl::android::hardware::graphics::common::PlaneLayoutComponentType;
 using aidl::android::hardware::graphics::common::Smpte2086;
 
-HandleImporter::HandleImporter() : mInitialized(false) {}
+std::vector<PlaneLayout> getPlaneLayouts(buffer_handle_t& buf);
+
+HandleImporter::HandleImporter(bool cacheMappings)
+    : mInitialized(false), mCacheMappings(cacheMappings) {}
 
 void HandleImporter::initializeLocked() {
     if (mInitialized) {
@@ -70,6 +73,27 @@ android_ycbcr HandleImporter::lockYCbCr(buffer_handle_t& buf, uint64_t cpuUsage,
     }
     android_ycbcr layout;
 
+    if (mCacheMappings) {
+        const CachedMapping& mapping = getCachedMappingLocked(buf);
+        if (mapping.ycbcrValid) {
+            void* base = nullptr;
+            status_t status = GraphicBufferMapper::get().lock(buf, cpuUsage, accessRegion, &base);
+            if (status != OK || base == nullptr) {
+                ALOGE("%s: failed to lock error %d!", __FUNCTION__, status);
+                return layout;
+            }
+            uint8_t* data = static_cast<uint8_t*>(base);
+            layout.y = data + mapping.yOffset;
+            layout.cb = data + mapping.cbOffset;
+            layout.cr = data + mapping.crOffset;
+            layout.ystride = mapping.yStride;
+            layout.cstride = mapping.cStride;
+            layout.chroma_step = mapping.chromaStep;
+            return layout;
+        }
+        // Mapper cannot describe the plane layout (e.g. gralloc 2/3), fall through
+    }
+
     status_t status = GraphicBufferMapper::get().lockYCbCr(buf, cpuUsage, accessRegion, &layout);
 
     if (status != OK) {
@@ -89,6 +113,65 @@ std::vector<PlaneLayout> getPlaneLayouts(buffer_handle_t& buf) {
     return planeLayouts;
 }
 
+HandleImporter::CachedMapping& HandleImporter::getCachedMappingLocked(buffer_handle_t& buf) {
+    auto it = mMappingCache.find(buf);
+    if (it != mMappingCache.end()) {
+        return it->second;
+    }
+
+    CachedMapping mapping;
+    std::vector<PlaneLayout> planeLayouts = getPlaneLayouts(buf);
+    if (planeLayouts.size() == 1) {
+        mapping.strideValid = true;
+        mapping.monoPlanarStrideBytes = planeLayouts[0].strideInBytes;
+    }
+
+    // Same derivation GraphicBufferMapper uses for gralloc4 lockYCbCr
+    bool hasY = false, hasCb = false, hasCr = false, valid = !planeLayouts.empty();
+    for (const auto& planeLayout : planeLayouts) {
+        for (const auto& component : planeLayout.components) {
+            if (!gralloc4::isStandardPlaneLayoutComponentType(component.type)) {
+                continue;
+            }
+            if (component.offsetInBits % 8 != 0 || planeLayout.sampleIncrementInBits % 8 != 0) {
+                valid = false;
+                continue;
+            }
+            size_t offset = planeLayout.offsetInBytes + component.offsetInBits / 8;
+            size_t step = planeLayout.sampleIncrementInBits / 8;
+            switch (static_cast<PlaneLayoutComponentType>(component.type.value)) {
+                case PlaneLayoutComponentType::Y:
+                    hasY = true;
+                    mapping.yOffset = offset;
+                    mapping.yStride = planeLayout.strideInBytes;
+                    break;
+                case PlaneLayoutComponentType::CB:
+                case PlaneLayoutComponentType::CR:
+                    if ((hasCb || hasCr) && (mapping.cStride != planeLayout.strideInBytes ||
+                                             mapping.chromaStep != step)) {
+                        valid = false;
+                    }
+                    if (static_cast<PlaneLayoutComponentType>(component.type.value) ==
+                        PlaneLayoutComponentType::CB) {
+                        hasCb = true;
+                        mapping.cbOffset = offset;
+                    } else {
+                        hasCr = true;
+                        mapping.crOffset = offset;
+                    }
+                    mapping.cStride = planeLayout.strideInBytes;
+                    mapping.chromaStep = step;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    mapping.ycbcrValid = valid && hasY && hasCb && hasCr;
+
+    return mMappingCache.emplace(buf, mapping).first->second;
+}
+
 // In IComposer, any buffer_handle_t is owned by the caller and we need to
 // make a clone for hwcomposer2.  We also need to translate empty handle
 // to nullptr.  This function does that, in-place.
@@ -116,6 +199,7 @@ void HandleImporter::freeBuffer(buffer_handle_t handle) {
         initializeLocked();
     }
 
+    mMappingCache.erase(handle);
     status_t status = GraphicBufferMapper::get().freeBuffer(handle);
     if (status != OK) {
         ALOGE("%s: mapper freeBuffer failed. Status %d", __FUNCTION__, status);
@@ -182,6 +266,14 @@ status_t HandleImporter::getMonoPlanarStrideBytes(buffer_handle_t& buf, uint32_t
         initializeLocked();
     }
 
+    if (mCacheMappings) {
+        const CachedMapping& mapping = getCachedMappingLocked(buf);
+        if (mapping.strideValid) {
+            *stride = mapping.monoPlanarStrideBytes;
+            return OK;
+        }
+    }
+
     std::vector<PlaneLayout> planeLayouts = getPlaneLayouts(buf);
     if (planeLayouts.size() != 1) {
         ALOGE("%s: Unexpected number of planes %zu!", __FUNCTION__, planeLayouts.size());
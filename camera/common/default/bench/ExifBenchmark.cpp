@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <CameraMetadata.h>
+#include <Exif.h>
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+using ::android::hardware::camera::common::helper::CameraMetadata;
+using ::android::hardware::camera::common::helper::ExifTemplate;
+using ::android::hardware::camera::common::helper::ExifUtils;
+
+namespace {
+
+constexpr size_t kWidth = 1920;
+constexpr size_t kHeight = 1080;
+constexpr size_t kThumbnailSize = 12 * 1024;
+const char kMake[] = "Generic UVC webcam";
+
+// Camera characteristics merged with still capture settings, as createJpegLocked does.
+CameraMetadata makeCaptureMetadata(bool withGps) {
+    CameraMetadata md;
+    const float focalLength = 3.04f;
+    md.update(ANDROID_LENS_FOCAL_LENGTH, &focalLength, 1);
+    const float aperture = 2.0f;
+    md.update(ANDROID_LENS_APERTURE, &aperture, 1);
+    const int64_t exposureTime = 16666666;
+    md.update(ANDROID_SENSOR_EXPOSURE_TIME, &exposureTime, 1);
+    const uint8_t flashAvailable = ANDROID_FLASH_INFO_AVAILABLE_FALSE;
+    md.update(ANDROID_FLASH_INFO_AVAILABLE, &flashAvailable, 1);
+    const uint8_t awbMode = ANDROID_CONTROL_AWB_MODE_AUTO;
+    md.update(ANDROID_CONTROL_AWB_MODE, &awbMode, 1);
+    const int32_t orientation = 90;
+    md.update(ANDROID_JPEG_ORIENTATION, &orientation, 1);
+    if (withGps) {
+        const double coordinates[] = {37.4220, -122.0841, 32.0};
+        md.update(ANDROID_JPEG_GPS_COORDINATES, coordinates, 3);
+        const uint8_t method[] = "GPS";
+        md.update(ANDROID_JPEG_GPS_PROCESSING_METHOD, method, sizeof(method));
+        const int64_t timestamp = 1760000000;
+        md.update(ANDROID_JPEG_GPS_TIMESTAMP, &timestamp, 1);
+    }
+    return md;
+}
+
+// The APP1 generation createJpegLocked did for every capture before ExifTemplate.
+void BM_Exif_ExifUtils(benchmark::State& state) {
+    CameraMetadata md = makeCaptureMetadata(state.range(1));
+    std::vector<uint8_t> thumbnail(state.range(0) ? kThumbnailSize : 0, 0xa5);
+    for (auto _ : state) {
+        std::unique_ptr<ExifUtils> utils(ExifUtils::create());
+        utils->initialize();
+        utils->setFromMetadata(md, kWidth, kHeight);
+        utils->setMake(kMake);
+        utils->setModel(kMake);
+        utils->generateApp1(thumbnail.empty() ? nullptr : thumbnail.data(), thumbnail.size());
+        benchmark::DoNotOptimize(utils->getApp1Buffer());
+    }
+}
+BENCHMARK(BM_Exif_ExifUtils)->ArgNames({"thumbnail", "gps"})->ArgsProduct({{0, 1}, {0, 1}});
+
+void BM_Exif_Template(benchmark::State& state) {
+    CameraMetadata md = makeCaptureMetadata(state.range(1));
+    std::vector<uint8_t> thumbnail(state.range(0) ? kThumbnailSize : 0, 0xa5);
+    std::unique_ptr<ExifTemplate> exif(ExifTemplate::create(kMake, kMake));
+    int64_t exposureTime = 16666666;
+    for (auto _ : state) {
+        // Auto-exposure changes the exposure time from shot to shot
+        exposureTime = exposureTime % 33333333 + 1000;
+        md.update(ANDROID_SENSOR_EXPOSURE_TIME, &exposureTime, 1);
+        exif->generateApp1(md, kWidth, kHeight, thumbnail.empty() ? nullptr : thumbnail.data(),
+                           thumbnail.size());
+        benchmark::DoNotOptimize(exif->getApp1Buffer());
+    }
+}
+BENCHMARK(BM_Exif_Template)->ArgNames({"thumbnail", "gps"})->ArgsProduct({{0, 1}, {0, 1}});
+
+}  // namespace
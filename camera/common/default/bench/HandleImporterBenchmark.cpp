@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <HandleImporter.h>
+#include <benchmark/benchmark.h>
+#include <ui/GraphicBuffer.h>
+#include <unistd.h>
+
+using ::android::GraphicBuffer;
+using ::android::OK;
+using ::android::Rect;
+using ::android::sp;
+using ::android::hardware::camera::common::helper::HandleImporter;
+
+namespace {
+
+constexpr uint64_t kUsage =
+        GraphicBuffer::USAGE_SW_READ_OFTEN | GraphicBuffer::USAGE_SW_WRITE_OFTEN;
+
+// Per-frame mapper cost of the output path in the external camera HAL: lock a YUV buffer for
+// CPU write, then unlock it and close the release fence.
+void lockYCbCrPerFrame(benchmark::State& state, bool cacheMappings) {
+    const uint32_t width = state.range(0);
+    const uint32_t height = state.range(1);
+    sp<GraphicBuffer> gb =
+            sp<GraphicBuffer>::make(width, height, HAL_PIXEL_FORMAT_YCBCR_420_888, 1, kUsage);
+    if (gb->initCheck() != OK) {
+        state.SkipWithError("failed to allocate graphic buffer");
+        return;
+    }
+
+    HandleImporter importer(cacheMappings);
+    buffer_handle_t handle = gb->handle;
+    if (!importer.importBuffer(handle) || handle == nullptr) {
+        state.SkipWithError("failed to import graphic buffer");
+        return;
+    }
+
+    Rect region(width, height);
+    for (auto _ : state) {
+        android_ycbcr layout = importer.lockYCbCr(handle, kUsage, region);
+        benchmark::DoNotOptimize(layout.y);
+        int relFence = importer.unlock(handle);
+        if (relFence >= 0) {
+            close(relFence);
+        }
+    }
+    importer.freeBuffer(handle);
+}
+
+void BM_LockYCbCr_Uncached(benchmark::State& state) {
+    lockYCbCrPerFrame(state, /*cacheMappings*/ false);
+}
+
+void BM_LockYCbCr_Cached(benchmark::State& state) {
+    lockYCbCrPerFrame(state, /*cacheMappings*/ true);
+}
+
+void frameSizes(benchmark::internal::Benchmark* b) {
+    b->Args({640, 480})->Args({1280, 720})->Args({1920, 1080});
+}
+
+}  // namespace
+
+BENCHMARK(BM_LockYCbCr_Uncached)->Apply(frameSizes);
+BENCHMARK(BM_LockYCbCr_Cached)->Apply(frameSizes);
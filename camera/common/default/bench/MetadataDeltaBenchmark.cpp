@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <CameraMetadata.h>
+#include <CameraMetadataDelta.h>
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <vector>
+
+using ::android::OK;
+using ::android::hardware::camera::common::helper::CameraMetadata;
+using ::android::hardware::camera::common::helper::MetadataDeltaDecoder;
+using ::android::hardware::camera::common::helper::MetadataDeltaEncoder;
+
+namespace {
+
+constexpr int64_t kFrameDurationNs = 33333333;  // 30 fps
+constexpr int kFramesPerSecond = 30;
+
+// Roughly what the external camera HAL returns per frame: the request settings echoed back plus
+// the tags filled in by fillCaptureResult. Only the sensor timestamp changes between frames.
+CameraMetadata makeResult(int64_t timestamp) {
+    CameraMetadata md;
+    const uint32_t byteTags[] = {
+            ANDROID_COLOR_CORRECTION_ABERRATION_MODE,
+            ANDROID_CONTROL_AE_ANTIBANDING_MODE,
+            ANDROID_CONTROL_AE_LOCK,
+            ANDROID_CONTROL_AE_MODE,
+            ANDROID_CONTROL_AE_PRECAPTURE_TRIGGER,
+            ANDROID_CONTROL_AE_STATE,
+            ANDROID_CONTROL_AF_MODE,
+            ANDROID_CONTROL_AF_STATE,
+            ANDROID_CONTROL_AF_TRIGGER,
+            ANDROID_CONTROL_AWB_LOCK,
+            ANDROID_CONTROL_AWB_MODE,
+            ANDROID_CONTROL_AWB_STATE,
+            ANDROID_CONTROL_CAPTURE_INTENT,
+            ANDROID_CONTROL_EFFECT_MODE,
+            ANDROID_CONTROL_MODE,
+            ANDROID_CONTROL_SCENE_MODE,
+            ANDROID_CONTROL_VIDEO_STABILIZATION_MODE,
+            ANDROID_FLASH_MODE,
+            ANDROID_FLASH_STATE,
+            ANDROID_JPEG_QUALITY,
+            ANDROID_JPEG_THUMBNAIL_QUALITY,
+            ANDROID_NOISE_REDUCTION_MODE,
+            ANDROID_REQUEST_PIPELINE_DEPTH,
+            ANDROID_STATISTICS_FACE_DETECT_MODE,
+            ANDROID_STATISTICS_LENS_SHADING_MAP_MODE,
+            ANDROID_STATISTICS_SCENE_FLICKER,
+    };
+    for (uint32_t tag : byteTags) {
+        uint8_t value = 0;
+        md.update(tag, &value, 1);
+    }
+    const int32_t fpsRange[] = {15, 30};
+    md.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE, fpsRange, 2);
+    const int32_t exposureCompensation = 0;
+    md.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION, &exposureCompensation, 1);
+    const int32_t orientation = 0;
+    md.update(ANDROID_JPEG_ORIENTATION, &orientation, 1);
+    const int32_t thumbnailSize[] = {240, 180};
+    md.update(ANDROID_JPEG_THUMBNAIL_SIZE, thumbnailSize, 2);
+    const int32_t cropRegion[] = {0, 0, 1920, 1080};
+    md.update(ANDROID_SCALER_CROP_REGION, cropRegion, 4);
+    const float focalLength = 3.0f;
+    md.update(ANDROID_LENS_FOCAL_LENGTH, &focalLength, 1);
+    md.update(ANDROID_SENSOR_TIMESTAMP, &timestamp, 1);
+    return md;
+}
+
+// What the HAL does today: the full metadata buffer is copied into the FMQ for every frame.
+void BM_ResultMetadata_Full(benchmark::State& state) {
+    CameraMetadata md = makeResult(0);
+    std::vector<uint8_t> fmq;
+    int64_t timestamp = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        timestamp += kFrameDurationNs;
+        md.update(ANDROID_SENSOR_TIMESTAMP, &timestamp, 1);
+        const camera_metadata_t* buf = md.getAndLock();
+        size_t size = get_camera_metadata_size(buf);
+        fmq.resize(size);
+        memcpy(fmq.data(), buf, size);
+        md.unlock(buf);
+        bytes += size;
+        benchmark::DoNotOptimize(fmq.data());
+    }
+    state.counters["fmq_bytes_per_frame"] =
+            benchmark::Counter(bytes, benchmark::Counter::kAvgIterations);
+    state.counters["fmq_bytes_per_sec_30fps"] =
+            benchmark::Counter(bytes * kFramesPerSecond, benchmark::Counter::kAvgIterations);
+}
+
+void BM_ResultMetadata_DeltaEncode(benchmark::State& state) {
+    CameraMetadata md = makeResult(0);
+    MetadataDeltaEncoder encoder(state.range(0));
+    std::vector<uint8_t> packet;
+    int64_t timestamp = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        timestamp += kFrameDurationNs;
+        md.update(ANDROID_SENSOR_TIMESTAMP, &timestamp, 1);
+        const camera_metadata_t* buf = md.getAndLock();
+        if (encoder.encode(buf, &packet) != OK) {
+            state.SkipWithError("encode failed");
+        }
+        md.unlock(buf);
+        bytes += packet.size();
+        benchmark::DoNotOptimize(packet.data());
+    }
+    state.counters["fmq_bytes_per_frame"] =
+            benchmark::Counter(bytes, benchmark::Counter::kAvgIterations);
+    state.counters["fmq_bytes_per_sec_30fps"] =
+            benchmark::Counter(bytes * kFramesPerSecond, benchmark::Counter::kAvgIterations);
+}
+
+// Client side cost of rebuilding the full metadata from the packets above.
+void BM_ResultMetadata_DeltaDecode(benchmark::State& state) {
+    CameraMetadata md = makeResult(0);
+    MetadataDeltaEncoder encoder(state.range(0));
+    std::vector<std::vector<uint8_t>> packets(state.range(0));
+    int64_t timestamp = 0;
+    for (auto& packet : packets) {
+        timestamp += kFrameDurationNs;
+        md.update(ANDROID_SENSOR_TIMESTAMP, &timestamp, 1);
+        const camera_metadata_t* buf = md.getAndLock();
+        encoder.encode(buf, &packet);
+        md.unlock(buf);
+    }
+
+    MetadataDeltaDecoder decoder;
+    CameraMetadata out;
+    size_t i = 0;
+    for (auto _ : state) {
+        if (decoder.decode(packets[i].data(), packets[i].size(), &out) != OK) {
+            state.SkipWithError("decode failed");
+        }
+        i = (i + 1) % packets.size();
+    }
+}
+
+}  // namespace
+
+// Argument is the keyframe interval in frames
+BENCHMARK(BM_ResultMetadata_Full);
+BENCHMARK(BM_ResultMetadata_DeltaEncode)->Arg(1)->Arg(30)->Arg(300);
+BENCHMARK(BM_ResultMetadata_DeltaDecode)->Arg(30)->Arg(300);
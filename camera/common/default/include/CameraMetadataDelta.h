@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAMERA_COMMON_CAMERAMETADATADELTA_H
+#define CAMERA_COMMON_CAMERAMETADATADELTA_H
+
+#include <utils/Errors.h>
+#include <vector>
+
+#include "CameraMetadata.h"
+
+namespace android {
+namespace hardware {
+namespace camera {
+namespace common {
+namespace helper {
+
+/**
+ * Opt-in delta encoding for a stream of result metadata, e.g. capture results sent over the
+ * result FMQ. Most result tags are identical from one frame to the next, so instead of the full
+ * camera_metadata_t the encoder only emits the entries that were added, changed or removed since
+ * the previous result, plus a full keyframe every keyframeInterval results.
+ *
+ * Both ends must opt in: a MetadataDeltaDecoder on the receiving side rebuilds the full
+ * metadata. Packets are:
+ *
+ *   PacketHeader, then
+ *     KEYFRAME: a complete camera_metadata_t buffer
+ *     DELTA:    entryCount x (EntryHeader + count * type size bytes of data)
+ *
+ * All fields are in host byte order; both ends are expected to run on the same device.
+ */
+class MetadataDeltaEncoder {
+  public:
+    static constexpr uint32_t kDefaultKeyframeInterval = 30;
+
+    explicit MetadataDeltaEncoder(uint32_t keyframeInterval = kDefaultKeyframeInterval);
+
+    /**
+     * Encodes metadata as a keyframe or as a delta against the previously encoded metadata.
+     * out is overwritten with the packet.
+     */
+    status_t encode(const camera_metadata_t* metadata, std::vector<uint8_t>* out);
+
+    /**
+     * Forces the next encoded packet to be a keyframe, e.g. after the receiver may have
+     * missed a packet.
+     */
+    void requestKeyframe();
+
+  private:
+    status_t encodeKeyframe(const camera_metadata_t* metadata, std::vector<uint8_t>* out);
+
+    const uint32_t mKeyframeInterval;
+    uint32_t mSequence = 0;
+    uint32_t mFramesSinceKeyframe = 0;
+    bool mKeyframeRequested = true;
+    // Sorted copy of the last encoded metadata
+    CameraMetadata mPrevious;
+};
+
+/**
+ * Rebuilds full metadata from packets produced by MetadataDeltaEncoder. Plain camera_metadata_t
+ * buffers are also accepted and treated as keyframes, so a receiver can decode results from
+ * producers that do not use delta encoding.
+ */
+class MetadataDeltaDecoder {
+  public:
+    /**
+     * Decodes one packet and copies the full, up to date metadata into out. Returns
+     * INVALID_OPERATION if a delta arrives without the preceding packet; the decoder then
+     * waits for the next keyframe.
+     */
+    status_t decode(const uint8_t* data, size_t size, CameraMetadata* out);
+
+    void reset();
+
+  private:
+    status_t applyDelta(const uint8_t* data, size_t size, uint32_t entryCount);
+
+    bool mSynced = false;
+    uint32_t mSequence = 0;
+    CameraMetadata mCurrent;
+};
+
+}  // namespace helper
+}  // namespace common
+}  // namespace camera
+}  // namespace hardware
+}  // namespace android
+
+#endif  // CAMERA_COMMON_CAMERAMETADATADELTA_H
@@ -240,12 +240,51 @@ class ExifUtils {
     virtual unsigned int getApp1Length() = 0;
 };
 
+// ExifTemplate generates APP1 segments for repeated captures within a session. The fields that
+// do not change from shot to shot are serialized once by ExifUtils into a byte template, and the
+// per-shot fields (date/time, subsec time, orientation, exposure time, GPS position and
+// timestamp, thumbnail) are patched into a copy of it at offsets located when the template is
+// built.
+//
+// A template is kept for each image size, thumbnail presence and combination of the remaining
+// metadata-derived fields, so e.g. a different AWB mode or GPS processing method just builds
+// another template. Captures that cannot be templated use the regular ExifUtils path.
+//
+// Example of using this class :
+//  std::unique_ptr<ExifTemplate> exif(ExifTemplate::create(make, model));
+//  ...
+//  // For each capture
+//  exif->generateApp1(metadata, width, height, thumbnail_buffer, thumbnail_size);
+//  encode(..., exif->getApp1Buffer(), exif->getApp1Length());
+class ExifTemplate {
+  public:
+    virtual ~ExifTemplate();
+
+    static ExifTemplate* create(const std::string& make, const std::string& model);
+
+    // Generates the APP1 segment for one capture, equivalent to ExifUtils::setFromMetadata(),
+    // setMake(), setModel() and generateApp1().
+    // Returns false if generating APP1 segment fails.
+    virtual bool generateApp1(const CameraMetadata& metadata, const size_t imageWidth,
+                              const size_t imageHeight, const void* thumbnail_buffer,
+                              uint32_t size) = 0;
+
+    // Gets buffer of APP1 segment. This method must be called only after calling
+    // generateApp1().
+    virtual const uint8_t* getApp1Buffer() = 0;
+
+    // Gets length of APP1 segment. This method must be called only after calling
+    // generateApp1().
+    virtual unsigned int getApp1Length() = 0;
+};
+
 }  // namespace helper
 
 // NOTE: Deprecated namespace. This namespace should no longer be used for the following symbols
 namespace V1_0::helper {
 // Export symbols to the old namespace to preserve compatibility
 typedef android::hardware::camera::common::helper::ExifUtils ExifUtils;
+typedef android::hardware::camera::common::helper::ExifTemplate ExifTemplate;
 }  // namespace V1_0::helper
 
 }  // namespace common
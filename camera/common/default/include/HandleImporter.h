@@ -21,6 +21,7 @@
 #include <system/graphics.h>
 #include <ui/Rect.h>
 #include <utils/Mutex.h>
+#include <unordered_map>
 
 namespace android {
 namespace hardware {
@@ -31,7 +32,10 @@ namespace helper {
 // Borrowed from graphics HAL. Use this until gralloc mapper HAL is working
 class HandleImporter {
   public:
-    HandleImporter();
+    // When cacheMappings is true, the plane layout of each imported buffer is queried from the
+    // mapper once and cached until freeBuffer(), so repeated lockYCbCr() and
+    // getMonoPlanarStrideBytes() calls only cost a mapper lock.
+    explicit HandleImporter(bool cacheMappings = false);
 
     // In IComposer, any buffer_handle_t is owned by the caller and we need to
     // make a clone for hwcomposer2.  We also need to translate empty handle
@@ -62,14 +66,32 @@ class HandleImporter {
     bool isSmpte2094_40Present(const buffer_handle_t& buf);
 
   private:
+    // Plane layout of an imported buffer, stored as byte offsets from the base address returned
+    // by the mapper lock.
+    struct CachedMapping {
+        bool ycbcrValid = false;
+        size_t yOffset = 0;
+        size_t cbOffset = 0;
+        size_t crOffset = 0;
+        size_t yStride = 0;
+        size_t cStride = 0;
+        size_t chromaStep = 0;
+
+        bool strideValid = false;
+        uint32_t monoPlanarStrideBytes = 0;
+    };
+
     void initializeLocked();
     void cleanup();
 
     bool importBufferInternal(buffer_handle_t& handle);
     int unlockInternal(buffer_handle_t& buf);
+    CachedMapping& getCachedMappingLocked(buffer_handle_t& buf);
 
     Mutex mLock;
     bool mInitialized;
+    const bool mCacheMappings;
+    std::unordered_map<buffer_handle_t, CachedMapping> mMappingCache;  // protected by mLock
 };
 
 }  // namespace helper
@@ -103,12 +103,12 @@ using ::aidl::android::hardware::camera::device::StreamConfigurationMode;
 using ::aidl::android::hardware::camera::device::StreamRotation;
 using ::aidl::android::hardware::camera::device::StreamType;
 using ::aidl::android::hardware::graphics::common::Dataspace;
-using ::android::hardware::camera::common::V1_0::helper::ExifUtils;
+using ::android::hardware::camera::common::V1_0::helper::ExifTemplate;
 
 // Static instances
 const int ExternalCameraDeviceSession::kMaxProcessedStream;
 const int ExternalCameraDeviceSession::kMaxStallStream;
-HandleImporter ExternalCameraDeviceSession::sHandleImporter;
+HandleImporter& ExternalCameraDeviceSession::sHandleImporter = getSharedHandleImporter();
 
 ExternalCameraDeviceSession::ExternalCameraDeviceSession(
         const std::shared_ptr<ICameraDeviceCallback>& callback, const ExternalCameraConfig& cfg,
@@ -200,6 +200,11 @@ bool ExternalCameraDeviceSession::initialize() {
         return true;
     }
 
+    if (mCfg.resultMetadataDelta) {
+        mResultMetadataEncoder =
+                std::make_unique<MetadataDeltaEncoder>(mCfg.resultMetadataKeyframeInterval);
+    }
+
     mOutputThread->run();
     return false;
 }
@@ -1523,6 +1528,26 @@ void ExternalCameraDeviceSession::invokeProcessCaptureResultCallback(
             return;
         }
     }
+    if (mResultMetadataEncoder != nullptr) {
+        // Results are encoded in the order they are sent, whether through the FMQ or binder
+        ATRACE_BEGIN("encodeResultMetadataDelta");
+        std::vector<uint8_t> packet;
+        for (CaptureResult& result : results) {
+            std::vector<uint8_t>& metadata = result.result.metadata;
+            if (metadata.empty()) {
+                continue;
+            }
+            status_t res = mResultMetadataEncoder->encode(
+                    reinterpret_cast<const camera_metadata_t*>(metadata.data()), &packet);
+            if (res != OK) {
+                ALOGE("%s: failed to encode result metadata: %d", __FUNCTION__, res);
+                mResultMetadataEncoder->requestKeyframe();
+                continue;
+            }
+            metadata.swap(packet);
+        }
+        ATRACE_END();
+    }
     if (tryWriteFmq && mResultMetadataQueue->availableToWrite() > 0) {
         for (CaptureResult& result : results) {
             CameraMetadata& md = result.result;
@@ -2143,6 +2168,10 @@ Status ExternalCameraDeviceSession::OutputThread::allocateIntermediateBuffers(
         return Status::INTERNAL_ERROR;
     }
 
+    // Buffers released by the previous configuration stay cached in the pool for reuse below,
+    // unless the system is already short on memory.
+    FrameBufferPool::getInstance().trimIfLowMemory();
+
     // Allocating intermediate YU12 frame
     if (mYu12Frame == nullptr || mYu12Frame->mWidth != v4lSize.width ||
         mYu12Frame->mHeight != v4lSize.height) {
@@ -2167,6 +2196,24 @@ Status ExternalCameraDeviceSession::OutputThread::allocateIntermediateBuffers(
         }
     }
 
+    // Remove unconfigured buffers first so their memory can be reused by new sizes
+    auto it = mIntermediateBuffers.begin();
+    while (it != mIntermediateBuffers.end()) {
+        bool configured = false;
+        auto sz = it->first;
+        for (const auto& stream : streams) {
+            if (stream.width == sz.width && stream.height == sz.height) {
+                configured = true;
+                break;
+            }
+        }
+        if (configured) {
+            it++;
+        } else {
+            it = mIntermediateBuffers.erase(it);
+        }
+    }
+
     // Allocating scaled buffers
     for (const auto& stream : streams) {
         Size sz = {stream.width, stream.height};
@@ -2187,24 +2234,6 @@ Status ExternalCameraDeviceSession::OutputThread::allocateIntermediateBuffers(
         }
     }
 
-    // Remove unconfigured buffers
-    auto it = mIntermediateBuffers.begin();
-    while (it != mIntermediateBuffers.end()) {
-        bool configured = false;
-        auto sz = it->first;
-        for (const auto& stream : streams) {
-            if (stream.width == sz.width && stream.height == sz.height) {
-                configured = true;
-                break;
-            }
-        }
-        if (configured) {
-            it++;
-        } else {
-            it = mIntermediateBuffers.erase(it);
-        }
-    }
-
     // Allocate mute test pattern frame
     mMuteTestPatternFrame.resize(mYu12Frame->mWidth * mYu12Frame->mHeight * 3);
 
@@ -2259,12 +2288,14 @@ void ExternalCameraDeviceSession::OutputThread::dump(int fd) {
         dprintf(fd, "%d, ", req->frameNumber);
     }
     dprintf(fd, "\n");
+    FrameBufferPool::getInstance().dump(fd);
 }
 
 void ExternalCameraDeviceSession::OutputThread::setExifMakeModel(const std::string& make,
                                                                  const std::string& model) {
     mExifMake = make;
     mExifModel = model;
+    mExifTemplate.reset(ExifTemplate::create(make, model));
 }
 
 std::list<std::shared_ptr<HalRequest>>
@@ -2653,23 +2684,20 @@ int ExternalCameraDeviceSession::OutputThread::createJpegLocked(
     meta.append(setting);
 
     /* Generate EXIF object */
-    std::unique_ptr<ExifUtils> utils(ExifUtils::create());
-    /* Make sure it's initialized */
-    utils->initialize();
-
-    utils->setFromMetadata(meta, jpegSize.width, jpegSize.height);
-    utils->setMake(mExifMake);
-    utils->setModel(mExifModel);
+    if (mExifTemplate == nullptr) {
+        mExifTemplate.reset(ExifTemplate::create(mExifMake, mExifModel));
+    }
 
-    ret = utils->generateApp1(outputThumbnail ? &thumbCode[0] : nullptr, thumbCodeSize);
+    ret = mExifTemplate->generateApp1(meta, jpegSize.width, jpegSize.height,
+                                      outputThumbnail ? &thumbCode[0] : nullptr, thumbCodeSize);
 
     if (!ret) {
         return lfail("%s: generating APP1 failed", __FUNCTION__);
     }
 
     /* Get internal buffer */
-    size_t exifDataSize = utils->getApp1Length();
-    const uint8_t* exifData = utils->getApp1Buffer();
+    size_t exifDataSize = mExifTemplate->getApp1Length();
+    const uint8_t* exifData = mExifTemplate->getApp1Buffer();
 
     /* Lock the HAL jpeg code buffer */
     void* bufPtr = sHandleImporter.lock(*(halBuf.bufPtr), static_cast<uint64_t>(halBuf.usage),
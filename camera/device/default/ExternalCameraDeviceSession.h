@@ -17,6 +17,8 @@
 #ifndef HARDWARE_INTERFACES_CAMERA_DEVICE_DEFAULT_EXTERNALCAMERADEVICESESSION_H_
 #define HARDWARE_INTERFACES_CAMERA_DEVICE_DEFAULT_EXTERNALCAMERADEVICESESSION_H_
 
+#include <CameraMetadataDelta.h>
+#include <Exif.h>
 #include <ExternalCameraUtils.h>
 #include <SimpleThread.h>
 #include <aidl/android/hardware/camera/common/Status.h>
@@ -55,6 +57,7 @@ using ::aidl::android::hardware::common::fmq::MQDescriptor;
 using ::aidl::android::hardware::common::fmq::SynchronizedReadWrite;
 using ::android::AidlMessageQueue;
 using ::android::base::unique_fd;
+using ::android::hardware::camera::common::helper::MetadataDeltaEncoder;
 using ::android::hardware::camera::common::helper::SimpleThread;
 using ::android::hardware::camera::external::common::ExternalCameraConfig;
 using ::android::hardware::camera::external::common::SizeHasher;
@@ -235,6 +238,8 @@ class ExternalCameraDeviceSession : public BnCameraDeviceSession, public OutputT
 
         std::string mExifMake;
         std::string mExifModel;
+        // Reuses the serialized APP1 segment across captures, see setExifMakeModel
+        std::unique_ptr<common::V1_0::helper::ExifTemplate> mExifTemplate;
 
         const std::shared_ptr<BufferRequestThread> mBufferRequestThread;
     };
@@ -358,7 +363,8 @@ class ExternalCameraDeviceSession : public BnCameraDeviceSession, public OutputT
 
     uint32_t mBlobBufferSize = 0;
 
-    static HandleImporter sHandleImporter;
+    // Shared with ExternalCameraOfflineSession, see getSharedHandleImporter()
+    static HandleImporter& sHandleImporter;
 
     std::shared_ptr<BufferRequestThread> mBufferRequestThread;
 
@@ -371,6 +377,9 @@ class ExternalCameraDeviceSession : public BnCameraDeviceSession, public OutputT
     // Protect against invokeProcessCaptureResultCallback()
     Mutex mProcessCaptureResultLock;
 
+    // Non-null when mCfg.resultMetadataDelta is set. Protected by mProcessCaptureResultLock
+    std::unique_ptr<MetadataDeltaEncoder> mResultMetadataEncoder;
+
     // tracks last seen stream config counter
     int32_t mLastStreamConfigCounter = -1;
 
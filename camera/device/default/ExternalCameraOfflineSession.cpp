@@ -27,7 +27,10 @@
 #include <convert.h>
 #include <linux/videodev2.h>
 #include <sync/sync.h>
+#include <utils/AndroidThreads.h>
 #include <utils/Trace.h>
+#include <algorithm>
+#include <thread>
 
 #define HAVE_JPEG  // required for libyuv.h to export MJPEG decode APIs
 #include <libyuv.h>
@@ -51,7 +54,7 @@ using ::aidl::android::hardware::camera::device::ShutterMsg;
 using ::aidl::android::hardware::camera::device::StreamBuffer;
 
 // Static instance
-HandleImporter ExternalCameraOfflineSession::sHandleImporter;
+HandleImporter& ExternalCameraOfflineSession::sHandleImporter = getSharedHandleImporter();
 
 ExternalCameraOfflineSession::ExternalCameraOfflineSession(
         const CroppingType& croppingType, const common::V1_0::helper::CameraMetadata& chars,
@@ -290,13 +293,13 @@ ScopedAStatus ExternalCameraOfflineSession::setCallback(
 
     initOutputThread();
 
-    if (mOutputThread == nullptr) {
+    if (mOutputThreads.empty()) {
         ALOGE("%s: init OutputThread failed!", __FUNCTION__);
     }
     return fromStatus(Status::OK);
 }
 void ExternalCameraOfflineSession::initOutputThread() {
-    if (mOutputThread != nullptr) {
+    if (!mOutputThreads.empty()) {
         ALOGE("%s: OutputThread already exist!", __FUNCTION__);
         return;
     }
@@ -308,17 +311,38 @@ void ExternalCameraOfflineSession::initOutputThread() {
             /*parent=*/thiz, mCallback);
     mBufferRequestThread->run();
 
-    mOutputThread = std::make_shared<OutputThread>(/*parent=*/thiz, mCroppingType, mChars,
-                                                   mBufferRequestThread, mOfflineReqs);
-
-    mOutputThread->setExifMakeModel(mExifMake, mExifModel);
-
+    // The queue holds the only reference to the offline requests from now on, so each input
+    // frame is freed as soon as its request completes
     Size inputSize = {mOfflineReqs[0]->frameIn->mWidth, mOfflineReqs[0]->frameIn->mHeight};
-    Size maxThumbSize = getMaxThumbnailResolution(mChars);
-    mOutputThread->allocateIntermediateBuffers(inputSize, maxThumbSize, mOfflineStreams,
-                                               mBlobBufferSize);
+    mRequestQueue = std::make_shared<RequestQueue>(mOfflineReqs);
+    size_t numThreads = std::min({mOfflineReqs.size(), kMaxOutputThreads,
+                                  std::max<size_t>(1, std::thread::hardware_concurrency() / 2)});
+    mOfflineReqs.clear();
 
-    mOutputThread->run();
+    Size maxThumbSize = getMaxThumbnailResolution(mChars);
+    for (size_t i = 0; i < numThreads; i++) {
+        std::shared_ptr<OutputThread> thread = std::make_shared<OutputThread>(
+                /*parent=*/thiz, mCroppingType, mChars, mBufferRequestThread, mRequestQueue);
+
+        thread->setExifMakeModel(mExifMake, mExifModel);
+
+        Status st = thread->allocateIntermediateBuffers(inputSize, maxThumbSize, mOfflineStreams,
+                                                        mBlobBufferSize);
+        if (st != Status::OK) {
+            // Keep going with the threads we have, the remaining requests just take longer
+            ALOGE("%s: allocating buffers for OutputThread %zu failed", __FUNCTION__, i);
+            break;
+        }
+        mOutputThreads.push_back(thread);
+        thread->run();
+    }
+    if (mOutputThreads.empty()) {
+        for (const auto& req : mRequestQueue->flush()) {
+            processCaptureRequestError(req, /*msgs*/ nullptr, /*results*/ nullptr);
+        }
+        return;
+    }
+    ALOGV("%s: processing offline requests on %zu threads", __FUNCTION__, mOutputThreads.size());
 }
 
 ScopedAStatus ExternalCameraOfflineSession::getCaptureResultMetadataQueue(
@@ -337,15 +361,19 @@ ScopedAStatus ExternalCameraOfflineSession::close() {
             return fromStatus(Status::OK);
         }
     }
+    if (mRequestQueue != nullptr) {
+        for (const auto& req : mRequestQueue->flush()) {
+            processCaptureRequestError(req, /*msgs*/ nullptr, /*results*/ nullptr);
+        }
+    }
     if (mBufferRequestThread != nullptr) {
         mBufferRequestThread->requestExitAndWait();
         mBufferRequestThread.reset();
     }
-    if (mOutputThread) {
-        mOutputThread->flush();
-        mOutputThread->requestExitAndWait();
-        mOutputThread.reset();
+    for (auto& thread : mOutputThreads) {
+        thread->requestExitAndWait();
     }
+    mOutputThreads.clear();
 
     Mutex::Autolock _l(mLock);
     // free all buffers
@@ -367,6 +395,108 @@ void ExternalCameraOfflineSession::cleanupBuffersLocked(int32_t id) {
     mCirculatingBuffers.erase(id);
 }
 
+ExternalCameraOfflineSession::RequestQueue::RequestQueue(
+        const std::deque<std::shared_ptr<HalRequest>>& offlineReqs)
+    : mPending(offlineReqs), mStartTime(systemTime()) {}
+
+std::shared_ptr<HalRequest> ExternalCameraOfflineSession::RequestQueue::pop() {
+    std::lock_guard<std::mutex> lk(mLock);
+    if (mPending.empty()) {
+        return nullptr;
+    }
+    std::shared_ptr<HalRequest> req = mPending.front();
+    mPending.pop_front();
+    mInflight.insert(req->frameNumber);
+    return req;
+}
+
+void ExternalCameraOfflineSession::RequestQueue::waitForTurn(int32_t frameNumber) {
+    ATRACE_CALL();
+    std::unique_lock<std::mutex> lk(mLock);
+    // Pending requests are all newer than inflight ones, so only inflight requests can be older
+    while (!mFlushed && !mInflight.empty() && *mInflight.begin() < frameNumber) {
+        auto timeout = std::chrono::seconds(kTurnWaitTimeoutSec);
+        if (mCompleteCond.wait_for(lk, timeout) == std::cv_status::timeout) {
+            ALOGE("%s: wait for frame %d to complete timeout!", __FUNCTION__, *mInflight.begin());
+            return;
+        }
+    }
+}
+
+void ExternalCameraOfflineSession::RequestQueue::complete(int32_t frameNumber) {
+    std::unique_lock<std::mutex> lk(mLock);
+    mInflight.erase(frameNumber);
+    nsecs_t latency = systemTime() - mStartTime;
+    mCompletedCount++;
+    mTotalLatency += latency;
+    mMaxLatency = std::max(mMaxLatency, latency);
+    mLastLatency = latency;
+    lk.unlock();
+    mCompleteCond.notify_all();
+}
+
+std::deque<std::shared_ptr<HalRequest>> ExternalCameraOfflineSession::RequestQueue::flush() {
+    ATRACE_CALL();
+    std::unique_lock<std::mutex> lk(mLock);
+    std::deque<std::shared_ptr<HalRequest>> reqs = std::move(mPending);
+    mPending.clear();
+    // The flushed requests are newer than the inflight ones, so their errors must wait for the
+    // inflight results to go out first
+    while (!mInflight.empty()) {
+        auto timeout = std::chrono::seconds(kTurnWaitTimeoutSec);
+        if (mCompleteCond.wait_for(lk, timeout) == std::cv_status::timeout) {
+            ALOGE("%s: wait for frame %d to complete timeout!", __FUNCTION__, *mInflight.begin());
+            break;
+        }
+    }
+    mFlushed = true;
+    lk.unlock();
+    mCompleteCond.notify_all();
+    return reqs;
+}
+
+void ExternalCameraOfflineSession::RequestQueue::dump(int fd) {
+    std::lock_guard<std::mutex> lk(mLock);
+    dprintf(fd, "Offline request queue: %zu pending, %zu processing, %zu completed%s\n",
+            mPending.size(), mInflight.size(), mCompletedCount, mFlushed ? " (flushed)" : "");
+    if (!mPending.empty()) {
+        dprintf(fd, "Offline request queue contains frame: ");
+        for (const auto& req : mPending) {
+            dprintf(fd, "%d, ", req->frameNumber);
+        }
+        dprintf(fd, "\n");
+    }
+    if (mCompletedCount > 0) {
+        dprintf(fd, "Offline completion latency (ms): avg %.1f, max %.1f, last %.1f\n",
+                ns2us(mTotalLatency / mCompletedCount) / 1000.0, ns2us(mMaxLatency) / 1000.0,
+                ns2us(mLastLatency) / 1000.0);
+    }
+}
+
+binder_status_t ExternalCameraOfflineSession::dump(int fd, const char** /*args*/,
+                                                   uint32_t /*numArgs*/) {
+    if (mInterfaceLock.tryLock() != OK) {
+        dprintf(fd, "!! ExternalCameraOfflineSession interface may be deadlocked !!\n");
+        return STATUS_OK;
+    }
+    if (mClosed) {
+        dprintf(fd, "External camera %s offline session is closed\n", mCameraId.c_str());
+        mInterfaceLock.unlock();
+        return STATUS_OK;
+    }
+    std::shared_ptr<RequestQueue> requestQueue = mRequestQueue;
+    size_t numThreads = mOutputThreads.size();
+    mInterfaceLock.unlock();
+
+    dprintf(fd, "External camera %s offline session, %zu output threads\n", mCameraId.c_str(),
+            numThreads);
+    if (requestQueue != nullptr) {
+        requestQueue->dump(fd);
+    }
+    FrameBufferPool::getInstance().dump(fd);
+    return STATUS_OK;
+}
+
 bool ExternalCameraOfflineSession::OutputThread::threadLoop() {
     auto parent = mParent.lock();
     if (parent == nullptr) {
@@ -374,18 +504,36 @@ bool ExternalCameraOfflineSession::OutputThread::threadLoop() {
         return false;
     }
 
-    if (mOfflineReqs.empty()) {
+    if (!mPrioritySet) {
+        // Offline processing must not compete with a new session of the same camera
+        androidSetThreadPriority(/*tid*/ 0, ANDROID_PRIORITY_BACKGROUND);
+        mPrioritySet = true;
+    }
+
+    // Once popped, a request must be processed, as flush() waits for it to complete
+    std::shared_ptr<HalRequest> req = exitPending() ? nullptr : mRequestQueue->pop();
+    if (req == nullptr) {
         ALOGI("%s: all offline requests are processed. Stopping.", __FUNCTION__);
+        // Other threads may still be working, release our buffers right away
+        clearIntermediateBuffers();
+        FrameBufferPool::getInstance().trimIfLowMemory();
         return false;
     }
 
-    std::shared_ptr<HalRequest> req = mOfflineReqs.front();
-    mOfflineReqs.pop_front();
+    bool ret = processRequest(parent, req);
+    mRequestQueue->complete(req->frameNumber);
+    if (!ret) {
+        clearIntermediateBuffers();
+    }
+    return ret;
+}
 
+bool ExternalCameraOfflineSession::OutputThread::processRequest(
+        const std::shared_ptr<OutputThreadInterface>& parent, std::shared_ptr<HalRequest>& req) {
     auto onDeviceError = [&](auto... args) {
         ALOGE(args...);
+        mRequestQueue->waitForTurn(req->frameNumber);
         parent->notifyError(req->frameNumber, /*stream*/ -1, ErrorCode::ERROR_DEVICE);
-        signalRequestDone();
         return false;
     };
 
@@ -396,10 +544,26 @@ bool ExternalCameraOfflineSession::OutputThread::threadLoop() {
                              (req->frameIn->mFourcc >> 24) & 0xFF);
     }
 
-    int res = requestBufferStart(req->buffers);
+    int res;
+    {
+        // Other threads may be decoding in the meantime, so there is nothing to overlap the
+        // buffer request with here
+        std::lock_guard<std::mutex> bufReqLock(mRequestQueue->bufferRequestLock());
+        res = requestBufferStart(req->buffers);
+        if (res != 0) {
+            ALOGE("%s: send BufferRequest failed! res %d", __FUNCTION__, res);
+        } else {
+            ATRACE_BEGIN("Wait for BufferRequest done");
+            res = waitForBufferRequestDone(&req->buffers);
+            ATRACE_END();
+            if (res != 0) {
+                ALOGE("%s: wait for BufferRequest done failed! res %d", __FUNCTION__, res);
+            }
+        }
+    }
+
     if (res != 0) {
-        ALOGE("%s: send BufferRequest failed! res %d", __FUNCTION__, res);
-        return onDeviceError("%s: failed to send buffer request!", __FUNCTION__);
+        return onDeviceError("%s: failed to process buffer request!", __FUNCTION__);
     }
 
     std::unique_lock<std::mutex> lk(mBufferLock);
@@ -427,25 +591,15 @@ bool ExternalCameraOfflineSession::OutputThread::threadLoop() {
             // For some webcam, the first few V4L2 frames might be malformed...
             ALOGE("%s: Convert V4L2 frame to YU12 failed! res %d", __FUNCTION__, convRes);
             lk.unlock();
+            mRequestQueue->waitForTurn(req->frameNumber);
             Status st = parent->processCaptureRequestError(req);
             if (st != Status::OK) {
                 return onDeviceError("%s: failed to process capture request error!", __FUNCTION__);
             }
-            signalRequestDone();
             return true;
         }
     }
 
-    ATRACE_BEGIN("Wait for BufferRequest done");
-    res = waitForBufferRequestDone(&req->buffers);
-    ATRACE_END();
-
-    if (res != 0) {
-        ALOGE("%s: wait for BufferRequest done failed! res %d", __FUNCTION__, res);
-        lk.unlock();
-        return onDeviceError("%s: failed to process buffer request error!", __FUNCTION__);
-    }
-
     ALOGV("%s processing new request", __FUNCTION__);
     const int kSyncWaitTimeoutMs = 500;
     for (auto& halBuf : req->buffers) {
@@ -545,11 +699,11 @@ bool ExternalCameraOfflineSession::OutputThread::threadLoop() {
 
     // Don't hold the lock while calling back to parent
     lk.unlock();
+    mRequestQueue->waitForTurn(req->frameNumber);
     Status st = parent->processCaptureResult(req);
     if (st != Status::OK) {
         return onDeviceError("%s: failed to process capture result!", __FUNCTION__);
     }
-    signalRequestDone();
     return true;
 }
 
@@ -24,7 +24,10 @@
 #include <aidl/android/hardware/camera/device/Stream.h>
 #include <fmq/AidlMessageQueue.h>
 #include <utils/RefBase.h>
+#include <utils/Timers.h>
+#include <condition_variable>
 #include <deque>
+#include <set>
 
 namespace android {
 namespace hardware {
@@ -75,23 +78,74 @@ class ExternalCameraOfflineSession final : public BnCameraOfflineSession,
             MQDescriptor<int8_t, SynchronizedReadWrite>* _aidl_return) override;
     ScopedAStatus close() override;
 
+    binder_status_t dump(int fd, const char** args, uint32_t numArgs) override;
+
   private:
+    // Hands out the remaining offline requests to the worker threads in frame number order
+    // and makes sure their results go back to the framework in that same order.
+    class RequestQueue {
+      public:
+        explicit RequestQueue(const std::deque<std::shared_ptr<HalRequest>>& offlineReqs);
+
+        // Returns the oldest pending request, or nullptr if there is none left
+        std::shared_ptr<HalRequest> pop();
+        // Blocks until all older requests have completed
+        void waitForTurn(int32_t frameNumber);
+        void complete(int32_t frameNumber);
+        // Removes all pending requests, waits for the inflight ones to complete, and returns the
+        // removed requests. waitForTurn no longer blocks afterwards.
+        std::deque<std::shared_ptr<HalRequest>> flush();
+
+        // Serializes buffer requests from the workers, as BufferRequestThread can only handle
+        // one at a time
+        std::mutex& bufferRequestLock() { return mBufferRequestLock; }
+
+        void dump(int fd);
+
+      private:
+        static const int kTurnWaitTimeoutSec = 3;
+
+        std::mutex mLock;
+        std::condition_variable mCompleteCond;  // signaled when a request completes
+        std::deque<std::shared_ptr<HalRequest>> mPending;
+        std::set<int32_t> mInflight;
+        bool mFlushed = false;
+
+        // Latency is measured from the switch to offline mode
+        const nsecs_t mStartTime;
+        size_t mCompletedCount = 0;
+        nsecs_t mTotalLatency = 0;
+        nsecs_t mMaxLatency = 0;
+        nsecs_t mLastLatency = 0;
+
+        std::mutex mBufferRequestLock;
+    };
+
     class OutputThread : public ExternalCameraDeviceSession::OutputThread {
       public:
         OutputThread(std::weak_ptr<OutputThreadInterface> parent, CroppingType ct,
                      const common::V1_0::helper::CameraMetadata& chars,
                      std::shared_ptr<ExternalCameraDeviceSession::BufferRequestThread> bufReqThread,
-                     std::deque<std::shared_ptr<HalRequest>>& offlineReqs)
+                     std::shared_ptr<RequestQueue> requestQueue)
             : ExternalCameraDeviceSession::OutputThread(std::move(parent), ct, chars,
                                                         std::move(bufReqThread)),
-              mOfflineReqs(offlineReqs) {}
+              mRequestQueue(std::move(requestQueue)) {}
 
         bool threadLoop() override;
 
       protected:
-        std::deque<std::shared_ptr<HalRequest>> mOfflineReqs;
+        // Returns false if the thread should stop after a device error
+        bool processRequest(const std::shared_ptr<OutputThreadInterface>& parent,
+                            std::shared_ptr<HalRequest>& req);
+
+        const std::shared_ptr<RequestQueue> mRequestQueue;
+        bool mPrioritySet = false;
     };  // OutputThread
 
+    // Offline requests are processed at background priority by up to this many threads, each
+    // with its own set of intermediate buffers
+    static const size_t kMaxOutputThreads = 3;
+
     status_t fillCaptureResult(common::V1_0::helper::CameraMetadata md, nsecs_t timestamp);
     void invokeProcessCaptureResultCallback(std::vector<CaptureResult>& results, bool tryWriteFmq);
     void initOutputThread();
@@ -120,7 +174,8 @@ class ExternalCameraOfflineSession final : public BnCameraOfflineSession,
     mutable Mutex mCbsLock;
     std::map<int, CirculatingBuffers> mCirculatingBuffers;
 
-    static HandleImporter sHandleImporter;
+    // Shared with ExternalCameraDeviceSession, see getSharedHandleImporter()
+    static HandleImporter& sHandleImporter;
 
     using ResultMetadataQueue = AidlMessageQueue<int8_t, SynchronizedReadWrite>;
     std::shared_ptr<ResultMetadataQueue> mResultMetadataQueue;
@@ -131,7 +186,8 @@ class ExternalCameraOfflineSession final : public BnCameraOfflineSession,
     std::shared_ptr<ICameraDeviceCallback> mCallback;
 
     std::shared_ptr<ExternalCameraDeviceSession::BufferRequestThread> mBufferRequestThread;
-    std::shared_ptr<OutputThread> mOutputThread;
+    std::shared_ptr<RequestQueue> mRequestQueue;
+    std::vector<std::shared_ptr<OutputThread>> mOutputThreads;
 };
 
 }  // namespace implementation
@@ -23,9 +23,11 @@
 #include <jpeglib.h>
 #include <linux/videodev2.h>
 #include <log/log.h>
+#include <sys/mman.h>
 #include <algorithm>
 #include <cinttypes>
 #include <cmath>
+#include <cstdio>
 
 #define HAVE_JPEG  // required for libyuv.h to export MJPEG decode APIs
 #include <libyuv.h>
@@ -44,6 +46,7 @@ const int kDefaultNumVideoBuffer = 4;
 const int kDefaultNumStillBuffer = 2;
 const int kDefaultOrientation = 0;  // suitable for natural landscape displays like tablet/TV
                                     // For phone devices 270 is better
+const int kDefaultResultMetadataKeyframeInterval = 30;
 }  // anonymous namespace
 
 const char* ExternalCameraConfig::kDefaultCfgPath = "/vendor/etc/external_camera_config.xml";
@@ -168,6 +171,15 @@ ExternalCameraConfig ExternalCameraConfig::loadFromCfg(const char* cfgPath) {
         ret.orientation = orientation->IntAttribute("degree", /*Default*/ kDefaultOrientation);
     }
 
+    XMLElement* resultDelta = deviceCfg->FirstChildElement("ResultMetadataDelta");
+    if (resultDelta == nullptr) {
+        ALOGI("%s: result metadata delta encoding is not enabled", __FUNCTION__);
+    } else {
+        ret.resultMetadataDelta = resultDelta->BoolAttribute("enabled", false);
+        ret.resultMetadataKeyframeInterval = resultDelta->UnsignedAttribute(
+                "keyframeInterval", /*Default*/ kDefaultResultMetadataKeyframeInterval);
+    }
+
     ALOGI("%s: external camera cfg loaded: maxJpgBufSize %d,"
           " num video buffers %d, num still buffers %d, orientation %d",
           __FUNCTION__, ret.maxJpegBufSize, ret.numVideoBuffers, ret.numStillBuffers,
@@ -220,7 +232,9 @@ ExternalCameraConfig::ExternalCameraConfig()
       numVideoBuffers(kDefaultNumVideoBuffer),
       numStillBuffers(kDefaultNumStillBuffer),
       depthEnabled(false),
-      orientation(kDefaultOrientation) {
+      orientation(kDefaultOrientation),
+      resultMetadataDelta(false),
+      resultMetadataKeyframeInterval(kDefaultResultMetadataKeyframeInterval) {
     fpsLimits.push_back({/* size */ {/* width */ 640, /* height */ 480}, /* fpsUpperBound */ 30.0});
     fpsLimits.push_back({/* size */ {/* width */ 1280, /* height */ 720}, /* fpsUpperBound */ 7.5});
     fpsLimits.push_back(
@@ -290,8 +304,186 @@ int V4L2Frame::unmap() {
     return 0;
 }
 
+FrameBufferPool& FrameBufferPool::getInstance() {
+    static FrameBufferPool* sInstance = new FrameBufferPool();
+    return *sInstance;
+}
+
+size_t FrameBufferPool::getSizeClass(size_t size) {
+    if (size <= kMinSizeClass) {
+        return kMinSizeClass;
+    }
+    // Split each power of two into 4 classes so at most 25% of a buffer is wasted by rounding,
+    // e.g. a 1920x1080 YU12 frame (3,110,400 bytes) lands in the 3MiB (3,145,728 bytes) class.
+    size_t msb = sizeof(size_t) * 8 - 1 - __builtin_clzl(size - 1);
+    size_t step = static_cast<size_t>(1) << (msb - 2);
+    return (size + step - 1) & ~(step - 1);
+}
+
+uint8_t* FrameBufferPool::allocateBuffer(size_t capacity) {
+    const bool hugePage = capacity >= kHugePageSize;
+    void* ptr = nullptr;
+    int ret = posix_memalign(&ptr, hugePage ? kHugePageSize : kCacheLineSize, capacity);
+    if (ret != 0) {
+        ALOGE("%s: allocating %zu bytes failed: %s", __FUNCTION__, capacity, strerror(ret));
+        return nullptr;
+    }
+    if (hugePage) {
+        // Best effort only: THP may be disabled on this device
+        size_t hugeLen = capacity & ~(kHugePageSize - 1);
+        if (madvise(ptr, hugeLen, MADV_HUGEPAGE) != 0) {
+            ALOGV("%s: madvise(MADV_HUGEPAGE) failed: %s", __FUNCTION__, strerror(errno));
+        }
+    }
+    return static_cast<uint8_t*>(ptr);
+}
+
+FrameBufferPool::Buffer FrameBufferPool::acquire(size_t size) {
+    Buffer buf;
+    size_t capacity = getSizeClass(size);
+    {
+        std::lock_guard<std::mutex> lk(mLock);
+        auto it = mFreeBuffers.find(capacity);
+        if (it != mFreeBuffers.end() && !it->second.empty()) {
+            buf.data = it->second.back();
+            buf.capacity = capacity;
+            it->second.pop_back();
+            if (it->second.empty()) {
+                mFreeBuffers.erase(it);
+            }
+            mCachedBytes -= capacity;
+            mHits++;
+        } else {
+            mMisses++;
+        }
+    }
+
+    if (buf.data == nullptr) {
+        buf.data = allocateBuffer(capacity);
+        if (buf.data == nullptr) {
+            return {};
+        }
+        buf.capacity = capacity;
+    }
+
+    std::lock_guard<std::mutex> lk(mLock);
+    mInUseBytes += capacity;
+    mInUseCount++;
+    mPeakBytes = std::max(mPeakBytes, mInUseBytes + mCachedBytes);
+    return buf;
+}
+
+void FrameBufferPool::release(Buffer buf) {
+    if (buf.data == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mLock);
+        mInUseBytes -= buf.capacity;
+        mInUseCount--;
+        mFreeBuffers[buf.capacity].push_back(buf.data);
+        mCachedBytes += buf.capacity;
+        trimLocked(kMaxCachedBytes);
+    }
+    trimIfLowMemory();
+}
+
+void FrameBufferPool::trim(size_t maxCachedBytes) {
+    std::lock_guard<std::mutex> lk(mLock);
+    trimLocked(maxCachedBytes);
+}
+
+void FrameBufferPool::trimLocked(size_t maxCachedBytes) {
+    while (mCachedBytes > maxCachedBytes && !mFreeBuffers.empty()) {
+        auto it = std::prev(mFreeBuffers.end());
+        // Drop the least recently released buffer of the largest class first
+        free(it->second.front());
+        it->second.erase(it->second.begin());
+        mCachedBytes -= it->first;
+        mTrimmedBytes += it->first;
+        if (it->second.empty()) {
+            mFreeBuffers.erase(it);
+        }
+    }
+}
+
+bool FrameBufferPool::readMemInfo(uint64_t* totalBytes, uint64_t* availBytes) {
+    // MemAvailable counts the page cache and the other memory the kernel can reclaim, which is
+    // most of the memory of a running system while its free memory is normally very low
+    FILE* file = fopen("/proc/meminfo", "re");
+    if (file == nullptr) {
+        ALOGV("%s: cannot open /proc/meminfo: %s", __FUNCTION__, strerror(errno));
+        return false;
+    }
+    uint64_t totalKb = 0;
+    uint64_t availKb = 0;
+    bool hasTotal = false;
+    bool hasAvail = false;
+    char line[128];
+    while (!(hasTotal && hasAvail) && fgets(line, sizeof(line), file) != nullptr) {
+        if (sscanf(line, "MemTotal: %" SCNu64 " kB", &totalKb) == 1) {
+            hasTotal = true;
+        } else if (sscanf(line, "MemAvailable: %" SCNu64 " kB", &availKb) == 1) {
+            hasAvail = true;
+        }
+    }
+    fclose(file);
+    if (!hasTotal || !hasAvail) {
+        return false;
+    }
+    *totalBytes = totalKb * 1024;
+    *availBytes = availKb * 1024;
+    return true;
+}
+
+void FrameBufferPool::trimIfLowMemory() {
+    {
+        std::lock_guard<std::mutex> lk(mLock);
+        auto now = std::chrono::steady_clock::now();
+        if (mCachedBytes == 0 || now - mLastMemoryCheck < kLowMemoryCheckInterval) {
+            return;
+        }
+        mLastMemoryCheck = now;
+    }
+
+    uint64_t totalBytes = 0;
+    uint64_t availBytes = 0;
+    if (!readMemInfo(&totalBytes, &availBytes)) {
+        return;
+    }
+    bool lowMemory = availBytes * 100 < totalBytes * kLowMemoryPercent;
+    {
+        std::lock_guard<std::mutex> lk(mLock);
+        // Logged once when the system gets low on memory, not on every trim
+        if (lowMemory && !mLowMemory) {
+            ALOGI("%s: low memory (%" PRIu64 "/%" PRIu64
+                  " bytes available), dropping cached frames",
+                  __FUNCTION__, availBytes, totalBytes);
+        }
+        mLowMemory = lowMemory;
+        if (lowMemory) {
+            trimLocked(0);
+        }
+    }
+}
+
+void FrameBufferPool::dump(int fd) {
+    std::lock_guard<std::mutex> lk(mLock);
+    dprintf(fd, "Frame buffer pool: %zu buffers (%zu bytes) in use, %zu bytes cached, peak %zu\n",
+            mInUseCount, mInUseBytes, mCachedBytes, mPeakBytes);
+    dprintf(fd,
+            "Frame buffer pool: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64
+            " bytes trimmed\n",
+            mHits, mMisses, mTrimmedBytes);
+    for (const auto& [capacity, bufs] : mFreeBuffers) {
+        dprintf(fd, "  size class %zu: %zu cached\n", capacity, bufs.size());
+    }
+}
+
 AllocatedFrame::AllocatedFrame(uint32_t w, uint32_t h) : Frame(w, h, V4L2_PIX_FMT_YUV420) {}
-AllocatedFrame::~AllocatedFrame() {}
+AllocatedFrame::~AllocatedFrame() {
+    FrameBufferPool::getInstance().release(mData);
+}
 
 int AllocatedFrame::getData(uint8_t** outData, size_t* dataSize) {
     YCbCrLayout layout;
@@ -299,7 +491,7 @@ int AllocatedFrame::getData(uint8_t** outData, size_t* dataSize) {
     if (ret != 0) {
         return ret;
     }
-    *outData = mData.data();
+    *outData = mData.data;
     *dataSize = mBufferSize;
     return 0;
 }
@@ -341,15 +533,23 @@ int AllocatedFrame::allocate(YCbCrLayout* out) {
     size_t padding = requiredCbWidth - cbWidth;
     size_t finalSize = dataSize + padding;
 
-    if (mData.size() != finalSize) {
-        mData.resize(finalSize);
-        mBufferSize = dataSize;
+    if (mData.capacity < finalSize) {
+        FrameBufferPool& pool = FrameBufferPool::getInstance();
+        pool.release(mData);
+        mData = pool.acquire(finalSize);
+        if (mData.data == nullptr) {
+            ALOGE("%s: failed to allocate %zu bytes for %dx%d frame", __FUNCTION__, finalSize,
+                  mWidth, mHeight);
+            mBufferSize = 0;
+            return -ENOMEM;
+        }
     }
+    mBufferSize = dataSize;
 
     if (out != nullptr) {
-        out->y = mData.data();
+        out->y = mData.data;
         out->yStride = mWidth;
-        uint8_t* cbStart = mData.data() + mWidth * mHeight;
+        uint8_t* cbStart = mData.data + mWidth * mHeight;
         uint8_t* crStart = cbStart + mWidth * mHeight / 4;
         out->cb = cbStart;
         out->cr = crStart;
@@ -379,9 +579,9 @@ int AllocatedFrame::getCroppedLayout(const IMapper::Rect& rect, YCbCrLayout* out
         return -1;
     }
 
-    out->y = mData.data() + mWidth * rect.top + rect.left;
+    out->y = mData.data + mWidth * rect.top + rect.left;
     out->yStride = mWidth;
-    uint8_t* cbStart = mData.data() + mWidth * mHeight;
+    uint8_t* cbStart = mData.data + mWidth * mHeight;
     uint8_t* crStart = cbStart + mWidth * mHeight / 4;
     out->cb = cbStart + mWidth * rect.top / 4 + rect.left / 2;
     out->cr = crStart + mWidth * rect.top / 4 + rect.left / 2;
@@ -396,6 +596,11 @@ bool isAspectRatioClose(float ar1, float ar2) {
     return std::abs(ar1 - ar2) < kAspectRatioMatchThres;
 }
 
+HandleImporter& getSharedHandleImporter() {
+    static HandleImporter* sImporter = new HandleImporter(/*cacheMappings*/ true);
+    return *sImporter;
+}
+
 aidl::android::hardware::camera::common::Status importBufferImpl(
         /*inout*/ std::map<int, CirculatingBuffers>& circulatingBuffers,
         /*inout*/ HandleImporter& handleImporter, int32_t streamId, uint64_t bufId,
@@ -29,7 +29,9 @@
 #include <android/hardware/graphics/mapper/3.0/IMapper.h>
 #include <android/hardware/graphics/mapper/4.0/IMapper.h>
 #include <tinyxml2.h>
+#include <chrono>
 #include <map>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -107,6 +109,14 @@ struct ExternalCameraConfig {
     // The value of android.sensor.orientation
     int32_t orientation;
 
+    // Send capture result metadata as deltas against the previous result (see
+    // MetadataDeltaEncoder). Only enable this for clients that decode results with
+    // MetadataDeltaDecoder.
+    bool resultMetadataDelta;
+
+    // Number of results between two full metadata keyframes when resultMetadataDelta is enabled
+    uint32_t resultMetadataKeyframeInterval;
+
   private:
     ExternalCameraConfig();
     static bool updateFpsList(tinyxml2::XMLElement* fpsList, std::vector<FpsLimitation>& fpsLimits);
@@ -170,8 +180,68 @@ class V4L2Frame : public Frame {
     bool mMapped = false;
 };
 
+// A process-wide pool of CPU buffers backing AllocatedFrame. Requested sizes are rounded up to a
+// size class (four classes per power of two) so that buffers released on stream reconfiguration
+// or session close can be handed to the next configuration without going back to the allocator.
+// Buffers are cache line aligned; buffers of kHugePageSize or more are huge page aligned and
+// advised for transparent huge pages. Cached buffers are trimmed down to kMaxCachedBytes on
+// release, and dropped entirely when the system is low on memory.
+class FrameBufferPool {
+  public:
+    struct Buffer {
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+    };
+
+    static FrameBufferPool& getInstance();
+
+    // Returns a buffer of at least size bytes, or an empty Buffer on allocation failure.
+    Buffer acquire(size_t size);
+    // Returns a buffer obtained from acquire() back to the pool.
+    void release(Buffer buf);
+
+    // Frees cached (not in use) buffers, largest size class first, until at most maxCachedBytes
+    // remain cached.
+    void trim(size_t maxCachedBytes);
+    // Frees all cached buffers if MemAvailable is below kLowMemoryPercent of MemTotal. Memory is
+    // checked at most once per kLowMemoryCheckInterval, so this is cheap enough to call on every
+    // release.
+    void trimIfLowMemory();
+
+    void dump(int fd);
+
+    static constexpr size_t kCacheLineSize = 64;
+    static constexpr size_t kHugePageSize = 2 << 20;     // 2MB
+    static constexpr size_t kMaxCachedBytes = 96 << 20;  // 96MB
+    static constexpr size_t kMinSizeClass = 4096;
+    static constexpr unsigned kLowMemoryPercent = 10;
+    static constexpr std::chrono::milliseconds kLowMemoryCheckInterval{1000};
+
+  private:
+    FrameBufferPool() = default;
+
+    static size_t getSizeClass(size_t size);
+    static uint8_t* allocateBuffer(size_t capacity);
+    static bool readMemInfo(uint64_t* totalBytes, uint64_t* availBytes);
+    void trimLocked(size_t maxCachedBytes);
+
+    std::mutex mLock;
+    // size class -> free buffers of that class, most recently released last
+    std::map<size_t, std::vector<uint8_t*>> mFreeBuffers;
+    size_t mCachedBytes = 0;
+    size_t mInUseBytes = 0;
+    size_t mInUseCount = 0;
+    size_t mPeakBytes = 0;
+    uint64_t mHits = 0;
+    uint64_t mMisses = 0;
+    uint64_t mTrimmedBytes = 0;
+    std::chrono::steady_clock::time_point mLastMemoryCheck;
+    // Whether the last memory check found the system low on memory
+    bool mLowMemory = false;
+};
+
 // A RAII class representing a CPU allocated YUV frame used as intermediate buffers
-// when generating output images.
+// when generating output images. The backing memory is borrowed from FrameBufferPool.
 class AllocatedFrame : public Frame {
   public:
     AllocatedFrame(uint32_t w, uint32_t h);  // only support V4L2_PIX_FMT_YUV420 for now
@@ -184,9 +254,10 @@ class AllocatedFrame : public Frame {
     int getCroppedLayout(const IMapper::Rect&, YCbCrLayout* out);  // return non-zero for bad input
   private:
     std::mutex mLock;
-    std::vector<uint8_t> mData;
-    size_t mBufferSize;  // size of mData before padding. Actual size of mData might be slightly
-                         // bigger to horizontally pad the frame for jpeglib.
+    FrameBufferPool::Buffer mData;
+    size_t mBufferSize = 0;  // size of frame data before padding. Capacity of mData might be
+                             // bigger to horizontally pad the frame for jpeglib and to round
+                             // up to a FrameBufferPool size class.
 };
 
 enum CroppingType { HORIZONTAL = 0, VERTICAL = 1 };
@@ -229,6 +300,11 @@ static const uint64_t BUFFER_ID_NO_BUFFER = 0;
 // when the stream is deleted or camera device session is closed
 typedef std::unordered_map<uint64_t, buffer_handle_t> CirculatingBuffers;
 
+// HandleImporter used by both online and offline sessions. It caches buffer mappings, and
+// buffers imported by a session may be freed by the offline session it switches to, so both
+// must evict from the same cache.
+HandleImporter& getSharedHandleImporter();
+
 aidl::android::hardware::camera::common::Status importBufferImpl(
         /*inout*/ std::map<int, CirculatingBuffers>& circulatingBuffers,
         /*inout*/ HandleImporter& handleImporter, int32_t streamId, uint64_t bufId,
@@ -157,6 +157,18 @@ class Burst final : public nn::IBurst, public std::enable_shared_from_this<Burst
             nn::SharedPreparedModel preparedModel, const sp<IPreparedModel>& hidlPreparedModel,
             std::chrono::microseconds pollingTimeWindow);
 
+    /**
+     * Creates a burst controller on a prepared model.
+     *
+     * @param preparedModel Model prepared for execution to execute on.
+     * @param pollingPolicy Decides how long the Burst polls the FMQ before waiting on the blocking
+     *     futex.
+     * @return Burst Execution burst controller object.
+     */
+    static nn::GeneralResult<std::shared_ptr<const Burst>> create(
+            nn::SharedPreparedModel preparedModel, const sp<IPreparedModel>& hidlPreparedModel,
+            BurstPollingPolicy pollingPolicy);
+
     Burst(PrivateConstructorTag tag, nn::SharedPreparedModel preparedModel,
           std::unique_ptr<RequestChannelSender> requestChannelSender,
           std::unique_ptr<ResultChannelReceiver> resultChannelReceiver,
@@ -188,7 +200,17 @@ class Burst final : public nn::IBurst, public std::enable_shared_from_this<Burst
             const std::vector<FmqRequestDatum>& requestPacket,
             const hal::utils::RequestRelocation& relocation, FallbackFunction fallback) const;
 
+    // Same as above, but serializes the request straight into the request channel.
+    nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> executeInternal(
+            const V1_0::Request& request, MeasureTiming measure, const std::vector<int32_t>& slots,
+            const hal::utils::RequestRelocation& relocation, FallbackFunction fallback) const;
+
   private:
+    template <typename SendRequest>
+    nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> executeInternal(
+            const SendRequest& sendRequest, const hal::utils::RequestRelocation& relocation,
+            FallbackFunction fallback) const;
+
     mutable std::atomic_flag mExecutionInFlight = ATOMIC_FLAG_INIT;
     const nn::SharedPreparedModel kPreparedModel;
     const std::unique_ptr<RequestChannelSender> mRequestChannelSender;
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_1_2_UTILS_BURST_POLLING_POLICY_H
+#define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_1_2_UTILS_BURST_POLLING_POLICY_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace android::hardware::neuralnetworks::V1_2::utils {
+
+/**
+ * Decides how long a burst channel receiver polls the FMQ before waiting on the futex.
+ *
+ * A fixed policy polls for the same time window on every wait. An adaptive policy learns how long
+ * the packets take to arrive, which is the execution duration on the controller side and the time
+ * between requests on the server side, and polls only when the next packet is predicted to arrive
+ * within its budget. The prediction is the smoothed wait time plus twice its mean deviation, as TCP
+ * estimates round-trip times. When it is over budget, one wait in kProbeInterval still polls for
+ * the whole budget, as the wait times measured through the futex include its wakeup latency and
+ * would otherwise keep the prediction over budget.
+ *
+ * A policy is used by the thread receiving on the channel only.
+ */
+class BurstPollingPolicy final {
+  public:
+    struct Stats {
+        uint64_t waits;
+        // Waits which polled the FMQ, and those of them which got the packet while polling
+        uint64_t polls;
+        uint64_t hits;
+        std::chrono::nanoseconds spinTime;
+        // Spin time of the polls which waited on the futex afterwards
+        std::chrono::nanoseconds wastedSpinTime;
+    };
+
+    static constexpr std::chrono::microseconds kDefaultBudget{100};
+    static constexpr uint64_t kProbeInterval = 16;
+
+    static BurstPollingPolicy fixed(std::chrono::microseconds pollingTimeWindow);
+    static BurstPollingPolicy adaptive(std::chrono::microseconds budget = kDefaultBudget);
+
+    /**
+     * Called when a wait starts.
+     *
+     * @return How long to poll the FMQ before waiting on the futex, zero to not poll.
+     */
+    std::chrono::nanoseconds getPollingTimeWindow();
+
+    /**
+     * Called when a wait ends with a packet.
+     *
+     * @param waitTime Time from the start of the wait to the packet.
+     * @param spinTime Time spent polling.
+     * @param isHit Whether the packet was got while polling.
+     */
+    void recordWait(std::chrono::nanoseconds waitTime, std::chrono::nanoseconds spinTime,
+                    bool isHit);
+
+    const Stats& getStats() const { return mStats; }
+
+  private:
+    BurstPollingPolicy(bool isAdaptive, std::chrono::nanoseconds pollingTimeWindow);
+
+    const bool kIsAdaptive;
+    // The fixed window, or the budget of an adaptive policy
+    const std::chrono::nanoseconds kPollingTimeWindow;
+
+    bool mHasEstimate = false;
+    std::chrono::nanoseconds mMeanWaitTime{0};
+    std::chrono::nanoseconds mWaitTimeDeviation{0};
+    uint64_t mWaitsSinceProbe = 0;
+    Stats mStats = {};
+};
+
+}  // namespace android::hardware::neuralnetworks::V1_2::utils
+
+#endif  // ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_1_2_UTILS_BURST_POLLING_POLICY_H
@@ -17,8 +17,11 @@
 #ifndef ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_1_2_UTILS_BURST_UTILS_H
 #define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_1_2_UTILS_BURST_UTILS_H
 
+#include "nnapi/hal/1.2/BurstPollingPolicy.h"
+
 #include <android/hardware/neuralnetworks/1.0/types.h>
 #include <android/hardware/neuralnetworks/1.2/types.h>
+#include <fmq/EventFlag.h>
 #include <fmq/MessageQueue.h>
 #include <hidl/MQDescriptor.h>
 #include <nnapi/Result.h>
@@ -28,6 +31,7 @@
 #include <atomic>
 #include <chrono>
 #include <memory>
+#include <span>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -57,6 +61,22 @@ std::chrono::microseconds getBurstControllerPollingTimeWindow();
  */
 std::chrono::microseconds getBurstServerPollingTimeWindow();
 
+/**
+ * Get the polling policy of the burst controller while waiting for results to be returned.
+ *
+ * This is an adaptive policy, unless the property "debug.nn.burst-controller-polling-window" sets
+ * a fixed polling time window.
+ */
+BurstPollingPolicy getBurstControllerPollingPolicy();
+
+/**
+ * Get the polling policy of the burst server while waiting for a request to be received.
+ *
+ * This is an adaptive policy, unless the property "debug.nn.burst-server-polling-window" sets a
+ * fixed polling time window.
+ */
+BurstPollingPolicy getBurstServerPollingPolicy();
+
 /**
  * Function to serialize a request.
  *
@@ -79,7 +99,7 @@ std::vector<FmqRequestDatum> serialize(const V1_0::Request& request, MeasureTimi
  * @return Request object if successfully deserialized, otherwise an error message.
  */
 nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, MeasureTiming>> deserialize(
-        const std::vector<FmqRequestDatum>& data);
+        std::span<const FmqRequestDatum> data);
 
 /**
  * Function to serialize results.
@@ -102,7 +122,7 @@ std::vector<FmqResultDatum> serialize(V1_0::ErrorStatus errorStatus,
  * @return Result object if successfully deserialized, otherwise an error message.
  */
 nn::Result<std::tuple<V1_0::ErrorStatus, std::vector<OutputShape>, Timing>> deserialize(
-        const std::vector<FmqResultDatum>& data);
+        std::span<const FmqResultDatum> data);
 
 /**
  * RequestChannelSender is responsible for serializing the result packet of information, sending it
@@ -126,6 +146,8 @@ class RequestChannelSender final : public neuralnetworks::utils::IProtectedCallb
     /**
      * Send the request to the channel.
      *
+     * The request is serialized straight into the FMQ, without an intermediate packet.
+     *
      * @param request Request object without the pool information.
      * @param measure Whether to collect timing information for the execution.
      * @param slots Slot identifiers corresponding to memory resources for the request.
@@ -144,9 +166,12 @@ class RequestChannelSender final : public neuralnetworks::utils::IProtectedCallb
     nn::Result<void> sendPacket(const std::vector<FmqRequestDatum>& packet);
 
     RequestChannelSender(PrivateConstructorTag tag, size_t channelLength);
+    ~RequestChannelSender();
 
   private:
     MessageQueue<FmqRequestDatum, kSynchronizedReadWrite> mFmqRequestChannel;
+    // Signals the futex after a packet is serialized into the FMQ
+    EventFlag* mEventFlag = nullptr;
     std::atomic<bool> mValid{true};
 };
 
@@ -174,6 +199,18 @@ class RequestChannelReceiver final {
             const MQDescriptorSync<FmqRequestDatum>& requestChannel,
             std::chrono::microseconds pollingTimeWindow);
 
+    /**
+     * Create the receiving end of a request channel.
+     *
+     * @param requestChannel Descriptor for the request channel.
+     * @param pollingPolicy Decides how long the RequestChannelReceiver polls the FMQ before
+     *     waiting on the blocking futex.
+     * @return RequestChannelReceiver on successful creation, nullptr otherwise.
+     */
+    static nn::GeneralResult<std::unique_ptr<RequestChannelReceiver>> create(
+            const MQDescriptorSync<FmqRequestDatum>& requestChannel,
+            BurstPollingPolicy pollingPolicy);
+
     /**
      * Get the request from the channel.
      *
@@ -192,16 +229,22 @@ class RequestChannelReceiver final {
      */
     void invalidate();
 
+    // Must not be called while a call to RequestChannelReceiver::getBlocking is in progress.
+    BurstPollingPolicy::Stats getPollingStats() const;
+
     RequestChannelReceiver(PrivateConstructorTag tag,
                            const MQDescriptorSync<FmqRequestDatum>& requestChannel,
-                           std::chrono::microseconds pollingTimeWindow);
+                           BurstPollingPolicy pollingPolicy);
 
   private:
-    nn::Result<std::vector<FmqRequestDatum>> getPacketBlocking();
+    // The packet is valid until the next call
+    nn::Result<std::span<const FmqRequestDatum>> getPacketBlocking();
 
     MessageQueue<FmqRequestDatum, kSynchronizedReadWrite> mFmqRequestChannel;
     std::atomic<bool> mTeardown{false};
-    const std::chrono::microseconds kPollingTimeWindow;
+    BurstPollingPolicy mPollingPolicy;
+    // Received packets are read into this buffer, which grows to the largest packet
+    std::vector<FmqRequestDatum> mPacketArena;
 };
 
 /**
@@ -224,6 +267,8 @@ class ResultChannelSender final {
     /**
      * Send the result to the channel.
      *
+     * The result is serialized straight into the FMQ, without an intermediate packet.
+     *
      * @param errorStatus Status of the execution.
      * @param outputShapes Dynamic shapes of the output tensors.
      * @param timing Timing information of the execution.
@@ -236,9 +281,12 @@ class ResultChannelSender final {
 
     ResultChannelSender(PrivateConstructorTag tag,
                         const MQDescriptorSync<FmqResultDatum>& resultChannel);
+    ~ResultChannelSender();
 
   private:
     MessageQueue<FmqResultDatum, kSynchronizedReadWrite> mFmqResultChannel;
+    // Signals the futex after a packet is serialized into the FMQ
+    EventFlag* mEventFlag = nullptr;
 };
 
 /**
@@ -266,6 +314,19 @@ class ResultChannelReceiver final : public neuralnetworks::utils::IProtectedCall
                                        const MQDescriptorSync<FmqResultDatum>*>>
     create(size_t channelLength, std::chrono::microseconds pollingTimeWindow);
 
+    /**
+     * Create the receiving end of a result channel.
+     *
+     * @param channelLength Number of elements in the FMQ.
+     * @param pollingPolicy Decides how long the ResultChannelReceiver polls the FMQ before waiting
+     *     on the blocking futex.
+     * @return A pair of ResultChannelReceiver and the FMQ descriptor on successful creation, or
+     *     GeneralError otherwise.
+     */
+    static nn::GeneralResult<std::pair<std::unique_ptr<ResultChannelReceiver>,
+                                       const MQDescriptorSync<FmqResultDatum>*>>
+    create(size_t channelLength, BurstPollingPolicy pollingPolicy);
+
     /**
      * Get the result from the channel.
      *
@@ -287,13 +348,21 @@ class ResultChannelReceiver final : public neuralnetworks::utils::IProtectedCall
     // prefer calling ResultChannelReceiver::getBlocking
     nn::Result<std::vector<FmqResultDatum>> getPacketBlocking();
 
+    // Must not be called while a call to ResultChannelReceiver::getBlocking is in progress.
+    BurstPollingPolicy::Stats getPollingStats() const;
+
     ResultChannelReceiver(PrivateConstructorTag tag, size_t channelLength,
-                          std::chrono::microseconds pollingTimeWindow);
+                          BurstPollingPolicy pollingPolicy);
 
   private:
+    // The packet is valid until the next call
+    nn::Result<std::span<const FmqResultDatum>> receivePacketBlocking();
+
     MessageQueue<FmqResultDatum, kSynchronizedReadWrite> mFmqResultChannel;
     std::atomic<bool> mValid{true};
-    const std::chrono::microseconds kPollingTimeWindow;
+    BurstPollingPolicy mPollingPolicy;
+    // Received packets are read into this buffer, which grows to the largest packet
+    std::vector<FmqResultDatum> mPacketArena;
 };
 
 }  // namespace android::hardware::neuralnetworks::V1_2::utils
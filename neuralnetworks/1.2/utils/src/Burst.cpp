@@ -240,6 +240,13 @@ Return<void> Burst::ExecutionBurstCallback::getMemories(const hidl_vec<int32_t>&
 nn::GeneralResult<std::shared_ptr<const Burst>> Burst::create(
         nn::SharedPreparedModel preparedModel, const sp<V1_2::IPreparedModel>& hidlPreparedModel,
         std::chrono::microseconds pollingTimeWindow) {
+    return create(std::move(preparedModel), hidlPreparedModel,
+                  BurstPollingPolicy::fixed(pollingTimeWindow));
+}
+
+nn::GeneralResult<std::shared_ptr<const Burst>> Burst::create(
+        nn::SharedPreparedModel preparedModel, const sp<V1_2::IPreparedModel>& hidlPreparedModel,
+        BurstPollingPolicy pollingPolicy) {
     // check inputs
     if (preparedModel == nullptr || hidlPreparedModel == nullptr) {
         return NN_ERROR() << "Burst::create passed a nullptr";
@@ -249,7 +256,7 @@ nn::GeneralResult<std::shared_ptr<const Burst>> Burst::create(
     auto [requestChannelSender, requestChannelDescriptor] =
             NN_TRY(RequestChannelSender::create(kExecutionBurstChannelLength));
     auto [resultChannelReceiver, resultChannelDescriptor] =
-            NN_TRY(ResultChannelReceiver::create(kExecutionBurstChannelLength, pollingTimeWindow));
+            NN_TRY(ResultChannelReceiver::create(kExecutionBurstChannelLength, pollingPolicy));
 
     // check FMQ objects
     CHECK(requestChannelSender != nullptr);
@@ -345,11 +352,10 @@ nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> Burst::
     }
 
     // send request packet
-    const auto requestPacket = serialize(hidlRequest, hidlMeasure, slots);
     const auto fallback = [this, &request, measure, &deadline, &loopTimeoutDuration] {
         return kPreparedModel->execute(request, measure, deadline, loopTimeoutDuration, {}, {});
     };
-    return executeInternal(requestPacket, relocation, fallback);
+    return executeInternal(hidlRequest, hidlMeasure, slots, relocation, fallback);
 }
 
 // See IBurst::createReusableExecution for information on this method.
@@ -399,6 +405,25 @@ nn::GeneralResult<nn::SharedExecution> Burst::createReusableExecution(
 nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> Burst::executeInternal(
         const std::vector<FmqRequestDatum>& requestPacket,
         const hal::utils::RequestRelocation& relocation, FallbackFunction fallback) const {
+    return executeInternal(
+            [this, &requestPacket] { return mRequestChannelSender->sendPacket(requestPacket); },
+            relocation, std::move(fallback));
+}
+
+nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> Burst::executeInternal(
+        const V1_0::Request& request, MeasureTiming measure, const std::vector<int32_t>& slots,
+        const hal::utils::RequestRelocation& relocation, FallbackFunction fallback) const {
+    return executeInternal(
+            [this, &request, measure, &slots] {
+                return mRequestChannelSender->send(request, measure, slots);
+            },
+            relocation, std::move(fallback));
+}
+
+template <typename SendRequest>
+nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> Burst::executeInternal(
+        const SendRequest& sendRequest, const hal::utils::RequestRelocation& relocation,
+        FallbackFunction fallback) const {
     NNTRACE_FULL(NNTRACE_LAYER_IPC, NNTRACE_PHASE_EXECUTION, "Burst::executeInternal");
 
     // Ensure that at most one execution is in flight at any given time.
@@ -413,7 +438,7 @@ nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> Burst::
     }
 
     // send request packet
-    const auto sendStatus = mRequestChannelSender->sendPacket(requestPacket);
+    const auto sendStatus = sendRequest();
     if (!sendStatus.ok()) {
         // fallback to another execution path if the packet could not be sent
         if (fallback) {
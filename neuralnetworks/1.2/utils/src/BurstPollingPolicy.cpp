@@ -0,0 +1,77 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BurstPollingPolicy.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace android::hardware::neuralnetworks::V1_2::utils {
+
+BurstPollingPolicy BurstPollingPolicy::fixed(std::chrono::microseconds pollingTimeWindow) {
+    return BurstPollingPolicy(/*isAdaptive=*/false, pollingTimeWindow);
+}
+
+BurstPollingPolicy BurstPollingPolicy::adaptive(std::chrono::microseconds budget) {
+    return BurstPollingPolicy(/*isAdaptive=*/true, budget);
+}
+
+BurstPollingPolicy::BurstPollingPolicy(bool isAdaptive, std::chrono::nanoseconds pollingTimeWindow)
+    : kIsAdaptive(isAdaptive), kPollingTimeWindow(pollingTimeWindow) {}
+
+std::chrono::nanoseconds BurstPollingPolicy::getPollingTimeWindow() {
+    // Without an estimate yet, the first wait polls to get one
+    if (!kIsAdaptive || !mHasEstimate) {
+        return kPollingTimeWindow;
+    }
+
+    if (mMeanWaitTime + 2 * mWaitTimeDeviation <= kPollingTimeWindow) {
+        mWaitsSinceProbe = 0;
+        // Long enough for the slower packets, so that few polls end up on the futex anyway
+        return std::min(kPollingTimeWindow, mMeanWaitTime + 4 * mWaitTimeDeviation);
+    }
+    if (++mWaitsSinceProbe >= kProbeInterval) {
+        mWaitsSinceProbe = 0;
+        return kPollingTimeWindow;
+    }
+    return std::chrono::nanoseconds{0};
+}
+
+void BurstPollingPolicy::recordWait(std::chrono::nanoseconds waitTime,
+                                    std::chrono::nanoseconds spinTime, bool isHit) {
+    ++mStats.waits;
+    if (isHit || spinTime.count() > 0) {
+        ++mStats.polls;
+    }
+    if (isHit) {
+        ++mStats.hits;
+    } else {
+        mStats.wastedSpinTime += spinTime;
+    }
+    mStats.spinTime += spinTime;
+
+    if (!mHasEstimate) {
+        mMeanWaitTime = waitTime;
+        mWaitTimeDeviation = waitTime / 2;
+        mHasEstimate = true;
+        return;
+    }
+    const auto error = waitTime - mMeanWaitTime;
+    mMeanWaitTime += error / 8;
+    mWaitTimeDeviation += (std::chrono::abs(error) - mWaitTimeDeviation) / 4;
+}
+
+}  // namespace android::hardware::neuralnetworks::V1_2::utils
@@ -16,11 +16,14 @@
 
 #include "BurstUtils.h"
 
+#include "BurstPollingPolicy.h"
+
 #include <android-base/logging.h>
 #include <android-base/properties.h>
 #include <android/hardware/neuralnetworks/1.0/types.h>
 #include <android/hardware/neuralnetworks/1.1/types.h>
 #include <android/hardware/neuralnetworks/1.2/types.h>
+#include <fmq/EventFlag.h>
 #include <fmq/MessageQueue.h>
 #include <hidl/MQDescriptor.h>
 #include <nnapi/Result.h>
@@ -29,7 +32,10 @@
 
 #include <atomic>
 #include <chrono>
+#include <limits>
 #include <memory>
+#include <new>
+#include <span>
 #include <thread>
 #include <tuple>
 #include <utility>
@@ -54,6 +60,15 @@ std::chrono::microseconds getPollingTimeWindow(const std::string& property) {
 #endif  // NN_DEBUGGABLE
 }
 
+BurstPollingPolicy getPollingPolicy(const std::string& property) {
+    // A polling time window set for debugging replaces the adaptive policy
+    const auto pollingTimeWindow = getPollingTimeWindow(property);
+    if (pollingTimeWindow.count() > 0) {
+        return BurstPollingPolicy::fixed(pollingTimeWindow);
+    }
+    return BurstPollingPolicy::adaptive();
+}
+
 }  // namespace
 
 std::chrono::microseconds getBurstControllerPollingTimeWindow() {
@@ -64,10 +79,21 @@ std::chrono::microseconds getBurstServerPollingTimeWindow() {
     return getPollingTimeWindow("debug.nn.burst-server-polling-window");
 }
 
-// serialize a request into a packet
-std::vector<FmqRequestDatum> serialize(const V1_0::Request& request, V1_2::MeasureTiming measure,
-                                       const std::vector<int32_t>& slots) {
-    // count how many elements need to be sent for a request
+BurstPollingPolicy getBurstControllerPollingPolicy() {
+    return getPollingPolicy("debug.nn.burst-controller-polling-window");
+}
+
+BurstPollingPolicy getBurstServerPollingPolicy() {
+    return getPollingPolicy("debug.nn.burst-server-polling-window");
+}
+
+namespace {
+
+// The EventFlag bit which FMQ's writeBlocking sets and its readBlocking waits on by default
+constexpr uint32_t kFmqNotEmpty = 1 << 0;
+
+// count how many elements need to be sent for a request
+size_t getPacketSize(const V1_0::Request& request, const std::vector<int32_t>& slots) {
     size_t count = 2 + request.inputs.size() + request.outputs.size() + slots.size();
     for (const auto& input : request.inputs) {
         count += input.dimensions.size();
@@ -76,14 +102,24 @@ std::vector<FmqRequestDatum> serialize(const V1_0::Request& request, V1_2::Measu
         count += output.dimensions.size();
     }
     CHECK_LE(count, std::numeric_limits<uint32_t>::max());
+    return count;
+}
 
-    // create buffer to temporarily store elements
-    std::vector<FmqRequestDatum> data;
-    data.reserve(count);
+// count how many elements need to be sent for a result
+size_t getPacketSize(const std::vector<V1_2::OutputShape>& outputShapes) {
+    size_t count = 2 + outputShapes.size();
+    for (const auto& outputShape : outputShapes) {
+        count += outputShape.dimensions.size();
+    }
+    return count;
+}
 
+// serialize a request into the `count` elements returned in order by `nextDatum`
+template <typename NextDatum>
+void serializeTo(const V1_0::Request& request, V1_2::MeasureTiming measure,
+                 const std::vector<int32_t>& slots, size_t count, NextDatum nextDatum) {
     // package packetInfo
-    data.emplace_back();
-    data.back().packetInformation(
+    nextDatum().packetInformation(
             {.packetSize = static_cast<uint32_t>(count),
              .numberOfInputOperands = static_cast<uint32_t>(request.inputs.size()),
              .numberOfOutputOperands = static_cast<uint32_t>(request.outputs.size()),
@@ -92,89 +128,128 @@ std::vector<FmqRequestDatum> serialize(const V1_0::Request& request, V1_2::Measu
     // package input data
     for (const auto& input : request.inputs) {
         // package operand information
-        data.emplace_back();
-        data.back().inputOperandInformation(
+        nextDatum().inputOperandInformation(
                 {.hasNoValue = input.hasNoValue,
                  .location = input.location,
                  .numberOfDimensions = static_cast<uint32_t>(input.dimensions.size())});
 
         // package operand dimensions
         for (uint32_t dimension : input.dimensions) {
-            data.emplace_back();
-            data.back().inputOperandDimensionValue(dimension);
+            nextDatum().inputOperandDimensionValue(dimension);
         }
     }
 
     // package output data
     for (const auto& output : request.outputs) {
         // package operand information
-        data.emplace_back();
-        data.back().outputOperandInformation(
+        nextDatum().outputOperandInformation(
                 {.hasNoValue = output.hasNoValue,
                  .location = output.location,
                  .numberOfDimensions = static_cast<uint32_t>(output.dimensions.size())});
 
         // package operand dimensions
         for (uint32_t dimension : output.dimensions) {
-            data.emplace_back();
-            data.back().outputOperandDimensionValue(dimension);
+            nextDatum().outputOperandDimensionValue(dimension);
         }
     }
 
     // package pool identifier
     for (int32_t slot : slots) {
-        data.emplace_back();
-        data.back().poolIdentifier(slot);
+        nextDatum().poolIdentifier(slot);
     }
 
     // package measureTiming
-    data.emplace_back();
-    data.back().measureTiming(measure);
-
-    CHECK_EQ(data.size(), count);
-
-    // return packet
-    return data;
+    nextDatum().measureTiming(measure);
 }
 
-// serialize result
-std::vector<FmqResultDatum> serialize(V1_0::ErrorStatus errorStatus,
-                                      const std::vector<V1_2::OutputShape>& outputShapes,
-                                      V1_2::Timing timing) {
-    // count how many elements need to be sent for a request
-    size_t count = 2 + outputShapes.size();
-    for (const auto& outputShape : outputShapes) {
-        count += outputShape.dimensions.size();
-    }
-
-    // create buffer to temporarily store elements
-    std::vector<FmqResultDatum> data;
-    data.reserve(count);
-
+// serialize a result into the `count` elements returned in order by `nextDatum`
+template <typename NextDatum>
+void serializeTo(V1_0::ErrorStatus errorStatus, const std::vector<V1_2::OutputShape>& outputShapes,
+                 V1_2::Timing timing, size_t count, NextDatum nextDatum) {
     // package packetInfo
-    data.emplace_back();
-    data.back().packetInformation({.packetSize = static_cast<uint32_t>(count),
+    nextDatum().packetInformation({.packetSize = static_cast<uint32_t>(count),
                                    .errorStatus = errorStatus,
                                    .numberOfOperands = static_cast<uint32_t>(outputShapes.size())});
 
     // package output shape data
     for (const auto& operand : outputShapes) {
         // package operand information
-        data.emplace_back();
-        data.back().operandInformation(
+        nextDatum().operandInformation(
                 {.isSufficient = operand.isSufficient,
                  .numberOfDimensions = static_cast<uint32_t>(operand.dimensions.size())});
 
         // package operand dimensions
         for (uint32_t dimension : operand.dimensions) {
-            data.emplace_back();
-            data.back().operandDimensionValue(dimension);
+            nextDatum().operandDimensionValue(dimension);
         }
     }
 
     // package executionTiming
-    data.emplace_back();
-    data.back().executionTiming(timing);
+    nextDatum().executionTiming(timing);
+}
+
+// Serializes a packet of `count` elements straight into the FMQ, then signals the futex as
+// writeBlocking would. `fill` is called with the function returning the next element.
+template <typename Datum, typename Fill>
+bool writeInPlace(MessageQueue<Datum, kSynchronizedReadWrite>* channel, EventFlag* eventFlag,
+                  size_t count, const Fill& fill) {
+    typename MessageQueue<Datum, kSynchronizedReadWrite>::MemTransaction tx;
+    if (!channel->beginWrite(count, &tx)) {
+        return false;
+    }
+
+    // The elements are constructed in the FMQ slots, which may wrap around the end of the ring
+    size_t index = 0;
+    fill([&tx, &index]() -> Datum& { return *new (tx.getSlot(index++)) Datum(); });
+    CHECK_EQ(index, count);
+
+    if (!channel->commitWrite(count)) {
+        return false;
+    }
+    eventFlag->wake(kFmqNotEmpty);
+    return true;
+}
+
+// Returns the first `count` elements of the arena of a receiver, growing it if needed. The arena
+// is never shrunk, so that receiving a packet does not allocate once the largest one was received.
+template <typename Datum>
+std::span<Datum> getArena(std::vector<Datum>* arena, size_t count) {
+    if (arena->size() < count) {
+        arena->resize(count);
+    }
+    return std::span(arena->data(), count);
+}
+
+}  // namespace
+
+// serialize a request into a packet
+std::vector<FmqRequestDatum> serialize(const V1_0::Request& request, V1_2::MeasureTiming measure,
+                                       const std::vector<int32_t>& slots) {
+    const size_t count = getPacketSize(request, slots);
+
+    // create buffer to temporarily store elements
+    std::vector<FmqRequestDatum> data;
+    data.reserve(count);
+    serializeTo(request, measure, slots, count,
+                [&data]() -> FmqRequestDatum& { return data.emplace_back(); });
+
+    CHECK_EQ(data.size(), count);
+
+    // return packet
+    return data;
+}
+
+// serialize result
+std::vector<FmqResultDatum> serialize(V1_0::ErrorStatus errorStatus,
+                                      const std::vector<V1_2::OutputShape>& outputShapes,
+                                      V1_2::Timing timing) {
+    const size_t count = getPacketSize(outputShapes);
+
+    // create buffer to temporarily store elements
+    std::vector<FmqResultDatum> data;
+    data.reserve(count);
+    serializeTo(errorStatus, outputShapes, timing, count,
+                [&data]() -> FmqResultDatum& { return data.emplace_back(); });
 
     CHECK_EQ(data.size(), count);
 
@@ -184,19 +259,19 @@ std::vector<FmqResultDatum> serialize(V1_0::ErrorStatus errorStatus,
 
 // deserialize request
 nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>> deserialize(
-        const std::vector<FmqRequestDatum>& data) {
+        std::span<const FmqRequestDatum> data) {
     using discriminator = FmqRequestDatum::hidl_discriminator;
 
     size_t index = 0;
 
     // validate packet information
     if (index >= data.size() ||
-        data.at(index).getDiscriminator() != discriminator::packetInformation) {
+        data[index].getDiscriminator() != discriminator::packetInformation) {
         return NN_ERROR() << "FMQ Request packet ill-formed";
     }
 
     // unpackage packet information
-    const FmqRequestDatum::PacketInformation& packetInfo = data.at(index).packetInformation();
+    const FmqRequestDatum::PacketInformation& packetInfo = data[index].packetInformation();
     index++;
     const uint32_t packetSize = packetInfo.packetSize;
     const uint32_t numberOfInputOperands = packetInfo.numberOfInputOperands;
@@ -214,13 +289,13 @@ nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>>
     for (size_t operand = 0; operand < numberOfInputOperands; ++operand) {
         // validate input operand information
         if (index >= data.size() ||
-            data.at(index).getDiscriminator() != discriminator::inputOperandInformation) {
+            data[index].getDiscriminator() != discriminator::inputOperandInformation) {
             return NN_ERROR() << "FMQ Request packet ill-formed";
         }
 
         // unpackage operand information
         const FmqRequestDatum::OperandInformation& operandInfo =
-                data.at(index).inputOperandInformation();
+                data[index].inputOperandInformation();
         index++;
         const bool hasNoValue = operandInfo.hasNoValue;
         const V1_0::DataLocation location = operandInfo.location;
@@ -232,12 +307,12 @@ nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>>
         for (size_t i = 0; i < numberOfDimensions; ++i) {
             // validate dimension
             if (index >= data.size() ||
-                data.at(index).getDiscriminator() != discriminator::inputOperandDimensionValue) {
+                data[index].getDiscriminator() != discriminator::inputOperandDimensionValue) {
                 return NN_ERROR() << "FMQ Request packet ill-formed";
             }
 
             // unpackage dimension
-            const uint32_t dimension = data.at(index).inputOperandDimensionValue();
+            const uint32_t dimension = data[index].inputOperandDimensionValue();
             index++;
 
             // store result
@@ -255,13 +330,13 @@ nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>>
     for (size_t operand = 0; operand < numberOfOutputOperands; ++operand) {
         // validate output operand information
         if (index >= data.size() ||
-            data.at(index).getDiscriminator() != discriminator::outputOperandInformation) {
+            data[index].getDiscriminator() != discriminator::outputOperandInformation) {
             return NN_ERROR() << "FMQ Request packet ill-formed";
         }
 
         // unpackage operand information
         const FmqRequestDatum::OperandInformation& operandInfo =
-                data.at(index).outputOperandInformation();
+                data[index].outputOperandInformation();
         index++;
         const bool hasNoValue = operandInfo.hasNoValue;
         const V1_0::DataLocation location = operandInfo.location;
@@ -273,12 +348,12 @@ nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>>
         for (size_t i = 0; i < numberOfDimensions; ++i) {
             // validate dimension
             if (index >= data.size() ||
-                data.at(index).getDiscriminator() != discriminator::outputOperandDimensionValue) {
+                data[index].getDiscriminator() != discriminator::outputOperandDimensionValue) {
                 return NN_ERROR() << "FMQ Request packet ill-formed";
             }
 
             // unpackage dimension
-            const uint32_t dimension = data.at(index).outputOperandDimensionValue();
+            const uint32_t dimension = data[index].outputOperandDimensionValue();
             index++;
 
             // store result
@@ -296,12 +371,12 @@ nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>>
     for (size_t pool = 0; pool < numberOfPools; ++pool) {
         // validate input operand information
         if (index >= data.size() ||
-            data.at(index).getDiscriminator() != discriminator::poolIdentifier) {
+            data[index].getDiscriminator() != discriminator::poolIdentifier) {
             return NN_ERROR() << "FMQ Request packet ill-formed";
         }
 
         // unpackage operand information
-        const int32_t poolId = data.at(index).poolIdentifier();
+        const int32_t poolId = data[index].poolIdentifier();
         index++;
 
         // store result
@@ -309,12 +384,12 @@ nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>>
     }
 
     // validate measureTiming
-    if (index >= data.size() || data.at(index).getDiscriminator() != discriminator::measureTiming) {
+    if (index >= data.size() || data[index].getDiscriminator() != discriminator::measureTiming) {
         return NN_ERROR() << "FMQ Request packet ill-formed";
     }
 
     // unpackage measureTiming
-    const V1_2::MeasureTiming measure = data.at(index).measureTiming();
+    const V1_2::MeasureTiming measure = data[index].measureTiming();
     index++;
 
     // validate packet information
@@ -329,18 +404,18 @@ nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>>
 
 // deserialize a packet into the result
 nn::Result<std::tuple<V1_0::ErrorStatus, std::vector<V1_2::OutputShape>, V1_2::Timing>> deserialize(
-        const std::vector<FmqResultDatum>& data) {
+        std::span<const FmqResultDatum> data) {
     using discriminator = FmqResultDatum::hidl_discriminator;
     size_t index = 0;
 
     // validate packet information
     if (index >= data.size() ||
-        data.at(index).getDiscriminator() != discriminator::packetInformation) {
+        data[index].getDiscriminator() != discriminator::packetInformation) {
         return NN_ERROR() << "FMQ Result packet ill-formed";
     }
 
     // unpackage packet information
-    const FmqResultDatum::PacketInformation& packetInfo = data.at(index).packetInformation();
+    const FmqResultDatum::PacketInformation& packetInfo = data[index].packetInformation();
     index++;
     const uint32_t packetSize = packetInfo.packetSize;
     const V1_0::ErrorStatus errorStatus = packetInfo.errorStatus;
@@ -357,12 +432,12 @@ nn::Result<std::tuple<V1_0::ErrorStatus, std::vector<V1_2::OutputShape>, V1_2::T
     for (size_t operand = 0; operand < numberOfOperands; ++operand) {
         // validate operand information
         if (index >= data.size() ||
-            data.at(index).getDiscriminator() != discriminator::operandInformation) {
+            data[index].getDiscriminator() != discriminator::operandInformation) {
             return NN_ERROR() << "FMQ Result packet ill-formed";
         }
 
         // unpackage operand information
-        const FmqResultDatum::OperandInformation& operandInfo = data.at(index).operandInformation();
+        const FmqResultDatum::OperandInformation& operandInfo = data[index].operandInformation();
         index++;
         const bool isSufficient = operandInfo.isSufficient;
         const uint32_t numberOfDimensions = operandInfo.numberOfDimensions;
@@ -373,12 +448,12 @@ nn::Result<std::tuple<V1_0::ErrorStatus, std::vector<V1_2::OutputShape>, V1_2::T
         for (size_t i = 0; i < numberOfDimensions; ++i) {
             // validate dimension
             if (index >= data.size() ||
-                data.at(index).getDiscriminator() != discriminator::operandDimensionValue) {
+                data[index].getDiscriminator() != discriminator::operandDimensionValue) {
                 return NN_ERROR() << "FMQ Result packet ill-formed";
             }
 
             // unpackage dimension
-            const uint32_t dimension = data.at(index).operandDimensionValue();
+            const uint32_t dimension = data[index].operandDimensionValue();
             index++;
 
             // store result
@@ -390,13 +465,12 @@ nn::Result<std::tuple<V1_0::ErrorStatus, std::vector<V1_2::OutputShape>, V1_2::T
     }
 
     // validate execution timing
-    if (index >= data.size() ||
-        data.at(index).getDiscriminator() != discriminator::executionTiming) {
+    if (index >= data.size() || data[index].getDiscriminator() != discriminator::executionTiming) {
         return NN_ERROR() << "FMQ Result packet ill-formed";
     }
 
     // unpackage execution timing
-    const V1_2::Timing timing = data.at(index).executionTiming();
+    const V1_2::Timing timing = data[index].executionTiming();
     index++;
 
     // validate packet information
@@ -418,6 +492,10 @@ RequestChannelSender::create(size_t channelLength) {
     if (!requestChannelSender->mFmqRequestChannel.isValid()) {
         return NN_ERROR() << "Unable to create RequestChannelSender";
     }
+    if (EventFlag::createEventFlag(requestChannelSender->mFmqRequestChannel.getEventFlagWord(),
+                                   &requestChannelSender->mEventFlag) != OK) {
+        return NN_ERROR() << "Unable to create the EventFlag of RequestChannelSender";
+    }
 
     const MQDescriptorSync<FmqRequestDatum>* descriptor =
             requestChannelSender->mFmqRequestChannel.getDesc();
@@ -427,11 +505,34 @@ RequestChannelSender::create(size_t channelLength) {
 RequestChannelSender::RequestChannelSender(PrivateConstructorTag /*tag*/, size_t channelLength)
     : mFmqRequestChannel(channelLength, /*configureEventFlagWord=*/true) {}
 
+RequestChannelSender::~RequestChannelSender() {
+    if (mEventFlag != nullptr) {
+        EventFlag::deleteEventFlag(&mEventFlag);
+    }
+}
+
 nn::Result<void> RequestChannelSender::send(const V1_0::Request& request,
                                             V1_2::MeasureTiming measure,
                                             const std::vector<int32_t>& slots) {
-    const std::vector<FmqRequestDatum> serialized = serialize(request, measure, slots);
-    return sendPacket(serialized);
+    if (!mValid) {
+        return NN_ERROR() << "FMQ object is invalid";
+    }
+
+    const size_t count = getPacketSize(request, slots);
+    if (count > mFmqRequestChannel.availableToWrite()) {
+        return NN_ERROR()
+               << "RequestChannelSender::send -- packet size exceeds size available in FMQ";
+    }
+
+    const bool success = writeInPlace(
+            &mFmqRequestChannel, mEventFlag, count, [&](const auto& nextDatum) {
+                serializeTo(request, measure, slots, count, nextDatum);
+            });
+    if (!success) {
+        return NN_ERROR() << "RequestChannelSender::send -- FMQ's beginWrite or commitWrite failed";
+    }
+
+    return {};
 }
 
 nn::Result<void> RequestChannelSender::sendPacket(const std::vector<FmqRequestDatum>& packet) {
@@ -464,8 +565,13 @@ void RequestChannelSender::notifyAsDeadObject() {
 nn::GeneralResult<std::unique_ptr<RequestChannelReceiver>> RequestChannelReceiver::create(
         const MQDescriptorSync<FmqRequestDatum>& requestChannel,
         std::chrono::microseconds pollingTimeWindow) {
+    return create(requestChannel, BurstPollingPolicy::fixed(pollingTimeWindow));
+}
+
+nn::GeneralResult<std::unique_ptr<RequestChannelReceiver>> RequestChannelReceiver::create(
+        const MQDescriptorSync<FmqRequestDatum>& requestChannel, BurstPollingPolicy pollingPolicy) {
     auto requestChannelReceiver = std::make_unique<RequestChannelReceiver>(
-            PrivateConstructorTag{}, requestChannel, pollingTimeWindow);
+            PrivateConstructorTag{}, requestChannel, pollingPolicy);
 
     if (!requestChannelReceiver->mFmqRequestChannel.isValid()) {
         return NN_ERROR() << "Unable to create RequestChannelReceiver";
@@ -480,8 +586,8 @@ nn::GeneralResult<std::unique_ptr<RequestChannelReceiver>> RequestChannelReceive
 
 RequestChannelReceiver::RequestChannelReceiver(
         PrivateConstructorTag /*tag*/, const MQDescriptorSync<FmqRequestDatum>& requestChannel,
-        std::chrono::microseconds pollingTimeWindow)
-    : mFmqRequestChannel(requestChannel), kPollingTimeWindow(pollingTimeWindow) {}
+        BurstPollingPolicy pollingPolicy)
+    : mFmqRequestChannel(requestChannel), mPollingPolicy(pollingPolicy) {}
 
 nn::Result<std::tuple<V1_0::Request, std::vector<int32_t>, V1_2::MeasureTiming>>
 RequestChannelReceiver::getBlocking() {
@@ -500,7 +606,11 @@ void RequestChannelReceiver::invalidate() {
     mFmqRequestChannel.writeBlocking(data.data(), data.size());
 }
 
-nn::Result<std::vector<FmqRequestDatum>> RequestChannelReceiver::getPacketBlocking() {
+BurstPollingPolicy::Stats RequestChannelReceiver::getPollingStats() const {
+    return mPollingPolicy.getStats();
+}
+
+nn::Result<std::span<const FmqRequestDatum>> RequestChannelReceiver::getPacketBlocking() {
     if (mTeardown) {
         return NN_ERROR() << "FMQ object is being torn down";
     }
@@ -510,7 +620,9 @@ nn::Result<std::vector<FmqRequestDatum>> RequestChannelReceiver::getPacketBlocki
     // poll for a limited period of time.
 
     auto& getCurrentTime = std::chrono::high_resolution_clock::now;
-    const auto timeToStopPolling = getCurrentTime() + kPollingTimeWindow;
+    const auto pollingTimeWindow = mPollingPolicy.getPollingTimeWindow();
+    const auto timeStartedWaiting = getCurrentTime();
+    const auto timeToStopPolling = timeStartedWaiting + pollingTimeWindow;
 
     while (getCurrentTime() < timeToStopPolling) {
         // if class is being torn down, immediately return
@@ -521,7 +633,9 @@ nn::Result<std::vector<FmqRequestDatum>> RequestChannelReceiver::getPacketBlocki
         // Check if data is available. If it is, immediately retrieve it and return.
         const size_t available = mFmqRequestChannel.availableToRead();
         if (available > 0) {
-            std::vector<FmqRequestDatum> packet(available);
+            const auto waitTime = getCurrentTime() - timeStartedWaiting;
+            mPollingPolicy.recordWait(waitTime, waitTime, /*isHit=*/true);
+            const auto packet = getArena(&mPacketArena, available);
             const bool success = mFmqRequestChannel.readBlocking(packet.data(), available);
             if (!success) {
                 return NN_ERROR() << "Error receiving packet";
@@ -534,10 +648,13 @@ nn::Result<std::vector<FmqRequestDatum>> RequestChannelReceiver::getPacketBlocki
 
     // If we get to this point, we either stopped polling because it was taking too long or polling
     // was not allowed. Instead, perform a blocking call which uses a futex to save power.
+    const auto spinTime = pollingTimeWindow.count() > 0 ? getCurrentTime() - timeStartedWaiting
+                                                        : std::chrono::nanoseconds{0};
 
     // wait for request packet and read first element of request packet
     FmqRequestDatum datum;
     bool success = mFmqRequestChannel.readBlocking(&datum, 1);
+    mPollingPolicy.recordWait(getCurrentTime() - timeStartedWaiting, spinTime, /*isHit=*/false);
 
     // retrieve remaining elements
     // NOTE: all of the data is already available at this point, so there's no need to do a blocking
@@ -546,7 +663,7 @@ nn::Result<std::vector<FmqRequestDatum>> RequestChannelReceiver::getPacketBlocki
     // function call, so if the first element of the packet is available, the remaining elements are
     // also available.
     const size_t count = mFmqRequestChannel.availableToRead();
-    std::vector<FmqRequestDatum> packet(count + 1);
+    const auto packet = getArena(&mPacketArena, count + 1);
     std::memcpy(&packet.front(), &datum, sizeof(datum));
     success &= mFmqRequestChannel.read(packet.data() + 1, count);
 
@@ -577,6 +694,10 @@ nn::GeneralResult<std::unique_ptr<ResultChannelSender>> ResultChannelSender::cre
         return NN_ERROR()
                << "ResultChannelSender::create was passed an MQDescriptor without an EventFlag";
     }
+    if (EventFlag::createEventFlag(resultChannelSender->mFmqResultChannel.getEventFlagWord(),
+                                   &resultChannelSender->mEventFlag) != OK) {
+        return NN_ERROR() << "Unable to create the EventFlag of ResultChannelSender";
+    }
 
     return resultChannelSender;
 }
@@ -585,11 +706,31 @@ ResultChannelSender::ResultChannelSender(PrivateConstructorTag /*tag*/,
                                          const MQDescriptorSync<FmqResultDatum>& resultChannel)
     : mFmqResultChannel(resultChannel) {}
 
+ResultChannelSender::~ResultChannelSender() {
+    if (mEventFlag != nullptr) {
+        EventFlag::deleteEventFlag(&mEventFlag);
+    }
+}
+
 void ResultChannelSender::send(V1_0::ErrorStatus errorStatus,
                                const std::vector<V1_2::OutputShape>& outputShapes,
                                V1_2::Timing timing) {
-    const std::vector<FmqResultDatum> serialized = serialize(errorStatus, outputShapes, timing);
-    sendPacket(serialized);
+    const size_t count = getPacketSize(outputShapes);
+    if (count > mFmqResultChannel.availableToWrite()) {
+        LOG(ERROR) << "ResultChannelSender::send -- packet size exceeds size available in FMQ";
+        const std::vector<FmqResultDatum> errorPacket =
+                serialize(V1_0::ErrorStatus::GENERAL_FAILURE, {}, kNoTiming);
+        mFmqResultChannel.writeBlocking(errorPacket.data(), errorPacket.size());
+        return;
+    }
+
+    const bool success = writeInPlace(
+            &mFmqResultChannel, mEventFlag, count, [&](const auto& nextDatum) {
+                serializeTo(errorStatus, outputShapes, timing, count, nextDatum);
+            });
+    if (!success) {
+        LOG(ERROR) << "ResultChannelSender::send -- FMQ's beginWrite or commitWrite failed";
+    }
 }
 
 void ResultChannelSender::sendPacket(const std::vector<FmqResultDatum>& packet) {
@@ -614,8 +755,14 @@ void ResultChannelSender::sendPacket(const std::vector<FmqResultDatum>& packet)
 nn::GeneralResult<
         std::pair<std::unique_ptr<ResultChannelReceiver>, const MQDescriptorSync<FmqResultDatum>*>>
 ResultChannelReceiver::create(size_t channelLength, std::chrono::microseconds pollingTimeWindow) {
+    return create(channelLength, BurstPollingPolicy::fixed(pollingTimeWindow));
+}
+
+nn::GeneralResult<
+        std::pair<std::unique_ptr<ResultChannelReceiver>, const MQDescriptorSync<FmqResultDatum>*>>
+ResultChannelReceiver::create(size_t channelLength, BurstPollingPolicy pollingPolicy) {
     auto resultChannelReceiver = std::make_unique<ResultChannelReceiver>(
-            PrivateConstructorTag{}, channelLength, pollingTimeWindow);
+            PrivateConstructorTag{}, channelLength, pollingPolicy);
     if (!resultChannelReceiver->mFmqResultChannel.isValid()) {
         return NN_ERROR() << "Unable to create ResultChannelReceiver";
     }
@@ -626,13 +773,13 @@ ResultChannelReceiver::create(size_t channelLength, std::chrono::microseconds po
 }
 
 ResultChannelReceiver::ResultChannelReceiver(PrivateConstructorTag /*tag*/, size_t channelLength,
-                                             std::chrono::microseconds pollingTimeWindow)
+                                             BurstPollingPolicy pollingPolicy)
     : mFmqResultChannel(channelLength, /*configureEventFlagWord=*/true),
-      kPollingTimeWindow(pollingTimeWindow) {}
+      mPollingPolicy(pollingPolicy) {}
 
 nn::Result<std::tuple<V1_0::ErrorStatus, std::vector<V1_2::OutputShape>, V1_2::Timing>>
 ResultChannelReceiver::getBlocking() {
-    const auto packet = NN_TRY(getPacketBlocking());
+    const auto packet = NN_TRY(receivePacketBlocking());
     return deserialize(packet);
 }
 
@@ -647,7 +794,16 @@ void ResultChannelReceiver::notifyAsDeadObject() {
     mFmqResultChannel.writeBlocking(data.data(), data.size());
 }
 
+BurstPollingPolicy::Stats ResultChannelReceiver::getPollingStats() const {
+    return mPollingPolicy.getStats();
+}
+
 nn::Result<std::vector<FmqResultDatum>> ResultChannelReceiver::getPacketBlocking() {
+    const auto packet = NN_TRY(receivePacketBlocking());
+    return std::vector<FmqResultDatum>(packet.begin(), packet.end());
+}
+
+nn::Result<std::span<const FmqResultDatum>> ResultChannelReceiver::receivePacketBlocking() {
     if (!mValid) {
         return NN_ERROR() << "FMQ object is invalid";
     }
@@ -657,7 +813,9 @@ nn::Result<std::vector<FmqResultDatum>> ResultChannelReceiver::getPacketBlocking
     // poll for a limited period of time.
 
     auto& getCurrentTime = std::chrono::high_resolution_clock::now;
-    const auto timeToStopPolling = getCurrentTime() + kPollingTimeWindow;
+    const auto pollingTimeWindow = mPollingPolicy.getPollingTimeWindow();
+    const auto timeStartedWaiting = getCurrentTime();
+    const auto timeToStopPolling = timeStartedWaiting + pollingTimeWindow;
 
     while (getCurrentTime() < timeToStopPolling) {
         // if class is being torn down, immediately return
@@ -668,7 +826,9 @@ nn::Result<std::vector<FmqResultDatum>> ResultChannelReceiver::getPacketBlocking
         // Check if data is available. If it is, immediately retrieve it and return.
         const size_t available = mFmqResultChannel.availableToRead();
         if (available > 0) {
-            std::vector<FmqResultDatum> packet(available);
+            const auto waitTime = getCurrentTime() - timeStartedWaiting;
+            mPollingPolicy.recordWait(waitTime, waitTime, /*isHit=*/true);
+            const auto packet = getArena(&mPacketArena, available);
             const bool success = mFmqResultChannel.readBlocking(packet.data(), available);
             if (!success) {
                 return NN_ERROR() << "Error receiving packet";
@@ -681,10 +841,13 @@ nn::Result<std::vector<FmqResultDatum>> ResultChannelReceiver::getPacketBlocking
 
     // If we get to this point, we either stopped polling because it was taking too long or polling
     // was not allowed. Instead, perform a blocking call which uses a futex to save power.
+    const auto spinTime = pollingTimeWindow.count() > 0 ? getCurrentTime() - timeStartedWaiting
+                                                        : std::chrono::nanoseconds{0};
 
     // wait for result packet and read first element of result packet
     FmqResultDatum datum;
     bool success = mFmqResultChannel.readBlocking(&datum, 1);
+    mPollingPolicy.recordWait(getCurrentTime() - timeStartedWaiting, spinTime, /*isHit=*/false);
 
     // retrieve remaining elements
     // NOTE: all of the data is already available at this point, so there's no need to do a blocking
@@ -693,7 +856,7 @@ nn::Result<std::vector<FmqResultDatum>> ResultChannelReceiver::getPacketBlocking
     // function call, so if the first element of the packet is available, the remaining elements are
     // also available.
     const size_t count = mFmqResultChannel.availableToRead();
-    std::vector<FmqResultDatum> packet(count + 1);
+    const auto packet = getArena(&mPacketArena, count + 1);
     std::memcpy(&packet.front(), &datum, sizeof(datum));
     success &= mFmqResultChannel.read(packet.data() + 1, count);
 
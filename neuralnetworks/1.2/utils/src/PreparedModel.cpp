@@ -155,8 +155,7 @@ nn::GeneralResult<nn::SharedExecution> PreparedModel::createReusableExecution(
 }
 
 nn::GeneralResult<nn::SharedBurst> PreparedModel::configureExecutionBurst() const {
-    const auto pollingTimeWindow = getBurstControllerPollingTimeWindow();
-    return Burst::create(shared_from_this(), kPreparedModel, pollingTimeWindow);
+    return Burst::create(shared_from_this(), kPreparedModel, getBurstControllerPollingPolicy());
 }
 
 std::any PreparedModel::getUnderlyingResource() const {
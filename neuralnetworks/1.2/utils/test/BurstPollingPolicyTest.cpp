@@ -0,0 +1,137 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <nnapi/hal/1.2/BurstPollingPolicy.h>
+
+#include <chrono>
+
+namespace android::hardware::neuralnetworks::V1_2::utils {
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr auto kBudget = 100us;
+
+// Waits the packet for waitTime, polling for the window the policy returns
+void wait(BurstPollingPolicy* policy, std::chrono::nanoseconds waitTime) {
+    const auto pollingTimeWindow = policy->getPollingTimeWindow();
+    if (waitTime <= pollingTimeWindow) {
+        policy->recordWait(waitTime, waitTime, /*isHit=*/true);
+    } else {
+        policy->recordWait(waitTime, pollingTimeWindow, /*isHit=*/false);
+    }
+}
+
+}  // namespace
+
+TEST(BurstPollingPolicyTest, fixedPollsEveryWait) {
+    // setup test
+    auto policy = BurstPollingPolicy::fixed(50us);
+
+    // run test
+    wait(&policy, 10us);
+    wait(&policy, 1ms);
+
+    // verify result
+    EXPECT_EQ(policy.getPollingTimeWindow(), 50us);
+    const auto stats = policy.getStats();
+    EXPECT_EQ(stats.waits, 2u);
+    EXPECT_EQ(stats.polls, 2u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.spinTime, 60us);
+    EXPECT_EQ(stats.wastedSpinTime, 50us);
+}
+
+TEST(BurstPollingPolicyTest, fixedZeroWindowNeverPolls) {
+    // setup test
+    auto policy = BurstPollingPolicy::fixed(0us);
+
+    // run test
+    wait(&policy, 10us);
+
+    // verify result
+    EXPECT_EQ(policy.getPollingTimeWindow(), 0us);
+    EXPECT_EQ(policy.getStats().polls, 0u);
+}
+
+TEST(BurstPollingPolicyTest, adaptivePollsFirstWaitForBudget) {
+    // setup test
+    auto policy = BurstPollingPolicy::adaptive(kBudget);
+
+    // run test
+    const auto pollingTimeWindow = policy.getPollingTimeWindow();
+
+    // verify result
+    EXPECT_EQ(pollingTimeWindow, kBudget);
+}
+
+TEST(BurstPollingPolicyTest, adaptivePollsForShortWaits) {
+    // setup test
+    auto policy = BurstPollingPolicy::adaptive(kBudget);
+
+    // run test
+    for (int i = 0; i < 100; ++i) {
+        wait(&policy, i % 2 == 0 ? 20us : 30us);
+    }
+
+    // verify result
+    const auto pollingTimeWindow = policy.getPollingTimeWindow();
+    EXPECT_GE(pollingTimeWindow, 30us);
+    EXPECT_LE(pollingTimeWindow, kBudget);
+    const auto stats = policy.getStats();
+    EXPECT_EQ(stats.polls, 100u);
+    EXPECT_GE(stats.hits, 95u);
+}
+
+TEST(BurstPollingPolicyTest, adaptiveProbesLongWaits) {
+    // setup test
+    auto policy = BurstPollingPolicy::adaptive(kBudget);
+    for (int i = 0; i < 10; ++i) {
+        wait(&policy, 5ms);
+    }
+    const auto before = policy.getStats();
+
+    // run test
+    for (uint64_t i = 0; i < 10 * BurstPollingPolicy::kProbeInterval; ++i) {
+        wait(&policy, 5ms);
+    }
+
+    // verify result
+    const auto stats = policy.getStats();
+    EXPECT_EQ(stats.polls - before.polls, 10u);
+    EXPECT_EQ(stats.hits, 0u);
+    EXPECT_EQ(stats.wastedSpinTime, stats.spinTime);
+}
+
+TEST(BurstPollingPolicyTest, adaptiveResumesPollingWhenWaitsShorten) {
+    // setup test
+    auto policy = BurstPollingPolicy::adaptive(kBudget);
+    for (int i = 0; i < 20; ++i) {
+        wait(&policy, 5ms);
+    }
+
+    // run test
+    for (int i = 0; i < 20 * static_cast<int>(BurstPollingPolicy::kProbeInterval); ++i) {
+        wait(&policy, 20us);
+    }
+
+    // verify result
+    EXPECT_GT(policy.getPollingTimeWindow(), 0us);
+}
+
+}  // namespace android::hardware::neuralnetworks::V1_2::utils
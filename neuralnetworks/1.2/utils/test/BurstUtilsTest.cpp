@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android/hardware/neuralnetworks/1.0/types.h>
+#include <android/hardware/neuralnetworks/1.2/types.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <nnapi/hal/1.2/BurstPollingPolicy.h>
+#include <nnapi/hal/1.2/BurstUtils.h>
+
+#include <chrono>
+#include <tuple>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::V1_2::utils {
+namespace {
+
+// Short enough for the packets below to wrap around the end of the FMQ within a few sends
+constexpr size_t kChannelLength = 32;
+constexpr size_t kSendCount = 10;
+
+const V1_0::Request kRequest = {
+        .inputs = {{.hasNoValue = false,
+                    .location = {.poolIndex = 0, .offset = 0, .length = 16},
+                    .dimensions = {2, 2}},
+                   {.hasNoValue = true, .location = {}, .dimensions = {}}},
+        .outputs = {{.hasNoValue = false,
+                     .location = {.poolIndex = 1, .offset = 64, .length = 4},
+                     .dimensions = {1}}},
+        .pools = {},
+};
+const std::vector<int32_t> kSlots = {3, 7};
+const std::vector<OutputShape> kOutputShapes = {{.dimensions = {1, 3}, .isSufficient = true},
+                                                {.dimensions = {5}, .isSufficient = false}};
+constexpr Timing kTiming = {.timeOnDevice = 10, .timeInDriver = 20};
+
+BurstPollingPolicy noPolling() {
+    return BurstPollingPolicy::fixed(std::chrono::microseconds{0});
+}
+
+}  // namespace
+
+TEST(BurstUtilsTest, requestSentInPlaceRoundTrips) {
+    // setup test
+    auto [sender, descriptor] = RequestChannelSender::create(kChannelLength).value();
+    const auto receiver = RequestChannelReceiver::create(*descriptor, noPolling()).value();
+
+    for (size_t i = 0; i < kSendCount; ++i) {
+        // run test
+        ASSERT_TRUE(sender->send(kRequest, MeasureTiming::YES, kSlots).has_value());
+        const auto result = receiver->getBlocking();
+
+        // verify result
+        ASSERT_TRUE(result.has_value()) << result.error().message;
+        const auto& [request, slots, measure] = result.value();
+        EXPECT_EQ(request, kRequest);
+        EXPECT_EQ(slots, kSlots);
+        EXPECT_EQ(measure, MeasureTiming::YES);
+    }
+}
+
+TEST(BurstUtilsTest, resultSentInPlaceMatchesSerializedPacket) {
+    // setup test
+    auto [receiver, descriptor] =
+            ResultChannelReceiver::create(kChannelLength, noPolling()).value();
+    const auto sender = ResultChannelSender::create(*descriptor).value();
+    const auto expectedPacket = serialize(V1_0::ErrorStatus::NONE, kOutputShapes, kTiming);
+
+    for (size_t i = 0; i < kSendCount; ++i) {
+        // run test
+        sender->send(V1_0::ErrorStatus::NONE, kOutputShapes, kTiming);
+        const auto packet = receiver->getPacketBlocking();
+
+        // verify result
+        ASSERT_TRUE(packet.has_value()) << packet.error().message;
+        EXPECT_EQ(packet.value(), expectedPacket);
+    }
+}
+
+TEST(BurstUtilsTest, resultTooLargeForChannelSendsFailure) {
+    // setup test
+    auto [receiver, descriptor] =
+            ResultChannelReceiver::create(kChannelLength, noPolling()).value();
+    const auto sender = ResultChannelSender::create(*descriptor).value();
+    const std::vector<OutputShape> outputShapes = {
+            {.dimensions = std::vector<uint32_t>(kChannelLength, 1), .isSufficient = true}};
+
+    // run test
+    sender->send(V1_0::ErrorStatus::NONE, outputShapes, kTiming);
+    const auto result = receiver->getBlocking();
+
+    // verify result
+    ASSERT_TRUE(result.has_value()) << result.error().message;
+    EXPECT_EQ(std::get<V1_0::ErrorStatus>(result.value()), V1_0::ErrorStatus::GENERAL_FAILURE);
+    EXPECT_TRUE(std::get<std::vector<OutputShape>>(result.value()).empty());
+}
+
+TEST(BurstUtilsTest, deserializeRejectsTruncatedPacket) {
+    // setup test
+    auto packet = serialize(kRequest, MeasureTiming::NO, kSlots);
+    packet.pop_back();
+
+    // run test
+    const auto result = deserialize(packet);
+
+    // verify result
+    EXPECT_FALSE(result.has_value());
+}
+
+}  // namespace android::hardware::neuralnetworks::V1_2::utils
@@ -252,8 +252,8 @@ nn::GeneralResult<nn::SharedExecution> PreparedModel::createReusableExecution(
 }
 
 nn::GeneralResult<nn::SharedBurst> PreparedModel::configureExecutionBurst() const {
-    const auto pollingTimeWindow = V1_2::utils::getBurstControllerPollingTimeWindow();
-    return V1_2::utils::Burst::create(shared_from_this(), kPreparedModel, pollingTimeWindow);
+    const auto pollingPolicy = V1_2::utils::getBurstControllerPollingPolicy();
+    return V1_2::utils::Burst::create(shared_from_this(), kPreparedModel, pollingPolicy);
 }
 
 std::any PreparedModel::getUnderlyingResource() const {
@@ -46,6 +46,9 @@ class AidlManagedBuffer {
 
     uint8_t* getPointer() const { return kBuffer.get(); }
     uint32_t getSize() const { return kSize; }
+    const std::set<AidlHalPreparedModelRole>& getRoles() const { return kRoles; }
+    OperandType getOperandType() const { return kOperandType; }
+    const std::vector<uint32_t>& getInitialDimensions() const { return kInitialDimensions; }
 
     // "poolIndex" is the index of this buffer in the request.pools.
     ErrorStatus validateRequest(uint32_t poolIndex, const Request& request,
@@ -58,6 +61,9 @@ class AidlManagedBuffer {
     bool updateDimensions(const std::vector<uint32_t>& dimensions);
     void setInitialized(bool initialized);
 
+    // Returns the buffer to its state after allocation, uninitialized with its initial dimensions.
+    void reset();
+
   private:
     mutable std::mutex mMutex;
     const std::unique_ptr<uint8_t[]> kBuffer;
@@ -114,6 +120,58 @@ class AidlBufferTracker : public std::enable_shared_from_this<AidlBufferTracker>
     std::vector<std::shared_ptr<AidlManagedBuffer>> mTokenToBuffers GUARDED_BY(mMutex);
 };
 
+// Keep the AidlManagedBuffers freed by the clients and recycle them in later allocations, so that
+// reusable executions allocating and freeing the same device memory on every inference do not
+// allocate a new buffer each time. The free buffers are grouped by size, and a buffer is only
+// recycled for an allocation with the same roles and operand, i.e. for the same prepared models.
+class AidlBufferPool : public std::enable_shared_from_this<AidlBufferPool> {
+    DISALLOW_COPY_AND_ASSIGN(AidlBufferPool);
+
+  public:
+    static constexpr size_t kDefaultMaxPooledBytes = 64 * 1024 * 1024;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        // Buffers freed instead of pooled because the pool was full.
+        uint64_t drops = 0;
+        size_t pooledBuffers = 0;
+        size_t pooledBytes = 0;
+    };
+
+    // The factory of AidlBufferPool. This ensures that the AidlBufferPool is always managed by a
+    // shared_ptr.
+    static std::shared_ptr<AidlBufferPool> create(
+            size_t maxPooledBytes = kDefaultMaxPooledBytes) {
+        return std::make_shared<AidlBufferPool>(maxPooledBytes);
+    }
+
+    // Prefer AidlBufferPool::create.
+    explicit AidlBufferPool(size_t maxPooledBytes) : kMaxPooledBytes(maxPooledBytes) {}
+
+    // Same as AidlManagedBuffer::create, except that the buffer returns to the pool when the last
+    // reference to it is dropped, e.g. when its AidlBufferTracker::Token is destroyed.
+    std::shared_ptr<AidlManagedBuffer> allocate(uint32_t size,
+                                                std::set<AidlHalPreparedModelRole> roles,
+                                                const Operand& operand);
+
+    // Free the pooled buffers with a role for the prepared model. This is to be called when the
+    // prepared model is destroyed, before another one may be allocated at the same address.
+    void removePreparedModel(const aidl_hal::IPreparedModel* preparedModel);
+
+    Stats getStats() const;
+
+  private:
+    void recycle(std::unique_ptr<AidlManagedBuffer> buffer);
+
+    const size_t kMaxPooledBytes;
+    mutable std::mutex mMutex;
+    // The free buffers by size, the most recently freed last.
+    std::map<uint32_t, std::vector<std::unique_ptr<AidlManagedBuffer>>> mFreeBuffers
+            GUARDED_BY(mMutex);
+    Stats mStats GUARDED_BY(mMutex);
+};
+
 }  // namespace android::nn
 
 #endif  // ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_AIDL_UTILS_BUFFER_TRACKER_H
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_AIDL_UTILS_MODEL_VALIDATOR_H
+#define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_AIDL_UTILS_MODEL_VALIDATOR_H
+
+#include "nnapi/hal/aidl/Conversions.h"
+
+#include <aidl/android/hardware/neuralnetworks/Model.h>
+#include <android-base/thread_annotations.h>
+#include <nnapi/Result.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/ThreadPoolExecutor.h>
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace aidl::android::hardware::neuralnetworks::utils {
+
+/**
+ * Converts the models received by a driver in parallel, and caches which of them were valid.
+ *
+ * The operands and operations of the main and referenced subgraphs are converted in chunks, on
+ * worker threads and on the calling thread. Each chunk is hashed as it is converted, and the
+ * SHA-256 digest of the whole model keys a cache of the models which were valid, so that the
+ * validation of a model received again, as by getSupportedOperations and then prepareModel, is
+ * skipped. Models with memory pools other than ashmem or mappable files are validated every time,
+ * as their validity may depend on more than their size.
+ *
+ * The validation itself is nn::validate, on the calling thread: the validation of an operation
+ * depends on the operands and subgraphs it refers to, which nn::validate does not expose per
+ * chunk. A model seen for the first time is therefore validated serially.
+ */
+class ModelValidator final {
+  public:
+    struct Options {
+        // Workers in addition to the calling thread, which converts chunks as well
+        size_t threadCount =
+                ::android::hardware::neuralnetworks::utils::ThreadPoolExecutor::
+                        getDefaultThreadCount();
+        size_t maxCachedModels = 16;
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+    // Operands, operations or bytes of operand values converted and hashed by one task
+    static constexpr size_t kObjectsPerChunk = 1024;
+    static constexpr size_t kBytesPerChunk = 1024 * 1024;
+
+    static std::shared_ptr<const ModelValidator> create(const Options& options);
+    static std::shared_ptr<const ModelValidator> create();
+
+    explicit ModelValidator(const Options& options);
+
+    // Returns the same model or error as nn::convert(model)
+    nn::GeneralResult<nn::Model> convert(const Model& model) const;
+
+    Stats getStats() const;
+
+  private:
+    using Digest = std::array<uint8_t, 32>;
+
+    std::optional<nn::Version> lookup(const Digest& digest) const EXCLUDES(mMutex);
+    void insert(const Digest& digest, nn::Version version) const EXCLUDES(mMutex);
+
+    const Options kOptions;
+    const std::unique_ptr<::android::hardware::neuralnetworks::utils::ThreadPoolExecutor> kWorkers;
+
+    mutable std::mutex mMutex;
+    // Most recently used first
+    mutable std::list<Digest> mLru GUARDED_BY(mMutex);
+    mutable std::map<Digest, std::pair<nn::Version, std::list<Digest>::iterator>> mValidModels
+            GUARDED_BY(mMutex);
+    mutable uint64_t mHits GUARDED_BY(mMutex) = 0;
+    mutable uint64_t mMisses GUARDED_BY(mMutex) = 0;
+};
+
+}  // namespace aidl::android::hardware::neuralnetworks::utils
+
+#endif  // ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_AIDL_UTILS_MODEL_VALIDATOR_H
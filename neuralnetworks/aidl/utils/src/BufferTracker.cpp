@@ -21,6 +21,9 @@
 #include <android-base/macros.h>
 #include <nnapi/TypeUtils.h>
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -29,9 +32,11 @@
 #include <vector>
 
 namespace android::nn {
+namespace {
 
-std::shared_ptr<AidlManagedBuffer> AidlManagedBuffer::create(
-        uint32_t size, std::set<AidlHalPreparedModelRole> roles, const Operand& operand) {
+std::unique_ptr<AidlManagedBuffer> makeManagedBuffer(uint32_t size,
+                                                     std::set<AidlHalPreparedModelRole> roles,
+                                                     const Operand& operand) {
     std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[size]);
     if (buffer == nullptr) {
         return nullptr;
@@ -40,7 +45,14 @@ std::shared_ptr<AidlManagedBuffer> AidlManagedBuffer::create(
         LOG(ERROR) << "AidlManagedBuffer cannot handle extension operands.";
         return nullptr;
     }
-    return std::make_shared<AidlManagedBuffer>(std::move(buffer), size, std::move(roles), operand);
+    return std::make_unique<AidlManagedBuffer>(std::move(buffer), size, std::move(roles), operand);
+}
+
+}  // namespace
+
+std::shared_ptr<AidlManagedBuffer> AidlManagedBuffer::create(
+        uint32_t size, std::set<AidlHalPreparedModelRole> roles, const Operand& operand) {
+    return makeManagedBuffer(size, std::move(roles), operand);
 }
 
 AidlManagedBuffer::AidlManagedBuffer(std::unique_ptr<uint8_t[]> buffer, uint32_t size,
@@ -187,6 +199,12 @@ void AidlManagedBuffer::setInitialized(bool initialized) {
     mInitialized = initialized;
 }
 
+void AidlManagedBuffer::reset() {
+    std::lock_guard<std::mutex> guard(mMutex);
+    mUpdatedDimensions = kInitialDimensions;
+    mInitialized = false;
+}
+
 std::unique_ptr<AidlBufferTracker::Token> AidlBufferTracker::add(
         std::shared_ptr<AidlManagedBuffer> buffer) {
     if (buffer == nullptr) {
@@ -224,4 +242,95 @@ void AidlBufferTracker::free(uint32_t token) {
     mFreeTokens.push(token);
 }
 
+std::shared_ptr<AidlManagedBuffer> AidlBufferPool::allocate(
+        uint32_t size, std::set<AidlHalPreparedModelRole> roles, const Operand& operand) {
+    std::unique_ptr<AidlManagedBuffer> buffer;
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        if (const auto it = mFreeBuffers.find(size); it != mFreeBuffers.end()) {
+            auto& freeBuffers = it->second;
+            const auto match = std::find_if(
+                    freeBuffers.rbegin(), freeBuffers.rend(), [&roles, &operand](const auto& free) {
+                        return free->getOperandType() == operand.type &&
+                               free->getInitialDimensions() == operand.dimensions &&
+                               free->getRoles() == roles;
+                    });
+            if (match != freeBuffers.rend()) {
+                buffer = std::move(*match);
+                freeBuffers.erase(std::next(match).base());
+                if (freeBuffers.empty()) {
+                    mFreeBuffers.erase(it);
+                }
+                mStats.pooledBuffers--;
+                mStats.pooledBytes -= size;
+            }
+        }
+        if (buffer != nullptr) {
+            mStats.hits++;
+        } else {
+            mStats.misses++;
+        }
+    }
+
+    const bool recycled = buffer != nullptr;
+    if (recycled) {
+        buffer->reset();
+    } else {
+        buffer = makeManagedBuffer(size, std::move(roles), operand);
+        if (buffer == nullptr) {
+            return nullptr;
+        }
+    }
+    VLOG(MEMORY) << "AidlBufferPool::allocate -- " << (recycled ? "recycled" : "new")
+                 << " buffer of size " << size;
+    return std::shared_ptr<AidlManagedBuffer>(
+            buffer.release(), [weakPool = weak_from_this()](AidlManagedBuffer* released) {
+                std::unique_ptr<AidlManagedBuffer> owned(released);
+                if (const auto pool = weakPool.lock()) {
+                    pool->recycle(std::move(owned));
+                }
+            });
+}
+
+void AidlBufferPool::recycle(std::unique_ptr<AidlManagedBuffer> buffer) {
+    std::lock_guard<std::mutex> guard(mMutex);
+    const uint32_t size = buffer->getSize();
+    if (mStats.pooledBytes + size > kMaxPooledBytes) {
+        mStats.drops++;
+        return;
+    }
+    mFreeBuffers[size].push_back(std::move(buffer));
+    mStats.pooledBuffers++;
+    mStats.pooledBytes += size;
+}
+
+void AidlBufferPool::removePreparedModel(const aidl_hal::IPreparedModel* preparedModel) {
+    // The buffers are freed after releasing the lock.
+    std::vector<std::unique_ptr<AidlManagedBuffer>> removed;
+    std::lock_guard<std::mutex> guard(mMutex);
+    for (auto it = mFreeBuffers.begin(); it != mFreeBuffers.end();) {
+        auto& freeBuffers = it->second;
+        const auto hasRole = [preparedModel](const auto& free) {
+            const auto& roles = free->getRoles();
+            return std::any_of(roles.begin(), roles.end(), [preparedModel](const auto& role) {
+                return std::get<0>(role) == preparedModel;
+            });
+        };
+        const auto end = std::stable_partition(freeBuffers.begin(), freeBuffers.end(),
+                                               std::not_fn(hasRole));
+        for (auto removedIt = end; removedIt != freeBuffers.end(); ++removedIt) {
+            mStats.pooledBuffers--;
+            mStats.pooledBytes -= (*removedIt)->getSize();
+            removed.push_back(std::move(*removedIt));
+        }
+        freeBuffers.erase(end, freeBuffers.end());
+        it = freeBuffers.empty() ? mFreeBuffers.erase(it) : std::next(it);
+    }
+}
+
+AidlBufferPool::Stats AidlBufferPool::getStats() const {
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mStats;
+}
+
 }  // namespace android::nn
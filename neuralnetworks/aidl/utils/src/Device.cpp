@@ -203,7 +203,12 @@ nn::GeneralResult<std::vector<bool>> Device::getSupportedOperations(const nn::Mo
     const nn::Model& modelInShared =
             NN_TRY(hal::utils::flushDataFromPointerToShared(&model, &maybeModelInShared));
 
-    const auto aidlModel = NN_TRY(convert(modelInShared));
+    // Send the large operand values in shared memory, so that they are not copied by the IPC.
+    std::optional<nn::Model> maybeModelWithConstantsInShared;
+    const nn::Model& modelWithConstantsInShared = NN_TRY(hal::utils::moveLargeConstantsToShared(
+            &modelInShared, hal::utils::kLargeConstantThreshold, &maybeModelWithConstantsInShared));
+
+    const auto aidlModel = NN_TRY(convert(modelWithConstantsInShared));
 
     std::vector<bool> supportedOperations;
     const auto ret = kDevice->getSupportedOperations(aidlModel, &supportedOperations);
@@ -223,7 +228,12 @@ nn::GeneralResult<nn::SharedPreparedModel> Device::prepareModel(
     const nn::Model& modelInShared =
             NN_TRY(hal::utils::flushDataFromPointerToShared(&model, &maybeModelInShared));
 
-    const auto aidlModel = NN_TRY(convert(modelInShared));
+    // Send the large operand values in shared memory, so that they are not copied by the IPC.
+    std::optional<nn::Model> maybeModelWithConstantsInShared;
+    const nn::Model& modelWithConstantsInShared = NN_TRY(hal::utils::moveLargeConstantsToShared(
+            &modelInShared, hal::utils::kLargeConstantThreshold, &maybeModelWithConstantsInShared));
+
+    const auto aidlModel = NN_TRY(convert(modelWithConstantsInShared));
     const auto aidlPreference = NN_TRY(convert(preference));
     const auto aidlPriority = NN_TRY(convert(priority));
     const auto aidlDeadline = NN_TRY(convert(deadline));
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ModelValidator.h"
+
+#include "Conversions.h"
+#include "Utils.h"
+
+#include <aidl/android/hardware/neuralnetworks/Model.h>
+#include <nnapi/Result.h>
+#include <nnapi/TypeUtils.h>
+#include <nnapi/Types.h>
+#include <nnapi/Validation.h>
+#include <nnapi/hal/ThreadPoolExecutor.h>
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace aidl::android::hardware::neuralnetworks::utils {
+namespace {
+
+using ::android::hardware::neuralnetworks::utils::ThreadPoolExecutor;
+
+static_assert(SHA256_DIGEST_LENGTH == 32);
+
+class Hasher {
+  public:
+    Hasher() { SHA256_Init(&mContext); }
+
+    void update(const void* data, size_t size) { SHA256_Update(&mContext, data, size); }
+
+    template <typename Type>
+    std::enable_if_t<std::is_arithmetic_v<Type> || std::is_enum_v<Type>> update(Type value) {
+        update(&value, sizeof(value));
+    }
+
+    template <typename Type>
+    std::enable_if_t<std::is_arithmetic_v<Type>> update(const std::vector<Type>& values) {
+        update(values.size());
+        update(values.data(), values.size() * sizeof(Type));
+    }
+
+    void update(const std::string& value) {
+        update(value.size());
+        update(value.data(), value.size());
+    }
+
+    std::array<uint8_t, 32> finish() {
+        std::array<uint8_t, 32> digest;
+        SHA256_Final(digest.data(), &mContext);
+        return digest;
+    }
+
+  private:
+    SHA256_CTX mContext;
+};
+
+void hash(Hasher* hasher, const nn::Operand& operand) {
+    hasher->update(operand.type);
+    hasher->update(operand.dimensions);
+    hasher->update(operand.scale);
+    hasher->update(operand.zeroPoint);
+    hasher->update(operand.lifetime);
+    hasher->update(operand.location.poolIndex);
+    hasher->update(operand.location.offset);
+    hasher->update(operand.location.length);
+    hasher->update(operand.location.padding);
+    hasher->update(operand.extraParams.index());
+    if (const auto* channelQuant =
+                std::get_if<nn::Operand::SymmPerChannelQuantParams>(&operand.extraParams)) {
+        hasher->update(channelQuant->scales);
+        hasher->update(channelQuant->channelDim);
+    } else if (const auto* extension =
+                       std::get_if<nn::Operand::ExtensionParams>(&operand.extraParams)) {
+        hasher->update(*extension);
+    }
+}
+
+void hash(Hasher* hasher, const nn::Operation& operation) {
+    hasher->update(operation.type);
+    hasher->update(operation.inputs);
+    hasher->update(operation.outputs);
+}
+
+// Hashes what the validation of the model depends on in its memory pools, or returns false if it
+// may depend on more than the hashed properties
+bool hashPools(Hasher* hasher, const std::vector<nn::SharedMemory>& pools) {
+    hasher->update(pools.size());
+    for (const auto& pool : pools) {
+        if (pool == nullptr) {
+            return false;
+        }
+        hasher->update(pool->handle.index());
+        if (const auto* ashmem = std::get_if<nn::Memory::Ashmem>(&pool->handle)) {
+            hasher->update(ashmem->size);
+        } else if (const auto* fd = std::get_if<nn::Memory::Fd>(&pool->handle)) {
+            hasher->update(fd->size);
+            hasher->update(fd->prot);
+            hasher->update(fd->offset);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs task(0) to task(count - 1) on the workers and on the calling thread, and returns once they
+// have all completed. The calling thread runs tasks as well, so that it makes progress even if all
+// of the workers are busy. A worker which starts after all the tasks were taken returns without
+// touching `task`, which may have gone out of scope by then.
+void parallelFor(ThreadPoolExecutor* workers, size_t threadCount, size_t count,
+                 const std::function<void(size_t)>& task) {
+    struct State {
+        std::mutex mutex;
+        std::condition_variable completed;
+        size_t next = 0;
+        size_t remaining = 0;
+        size_t count = 0;
+        const std::function<void(size_t)>* task = nullptr;
+
+        void run() {
+            std::unique_lock lock(mutex);
+            while (next < count) {
+                const size_t index = next++;
+                lock.unlock();
+                (*task)(index);
+                lock.lock();
+                if (--remaining == 0) {
+                    completed.notify_all();
+                }
+            }
+        }
+    };
+
+    if (count == 0) {
+        return;
+    }
+    const auto state = std::make_shared<State>();
+    state->remaining = count;
+    state->count = count;
+    state->task = &task;
+
+    const size_t helperCount = workers == nullptr ? 0 : std::min(threadCount, count - 1);
+    for (size_t i = 0; i < helperCount; ++i) {
+        workers->execute([state] { state->run(); }, {}, nn::Priority::DEFAULT, {});
+    }
+    state->run();
+
+    std::unique_lock lock(state->mutex);
+    state->completed.wait(lock, [&state] { return state->remaining == 0; });
+}
+
+// A range of the operands or of the operations of a subgraph, or of the operand values of the
+// model
+struct Chunk {
+    enum class Kind { OPERANDS, OPERATIONS, OPERAND_VALUES };
+
+    Kind kind;
+    size_t subgraph;
+    size_t begin;
+    size_t end;
+};
+
+void addChunks(Chunk::Kind kind, size_t subgraph, size_t size, size_t chunkSize,
+               std::vector<Chunk>* chunks) {
+    for (size_t begin = 0; begin < size; begin += chunkSize) {
+        chunks->push_back({.kind = kind,
+                           .subgraph = subgraph,
+                           .begin = begin,
+                           .end = std::min(size, begin + chunkSize)});
+    }
+}
+
+nn::GeneralResult<void> convertChunk(const Chunk& chunk, const std::vector<const Subgraph*>& from,
+                                     std::vector<nn::Model::Subgraph>* to,
+                                     const nn::Model::OperandValues& operandValues,
+                                     Hasher* hasher) {
+    switch (chunk.kind) {
+        case Chunk::Kind::OPERANDS: {
+            auto& operands = (*to)[chunk.subgraph].operands;
+            for (size_t i = chunk.begin; i < chunk.end; ++i) {
+                operands[i] = NN_TRY(nn::unvalidatedConvert(from[chunk.subgraph]->operands[i]));
+                hash(hasher, operands[i]);
+            }
+            return {};
+        }
+        case Chunk::Kind::OPERATIONS: {
+            auto& operations = (*to)[chunk.subgraph].operations;
+            for (size_t i = chunk.begin; i < chunk.end; ++i) {
+                operations[i] = NN_TRY(nn::unvalidatedConvert(from[chunk.subgraph]->operations[i]));
+                hash(hasher, operations[i]);
+            }
+            return {};
+        }
+        case Chunk::Kind::OPERAND_VALUES:
+            hasher->update(operandValues.data() + chunk.begin, chunk.end - chunk.begin);
+            return {};
+    }
+    return NN_ERROR() << "Unrecognized chunk kind";
+}
+
+}  // namespace
+
+std::shared_ptr<const ModelValidator> ModelValidator::create(const Options& options) {
+    return std::make_shared<const ModelValidator>(options);
+}
+
+std::shared_ptr<const ModelValidator> ModelValidator::create() {
+    return create(Options{});
+}
+
+ModelValidator::ModelValidator(const Options& options)
+    : kOptions(options),
+      kWorkers(options.threadCount > 0 ? std::make_unique<ThreadPoolExecutor>(options.threadCount)
+                                       : nullptr) {}
+
+nn::GeneralResult<nn::Model> ModelValidator::convert(const Model& model) const {
+    std::vector<const Subgraph*> subgraphs = {&model.main};
+    for (const auto& referenced : model.referenced) {
+        subgraphs.push_back(&referenced);
+    }
+
+    // Converted on the calling thread, before the chunks which hash them
+    auto operandValues = NN_TRY(nn::unvalidatedConvert(model.operandValues));
+    std::vector<nn::SharedMemory> pools;
+    pools.reserve(model.pools.size());
+    for (const auto& pool : model.pools) {
+        pools.push_back(NN_TRY(nn::unvalidatedConvert(pool)));
+    }
+    std::vector<nn::ExtensionNameAndPrefix> extensionNameToPrefix;
+    extensionNameToPrefix.reserve(model.extensionNameToPrefix.size());
+    for (const auto& extensionNameAndPrefix : model.extensionNameToPrefix) {
+        extensionNameToPrefix.push_back(NN_TRY(nn::unvalidatedConvert(extensionNameAndPrefix)));
+    }
+
+    Hasher hasher;
+    std::vector<nn::Model::Subgraph> canonicalSubgraphs(subgraphs.size());
+    std::vector<Chunk> chunks;
+    hasher.update(subgraphs.size());
+    for (size_t i = 0; i < subgraphs.size(); ++i) {
+        auto& canonical = canonicalSubgraphs[i];
+        canonical.operands.resize(subgraphs[i]->operands.size());
+        canonical.operations.resize(subgraphs[i]->operations.size());
+        canonical.inputIndexes = NN_TRY(nn::toUnsigned(subgraphs[i]->inputIndexes));
+        canonical.outputIndexes = NN_TRY(nn::toUnsigned(subgraphs[i]->outputIndexes));
+        hasher.update(canonical.operands.size());
+        hasher.update(canonical.operations.size());
+        hasher.update(canonical.inputIndexes);
+        hasher.update(canonical.outputIndexes);
+        addChunks(Chunk::Kind::OPERANDS, i, canonical.operands.size(), kObjectsPerChunk, &chunks);
+        addChunks(Chunk::Kind::OPERATIONS, i, canonical.operations.size(), kObjectsPerChunk,
+                  &chunks);
+    }
+    hasher.update(operandValues.size());
+    addChunks(Chunk::Kind::OPERAND_VALUES, 0, operandValues.size(), kBytesPerChunk, &chunks);
+    const bool cacheable = hashPools(&hasher, pools);
+    hasher.update(model.relaxComputationFloat32toFloat16);
+    hasher.update(extensionNameToPrefix.size());
+    for (const auto& [name, prefix] : extensionNameToPrefix) {
+        hasher.update(name);
+        hasher.update(prefix);
+    }
+
+    std::vector<nn::GeneralResult<void>> results(chunks.size());
+    std::vector<Digest> digests(chunks.size());
+    parallelFor(kWorkers.get(), kOptions.threadCount, chunks.size(),
+                [&chunks, &subgraphs, &canonicalSubgraphs, &operandValues, &results,
+                 &digests](size_t index) {
+                    Hasher chunkHasher;
+                    results[index] = convertChunk(chunks[index], subgraphs, &canonicalSubgraphs,
+                                                  operandValues, &chunkHasher);
+                    digests[index] = chunkHasher.finish();
+                });
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        NN_TRY(results[i]);
+        hasher.update(digests[i].data(), digests[i].size());
+    }
+    const Digest digest = hasher.finish();
+
+    std::vector<nn::Model::Subgraph> referenced(
+            std::make_move_iterator(canonicalSubgraphs.begin() + 1),
+            std::make_move_iterator(canonicalSubgraphs.end()));
+    auto canonicalModel = nn::Model{
+            .main = std::move(canonicalSubgraphs.front()),
+            .referenced = std::move(referenced),
+            .operandValues = std::move(operandValues),
+            .pools = std::move(pools),
+            .relaxComputationFloat32toFloat16 = model.relaxComputationFloat32toFloat16,
+            .extensionNameToPrefix = std::move(extensionNameToPrefix),
+    };
+
+    std::optional<nn::Version> version = cacheable ? lookup(digest) : std::nullopt;
+    if (!version.has_value()) {
+        version = NN_TRY(nn::validate(canonicalModel));
+        if (cacheable) {
+            insert(digest, *version);
+        }
+    }
+    if (!nn::isCompliantVersion(*version, kVersion)) {
+        return NN_ERROR() << "Insufficient version: " << *version << " vs required " << kVersion;
+    }
+    return canonicalModel;
+}
+
+ModelValidator::Stats ModelValidator::getStats() const {
+    std::lock_guard guard(mMutex);
+    return {.hits = mHits, .misses = mMisses};
+}
+
+std::optional<nn::Version> ModelValidator::lookup(const Digest& digest) const {
+    std::lock_guard guard(mMutex);
+    const auto it = mValidModels.find(digest);
+    if (it == mValidModels.end()) {
+        ++mMisses;
+        return std::nullopt;
+    }
+    ++mHits;
+    mLru.splice(mLru.begin(), mLru, it->second.second);
+    return it->second.first;
+}
+
+void ModelValidator::insert(const Digest& digest, nn::Version version) const {
+    std::lock_guard guard(mMutex);
+    if (kOptions.maxCachedModels == 0 || mValidModels.count(digest) > 0) {
+        return;
+    }
+    mLru.push_front(digest);
+    mValidModels.emplace(digest, std::make_pair(version, mLru.begin()));
+    if (mValidModels.size() > kOptions.maxCachedModels) {
+        mValidModels.erase(mLru.back());
+        mLru.pop_back();
+    }
+}
+
+}  // namespace aidl::android::hardware::neuralnetworks::utils
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/aidl/BufferTracker.h>
+
+#include <cstdint>
+#include <memory>
+#include <set>
+
+namespace android::nn {
+namespace {
+
+constexpr uint32_t kSize = 16;
+const Operand kOperand = {.type = OperandType::TENSOR_FLOAT32,
+                          .dimensions = {4},
+                          .scale = 0.0f,
+                          .zeroPoint = 0,
+                          .lifetime = Operand::LifeTime::SUBGRAPH_INPUT,
+                          .location = {}};
+
+// The roles are only compared, so the prepared models do not need to exist
+const aidl_hal::IPreparedModel* fakePreparedModel(uintptr_t id) {
+    return reinterpret_cast<const aidl_hal::IPreparedModel*>(id);
+}
+
+std::set<AidlHalPreparedModelRole> makeRoles(uintptr_t preparedModelId) {
+    return {{fakePreparedModel(preparedModelId), IOType::INPUT, 0},
+            {fakePreparedModel(preparedModelId), IOType::OUTPUT, 0}};
+}
+
+}  // namespace
+
+TEST(AidlBufferPoolTest, freedBufferIsRecycled) {
+    // setup test
+    const auto pool = AidlBufferPool::create();
+    const auto tracker = AidlBufferTracker::create();
+    const uint8_t* pointer = nullptr;
+    {
+        auto buffer = pool->allocate(kSize, makeRoles(1), kOperand);
+        ASSERT_NE(buffer, nullptr);
+        pointer = buffer->getPointer();
+        const auto token = tracker->add(std::move(buffer));
+    }
+
+    // run test
+    const auto buffer = pool->allocate(kSize, makeRoles(1), kOperand);
+
+    // verify result
+    ASSERT_NE(buffer, nullptr);
+    EXPECT_EQ(buffer->getPointer(), pointer);
+    const auto stats = pool->getStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.pooledBuffers, 0u);
+}
+
+TEST(AidlBufferPoolTest, recycledBufferIsReset) {
+    // setup test
+    const auto pool = AidlBufferPool::create();
+    {
+        const auto buffer = pool->allocate(kSize, makeRoles(1), kOperand);
+        buffer->setInitialized(true);
+        ASSERT_EQ(buffer->validateCopyTo(kSize), ErrorStatus::NONE);
+    }
+
+    // run test
+    const auto buffer = pool->allocate(kSize, makeRoles(1), kOperand);
+
+    // verify result
+    EXPECT_EQ(buffer->validateCopyTo(kSize), ErrorStatus::GENERAL_FAILURE);
+}
+
+TEST(AidlBufferPoolTest, bufferIsOnlyRecycledForSameRoles) {
+    // setup test
+    const auto pool = AidlBufferPool::create();
+    pool->allocate(kSize, makeRoles(1), kOperand);
+
+    // run test
+    const auto buffer = pool->allocate(kSize, makeRoles(2), kOperand);
+
+    // verify result
+    ASSERT_NE(buffer, nullptr);
+    const auto stats = pool->getStats();
+    EXPECT_EQ(stats.hits, 0u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.pooledBuffers, 1u);
+}
+
+TEST(AidlBufferPoolTest, fullPoolDropsBuffers) {
+    // setup test
+    const auto pool = AidlBufferPool::create(/*maxPooledBytes=*/kSize);
+    auto first = pool->allocate(kSize, makeRoles(1), kOperand);
+    auto second = pool->allocate(kSize, makeRoles(1), kOperand);
+
+    // run test
+    first.reset();
+    second.reset();
+
+    // verify result
+    const auto stats = pool->getStats();
+    EXPECT_EQ(stats.drops, 1u);
+    EXPECT_EQ(stats.pooledBuffers, 1u);
+    EXPECT_EQ(stats.pooledBytes, kSize);
+}
+
+TEST(AidlBufferPoolTest, removePreparedModelFreesItsBuffers) {
+    // setup test
+    const auto pool = AidlBufferPool::create();
+    pool->allocate(kSize, makeRoles(1), kOperand);
+    pool->allocate(kSize, makeRoles(2), kOperand);
+
+    // run test
+    pool->removePreparedModel(fakePreparedModel(1));
+
+    // verify result
+    const auto stats = pool->getStats();
+    EXPECT_EQ(stats.pooledBuffers, 1u);
+    EXPECT_EQ(stats.pooledBytes, kSize);
+}
+
+TEST(AidlBufferPoolTest, bufferOutlivesPool) {
+    // setup test
+    auto pool = AidlBufferPool::create();
+    auto buffer = pool->allocate(kSize, makeRoles(1), kOperand);
+
+    // run test
+    pool.reset();
+
+    // verify result
+    ASSERT_NE(buffer, nullptr);
+    EXPECT_EQ(buffer->getSize(), kSize);
+}
+
+}  // namespace android::nn
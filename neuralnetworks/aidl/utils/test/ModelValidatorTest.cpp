@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/neuralnetworks/Model.h>
+#include <gtest/gtest.h>
+#include <nnapi/TypeUtils.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/aidl/Conversions.h>
+#include <nnapi/hal/aidl/ModelValidator.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace aidl::android::hardware::neuralnetworks::utils {
+namespace {
+
+const nn::Operand kTensor = {.type = nn::OperandType::TENSOR_FLOAT32,
+                             .dimensions = {4},
+                             .scale = 0.0f,
+                             .zeroPoint = 0,
+                             .lifetime = nn::Operand::LifeTime::TEMPORARY_VARIABLE,
+                             .location = {}};
+
+// Chain of `size` ADD operations, each adding the previous result to itself
+nn::Model createChainModel(uint32_t size) {
+    nn::Model model;
+    const int32_t activation = 0;
+    model.operandValues = nn::Model::OperandValues(reinterpret_cast<const uint8_t*>(&activation),
+                                                   sizeof(activation));
+    model.main.operands.push_back({.type = nn::OperandType::INT32,
+                                   .dimensions = {},
+                                   .scale = 0.0f,
+                                   .zeroPoint = 0,
+                                   .lifetime = nn::Operand::LifeTime::CONSTANT_COPY,
+                                   .location = {.offset = 0, .length = sizeof(activation)}});
+    for (uint32_t i = 0; i <= size; ++i) {
+        model.main.operands.push_back(kTensor);
+    }
+    model.main.operands[1].lifetime = nn::Operand::LifeTime::SUBGRAPH_INPUT;
+    model.main.operands.back().lifetime = nn::Operand::LifeTime::SUBGRAPH_OUTPUT;
+    for (uint32_t i = 1; i <= size; ++i) {
+        model.main.operations.push_back(
+                {.type = nn::OperationType::ADD, .inputs = {i, i, 0}, .outputs = {i + 1}});
+    }
+    model.main.inputIndexes = {1};
+    model.main.outputIndexes = {size + 1};
+    return model;
+}
+
+Model createAidlChainModel(uint32_t size) {
+    return utils::convert(createChainModel(size)).value();
+}
+
+}  // namespace
+
+TEST(ModelValidatorTest, validModel) {
+    // setup test
+    const auto validator = ModelValidator::create();
+    const auto model = createAidlChainModel(4);
+
+    // run test
+    const auto result = validator->convert(model);
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(utils::convert(result.value()).value(), model);
+}
+
+TEST(ModelValidatorTest, invalidModel) {
+    // setup test
+    const auto validator = ModelValidator::create();
+    auto model = createAidlChainModel(4);
+    model.main.operations.back().outputs = {static_cast<int32_t>(model.main.operands.size())};
+
+    // run test
+    const auto result = validator->convert(model);
+
+    // verify result
+    EXPECT_FALSE(result.has_value());
+    EXPECT_FALSE(nn::convert(model).has_value());
+}
+
+TEST(ModelValidatorTest, invalidModelIsNotCached) {
+    // setup test
+    const auto validator = ModelValidator::create();
+    auto model = createAidlChainModel(4);
+    model.main.inputIndexes = {};
+    ASSERT_FALSE(validator->convert(model).has_value());
+
+    // run test
+    const auto result = validator->convert(model);
+
+    // verify result
+    EXPECT_FALSE(result.has_value());
+    EXPECT_EQ(validator->getStats().hits, 0u);
+}
+
+TEST(ModelValidatorTest, sameModelIsValidatedOnce) {
+    // setup test
+    const auto validator = ModelValidator::create();
+    const auto model = createAidlChainModel(4);
+    ASSERT_TRUE(validator->convert(model).has_value());
+
+    // run test
+    const auto result = validator->convert(model);
+
+    // verify result
+    ASSERT_TRUE(result.has_value());
+    const auto stats = validator->getStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+}
+
+TEST(ModelValidatorTest, changedOperandValueIsValidatedAgain) {
+    // setup test
+    const auto validator = ModelValidator::create();
+    auto model = createAidlChainModel(4);
+    ASSERT_TRUE(validator->convert(model).has_value());
+    const int32_t reluActivation = 1;
+    std::memcpy(model.operandValues.data(), &reluActivation, sizeof(reluActivation));
+
+    // run test
+    const auto result = validator->convert(model);
+
+    // verify result
+    ASSERT_TRUE(result.has_value());
+    const auto stats = validator->getStats();
+    EXPECT_EQ(stats.hits, 0u);
+    EXPECT_EQ(stats.misses, 2u);
+}
+
+TEST(ModelValidatorTest, evictsLeastRecentlyUsedModel) {
+    // setup test
+    const auto validator = ModelValidator::create({.threadCount = 0, .maxCachedModels = 1});
+    const auto first = createAidlChainModel(1);
+    const auto second = createAidlChainModel(2);
+    ASSERT_TRUE(validator->convert(first).has_value());
+    ASSERT_TRUE(validator->convert(second).has_value());
+
+    // run test
+    const auto result = validator->convert(first);
+
+    // verify result
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(validator->getStats().hits, 0u);
+}
+
+TEST(ModelValidatorTest, hugeModelMatchesSerialConversion) {
+    // setup test
+    const auto validator = ModelValidator::create({.threadCount = 4, .maxCachedModels = 1});
+    const auto model = createAidlChainModel(4 * ModelValidator::kObjectsPerChunk + 1);
+    const auto expected = nn::convert(model);
+    ASSERT_TRUE(expected.has_value());
+
+    // run test
+    const auto result = validator->convert(model);
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(utils::convert(result.value()).value(), utils::convert(expected.value()).value());
+}
+
+TEST(ModelValidatorTest, hugeInvalidModel) {
+    // setup test
+    const auto validator = ModelValidator::create({.threadCount = 4, .maxCachedModels = 1});
+    auto model = createAidlChainModel(4 * ModelValidator::kObjectsPerChunk + 1);
+    model.main.operands[3 * ModelValidator::kObjectsPerChunk].type = static_cast<OperandType>(-1);
+
+    // run test
+    const auto result = validator->convert(model);
+
+    // verify result
+    EXPECT_FALSE(result.has_value());
+}
+
+}  // namespace aidl::android::hardware::neuralnetworks::utils
@@ -17,6 +17,8 @@
 #ifndef ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_ADAPTER_AIDL_ADAPTER_H
 #define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_ADAPTER_AIDL_ADAPTER_H
 
+#include "nnapi/hal/aidl/ExecutionCoalescer.h"
+
 #include <aidl/android/hardware/neuralnetworks/BnDevice.h>
 #include <nnapi/IDevice.h>
 #include <nnapi/Types.h>
@@ -43,6 +45,17 @@ using Task = std::function<void()>;
  */
 using Executor = std::function<void(Task, ::android::nn::OptionalTimePoint)>;
 
+/**
+ * A type-erased executor which executes a task asynchronously, and is also provided the priority
+ * of the task.
+ *
+ * If the deadline passes before the task starts, the executor may run onDeadlineMissed instead of
+ * the task, which notifies the client that the deadline was missed.
+ */
+using PrioritizedExecutor =
+        std::function<void(Task task, Task onDeadlineMissed, ::android::nn::Priority priority,
+                           ::android::nn::OptionalTimePoint deadline)>;
+
 /**
  * Adapt an NNAPI canonical interface object to a AIDL NN HAL interface object.
  *
@@ -55,7 +68,33 @@ std::shared_ptr<BnDevice> adapt(::android::nn::SharedDevice device, Executor exe
 /**
  * Adapt an NNAPI canonical interface object to a AIDL NN HAL interface object.
  *
- * This function uses a default executor, which will execute tasks from a detached thread.
+ * @param device NNAPI canonical IDevice interface object to be adapted.
+ * @param executor Type-erased executor to handle executing tasks asynchronously by priority.
+ * @return AIDL NN HAL IDevice interface object.
+ */
+std::shared_ptr<BnDevice> adapt(::android::nn::SharedDevice device, PrioritizedExecutor executor);
+
+/**
+ * Adapt an NNAPI canonical interface object to a AIDL NN HAL interface object, coalescing the
+ * concurrent synchronous executions of each prepared model into batched executions.
+ *
+ * Coalescing applies to the models prepared from a model whose inputs and outputs all have an
+ * unspecified first dimension. It must only be enabled for drivers whose models compute the items
+ * of that dimension independently of each other. See ExecutionCoalescer.h.
+ *
+ * @param device NNAPI canonical IDevice interface object to be adapted.
+ * @param executor Type-erased executor to handle executing tasks asynchronously by priority.
+ * @param coalescing Options of the coalescing of the executions.
+ * @return AIDL NN HAL IDevice interface object.
+ */
+std::shared_ptr<BnDevice> adapt(::android::nn::SharedDevice device, PrioritizedExecutor executor,
+                                const ExecutionCoalescer::Options& coalescing);
+
+/**
+ * Adapt an NNAPI canonical interface object to a AIDL NN HAL interface object.
+ *
+ * This function uses a default executor, which executes tasks on a bounded pool of threads in
+ * order of priority and deadline, and sheds the tasks whose deadline passes before they start.
  *
  * @param device NNAPI canonical IDevice interface object to be adapted.
  * @return AIDL NN HAL IDevice interface object.
@@ -18,6 +18,7 @@
 #define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_ADAPTER_AIDL_DEVICE_H
 
 #include "nnapi/hal/aidl/Adapter.h"
+#include "nnapi/hal/aidl/ExecutionCoalescer.h"
 
 #include <aidl/android/hardware/neuralnetworks/BnDevice.h>
 #include <aidl/android/hardware/neuralnetworks/BufferDesc.h>
@@ -35,6 +36,7 @@
 #include <aidl/android/hardware/neuralnetworks/Priority.h>
 #include <android/binder_auto_utils.h>
 #include <nnapi/IDevice.h>
+#include <nnapi/hal/aidl/ModelValidator.h>
 
 #include <memory>
 #include <string>
@@ -48,7 +50,8 @@ namespace aidl::android::hardware::neuralnetworks::adapter {
 // Class that adapts nn::IDevice to BnDevice.
 class Device : public BnDevice {
   public:
-    Device(::android::nn::SharedDevice device, Executor executor);
+    Device(::android::nn::SharedDevice device, PrioritizedExecutor executor,
+           const ExecutionCoalescer::Options& coalescing = {});
 
     ndk::ScopedAStatus allocate(const BufferDesc& desc,
                                 const std::vector<IPreparedModelParcel>& preparedModels,
@@ -79,7 +82,9 @@ class Device : public BnDevice {
 
   protected:
     const ::android::nn::SharedDevice kDevice;
-    const Executor kExecutor;
+    const PrioritizedExecutor kExecutor;
+    const std::shared_ptr<const utils::ModelValidator> kModelValidator;
+    const ExecutionCoalescer::Options kCoalescing;
 };
 
 }  // namespace aidl::android::hardware::neuralnetworks::adapter
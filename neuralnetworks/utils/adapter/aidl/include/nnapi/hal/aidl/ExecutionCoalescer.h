@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_ADAPTER_AIDL_EXECUTION_COALESCER_H
+#define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_ADAPTER_AIDL_EXECUTION_COALESCER_H
+
+#include <android-base/thread_annotations.h>
+#include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/Types.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace aidl::android::hardware::neuralnetworks::adapter {
+
+// Coalesces the concurrent synchronous executions of a prepared model into batched executions.
+//
+// The first execution of a batch waits up to Options::window for other executions with the same
+// shapes, deadline and loop timeout, then concatenates the inputs of all of them along their
+// first dimension into a shared memory, executes the batched request once, and copies each slice
+// of the outputs back to the execution it belongs to. This trades the latency of the window for
+// the throughput of drivers whose cost per execution is dominated by a fixed overhead.
+//
+// Batching is only correct for models that compute the items of their first dimension
+// independently of each other, which cannot be derived from the model, so coalescing is disabled
+// unless the driver enables it when it is adapted. Executions that cannot be batched, such as the
+// ones that measure timing or whose arguments do not have fully specified dimensions, are
+// executed alone, as are the executions of a batch that fails for another reason than the size
+// of its outputs.
+class ExecutionCoalescer {
+  public:
+    struct Options {
+        // How long the first execution of a batch waits for other executions to join it. Zero
+        // disables coalescing.
+        ::android::nn::Duration window = ::android::nn::Duration::zero();
+        // A full batch is executed without waiting for the end of the window
+        size_t maxBatchSize = 8;
+    };
+
+    using Result = ::android::nn::ExecutionResult<
+            std::pair<std::vector<::android::nn::OutputShape>, ::android::nn::Timing>>;
+
+    // Returns whether all the inputs and outputs of the main subgraph of the model have an
+    // unspecified first dimension, so that requests may specify it as their batch size
+    static bool isBatchable(const ::android::nn::Model& model);
+
+    // Precondition: preparedModel != nullptr
+    ExecutionCoalescer(::android::nn::SharedPreparedModel preparedModel, const Options& options);
+
+    // Executes the request in a batch with the requests of concurrent calls, and returns its
+    // result, or returns std::nullopt if the caller must execute the request alone.
+    std::optional<Result> execute(const ::android::nn::Request& request,
+                                  ::android::nn::MeasureTiming measure,
+                                  const ::android::nn::OptionalTimePoint& deadline,
+                                  const ::android::nn::OptionalDuration& loopTimeoutDuration) const;
+
+  private:
+    struct Member;
+    struct Batch;
+    struct Scratch {
+        ::android::nn::SharedMemory memory;
+        ::android::nn::Mapping mapping;
+    };
+
+    void run(const Batch& batch) const;
+    ::android::nn::GeneralResult<Scratch> takeScratch(size_t size) const EXCLUDES(mMutex);
+    void returnScratch(Scratch scratch) const EXCLUDES(mMutex);
+
+    const ::android::nn::SharedPreparedModel kPreparedModel;
+    const Options kOptions;
+
+    mutable std::mutex mMutex;
+    // Batch that executions may still join
+    mutable std::shared_ptr<Batch> mOpenBatch GUARDED_BY(mMutex);
+    // Memories of the previous batches, kept so that the driver sees the same memories again
+    mutable std::vector<Scratch> mScratches GUARDED_BY(mMutex);
+};
+
+}  // namespace aidl::android::hardware::neuralnetworks::adapter
+
+#endif  // ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_ADAPTER_AIDL_EXECUTION_COALESCER_H
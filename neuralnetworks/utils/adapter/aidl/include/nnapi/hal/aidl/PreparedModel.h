@@ -18,18 +18,28 @@
 #define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_ADAPTER_AIDL_PREPARED_MDOEL_H
 
 #include "nnapi/hal/aidl/Adapter.h"
+#include "nnapi/hal/aidl/ExecutionCoalescer.h"
 
 #include <aidl/android/hardware/neuralnetworks/BnPreparedModel.h>
 #include <aidl/android/hardware/neuralnetworks/ExecutionResult.h>
 #include <aidl/android/hardware/neuralnetworks/FencedExecutionResult.h>
 #include <aidl/android/hardware/neuralnetworks/IBurst.h>
 #include <aidl/android/hardware/neuralnetworks/IExecution.h>
+#include <aidl/android/hardware/neuralnetworks/Memory.h>
 #include <aidl/android/hardware/neuralnetworks/Request.h>
+#include <android-base/thread_annotations.h>
 #include <android/binder_auto_utils.h>
 #include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
 #include <nnapi/Types.h>
+#include <sys/types.h>
 
+#include <cstdint>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 
 // See hardware/interfaces/neuralnetworks/utils/README.md for more information on AIDL interface
@@ -40,7 +50,12 @@ namespace aidl::android::hardware::neuralnetworks::adapter {
 // Class that adapts nn::IPreparedModel to BnPreparedModel.
 class PreparedModel : public BnPreparedModel {
   public:
-    explicit PreparedModel(::android::nn::SharedPreparedModel preparedModel);
+    // Precondition: preparedModel != nullptr
+    // The synchronous executions are coalesced by `coalescer` if it is not nullptr.
+    explicit PreparedModel(
+            ::android::nn::SharedPreparedModel preparedModel,
+            size_t maxCachedRequestPools = ThreadSafeRequestPoolCache::kDefaultMaxEntries,
+            std::shared_ptr<const ExecutionCoalescer> coalescer = nullptr);
 
     ndk::ScopedAStatus executeSynchronously(const Request& request, bool measureTiming,
                                             int64_t deadlineNs, int64_t loopTimeoutDurationNs,
@@ -65,8 +80,69 @@ class PreparedModel : public BnPreparedModel {
 
     ::android::nn::SharedPreparedModel getUnderlyingPreparedModel() const;
 
+    // Cache of the memory pools of the requests executed without a burst. A client that executes
+    // requests on the same memories gets the same nn::SharedMemory objects on each execution,
+    // without the duplication and conversion of their file descriptors, so the driver can keep
+    // its mappings of the memories across executions as it does for a burst or a reusable
+    // execution.
+    //
+    // Memories are identified by the device and inode of their file, with the offset, size and
+    // protection of the mapping. Only regular files, such as memfds, are cached: the regions of
+    // /dev/ashmem all share the inode of the device, so they cannot be told apart.
+    //
+    // An entry holds a duplicate of the file descriptor of the client, which keeps the file open,
+    // so its identity cannot be reused by another file while the entry is cached. It also keeps
+    // the memory of the file allocated after the client releases it, until the entry is evicted.
+    // The least recently used entries are evicted when the cache holds more than `maxEntries`
+    // memories or more than `maxBytes` bytes of them, and all the entries are released with the
+    // PreparedModel, when the client drops its last reference to it or dies.
+    class ThreadSafeRequestPoolCache {
+      public:
+        static constexpr size_t kDefaultMaxEntries = 64;
+        static constexpr size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+
+        explicit ThreadSafeRequestPoolCache(size_t maxEntries = kDefaultMaxEntries,
+                                            size_t maxBytes = kDefaultMaxBytes);
+
+        // Returns the memory converted for the same mapping of the same file as `memory`, or
+        // converts and caches `memory`. Memories that cannot be identified by their file, such
+        // as hardware buffers and /dev/ashmem regions, and memories larger than `maxBytes` are
+        // converted without being cached.
+        ::android::nn::GeneralResult<::android::nn::SharedMemory> getOrConvert(
+                const Memory& memory) const;
+
+      private:
+        struct Key {
+            dev_t device;
+            ino_t inode;
+            Memory::Tag tag;
+            int64_t offset;
+            int64_t size;
+            int32_t prot;
+
+            bool operator<(const Key& other) const;
+        };
+        struct Entry {
+            ::android::nn::SharedMemory memory;
+            std::list<Key>::iterator lruPosition;
+        };
+
+        static std::optional<Key> makeKey(const Memory& memory);
+
+        const size_t kMaxEntries;
+        const size_t kMaxBytes;
+        mutable std::mutex mMutex;
+        mutable std::map<Key, Entry> mEntries GUARDED_BY(mMutex);
+        // Most recently used first
+        mutable std::list<Key> mLru GUARDED_BY(mMutex);
+        // Sum of the sizes of the cached memories
+        mutable size_t mBytes GUARDED_BY(mMutex) = 0;
+    };
+
   protected:
     const ::android::nn::SharedPreparedModel kPreparedModel;
+    const ThreadSafeRequestPoolCache kRequestPoolCache;
+    const std::shared_ptr<const ExecutionCoalescer> kCoalescer;
 };
 
 }  // namespace aidl::android::hardware::neuralnetworks::adapter
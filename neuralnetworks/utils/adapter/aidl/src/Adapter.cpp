@@ -19,13 +19,14 @@
 #include "Device.h"
 
 #include <aidl/android/hardware/neuralnetworks/BnDevice.h>
+#include <android-base/logging.h>
 #include <android/binder_interface_utils.h>
 #include <nnapi/IDevice.h>
 #include <nnapi/Types.h>
+#include <nnapi/hal/ThreadPoolExecutor.h>
 
 #include <functional>
 #include <memory>
-#include <thread>
 
 // See hardware/interfaces/neuralnetworks/utils/README.md for more information on AIDL interface
 // lifetimes across processes and for protecting asynchronous calls across AIDL.
@@ -33,12 +34,34 @@
 namespace aidl::android::hardware::neuralnetworks::adapter {
 
 std::shared_ptr<BnDevice> adapt(::android::nn::SharedDevice device, Executor executor) {
+    CHECK(executor != nullptr);
+    // The tasks are never shed, as the executor can't report the missed deadline
+    PrioritizedExecutor prioritizedExecutor =
+            [executor = std::move(executor)](Task task, Task /*onDeadlineMissed*/,
+                                             ::android::nn::Priority /*priority*/,
+                                             ::android::nn::OptionalTimePoint deadline) {
+                executor(std::move(task), deadline);
+            };
+    return adapt(std::move(device), std::move(prioritizedExecutor));
+}
+
+std::shared_ptr<BnDevice> adapt(::android::nn::SharedDevice device, PrioritizedExecutor executor) {
     return ndk::SharedRefBase::make<Device>(std::move(device), std::move(executor));
 }
 
+std::shared_ptr<BnDevice> adapt(::android::nn::SharedDevice device, PrioritizedExecutor executor,
+                                const ExecutionCoalescer::Options& coalescing) {
+    return ndk::SharedRefBase::make<Device>(std::move(device), std::move(executor), coalescing);
+}
+
 std::shared_ptr<BnDevice> adapt(::android::nn::SharedDevice device) {
-    Executor defaultExecutor = [](Task task, ::android::nn::OptionalTimePoint /*deadline*/) {
-        std::thread(std::move(task)).detach();
+    // The pool is destroyed with the last reference to the device, after its queued tasks
+    auto pool = std::make_shared<::android::hardware::neuralnetworks::utils::ThreadPoolExecutor>();
+    PrioritizedExecutor defaultExecutor = [pool = std::move(pool)](
+                                                  Task task, Task onDeadlineMissed,
+                                                  ::android::nn::Priority priority,
+                                                  ::android::nn::OptionalTimePoint deadline) {
+        pool->execute(std::move(task), std::move(onDeadlineMissed), priority, deadline);
     };
     return adapt(std::move(device), std::move(defaultExecutor));
 }
@@ -18,6 +18,7 @@
 
 #include "Adapter.h"
 #include "Buffer.h"
+#include "ExecutionCoalescer.h"
 #include "PreparedModel.h"
 
 #include <aidl/android/hardware/neuralnetworks/BnDevice.h>
@@ -41,9 +42,11 @@
 #include <nnapi/TypeUtils.h>
 #include <nnapi/Types.h>
 #include <nnapi/hal/aidl/Conversions.h>
+#include <nnapi/hal/aidl/ModelValidator.h>
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -59,6 +62,15 @@ auto convertInput(const Type& object) -> decltype(nn::convert(std::declval<Type>
     return result;
 }
 
+nn::GeneralResult<nn::Model> convertInput(const utils::ModelValidator& validator,
+                                          const Model& model) {
+    auto result = validator.convert(model);
+    if (!result.has_value()) {
+        result.error().code = nn::ErrorStatus::INVALID_ARGUMENT;
+    }
+    return result;
+}
+
 nn::Duration makeDuration(int64_t durationNs) {
     return nn::Duration(std::chrono::nanoseconds(durationNs));
 }
@@ -120,19 +132,27 @@ nn::GeneralResult<DeviceBuffer> allocate(const nn::IDevice& device, const Buffer
     return DeviceBuffer{.buffer = std::move(aidlBuffer), .token = static_cast<int32_t>(token)};
 }
 
-nn::GeneralResult<std::vector<bool>> getSupportedOperations(const nn::IDevice& device,
-                                                            const Model& model) {
-    const auto nnModel = NN_TRY(convertInput(model));
+nn::GeneralResult<std::vector<bool>> getSupportedOperations(
+        const nn::IDevice& device, const utils::ModelValidator& validator, const Model& model) {
+    const auto nnModel = NN_TRY(convertInput(validator, model));
     return device.getSupportedOperations(nnModel);
 }
 
 using PrepareModelResult = nn::GeneralResult<nn::SharedPreparedModel>;
 
-std::shared_ptr<PreparedModel> adaptPreparedModel(nn::SharedPreparedModel preparedModel) {
+std::shared_ptr<PreparedModel> adaptPreparedModel(
+        nn::SharedPreparedModel preparedModel,
+        const std::optional<ExecutionCoalescer::Options>& coalescing) {
     if (preparedModel == nullptr) {
         return nullptr;
     }
-    return ndk::SharedRefBase::make<PreparedModel>(std::move(preparedModel));
+    std::shared_ptr<const ExecutionCoalescer> coalescer;
+    if (coalescing.has_value()) {
+        coalescer = std::make_shared<const ExecutionCoalescer>(preparedModel, *coalescing);
+    }
+    return ndk::SharedRefBase::make<PreparedModel>(
+            std::move(preparedModel), PreparedModel::ThreadSafeRequestPoolCache::kDefaultMaxEntries,
+            std::move(coalescer));
 }
 
 void notify(IPreparedModelCallback* callback, ErrorStatus status,
@@ -145,7 +165,8 @@ void notify(IPreparedModelCallback* callback, ErrorStatus status,
     }
 }
 
-void notify(IPreparedModelCallback* callback, PrepareModelResult result) {
+void notify(IPreparedModelCallback* callback, PrepareModelResult result,
+            const std::optional<ExecutionCoalescer::Options>& coalescing = std::nullopt) {
     if (!result.has_value()) {
         const auto& [message, status] = result.error();
         LOG(ERROR) << message;
@@ -153,14 +174,22 @@ void notify(IPreparedModelCallback* callback, PrepareModelResult result) {
         notify(callback, aidlCode, nullptr);
     } else {
         auto preparedModel = std::move(result).value();
-        auto aidlPreparedModel = adaptPreparedModel(std::move(preparedModel));
+        auto aidlPreparedModel = adaptPreparedModel(std::move(preparedModel), coalescing);
         notify(callback, ErrorStatus::NONE, std::move(aidlPreparedModel));
     }
 }
 
+// Run by the executor instead of a task whose deadline passed before it started
+Task makeDeadlineMissedTask(std::shared_ptr<IPreparedModelCallback> callback) {
+    return [callback = std::move(callback)] {
+        notify(callback.get(), ErrorStatus::MISSED_DEADLINE_TRANSIENT, nullptr);
+    };
+}
+
 nn::GeneralResult<void> prepareModel(
-        const nn::SharedDevice& device, const Executor& executor, const Model& model,
-        ExecutionPreference preference, Priority priority, int64_t deadlineNs,
+        const nn::SharedDevice& device, const PrioritizedExecutor& executor,
+        const utils::ModelValidator& validator, const ExecutionCoalescer::Options& coalescing,
+        const Model& model, ExecutionPreference preference, Priority priority, int64_t deadlineNs,
         const std::vector<ndk::ScopedFileDescriptor>& modelCache,
         const std::vector<ndk::ScopedFileDescriptor>& dataCache, const std::vector<uint8_t>& token,
         const std::vector<TokenValuePair>& hints,
@@ -170,7 +199,7 @@ nn::GeneralResult<void> prepareModel(
         return NN_ERROR(nn::ErrorStatus::INVALID_ARGUMENT) << "Invalid callback";
     }
 
-    auto nnModel = NN_TRY(convertInput(model));
+    auto nnModel = NN_TRY(convertInput(validator, model));
     const auto nnPreference = NN_TRY(convertInput(preference));
     const auto nnPriority = NN_TRY(convertInput(priority));
     const auto nnDeadline = NN_TRY(makeOptionalTimePoint(deadlineNs));
@@ -179,23 +208,28 @@ nn::GeneralResult<void> prepareModel(
     const auto nnToken = NN_TRY(convertCacheToken(token));
     auto nnHints = NN_TRY(convertInput(hints));
     auto nnExtensionNameToPrefix = NN_TRY(convertInput(extensionNameToPrefix));
+    std::optional<ExecutionCoalescer::Options> modelCoalescing;
+    if (coalescing.window > nn::Duration::zero() && ExecutionCoalescer::isBatchable(nnModel)) {
+        modelCoalescing = coalescing;
+    }
 
     Task task = [device, nnModel = std::move(nnModel), nnPreference, nnPriority, nnDeadline,
                  nnModelCache = std::move(nnModelCache), nnDataCache = std::move(nnDataCache),
                  nnToken, nnHints = std::move(nnHints),
-                 nnExtensionNameToPrefix = std::move(nnExtensionNameToPrefix), callback] {
+                 nnExtensionNameToPrefix = std::move(nnExtensionNameToPrefix),
+                 modelCoalescing = std::move(modelCoalescing), callback] {
         auto result =
                 device->prepareModel(nnModel, nnPreference, nnPriority, nnDeadline, nnModelCache,
                                      nnDataCache, nnToken, nnHints, nnExtensionNameToPrefix);
-        notify(callback.get(), std::move(result));
+        notify(callback.get(), std::move(result), modelCoalescing);
     };
-    executor(std::move(task), nnDeadline);
+    executor(std::move(task), makeDeadlineMissedTask(callback), nnPriority, nnDeadline);
 
     return {};
 }
 
 nn::GeneralResult<void> prepareModelFromCache(
-        const nn::SharedDevice& device, const Executor& executor, int64_t deadlineNs,
+        const nn::SharedDevice& device, const PrioritizedExecutor& executor, int64_t deadlineNs,
         const std::vector<ndk::ScopedFileDescriptor>& modelCache,
         const std::vector<ndk::ScopedFileDescriptor>& dataCache, const std::vector<uint8_t>& token,
         const std::shared_ptr<IPreparedModelCallback>& callback) {
@@ -213,17 +247,23 @@ nn::GeneralResult<void> prepareModelFromCache(
         auto result = device->prepareModelFromCache(nnDeadline, nnModelCache, nnDataCache, nnToken);
         notify(callback.get(), std::move(result));
     };
-    executor(std::move(task), nnDeadline);
+    executor(std::move(task), makeDeadlineMissedTask(callback), nn::Priority::DEFAULT,
+             nnDeadline);
 
     return {};
 }
 
 }  // namespace
 
-Device::Device(::android::nn::SharedDevice device, Executor executor)
-    : kDevice(std::move(device)), kExecutor(std::move(executor)) {
+Device::Device(::android::nn::SharedDevice device, PrioritizedExecutor executor,
+               const ExecutionCoalescer::Options& coalescing)
+    : kDevice(std::move(device)),
+      kExecutor(std::move(executor)),
+      kModelValidator(utils::ModelValidator::create()),
+      kCoalescing(coalescing) {
     CHECK(kDevice != nullptr);
     CHECK(kExecutor != nullptr);
+    CHECK(kModelValidator != nullptr);
 }
 
 ndk::ScopedAStatus Device::allocate(const BufferDesc& desc,
@@ -261,7 +301,7 @@ ndk::ScopedAStatus Device::getSupportedExtensions(std::vector<Extension>* extens
 
 ndk::ScopedAStatus Device::getSupportedOperations(const Model& model,
                                                   std::vector<bool>* supported) {
-    auto result = adapter::getSupportedOperations(*kDevice, model);
+    auto result = adapter::getSupportedOperations(*kDevice, *kModelValidator, model);
     if (!result.has_value()) {
         const auto& [message, code] = result.error();
         const auto aidlCode = utils::convert(code).value_or(ErrorStatus::GENERAL_FAILURE);
@@ -289,8 +329,9 @@ ndk::ScopedAStatus Device::prepareModel(const Model& model, ExecutionPreference
                                         const std::vector<uint8_t>& token,
                                         const std::shared_ptr<IPreparedModelCallback>& callback) {
     const auto result =
-            adapter::prepareModel(kDevice, kExecutor, model, preference, priority, deadlineNs,
-                                  modelCache, dataCache, token, {}, {}, callback);
+            adapter::prepareModel(kDevice, kExecutor, *kModelValidator, kCoalescing, model,
+                                  preference, priority, deadlineNs, modelCache, dataCache, token,
+                                  {}, {}, callback);
     if (!result.has_value()) {
         const auto& [message, code] = result.error();
         const auto aidlCode = utils::convert(code).value_or(ErrorStatus::GENERAL_FAILURE);
@@ -321,9 +362,10 @@ ndk::ScopedAStatus Device::prepareModelWithConfig(
         const Model& model, const PrepareModelConfig& config,
         const std::shared_ptr<IPreparedModelCallback>& callback) {
     const auto result = adapter::prepareModel(
-            kDevice, kExecutor, model, config.preference, config.priority, config.deadlineNs,
-            config.modelCache, config.dataCache, utils::toVec(config.cacheToken),
-            config.compilationHints, config.extensionNameToPrefix, callback);
+            kDevice, kExecutor, *kModelValidator, kCoalescing, model, config.preference,
+            config.priority, config.deadlineNs, config.modelCache, config.dataCache,
+            utils::toVec(config.cacheToken), config.compilationHints,
+            config.extensionNameToPrefix, callback);
     if (!result.has_value()) {
         const auto& [message, code] = result.error();
         const auto aidlCode = utils::convert(code).value_or(ErrorStatus::GENERAL_FAILURE);
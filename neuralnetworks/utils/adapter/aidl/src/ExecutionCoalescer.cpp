@@ -0,0 +1,356 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ExecutionCoalescer.h"
+
+#include <android-base/logging.h>
+#include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/TypeUtils.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/CommonUtils.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace aidl::android::hardware::neuralnetworks::adapter {
+namespace {
+
+// Alignment of the arguments of a batch within its memory
+constexpr size_t kAlignment = 64;
+// Memories of previous batches kept for the next batches
+constexpr size_t kMaxScratches = 4;
+
+// The dimensions and the length of each input, then of each output, of a request. Requests with
+// the same shape are batched together.
+using Shape = std::vector<std::pair<nn::Dimensions, uint32_t>>;
+
+std::optional<Shape> getShape(const nn::Request& request, size_t maxBatchSize) {
+    const auto isMemory = [](const nn::Request::MemoryPool& pool) {
+        return std::holds_alternative<nn::SharedMemory>(pool) &&
+               std::get<nn::SharedMemory>(pool) != nullptr;
+    };
+    if (!std::all_of(request.pools.begin(), request.pools.end(), isMemory)) {
+        return std::nullopt;
+    }
+
+    Shape shape;
+    shape.reserve(request.inputs.size() + request.outputs.size());
+    for (const auto* arguments : {&request.inputs, &request.outputs}) {
+        for (const auto& argument : *arguments) {
+            const auto& dimensions = argument.dimensions;
+            const auto isSpecified = [](uint32_t dimension) { return dimension > 0; };
+            if (argument.lifetime != nn::Request::Argument::LifeTime::POOL || dimensions.empty() ||
+                !std::all_of(dimensions.begin(), dimensions.end(), isSpecified) ||
+                argument.location.length == 0) {
+                return std::nullopt;
+            }
+            // The batched first dimension and length must fit in 32 bits
+            constexpr auto kMax = std::numeric_limits<uint32_t>::max();
+            if (dimensions.front() > kMax / maxBatchSize ||
+                argument.location.length > kMax / maxBatchSize) {
+                return std::nullopt;
+            }
+            shape.emplace_back(dimensions, argument.location.length);
+        }
+    }
+    return shape;
+}
+
+size_t align(size_t size) {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Divides the first dimension of each output shape of a batch by the number of its executions
+std::optional<std::vector<nn::OutputShape>> splitOutputShapes(
+        std::vector<nn::OutputShape> outputShapes, size_t count) {
+    for (auto& outputShape : outputShapes) {
+        auto& dimensions = outputShape.dimensions;
+        if (dimensions.empty() || dimensions.front() % count != 0) {
+            return std::nullopt;
+        }
+        dimensions.front() /= count;
+    }
+    return outputShapes;
+}
+
+}  // namespace
+
+struct ExecutionCoalescer::Member {
+    const nn::Request* request;
+    // Set by the leader of the batch. std::nullopt once done means that the member must execute
+    // its request alone.
+    std::optional<Result> result;
+    bool done = false;
+};
+
+struct ExecutionCoalescer::Batch {
+    Shape shape;
+    // Shared by all the members, so that none of them is executed under the deadline of another
+    nn::OptionalTimePoint deadline;
+    nn::OptionalDuration loopTimeoutDuration;
+    nn::TimePoint closeTime;
+    // The first member is the leader, which executes the batch
+    std::vector<Member*> members;
+    std::condition_variable joined;
+    std::condition_variable completed;
+};
+
+bool ExecutionCoalescer::isBatchable(const nn::Model& model) {
+    const auto hasBatchDimension = [&model](uint32_t index) {
+        const auto& dimensions = model.main.operands[index].dimensions;
+        return !dimensions.empty() && dimensions.front() == 0;
+    };
+    const auto& inputs = model.main.inputIndexes;
+    const auto& outputs = model.main.outputIndexes;
+    return std::all_of(inputs.begin(), inputs.end(), hasBatchDimension) &&
+           std::all_of(outputs.begin(), outputs.end(), hasBatchDimension);
+}
+
+ExecutionCoalescer::ExecutionCoalescer(nn::SharedPreparedModel preparedModel,
+                                       const Options& options)
+    : kPreparedModel(std::move(preparedModel)), kOptions(options) {
+    CHECK(kPreparedModel != nullptr);
+}
+
+std::optional<ExecutionCoalescer::Result> ExecutionCoalescer::execute(
+        const nn::Request& request, nn::MeasureTiming measure,
+        const nn::OptionalTimePoint& deadline,
+        const nn::OptionalDuration& loopTimeoutDuration) const {
+    // The timing of a batch is not the timing of any of its executions
+    if (kOptions.window <= nn::Duration::zero() || kOptions.maxBatchSize < 2 ||
+        measure == nn::MeasureTiming::YES) {
+        return std::nullopt;
+    }
+    auto shape = getShape(request, kOptions.maxBatchSize);
+    if (!shape.has_value()) {
+        return std::nullopt;
+    }
+
+    Member self = {.request = &request, .result = {}, .done = false};
+    std::unique_lock lock(mMutex);
+
+    // Join the open batch
+    if (mOpenBatch != nullptr) {
+        const auto batch = mOpenBatch;
+        if (batch->shape != *shape || batch->deadline != deadline ||
+            batch->loopTimeoutDuration != loopTimeoutDuration) {
+            return std::nullopt;
+        }
+        batch->members.push_back(&self);
+        if (batch->members.size() == kOptions.maxBatchSize) {
+            mOpenBatch = nullptr;
+        }
+        batch->joined.notify_one();
+        batch->completed.wait(lock, [&self] { return self.done; });
+        return std::move(self.result);
+    }
+
+    // Lead a new batch, and wait for other executions to join it
+    const auto batch = std::make_shared<Batch>();
+    batch->shape = std::move(shape).value();
+    batch->deadline = deadline;
+    batch->loopTimeoutDuration = loopTimeoutDuration;
+    batch->closeTime = nn::Clock::now() + kOptions.window;
+    if (deadline.has_value()) {
+        batch->closeTime = std::min(batch->closeTime, *deadline);
+    }
+    batch->members.push_back(&self);
+    mOpenBatch = batch;
+    while (mOpenBatch == batch && nn::Clock::now() < batch->closeTime) {
+        batch->joined.wait_until(lock, batch->closeTime);
+    }
+    if (mOpenBatch == batch) {
+        mOpenBatch = nullptr;
+    }
+    if (batch->members.size() == 1) {
+        return std::nullopt;
+    }
+    lock.unlock();
+
+    run(*batch);
+
+    lock.lock();
+    for (auto* member : batch->members) {
+        member->done = true;
+    }
+    batch->completed.notify_all();
+    return std::move(self.result);
+}
+
+void ExecutionCoalescer::run(const Batch& batch) const {
+    // Map the memories of the members. A member whose memories cannot be mapped, or whose
+    // arguments are out of the bounds of its memories, is left to execute its request alone.
+    struct Mapped {
+        Member* member;
+        std::vector<nn::Mapping> mappings;
+    };
+    std::vector<Mapped> batched;
+    batched.reserve(batch.members.size());
+    for (auto* member : batch.members) {
+        const auto& request = *member->request;
+        Mapped mapped = {.member = member, .mappings = {}};
+        bool valid = true;
+        for (const auto& pool : request.pools) {
+            auto mapping = nn::map(std::get<nn::SharedMemory>(pool));
+            if (!mapping.has_value()) {
+                valid = false;
+                break;
+            }
+            mapped.mappings.push_back(std::move(mapping).value());
+        }
+        const auto inBounds = [&mapped](const nn::Request::Argument& argument) {
+            const auto& location = argument.location;
+            return location.poolIndex < mapped.mappings.size() &&
+                   size_t{location.offset} + location.length <=
+                           mapped.mappings[location.poolIndex].size;
+        };
+        const auto writable = [&mapped](const nn::Request::Argument& argument) {
+            return std::holds_alternative<void*>(
+                    mapped.mappings[argument.location.poolIndex].pointer);
+        };
+        valid = valid && std::all_of(request.inputs.begin(), request.inputs.end(), inBounds) &&
+                std::all_of(request.outputs.begin(), request.outputs.end(), inBounds) &&
+                std::all_of(request.outputs.begin(), request.outputs.end(), writable);
+        if (valid) {
+            batched.push_back(std::move(mapped));
+        }
+    }
+    const size_t count = batched.size();
+    if (count < 2) {
+        return;
+    }
+
+    // Lay out each argument of the batch as the concatenation of the argument of each member
+    std::vector<size_t> offsets;
+    offsets.reserve(batch.shape.size());
+    size_t size = 0;
+    for (const auto& [dimensions, length] : batch.shape) {
+        offsets.push_back(size);
+        size = align(size + count * length);
+    }
+    auto scratch = takeScratch(size);
+    if (!scratch.has_value()) {
+        LOG(WARNING) << "Failed to create the memory of a batch: " << scratch.error().message;
+        return;
+    }
+    auto* data = static_cast<uint8_t*>(std::get<void*>(scratch->mapping.pointer));
+
+    // Gather the inputs and build the batched request
+    const size_t inputCount = batched.front().member->request->inputs.size();
+    const auto getArgument = [inputCount](const nn::Request& request,
+                                          size_t index) -> const nn::Request::Argument& {
+        return index < inputCount ? request.inputs[index] : request.outputs[index - inputCount];
+    };
+    nn::Request request = {.inputs = {}, .outputs = {}, .pools = {scratch->memory}};
+    for (size_t i = 0; i < batch.shape.size(); ++i) {
+        auto dimensions = batch.shape[i].first;
+        const uint32_t length = batch.shape[i].second;
+        dimensions.front() *= count;
+        auto& arguments = i < inputCount ? request.inputs : request.outputs;
+        arguments.push_back({.lifetime = nn::Request::Argument::LifeTime::POOL,
+                             .location = {.poolIndex = 0,
+                                          .offset = static_cast<uint32_t>(offsets[i]),
+                                          .length = static_cast<uint32_t>(count * length)},
+                             .dimensions = std::move(dimensions)});
+        if (i >= inputCount) {
+            continue;
+        }
+        for (size_t k = 0; k < count; ++k) {
+            const auto& location = getArgument(*batched[k].member->request, i).location;
+            std::visit(
+                    [&](auto* pointer) {
+                        std::memcpy(data + offsets[i] + k * length,
+                                    static_cast<const uint8_t*>(pointer) + location.offset,
+                                    length);
+                    },
+                    batched[k].mappings[location.poolIndex].pointer);
+        }
+    }
+
+    auto result = kPreparedModel->execute(request, nn::MeasureTiming::NO, batch.deadline,
+                                          batch.loopTimeoutDuration, {}, {});
+
+    // Scatter the outputs, or the error of the outputs, to the members. Any other error may be an
+    // error of the batch rather than of the requests, so the members execute their requests alone.
+    std::optional<Result> memberResult;
+    if (!result.has_value()) {
+        auto& [message, code, outputShapes] = result.error();
+        auto split = code == nn::ErrorStatus::OUTPUT_INSUFFICIENT_SIZE
+                             ? splitOutputShapes(std::move(outputShapes), count)
+                             : std::nullopt;
+        if (split.has_value()) {
+            memberResult = NN_ERROR(code, std::move(split).value()) << message;
+        } else {
+            LOG(WARNING) << "Batched execution failed with " << code << ": " << message;
+        }
+    } else if (auto outputShapes = splitOutputShapes(std::move(result).value().first, count);
+               !outputShapes.has_value()) {
+        LOG(WARNING) << "Unexpected output shapes of a batched execution";
+    } else {
+        for (size_t i = inputCount; i < batch.shape.size(); ++i) {
+            const uint32_t length = batch.shape[i].second;
+            for (size_t k = 0; k < count; ++k) {
+                const auto& location = getArgument(*batched[k].member->request, i).location;
+                auto* pointer = std::get<void*>(batched[k].mappings[location.poolIndex].pointer);
+                std::memcpy(static_cast<uint8_t*>(pointer) + location.offset,
+                            data + offsets[i] + k * length, length);
+            }
+        }
+        memberResult = std::make_pair(std::move(outputShapes).value(), nn::Timing{});
+    }
+    for (auto& mapped : batched) {
+        mapped.member->result = memberResult;
+    }
+    returnScratch(std::move(scratch).value());
+}
+
+nn::GeneralResult<ExecutionCoalescer::Scratch> ExecutionCoalescer::takeScratch(
+        size_t size) const {
+    {
+        std::lock_guard guard(mMutex);
+        const auto it = std::find_if(mScratches.begin(), mScratches.end(),
+                                     [size](const Scratch& scratch) {
+                                         return scratch.mapping.size >= size;
+                                     });
+        if (it != mScratches.end()) {
+            auto scratch = std::move(*it);
+            mScratches.erase(it);
+            return scratch;
+        }
+    }
+    auto memory = NN_TRY(nn::createSharedMemory(size));
+    auto mapping = NN_TRY(nn::map(memory));
+    return Scratch{.memory = std::move(memory), .mapping = std::move(mapping)};
+}
+
+void ExecutionCoalescer::returnScratch(Scratch scratch) const {
+    std::lock_guard guard(mMutex);
+    if (mScratches.size() < kMaxScratches) {
+        mScratches.push_back(std::move(scratch));
+    }
+}
+
+}  // namespace aidl::android::hardware::neuralnetworks::adapter
@@ -18,6 +18,7 @@
 
 #include "Burst.h"
 #include "Execution.h"
+#include "ExecutionCoalescer.h"
 
 #include <aidl/android/hardware/neuralnetworks/BnFencedExecutionCallback.h>
 #include <aidl/android/hardware/neuralnetworks/BnPreparedModel.h>
@@ -35,8 +36,12 @@
 #include <nnapi/Validation.h>
 #include <nnapi/hal/aidl/Conversions.h>
 #include <nnapi/hal/aidl/Utils.h>
+#include <sys/stat.h>
 
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -81,6 +86,37 @@ auto convertInput(const Type& object) -> decltype(nn::convert(std::declval<Type>
     return result;
 }
 
+// Converts the request as convertInput does, taking the memory pools from the cache
+nn::GeneralResult<nn::Request> convertRequest(
+        const Request& request, const PreparedModel::ThreadSafeRequestPoolCache& poolCache) {
+    auto result = [&request, &poolCache]() -> nn::GeneralResult<nn::Request> {
+        nn::Request nnRequest;
+        nnRequest.inputs.reserve(request.inputs.size());
+        for (const auto& input : request.inputs) {
+            nnRequest.inputs.push_back(NN_TRY(nn::unvalidatedConvert(input)));
+        }
+        nnRequest.outputs.reserve(request.outputs.size());
+        for (const auto& output : request.outputs) {
+            nnRequest.outputs.push_back(NN_TRY(nn::unvalidatedConvert(output)));
+        }
+        nnRequest.pools.reserve(request.pools.size());
+        for (const auto& pool : request.pools) {
+            if (pool.getTag() == RequestMemoryPool::Tag::pool) {
+                nnRequest.pools.push_back(
+                        NN_TRY(poolCache.getOrConvert(pool.get<RequestMemoryPool::Tag::pool>())));
+            } else {
+                nnRequest.pools.push_back(NN_TRY(nn::unvalidatedConvert(pool)));
+            }
+        }
+        NN_TRY(utils::compliantVersion(nnRequest));
+        return nnRequest;
+    }();
+    if (!result.has_value()) {
+        result.error().code = nn::ErrorStatus::INVALID_ARGUMENT;
+    }
+    return result;
+}
+
 nn::GeneralResult<std::vector<nn::SyncFence>> convertSyncFences(
         const std::vector<ndk::ScopedFileDescriptor>& waitFor) {
     auto handles = NN_TRY(convertInput(waitFor));
@@ -119,19 +155,29 @@ nn::GeneralResult<nn::OptionalTimePoint> makeOptionalTimePoint(int64_t durationN
 }
 
 nn::ExecutionResult<ExecutionResult> executeSynchronously(
-        const nn::IPreparedModel& preparedModel, const Request& request, bool measureTiming,
+        const nn::IPreparedModel& preparedModel,
+        const PreparedModel::ThreadSafeRequestPoolCache& poolCache,
+        const ExecutionCoalescer* coalescer, const Request& request, bool measureTiming,
         int64_t deadlineNs, int64_t loopTimeoutDurationNs, const std::vector<TokenValuePair>& hints,
         const std::vector<ExtensionNameAndPrefix>& extensionNameToPrefix) {
-    const auto nnRequest = NN_TRY(convertInput(request));
+    const auto nnRequest = NN_TRY(convertRequest(request, poolCache));
     const auto nnMeasureTiming = measureTiming ? nn::MeasureTiming::YES : nn::MeasureTiming::NO;
     const auto nnDeadline = NN_TRY(makeOptionalTimePoint(deadlineNs));
     const auto nnLoopTimeoutDuration = NN_TRY(makeOptionalDuration(loopTimeoutDurationNs));
     auto nnHints = NN_TRY(convertInput(hints));
     auto nnExtensionNameToPrefix = NN_TRY(convertInput(extensionNameToPrefix));
 
-    const auto result =
-            preparedModel.execute(nnRequest, nnMeasureTiming, nnDeadline, nnLoopTimeoutDuration,
-                                  nnHints, nnExtensionNameToPrefix);
+    // Executions with hints or extensions are not coalesced, as they may not apply to a batch
+    std::optional<ExecutionCoalescer::Result> coalesced;
+    if (coalescer != nullptr && nnHints.empty() && nnExtensionNameToPrefix.empty()) {
+        coalesced = coalescer->execute(nnRequest, nnMeasureTiming, nnDeadline,
+                                       nnLoopTimeoutDuration);
+    }
+    const auto result = coalesced.has_value()
+                                ? std::move(coalesced).value()
+                                : preparedModel.execute(nnRequest, nnMeasureTiming, nnDeadline,
+                                                        nnLoopTimeoutDuration, nnHints,
+                                                        nnExtensionNameToPrefix);
 
     if (!result.ok() && result.error().code == nn::ErrorStatus::OUTPUT_INSUFFICIENT_SIZE) {
         const auto& [message, code, outputShapes] = result.error();
@@ -148,12 +194,13 @@ nn::ExecutionResult<ExecutionResult> executeSynchronously(
 }
 
 nn::GeneralResult<FencedExecutionResult> executeFenced(
-        const nn::IPreparedModel& preparedModel, const Request& request,
+        const nn::IPreparedModel& preparedModel,
+        const PreparedModel::ThreadSafeRequestPoolCache& poolCache, const Request& request,
         const std::vector<ndk::ScopedFileDescriptor>& waitFor, bool measureTiming,
         int64_t deadlineNs, int64_t loopTimeoutDurationNs, int64_t durationNs,
         const std::vector<TokenValuePair>& hints,
         const std::vector<ExtensionNameAndPrefix>& extensionNameToPrefix) {
-    const auto nnRequest = NN_TRY(convertInput(request));
+    const auto nnRequest = NN_TRY(convertRequest(request, poolCache));
     const auto nnWaitFor = NN_TRY(convertSyncFences(waitFor));
     const auto nnMeasureTiming = measureTiming ? nn::MeasureTiming::YES : nn::MeasureTiming::NO;
     const auto nnDeadline = NN_TRY(makeOptionalTimePoint(deadlineNs));
@@ -234,8 +281,95 @@ nn::GeneralResult<FencedExecutionResult> executeFenced(
 
 }  // namespace
 
-PreparedModel::PreparedModel(nn::SharedPreparedModel preparedModel)
-    : kPreparedModel(std::move(preparedModel)) {
+PreparedModel::ThreadSafeRequestPoolCache::ThreadSafeRequestPoolCache(size_t maxEntries,
+                                                                      size_t maxBytes)
+    : kMaxEntries(maxEntries), kMaxBytes(maxBytes) {}
+
+bool PreparedModel::ThreadSafeRequestPoolCache::Key::operator<(const Key& other) const {
+    return std::tie(device, inode, tag, offset, size, prot) <
+           std::tie(other.device, other.inode, other.tag, other.offset, other.size, other.prot);
+}
+
+std::optional<PreparedModel::ThreadSafeRequestPoolCache::Key>
+PreparedModel::ThreadSafeRequestPoolCache::makeKey(const Memory& memory) {
+    int fd = -1;
+    int64_t offset = 0;
+    int64_t size = 0;
+    int32_t prot = 0;
+    switch (memory.getTag()) {
+        case Memory::Tag::ashmem: {
+            const auto& ashmem = memory.get<Memory::Tag::ashmem>();
+            fd = ashmem.fd.get();
+            size = ashmem.size;
+            break;
+        }
+        case Memory::Tag::mappableFile: {
+            const auto& mappableFile = memory.get<Memory::Tag::mappableFile>();
+            fd = mappableFile.fd.get();
+            offset = mappableFile.offset;
+            size = mappableFile.length;
+            prot = mappableFile.prot;
+            break;
+        }
+        case Memory::Tag::hardwareBuffer:
+            return std::nullopt;
+    }
+
+    // The inode of a regular file identifies its memory, but all the regions of /dev/ashmem
+    // share the inode of the device
+    struct stat status = {};
+    if (fd < 0 || size < 0 || fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        return std::nullopt;
+    }
+    return Key{.device = status.st_dev,
+               .inode = status.st_ino,
+               .tag = memory.getTag(),
+               .offset = offset,
+               .size = size,
+               .prot = prot};
+}
+
+nn::GeneralResult<nn::SharedMemory> PreparedModel::ThreadSafeRequestPoolCache::getOrConvert(
+        const Memory& memory) const {
+    const auto key = makeKey(memory);
+    if (!key.has_value() || kMaxEntries == 0 || static_cast<uint64_t>(key->size) > kMaxBytes) {
+        return nn::unvalidatedConvert(memory);
+    }
+
+    {
+        std::lock_guard guard(mMutex);
+        if (const auto it = mEntries.find(*key); it != mEntries.end()) {
+            mLru.splice(mLru.begin(), mLru, it->second.lruPosition);
+            return it->second.memory;
+        }
+    }
+
+    // Convert outside of the lock, as the conversion duplicates and maps the file descriptor
+    auto nnMemory = NN_TRY(nn::unvalidatedConvert(memory));
+
+    std::lock_guard guard(mMutex);
+    const auto [it, inserted] =
+            mEntries.try_emplace(*key, Entry{.memory = nnMemory, .lruPosition = {}});
+    if (!inserted) {
+        // Another execution converted the same memory concurrently
+        return it->second.memory;
+    }
+    mLru.push_front(*key);
+    it->second.lruPosition = mLru.begin();
+    mBytes += key->size;
+    while (mEntries.size() > kMaxEntries || mBytes > kMaxBytes) {
+        mBytes -= mLru.back().size;
+        mEntries.erase(mLru.back());
+        mLru.pop_back();
+    }
+    return nnMemory;
+}
+
+PreparedModel::PreparedModel(nn::SharedPreparedModel preparedModel, size_t maxCachedRequestPools,
+                             std::shared_ptr<const ExecutionCoalescer> coalescer)
+    : kPreparedModel(std::move(preparedModel)),
+      kRequestPoolCache(maxCachedRequestPools),
+      kCoalescer(std::move(coalescer)) {
     CHECK(kPreparedModel != nullptr);
 }
 
@@ -243,8 +377,9 @@ ndk::ScopedAStatus PreparedModel::executeSynchronously(const Request& request, b
                                                        int64_t deadlineNs,
                                                        int64_t loopTimeoutDurationNs,
                                                        ExecutionResult* executionResult) {
-    auto result = adapter::executeSynchronously(*kPreparedModel, request, measureTiming, deadlineNs,
-                                                loopTimeoutDurationNs, {}, {});
+    auto result = adapter::executeSynchronously(*kPreparedModel, kRequestPoolCache,
+                                                kCoalescer.get(), request, measureTiming,
+                                                deadlineNs, loopTimeoutDurationNs, {}, {});
     if (!result.has_value()) {
         const auto& [message, code, _] = result.error();
         const auto aidlCode = utils::convert(code).value_or(ErrorStatus::GENERAL_FAILURE);
@@ -259,8 +394,9 @@ ndk::ScopedAStatus PreparedModel::executeFenced(
         const Request& request, const std::vector<ndk::ScopedFileDescriptor>& waitFor,
         bool measureTiming, int64_t deadlineNs, int64_t loopTimeoutDurationNs, int64_t durationNs,
         FencedExecutionResult* executionResult) {
-    auto result = adapter::executeFenced(*kPreparedModel, request, waitFor, measureTiming,
-                                         deadlineNs, loopTimeoutDurationNs, durationNs, {}, {});
+    auto result = adapter::executeFenced(*kPreparedModel, kRequestPoolCache, request, waitFor,
+                                         measureTiming, deadlineNs, loopTimeoutDurationNs,
+                                         durationNs, {}, {});
     if (!result.has_value()) {
         const auto& [message, code] = result.error();
         const auto aidlCode = utils::convert(code).value_or(ErrorStatus::GENERAL_FAILURE);
@@ -276,8 +412,9 @@ ndk::ScopedAStatus PreparedModel::executeSynchronouslyWithConfig(const Request&
                                                                  int64_t deadlineNs,
                                                                  ExecutionResult* executionResult) {
     auto result = adapter::executeSynchronously(
-            *kPreparedModel, request, config.measureTiming, deadlineNs,
-            config.loopTimeoutDurationNs, config.executionHints, config.extensionNameToPrefix);
+            *kPreparedModel, kRequestPoolCache, kCoalescer.get(), request, config.measureTiming,
+            deadlineNs, config.loopTimeoutDurationNs, config.executionHints,
+            config.extensionNameToPrefix);
     if (!result.has_value()) {
         const auto& [message, code, _] = result.error();
         const auto aidlCode = utils::convert(code).value_or(ErrorStatus::GENERAL_FAILURE);
@@ -292,9 +429,10 @@ ndk::ScopedAStatus PreparedModel::executeFencedWithConfig(
         const Request& request, const std::vector<ndk::ScopedFileDescriptor>& waitFor,
         const ExecutionConfig& config, int64_t deadlineNs, int64_t durationNs,
         FencedExecutionResult* executionResult) {
-    auto result = adapter::executeFenced(*kPreparedModel, request, waitFor, config.measureTiming,
-                                         deadlineNs, config.loopTimeoutDurationNs, durationNs,
-                                         config.executionHints, config.extensionNameToPrefix);
+    auto result = adapter::executeFenced(
+            *kPreparedModel, kRequestPoolCache, request, waitFor, config.measureTiming, deadlineNs,
+            config.loopTimeoutDurationNs, durationNs, config.executionHints,
+            config.extensionNameToPrefix);
     if (!result.has_value()) {
         const auto& [message, code] = result.error();
         const auto aidlCode = utils::convert(code).value_or(ErrorStatus::GENERAL_FAILURE);
@@ -0,0 +1,387 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/TypeUtils.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/aidl/ExecutionCoalescer.h>
+
+#include <any>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aidl::android::hardware::neuralnetworks::adapter {
+namespace {
+
+namespace nn = ::android::nn;
+
+using Result = ExecutionCoalescer::Result;
+
+constexpr uint32_t kElements = 4;
+constexpr uint32_t kLength = kElements * sizeof(float);
+// Long enough for the executions of a test to join the same batch, which is executed as soon as
+// it is full
+constexpr auto kLongWindow = std::chrono::seconds(10);
+
+// Driver that adds one to each element of its input, or fails as told
+class FakePreparedModel final : public nn::IPreparedModel {
+  public:
+    nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> execute(
+            const nn::Request& request, nn::MeasureTiming /*measure*/,
+            const nn::OptionalTimePoint& deadline,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        std::lock_guard guard(mMutex);
+        mBatchSizes.push_back(request.inputs.front().dimensions.front());
+        mDeadlines.push_back(deadline);
+        if (mError.has_value()) {
+            return NN_ERROR(*mError, mOutputShapes) << "Fake error";
+        }
+
+        const auto& input = request.inputs.front().location;
+        const auto& output = request.outputs.front().location;
+        const auto mapping = NN_TRY(nn::map(std::get<nn::SharedMemory>(request.pools.front())));
+        auto* data = static_cast<uint8_t*>(std::get<void*>(mapping.pointer));
+        const auto* in = reinterpret_cast<const float*>(data + input.offset);
+        auto* out = reinterpret_cast<float*>(data + output.offset);
+        for (uint32_t i = 0; i < input.length / sizeof(float); ++i) {
+            out[i] = in[i] + 1;
+        }
+        auto outputShapes = mOutputShapes;
+        if (outputShapes.empty()) {
+            outputShapes.push_back(
+                    {.dimensions = request.outputs.front().dimensions, .isSufficient = true});
+        }
+        return std::make_pair(std::move(outputShapes), nn::Timing{});
+    }
+
+    nn::GeneralResult<std::pair<nn::SyncFence, nn::ExecuteFencedInfoCallback>> executeFenced(
+            const nn::Request& /*request*/, const std::vector<nn::SyncFence>& /*waitFor*/,
+            nn::MeasureTiming /*measure*/, const nn::OptionalTimePoint& /*deadline*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const nn::OptionalDuration& /*timeoutDurationAfterFence*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the test";
+    }
+
+    nn::GeneralResult<nn::SharedExecution> createReusableExecution(
+            const nn::Request& /*request*/, nn::MeasureTiming /*measure*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the test";
+    }
+
+    nn::GeneralResult<nn::SharedBurst> configureExecutionBurst() const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the test";
+    }
+
+    std::any getUnderlyingResource() const override { return {}; }
+
+    // Makes the next executions fail with `code`
+    void setError(nn::ErrorStatus code) {
+        std::lock_guard guard(mMutex);
+        mError = code;
+    }
+
+    // Makes the next executions return `outputShapes` instead of the dimensions of their outputs
+    void setOutputShapes(std::vector<nn::OutputShape> outputShapes) {
+        std::lock_guard guard(mMutex);
+        mOutputShapes = std::move(outputShapes);
+    }
+
+    std::vector<uint32_t> getBatchSizes() const {
+        std::lock_guard guard(mMutex);
+        return mBatchSizes;
+    }
+
+    std::vector<nn::OptionalTimePoint> getDeadlines() const {
+        std::lock_guard guard(mMutex);
+        return mDeadlines;
+    }
+
+  private:
+    mutable std::mutex mMutex;
+    std::optional<nn::ErrorStatus> mError;
+    std::vector<nn::OutputShape> mOutputShapes;
+    mutable std::vector<uint32_t> mBatchSizes;
+    mutable std::vector<nn::OptionalTimePoint> mDeadlines;
+};
+
+// Request of a client, with its input and its output in a single memory
+struct Client {
+    nn::Request request;
+    nn::Mapping mapping;
+
+    float* data() const { return static_cast<float*>(std::get<void*>(mapping.pointer)); }
+    const float* input() const { return data(); }
+    const float* output() const { return data() + kElements; }
+};
+
+Client createClient(float value) {
+    auto memory = nn::createSharedMemory(2 * kLength).value();
+    auto mapping = nn::map(memory).value();
+    Client client = {.request = {}, .mapping = std::move(mapping)};
+    for (uint32_t i = 0; i < kElements; ++i) {
+        client.data()[i] = value + i;
+    }
+    client.request.pools.push_back(std::move(memory));
+    client.request.inputs.push_back({.lifetime = nn::Request::Argument::LifeTime::POOL,
+                                     .location = {.poolIndex = 0, .offset = 0, .length = kLength},
+                                     .dimensions = {1, kElements}});
+    client.request.outputs.push_back(
+            {.lifetime = nn::Request::Argument::LifeTime::POOL,
+             .location = {.poolIndex = 0, .offset = kLength, .length = kLength},
+             .dimensions = {1, kElements}});
+    return client;
+}
+
+// Executes the request of each client on its own thread, with the deadline of the client
+std::vector<std::optional<Result>> executeConcurrently(
+        const ExecutionCoalescer& coalescer, const std::vector<Client>& clients,
+        const std::vector<nn::OptionalTimePoint>& deadlines = {}) {
+    std::vector<std::optional<Result>> results(clients.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < clients.size(); ++i) {
+        const auto deadline = i < deadlines.size() ? deadlines[i] : nn::OptionalTimePoint{};
+        threads.emplace_back([&coalescer, &clients, &results, i, deadline] {
+            results[i] = coalescer.execute(clients[i].request, nn::MeasureTiming::NO, deadline,
+                                           /*loopTimeoutDuration=*/{});
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return results;
+}
+
+void expectExecuted(const Client& client, const std::optional<Result>& result) {
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->has_value())
+            << "Failed with " << result->error().code << ": " << result->error().message;
+    const auto& outputShapes = result->value().first;
+    ASSERT_EQ(outputShapes.size(), 1u);
+    EXPECT_EQ(outputShapes.front().dimensions, (nn::Dimensions{1, kElements}));
+    for (uint32_t i = 0; i < kElements; ++i) {
+        EXPECT_EQ(client.output()[i], client.input()[i] + 1);
+    }
+}
+
+}  // namespace
+
+TEST(ExecutionCoalescerTest, disabledWithoutWindow) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    const ExecutionCoalescer coalescer(driver, {.window = nn::Duration::zero(), .maxBatchSize = 8});
+    const auto client = createClient(0);
+
+    // run test
+    const auto result = coalescer.execute(client.request, nn::MeasureTiming::NO, {},
+                                          /*loopTimeoutDuration=*/{});
+
+    // verify result
+    EXPECT_FALSE(result.has_value());
+    EXPECT_TRUE(driver->getBatchSizes().empty());
+}
+
+TEST(ExecutionCoalescerTest, executionMeasuringTimingIsExecutedAlone) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    const ExecutionCoalescer coalescer(driver, {.window = kLongWindow, .maxBatchSize = 8});
+    const auto client = createClient(0);
+
+    // run test
+    const auto result = coalescer.execute(client.request, nn::MeasureTiming::YES, {},
+                                          /*loopTimeoutDuration=*/{});
+
+    // verify result
+    EXPECT_FALSE(result.has_value());
+    EXPECT_TRUE(driver->getBatchSizes().empty());
+}
+
+TEST(ExecutionCoalescerTest, batchClosesAtEndOfWindow) {
+    // setup test
+    constexpr auto kWindow = std::chrono::milliseconds(20);
+    const auto driver = std::make_shared<FakePreparedModel>();
+    const ExecutionCoalescer coalescer(driver, {.window = kWindow, .maxBatchSize = 8});
+    const auto client = createClient(0);
+    const auto start = nn::Clock::now();
+
+    // run test
+    const auto result = coalescer.execute(client.request, nn::MeasureTiming::NO, {},
+                                          /*loopTimeoutDuration=*/{});
+
+    // verify result
+    EXPECT_FALSE(result.has_value());
+    EXPECT_GE(nn::Clock::now() - start, kWindow);
+    EXPECT_TRUE(driver->getBatchSizes().empty());
+}
+
+TEST(ExecutionCoalescerTest, executionsJoinOpenBatch) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    const ExecutionCoalescer coalescer(driver,
+                                       {.window = std::chrono::seconds(1), .maxBatchSize = 8});
+    const std::vector<Client> clients = {createClient(0), createClient(10)};
+
+    // run test
+    const auto results = executeConcurrently(coalescer, clients);
+
+    // verify result
+    for (size_t i = 0; i < clients.size(); ++i) {
+        expectExecuted(clients[i], results[i]);
+    }
+    EXPECT_EQ(driver->getBatchSizes(), std::vector<uint32_t>{2});
+}
+
+TEST(ExecutionCoalescerTest, fullBatchIsExecutedOnceWithSlicedOutputs) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    const ExecutionCoalescer coalescer(driver, {.window = kLongWindow, .maxBatchSize = 4});
+    const std::vector<Client> clients = {createClient(0), createClient(10), createClient(20),
+                                         createClient(30)};
+
+    // run test
+    const auto results = executeConcurrently(coalescer, clients);
+
+    // verify result
+    for (size_t i = 0; i < clients.size(); ++i) {
+        expectExecuted(clients[i], results[i]);
+    }
+    EXPECT_EQ(driver->getBatchSizes(), std::vector<uint32_t>{4});
+}
+
+TEST(ExecutionCoalescerTest, executionsWithSameDeadlineAreBatched) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    const ExecutionCoalescer coalescer(driver, {.window = kLongWindow, .maxBatchSize = 2});
+    const std::vector<Client> clients = {createClient(0), createClient(10)};
+    const nn::TimePoint deadline = nn::Clock::now() + kLongWindow;
+
+    // run test
+    const auto results = executeConcurrently(coalescer, clients, {deadline, deadline});
+
+    // verify result
+    for (size_t i = 0; i < clients.size(); ++i) {
+        expectExecuted(clients[i], results[i]);
+    }
+    EXPECT_EQ(driver->getDeadlines(), std::vector<nn::OptionalTimePoint>{deadline});
+}
+
+TEST(ExecutionCoalescerTest, executionsWithDifferentDeadlinesAreExecutedAlone) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    const ExecutionCoalescer coalescer(driver, {.window = kLongWindow, .maxBatchSize = 2});
+    const std::vector<Client> clients = {createClient(0), createClient(10)};
+    const nn::TimePoint now = nn::Clock::now();
+
+    // run test
+    const auto results = executeConcurrently(
+            coalescer, clients,
+            {now + std::chrono::milliseconds(100), now + std::chrono::milliseconds(200)});
+
+    // verify result
+    EXPECT_FALSE(results[0].has_value());
+    EXPECT_FALSE(results[1].has_value());
+    EXPECT_TRUE(driver->getBatchSizes().empty());
+}
+
+TEST(ExecutionCoalescerTest, memberOutOfBoundsIsExecutedAlone) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    const ExecutionCoalescer coalescer(driver, {.window = kLongWindow, .maxBatchSize = 3});
+    std::vector<Client> clients = {createClient(0), createClient(10), createClient(20)};
+    clients[1].request.outputs.front().location.offset = 2 * kLength;
+
+    // run test
+    const auto results = executeConcurrently(coalescer, clients);
+
+    // verify result
+    expectExecuted(clients[0], results[0]);
+    EXPECT_FALSE(results[1].has_value());
+    expectExecuted(clients[2], results[2]);
+    EXPECT_EQ(driver->getBatchSizes(), std::vector<uint32_t>{2});
+}
+
+TEST(ExecutionCoalescerTest, failedBatchIsExecutedAlone) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    driver->setError(nn::ErrorStatus::GENERAL_FAILURE);
+    const ExecutionCoalescer coalescer(driver, {.window = kLongWindow, .maxBatchSize = 2});
+    const std::vector<Client> clients = {createClient(0), createClient(10)};
+
+    // run test
+    const auto results = executeConcurrently(coalescer, clients);
+
+    // verify result
+    EXPECT_FALSE(results[0].has_value());
+    EXPECT_FALSE(results[1].has_value());
+    EXPECT_EQ(driver->getBatchSizes(), std::vector<uint32_t>{2});
+}
+
+TEST(ExecutionCoalescerTest, outputInsufficientSizeIsSlicedToMembers) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    driver->setError(nn::ErrorStatus::OUTPUT_INSUFFICIENT_SIZE);
+    driver->setOutputShapes({{.dimensions = {2, 2 * kElements}, .isSufficient = false}});
+    const ExecutionCoalescer coalescer(driver, {.window = kLongWindow, .maxBatchSize = 2});
+    const std::vector<Client> clients = {createClient(0), createClient(10)};
+
+    // run test
+    const auto results = executeConcurrently(coalescer, clients);
+
+    // verify result
+    for (const auto& result : results) {
+        ASSERT_TRUE(result.has_value());
+        ASSERT_FALSE(result->has_value());
+        EXPECT_EQ(result->error().code, nn::ErrorStatus::OUTPUT_INSUFFICIENT_SIZE);
+        ASSERT_EQ(result->error().outputShapes.size(), 1u);
+        EXPECT_EQ(result->error().outputShapes.front().dimensions,
+                  (nn::Dimensions{1, 2 * kElements}));
+        EXPECT_FALSE(result->error().outputShapes.front().isSufficient);
+    }
+}
+
+TEST(ExecutionCoalescerTest, unexpectedOutputShapesAreExecutedAlone) {
+    // setup test
+    const auto driver = std::make_shared<FakePreparedModel>();
+    driver->setOutputShapes({{.dimensions = {3, kElements}, .isSufficient = true}});
+    const ExecutionCoalescer coalescer(driver, {.window = kLongWindow, .maxBatchSize = 2});
+    const std::vector<Client> clients = {createClient(0), createClient(10)};
+
+    // run test
+    const auto results = executeConcurrently(coalescer, clients);
+
+    // verify result
+    EXPECT_FALSE(results[0].has_value());
+    EXPECT_FALSE(results[1].has_value());
+}
+
+}  // namespace aidl::android::hardware::neuralnetworks::adapter
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/common/MappableFile.h>
+#include <aidl/android/hardware/neuralnetworks/Memory.h>
+#include <android-base/unique_fd.h>
+#include <android/binder_auto_utils.h>
+#include <gtest/gtest.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/aidl/Conversions.h>
+#include <nnapi/hal/aidl/PreparedModel.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace aidl::android::hardware::neuralnetworks::adapter {
+namespace {
+
+namespace nn = ::android::nn;
+
+using Cache = PreparedModel::ThreadSafeRequestPoolCache;
+
+constexpr int64_t kSize = 4096;
+
+// Memory of a memfd, which is a regular file with its own inode
+Memory createMappableFile(int64_t size = kSize) {
+    ::android::base::unique_fd fd(memfd_create("RequestPoolCacheTest", MFD_CLOEXEC));
+    EXPECT_TRUE(fd.ok());
+    EXPECT_EQ(ftruncate(fd.get(), size), 0);
+    return Memory::make<Memory::Tag::mappableFile>(
+            common::MappableFile{.length = size,
+                                 .prot = PROT_READ | PROT_WRITE,
+                                 .fd = ndk::ScopedFileDescriptor(fd.release()),
+                                 .offset = 0});
+}
+
+Memory createAshmem() {
+    return utils::convert(nn::createSharedMemory(kSize).value()).value();
+}
+
+}  // namespace
+
+TEST(RequestPoolCacheTest, sameMemoryIsConvertedOnce) {
+    // setup test
+    const Cache cache;
+    const auto memory = createMappableFile();
+    const auto first = cache.getOrConvert(memory).value();
+
+    // run test
+    const auto result = cache.getOrConvert(memory);
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(result.value(), first);
+}
+
+TEST(RequestPoolCacheTest, distinctFilesOfSameSizeAreNotShared) {
+    // setup test
+    const Cache cache;
+    const auto memory = createMappableFile();
+    const auto other = createMappableFile();
+    const auto first = cache.getOrConvert(memory).value();
+
+    // run test
+    const auto result = cache.getOrConvert(other);
+
+    // verify result
+    ASSERT_TRUE(result.has_value());
+    EXPECT_NE(result.value(), first);
+}
+
+TEST(RequestPoolCacheTest, distinctAshmemRegionsOfSameSizeAreNotShared) {
+    // setup test
+    const Cache cache;
+    const auto memory = createAshmem();
+    const auto other = createAshmem();
+    const auto first = cache.getOrConvert(memory).value();
+
+    // run test
+    const auto result = cache.getOrConvert(other);
+
+    // verify result
+    ASSERT_TRUE(result.has_value());
+    EXPECT_NE(result.value(), first);
+    // The two regions are not aliased either
+    const auto firstMapping = nn::map(first).value();
+    const auto resultMapping = nn::map(result.value()).value();
+    *static_cast<uint8_t*>(std::get<void*>(firstMapping.pointer)) = 1;
+    *static_cast<uint8_t*>(std::get<void*>(resultMapping.pointer)) = 2;
+    EXPECT_EQ(*static_cast<uint8_t*>(std::get<void*>(firstMapping.pointer)), 1);
+}
+
+TEST(RequestPoolCacheTest, evictsLeastRecentlyUsedMemory) {
+    // setup test
+    const Cache cache(/*maxEntries=*/2);
+    const auto memory = createMappableFile();
+    const auto stale = createMappableFile();
+    const auto staleFirst = cache.getOrConvert(stale).value();
+    const auto first = cache.getOrConvert(memory).value();
+    ASSERT_EQ(cache.getOrConvert(stale).value(), staleFirst);
+    ASSERT_EQ(cache.getOrConvert(memory).value(), first);
+
+    // run test
+    const auto result = cache.getOrConvert(createMappableFile());
+
+    // verify result
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(cache.getOrConvert(memory).value(), first);
+    EXPECT_NE(cache.getOrConvert(stale).value(), staleFirst);
+}
+
+TEST(RequestPoolCacheTest, evictsWhenOverMaxBytes) {
+    // setup test
+    const Cache cache(Cache::kDefaultMaxEntries, /*maxBytes=*/2 * kSize);
+    const auto memory = createMappableFile();
+    const auto first = cache.getOrConvert(memory).value();
+    ASSERT_TRUE(cache.getOrConvert(createMappableFile()).has_value());
+    ASSERT_TRUE(cache.getOrConvert(createMappableFile()).has_value());
+
+    // run test
+    const auto result = cache.getOrConvert(memory);
+
+    // verify result
+    ASSERT_TRUE(result.has_value());
+    EXPECT_NE(result.value(), first);
+}
+
+TEST(RequestPoolCacheTest, memoryLargerThanMaxBytesIsNotCached) {
+    // setup test
+    const Cache cache(Cache::kDefaultMaxEntries, /*maxBytes=*/kSize);
+    const auto memory = createMappableFile(2 * kSize);
+    const auto first = cache.getOrConvert(memory).value();
+
+    // run test
+    const auto result = cache.getOrConvert(memory);
+
+    // verify result
+    ASSERT_TRUE(result.has_value());
+    EXPECT_NE(result.value(), first);
+}
+
+TEST(RequestPoolCacheTest, concurrentConversionsShareOneMemory) {
+    // setup test
+    constexpr size_t kThreadCount = 8;
+    constexpr size_t kConversionsPerThread = 64;
+    const Cache cache;
+    const auto memory = createMappableFile();
+    std::vector<std::vector<nn::SharedMemory>> results(kThreadCount);
+
+    // run test
+    std::vector<std::thread> threads;
+    for (auto& threadResults : results) {
+        threads.emplace_back([&cache, &memory, &threadResults] {
+            for (size_t i = 0; i < kConversionsPerThread; ++i) {
+                threadResults.push_back(cache.getOrConvert(memory).value());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // verify result
+    const auto expected = cache.getOrConvert(memory).value();
+    for (const auto& threadResults : results) {
+        ASSERT_EQ(threadResults.size(), kConversionsPerThread);
+        for (const auto& result : threadResults) {
+            EXPECT_EQ(result, expected);
+        }
+    }
+}
+
+}  // namespace aidl::android::hardware::neuralnetworks::adapter
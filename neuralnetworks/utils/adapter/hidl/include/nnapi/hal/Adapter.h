@@ -43,6 +43,17 @@ using Task = std::function<void()>;
  */
 using Executor = std::function<void(Task, nn::OptionalTimePoint)>;
 
+/**
+ * A type-erased executor which executes a task asynchronously, and is also provided the priority
+ * of the task.
+ *
+ * If the deadline passes before the task starts, the executor may run onDeadlineMissed instead of
+ * the task, which notifies the client that the deadline was missed.
+ */
+using PrioritizedExecutor =
+        std::function<void(Task task, Task onDeadlineMissed, nn::Priority priority,
+                           nn::OptionalTimePoint deadline)>;
+
 /**
  * Adapt an NNAPI canonical interface object to a HIDL NN HAL interface object.
  *
@@ -55,7 +66,17 @@ sp<V1_3::IDevice> adapt(nn::SharedDevice device, Executor executor);
 /**
  * Adapt an NNAPI canonical interface object to a HIDL NN HAL interface object.
  *
- * This function uses a default executor, which will execute tasks from a detached thread.
+ * @param device NNAPI canonical IDevice interface object to be adapted.
+ * @param executor Type-erased executor to handle executing tasks asynchronously by priority.
+ * @return HIDL NN HAL IDevice interface object.
+ */
+sp<V1_3::IDevice> adapt(nn::SharedDevice device, PrioritizedExecutor executor);
+
+/**
+ * Adapt an NNAPI canonical interface object to a HIDL NN HAL interface object.
+ *
+ * This function uses a default executor, which executes tasks on a bounded pool of threads in
+ * order of priority and deadline, and sheds the tasks whose deadline passes before they start.
  *
  * @param device NNAPI canonical IDevice interface object to be adapted.
  * @return HIDL NN HAL IDevice interface object.
@@ -123,6 +123,26 @@ class Burst : public V1_2::IBurstContext {
             nn::SharedBurst burstExecutor,
             std::chrono::microseconds pollingTimeWindow = std::chrono::microseconds{0});
 
+    /**
+     * Create automated context to manage FMQ-based executions.
+     *
+     * @param callback Callback used to retrieve memories corresponding to unrecognized slots.
+     * @param requestChannel Input FMQ channel through which the client passes the request to the
+     *     service.
+     * @param resultChannel Output FMQ channel from which the client can retrieve the result of the
+     *     execution.
+     * @param burstExecutor Object which maintains a local cache of the memory pools and executes
+     *     using the cached memory pools.
+     * @param pollingPolicy Decides how long the Burst polls the FMQ before waiting on the blocking
+     *     futex.
+     * @return V1_2::IBurstContext Handle to the burst context.
+     */
+    static nn::GeneralResult<sp<Burst>> create(
+            const sp<V1_2::IBurstCallback>& callback,
+            const MQDescriptorSync<V1_2::FmqRequestDatum>& requestChannel,
+            const MQDescriptorSync<V1_2::FmqResultDatum>& resultChannel,
+            nn::SharedBurst burstExecutor, V1_2::utils::BurstPollingPolicy pollingPolicy);
+
     Burst(PrivateConstructorTag tag, const sp<V1_2::IBurstCallback>& callback,
           std::unique_ptr<V1_2::utils::RequestChannelReceiver> requestChannel,
           std::unique_ptr<V1_2::utils::ResultChannelSender> resultChannel,
@@ -18,13 +18,14 @@
 
 #include "Device.h"
 
+#include <android-base/logging.h>
 #include <android/hardware/neuralnetworks/1.3/IDevice.h>
 #include <nnapi/IDevice.h>
 #include <nnapi/Types.h>
+#include <nnapi/hal/ThreadPoolExecutor.h>
 
 #include <functional>
 #include <memory>
-#include <thread>
 
 // See hardware/interfaces/neuralnetworks/utils/README.md for more information on HIDL interface
 // lifetimes across processes and for protecting asynchronous calls across HIDL.
@@ -32,12 +33,29 @@
 namespace android::hardware::neuralnetworks::adapter {
 
 sp<V1_3::IDevice> adapt(nn::SharedDevice device, Executor executor) {
+    CHECK(executor != nullptr);
+    // The tasks are never shed, as the executor can't report the missed deadline
+    PrioritizedExecutor prioritizedExecutor =
+            [executor = std::move(executor)](Task task, Task /*onDeadlineMissed*/,
+                                             nn::Priority /*priority*/,
+                                             nn::OptionalTimePoint deadline) {
+                executor(std::move(task), deadline);
+            };
+    return adapt(std::move(device), std::move(prioritizedExecutor));
+}
+
+sp<V1_3::IDevice> adapt(nn::SharedDevice device, PrioritizedExecutor executor) {
     return sp<Device>::make(std::move(device), std::move(executor));
 }
 
 sp<V1_3::IDevice> adapt(nn::SharedDevice device) {
-    Executor defaultExecutor = [](Task task, nn::OptionalTimePoint /*deadline*/) {
-        std::thread(std::move(task)).detach();
+    // The pool is destroyed with the last reference to the device, after its queued tasks
+    auto pool = std::make_shared<utils::ThreadPoolExecutor>();
+    PrioritizedExecutor defaultExecutor = [pool = std::move(pool)](
+                                                  Task task, Task onDeadlineMissed,
+                                                  nn::Priority priority,
+                                                  nn::OptionalTimePoint deadline) {
+        pool->execute(std::move(task), std::move(onDeadlineMissed), priority, deadline);
     };
     return adapt(std::move(device), std::move(defaultExecutor));
 }
@@ -145,6 +145,15 @@ nn::GeneralResult<sp<Burst>> Burst::create(
         const MQDescriptorSync<V1_2::FmqRequestDatum>& requestChannel,
         const MQDescriptorSync<V1_2::FmqResultDatum>& resultChannel, nn::SharedBurst burstExecutor,
         std::chrono::microseconds pollingTimeWindow) {
+    return create(callback, requestChannel, resultChannel, std::move(burstExecutor),
+                  V1_2::utils::BurstPollingPolicy::fixed(pollingTimeWindow));
+}
+
+nn::GeneralResult<sp<Burst>> Burst::create(
+        const sp<V1_2::IBurstCallback>& callback,
+        const MQDescriptorSync<V1_2::FmqRequestDatum>& requestChannel,
+        const MQDescriptorSync<V1_2::FmqResultDatum>& resultChannel, nn::SharedBurst burstExecutor,
+        V1_2::utils::BurstPollingPolicy pollingPolicy) {
     // check inputs
     if (callback == nullptr || burstExecutor == nullptr) {
         return NN_ERROR() << "Burst::create passed a nullptr";
@@ -152,7 +161,7 @@ nn::GeneralResult<sp<Burst>> Burst::create(
 
     // create FMQ objects
     auto requestChannelReceiver =
-            NN_TRY(V1_2::utils::RequestChannelReceiver::create(requestChannel, pollingTimeWindow));
+            NN_TRY(V1_2::utils::RequestChannelReceiver::create(requestChannel, pollingPolicy));
     auto resultChannelSender = NN_TRY(V1_2::utils::ResultChannelSender::create(resultChannel));
 
     // check FMQ objects
@@ -117,6 +117,13 @@ void notify(CallbackType* callback, PrepareModelResult result) {
     }
 }
 
+// Run by the executor instead of a task whose deadline passed before it started
+Task makeDeadlineMissedTask(sp<V1_3::IPreparedModelCallback> callback) {
+    return [callback = std::move(callback)] {
+        notify(callback.get(), nn::ErrorStatus::MISSED_DEADLINE_TRANSIENT, nullptr);
+    };
+}
+
 template <typename ModelType>
 nn::GeneralResult<hidl_vec<bool>> getSupportedOperations(const nn::SharedDevice& device,
                                                          const ModelType& model) {
@@ -124,8 +131,8 @@ nn::GeneralResult<hidl_vec<bool>> getSupportedOperations(const nn::SharedDevice&
     return NN_TRY(device->getSupportedOperations(nnModel));
 }
 
-nn::GeneralResult<void> prepareModel(const nn::SharedDevice& device, const Executor& executor,
-                                     const V1_0::Model& model,
+nn::GeneralResult<void> prepareModel(const nn::SharedDevice& device,
+                                     const PrioritizedExecutor& executor, const V1_0::Model& model,
                                      const sp<V1_0::IPreparedModelCallback>& callback) {
     if (callback.get() == nullptr) {
         return NN_ERROR(nn::ErrorStatus::INVALID_ARGUMENT) << "Invalid callback";
@@ -138,12 +145,13 @@ nn::GeneralResult<void> prepareModel(const nn::SharedDevice& device, const Execu
                                            nn::Priority::DEFAULT, {}, {}, {}, {}, {}, {});
         notify(callback.get(), std::move(result));
     };
-    executor(std::move(task), {});
+    executor(std::move(task), {}, nn::Priority::DEFAULT, {});
 
     return {};
 }
 
-nn::GeneralResult<void> prepareModel_1_1(const nn::SharedDevice& device, const Executor& executor,
+nn::GeneralResult<void> prepareModel_1_1(const nn::SharedDevice& device,
+                                         const PrioritizedExecutor& executor,
                                          const V1_1::Model& model,
                                          V1_1::ExecutionPreference preference,
                                          const sp<V1_0::IPreparedModelCallback>& callback) {
@@ -159,12 +167,13 @@ nn::GeneralResult<void> prepareModel_1_1(const nn::SharedDevice& device, const E
                                            {}, {}, {});
         notify(callback.get(), std::move(result));
     };
-    executor(std::move(task), {});
+    executor(std::move(task), {}, nn::Priority::DEFAULT, {});
 
     return {};
 }
 
-nn::GeneralResult<void> prepareModel_1_2(const nn::SharedDevice& device, const Executor& executor,
+nn::GeneralResult<void> prepareModel_1_2(const nn::SharedDevice& device,
+                                         const PrioritizedExecutor& executor,
                                          const V1_2::Model& model,
                                          V1_1::ExecutionPreference preference,
                                          const hidl_vec<hidl_handle>& modelCache,
@@ -188,14 +197,14 @@ nn::GeneralResult<void> prepareModel_1_2(const nn::SharedDevice& device, const E
                                            nnModelCache, nnDataCache, nnToken, {}, {});
         notify(callback.get(), std::move(result));
     };
-    executor(std::move(task), {});
+    executor(std::move(task), {}, nn::Priority::DEFAULT, {});
 
     return {};
 }
 
 nn::GeneralResult<void> prepareModel_1_3(
-        const nn::SharedDevice& device, const Executor& executor, const V1_3::Model& model,
-        V1_1::ExecutionPreference preference, V1_3::Priority priority,
+        const nn::SharedDevice& device, const PrioritizedExecutor& executor,
+        const V1_3::Model& model, V1_1::ExecutionPreference preference, V1_3::Priority priority,
         const V1_3::OptionalTimePoint& deadline, const hidl_vec<hidl_handle>& modelCache,
         const hidl_vec<hidl_handle>& dataCache, const CacheToken& token,
         const sp<V1_3::IPreparedModelCallback>& callback) {
@@ -218,13 +227,13 @@ nn::GeneralResult<void> prepareModel_1_3(
                                            nnModelCache, nnDataCache, nnToken, {}, {});
         notify(callback.get(), std::move(result));
     };
-    executor(std::move(task), nnDeadline);
+    executor(std::move(task), makeDeadlineMissedTask(callback), nnPriority, nnDeadline);
 
     return {};
 }
 
 nn::GeneralResult<void> prepareModelFromCache(const nn::SharedDevice& device,
-                                              const Executor& executor,
+                                              const PrioritizedExecutor& executor,
                                               const hidl_vec<hidl_handle>& modelCache,
                                               const hidl_vec<hidl_handle>& dataCache,
                                               const CacheToken& token,
@@ -242,13 +251,13 @@ nn::GeneralResult<void> prepareModelFromCache(const nn::SharedDevice& device,
         auto result = device->prepareModelFromCache({}, nnModelCache, nnDataCache, nnToken);
         notify(callback.get(), std::move(result));
     };
-    executor(std::move(task), {});
+    executor(std::move(task), {}, nn::Priority::DEFAULT, {});
 
     return {};
 }
 
 nn::GeneralResult<void> prepareModelFromCache_1_3(
-        const nn::SharedDevice& device, const Executor& executor,
+        const nn::SharedDevice& device, const PrioritizedExecutor& executor,
         const V1_3::OptionalTimePoint& deadline, const hidl_vec<hidl_handle>& modelCache,
         const hidl_vec<hidl_handle>& dataCache, const CacheToken& token,
         const sp<V1_3::IPreparedModelCallback>& callback) {
@@ -266,7 +275,8 @@ nn::GeneralResult<void> prepareModelFromCache_1_3(
         auto result = device->prepareModelFromCache(nnDeadline, nnModelCache, nnDataCache, nnToken);
         notify(callback.get(), std::move(result));
     };
-    executor(std::move(task), nnDeadline);
+    executor(std::move(task), makeDeadlineMissedTask(callback), nn::Priority::DEFAULT,
+             nnDeadline);
 
     return {};
 }
@@ -314,7 +324,7 @@ nn::GeneralResult<std::pair<sp<V1_3::IBuffer>, uint32_t>> allocate(
 
 }  // namespace
 
-Device::Device(nn::SharedDevice device, Executor executor)
+Device::Device(nn::SharedDevice device, PrioritizedExecutor executor)
     : kDevice(std::move(device)), kExecutor(std::move(executor)) {
     CHECK(kDevice != nullptr);
     CHECK(kExecutor != nullptr);
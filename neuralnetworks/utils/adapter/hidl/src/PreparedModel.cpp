@@ -253,7 +253,7 @@ nn::GeneralResult<sp<V1_2::IBurstContext>> configureExecutionBurst(
         const MQDescriptorSync<V1_2::FmqResultDatum>& resultChannel) {
     auto burstExecutor = NN_TRY(preparedModel->configureExecutionBurst());
     return Burst::create(callback, requestChannel, resultChannel, std::move(burstExecutor),
-                         V1_2::utils::getBurstServerPollingTimeWindow());
+                         V1_2::utils::getBurstServerPollingPolicy());
 }
 
 nn::GeneralResult<std::pair<hidl_handle, sp<V1_3::IFencedExecutionCallback>>> executeFenced(
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/aidl/BufferTracker.h>
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace android::nn {
+namespace {
+
+// Device memories of an inference: an input, an output and two intermediate tensors passed
+// between the prepared models of a pipeline
+constexpr uint32_t kBuffersPerInference = 4;
+
+const aidl_hal::IPreparedModel* fakePreparedModel(uintptr_t id) {
+    return reinterpret_cast<const aidl_hal::IPreparedModel*>(id);
+}
+
+std::set<AidlHalPreparedModelRole> makeRoles(uint32_t index) {
+    return {{fakePreparedModel(1), IOType::OUTPUT, index},
+            {fakePreparedModel(2), IOType::INPUT, index}};
+}
+
+Operand makeOperand(uint32_t size) {
+    return {.type = OperandType::TENSOR_QUANT8_ASYMM,
+            .dimensions = {size},
+            .scale = 1.0f,
+            .zeroPoint = 0,
+            .lifetime = Operand::LifeTime::TEMPORARY_VARIABLE,
+            .location = {}};
+}
+
+// Allocates the device memories of an inference, registers them with the tracker as
+// IDevice::allocate does, and frees them. Args: the size of each buffer, and whether the buffers
+// come from an AidlBufferPool.
+void BM_AllocateFreeChurn(benchmark::State& state) {
+    const auto size = static_cast<uint32_t>(state.range(0));
+    const bool pooled = state.range(1) != 0;
+    const auto operand = makeOperand(size);
+    const auto tracker = AidlBufferTracker::create();
+    const auto pool = AidlBufferPool::create();
+
+    std::vector<std::unique_ptr<AidlBufferTracker::Token>> tokens;
+    tokens.reserve(kBuffersPerInference);
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < kBuffersPerInference; ++i) {
+            auto buffer = pooled ? pool->allocate(size, makeRoles(i), operand)
+                                 : AidlManagedBuffer::create(size, makeRoles(i), operand);
+            tokens.push_back(tracker->add(std::move(buffer)));
+        }
+        tokens.clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kBuffersPerInference);
+    if (pooled) {
+        const auto stats = pool->getStats();
+        state.counters["hit_rate"] =
+                static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses);
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_AllocateFreeChurn)
+        ->ArgsProduct({{4 * 1024, 1024 * 1024, 8 * 1024 * 1024}, {0, 1}})
+        ->ArgNames({"bytes", "pooled"})
+        ->Unit(benchmark::kMicrosecond);
+
+}  // namespace android::nn
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android/hardware/neuralnetworks/1.0/types.h>
+#include <android/hardware/neuralnetworks/1.2/types.h>
+#include <benchmark/benchmark.h>
+#include <nnapi/hal/1.2/BurstPollingPolicy.h>
+#include <nnapi/hal/1.2/BurstUtils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::V1_2::utils {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr V1_2::Timing kNoTiming = {std::numeric_limits<uint64_t>::max(),
+                                    std::numeric_limits<uint64_t>::max()};
+
+enum class Policy {
+    // The release builds default of the fixed policy
+    NO_POLLING,
+    FIXED,
+    ADAPTIVE,
+};
+
+BurstPollingPolicy makePolicy(Policy policy) {
+    switch (policy) {
+        case Policy::NO_POLLING:
+            return BurstPollingPolicy::fixed(std::chrono::microseconds{0});
+        case Policy::FIXED:
+            return BurstPollingPolicy::fixed(BurstPollingPolicy::kDefaultBudget);
+        case Policy::ADAPTIVE:
+            return BurstPollingPolicy::adaptive(BurstPollingPolicy::kDefaultBudget);
+    }
+}
+
+void spinFor(std::chrono::microseconds duration) {
+    const auto end = Clock::now() + duration;
+    while (Clock::now() < end) {
+    }
+}
+
+// Both ends of the channels of a burst in one process, with a server thread executing each request
+// for a set time
+class BurstLoop {
+  public:
+    BurstLoop(Policy policy, std::chrono::microseconds executionTime) {
+        auto [requestSender, requestDescriptor] =
+                RequestChannelSender::create(kExecutionBurstChannelLength).value();
+        auto [resultReceiver, resultDescriptor] =
+                ResultChannelReceiver::create(kExecutionBurstChannelLength, makePolicy(policy))
+                        .value();
+        mRequestSender = std::move(requestSender);
+        mResultReceiver = std::move(resultReceiver);
+        mRequestReceiver =
+                RequestChannelReceiver::create(*requestDescriptor, makePolicy(policy)).value();
+        mResultSender = ResultChannelSender::create(*resultDescriptor).value();
+        mServer = std::thread([this, executionTime] {
+            while (mRequestReceiver->getBlocking().has_value()) {
+                spinFor(executionTime);
+                mResultSender->send(V1_0::ErrorStatus::NONE, {}, kNoTiming);
+            }
+        });
+    }
+
+    ~BurstLoop() {
+        if (mServer.joinable()) {
+            stop();
+        }
+    }
+
+    bool execute() {
+        return mRequestSender->send(V1_0::Request{}, V1_2::MeasureTiming::NO, {}).has_value() &&
+               mResultReceiver->getBlocking().has_value();
+    }
+
+    // Stops the server thread, after which the server polling stats can be read
+    void stop() {
+        mRequestReceiver->invalidate();
+        mServer.join();
+    }
+
+    BurstPollingPolicy::Stats getClientStats() const { return mResultReceiver->getPollingStats(); }
+    BurstPollingPolicy::Stats getServerStats() const { return mRequestReceiver->getPollingStats(); }
+
+  private:
+    std::unique_ptr<RequestChannelSender> mRequestSender;
+    std::unique_ptr<ResultChannelReceiver> mResultReceiver;
+    std::unique_ptr<RequestChannelReceiver> mRequestReceiver;
+    std::unique_ptr<ResultChannelSender> mResultSender;
+    std::thread mServer;
+};
+
+double getPercentileUs(std::vector<Clock::duration> latencies, size_t percent) {
+    if (latencies.empty()) {
+        return 0;
+    }
+    const auto it = latencies.begin() + (latencies.size() - 1) * percent / 100;
+    std::nth_element(latencies.begin(), it, latencies.end());
+    return std::chrono::duration<double, std::micro>(*it).count();
+}
+
+double getHitPercent(const BurstPollingPolicy::Stats& stats) {
+    return stats.polls > 0 ? 100.0 * stats.hits / stats.polls : 0.0;
+}
+
+// Args: the policy, the execution time and the time between requests in microseconds
+void BM_BurstRoundTrip(benchmark::State& state) {
+    const auto policy = static_cast<Policy>(state.range(0));
+    const auto executionTime = std::chrono::microseconds(state.range(1));
+    const auto requestInterval = std::chrono::microseconds(state.range(2));
+    BurstLoop loop(policy, executionTime);
+
+    std::vector<Clock::duration> latencies;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::this_thread::sleep_for(requestInterval);
+        state.ResumeTiming();
+        const auto start = Clock::now();
+        if (!loop.execute()) {
+            state.SkipWithError("Burst execution failed");
+            break;
+        }
+        latencies.push_back(Clock::now() - start);
+    }
+    loop.stop();
+
+    const auto client = loop.getClientStats();
+    const auto server = loop.getServerStats();
+    const double waits = std::max<uint64_t>(client.waits, 1);
+    state.counters["p50_us"] = getPercentileUs(latencies, 50);
+    state.counters["p99_us"] = getPercentileUs(latencies, 99);
+    state.counters["client_hit%"] = getHitPercent(client);
+    state.counters["server_hit%"] = getHitPercent(server);
+    state.counters["spin_us"] =
+            std::chrono::duration<double, std::micro>(client.spinTime + server.spinTime).count() /
+            waits;
+    state.counters["wasted_spin_us"] =
+            std::chrono::duration<double, std::micro>(client.wastedSpinTime +
+                                                      server.wastedSpinTime)
+                    .count() /
+            waits;
+}
+
+void applyArgs(benchmark::internal::Benchmark* benchmark) {
+    for (auto policy : {Policy::NO_POLLING, Policy::FIXED, Policy::ADAPTIVE}) {
+        // A small model back to back, a small model at camera frame rate, and a large model
+        for (auto [executionTime, requestInterval] :
+             {std::pair{20, 0}, std::pair{20, 33000}, std::pair{2000, 0}}) {
+            benchmark->Args({static_cast<int64_t>(policy), executionTime, requestInterval});
+        }
+    }
+}
+
+}  // namespace
+
+// Fixed iterations, as the paused time between requests would make automatic ones last minutes
+BENCHMARK(BM_BurstRoundTrip)
+        ->Apply(applyArgs)
+        ->Iterations(200)
+        ->UseRealTime()
+        ->Unit(benchmark::kMicrosecond);
+
+}  // namespace android::hardware::neuralnetworks::V1_2::utils
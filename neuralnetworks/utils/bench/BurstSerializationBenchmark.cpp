@@ -0,0 +1,159 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android/hardware/neuralnetworks/1.0/types.h>
+#include <android/hardware/neuralnetworks/1.2/types.h>
+#include <benchmark/benchmark.h>
+#include <nnapi/hal/1.2/BurstPollingPolicy.h>
+#include <nnapi/hal/1.2/BurstUtils.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::V1_2::utils {
+namespace {
+
+// Rank of the operands of the small audio and sensor models bursts are used for
+constexpr uint32_t kRank = 4;
+
+constexpr V1_2::Timing kTiming = {.timeOnDevice = 100, .timeInDriver = 120};
+
+BurstPollingPolicy noPolling() {
+    return BurstPollingPolicy::fixed(std::chrono::microseconds{0});
+}
+
+// A request with this many inputs and outputs, each in its own pool
+V1_0::Request makeRequest(size_t operandCount, std::vector<int32_t>* slots) {
+    const V1_0::RequestArgument argument = {
+            .hasNoValue = false, .location = {}, .dimensions = std::vector<uint32_t>(kRank, 8)};
+    V1_0::Request request;
+    request.inputs = std::vector<V1_0::RequestArgument>(operandCount, argument);
+    request.outputs = std::vector<V1_0::RequestArgument>(operandCount, argument);
+    slots->resize(2 * operandCount);
+    for (size_t i = 0; i < slots->size(); ++i) {
+        (*slots)[i] = static_cast<int32_t>(i);
+    }
+    return request;
+}
+
+std::vector<V1_2::OutputShape> makeOutputShapes(size_t operandCount) {
+    return std::vector<V1_2::OutputShape>(
+            operandCount, {.dimensions = std::vector<uint32_t>(kRank, 8), .isSufficient = true});
+}
+
+// Both ends of the request channel of a burst, used from one thread. The packet is in the FMQ when
+// the receiver is called, so the time is that of the serialization, copies and deserialization.
+class RequestChannel {
+  public:
+    RequestChannel() {
+        auto [sender, descriptor] =
+                RequestChannelSender::create(kExecutionBurstChannelLength).value();
+        mSender = std::move(sender);
+        mReceiver = RequestChannelReceiver::create(*descriptor, noPolling()).value();
+    }
+
+    RequestChannelSender* sender() const { return mSender.get(); }
+    RequestChannelReceiver* receiver() const { return mReceiver.get(); }
+
+  private:
+    std::unique_ptr<RequestChannelSender> mSender;
+    std::unique_ptr<RequestChannelReceiver> mReceiver;
+};
+
+// Both ends of the result channel of a burst, used from one thread
+class ResultChannel {
+  public:
+    ResultChannel() {
+        auto [receiver, descriptor] =
+                ResultChannelReceiver::create(kExecutionBurstChannelLength, noPolling()).value();
+        mReceiver = std::move(receiver);
+        mSender = ResultChannelSender::create(*descriptor).value();
+    }
+
+    ResultChannelSender* sender() const { return mSender.get(); }
+    ResultChannelReceiver* receiver() const { return mReceiver.get(); }
+
+  private:
+    std::unique_ptr<ResultChannelReceiver> mReceiver;
+    std::unique_ptr<ResultChannelSender> mSender;
+};
+
+// Serializes the request into a packet before copying it into the FMQ, as Burst::execute used to.
+// Arg: the number of inputs and of outputs of the request.
+void BM_RequestRoundTrip_Packet(benchmark::State& state) {
+    std::vector<int32_t> slots;
+    const auto request = makeRequest(static_cast<size_t>(state.range(0)), &slots);
+    RequestChannel channel;
+    for (auto _ : state) {
+        const auto packet = serialize(request, V1_2::MeasureTiming::NO, slots);
+        if (!channel.sender()->sendPacket(packet).has_value() ||
+            !channel.receiver()->getBlocking().has_value()) {
+            state.SkipWithError("Burst request round trip failed");
+            break;
+        }
+    }
+}
+
+void BM_RequestRoundTrip_InPlace(benchmark::State& state) {
+    std::vector<int32_t> slots;
+    const auto request = makeRequest(static_cast<size_t>(state.range(0)), &slots);
+    RequestChannel channel;
+    for (auto _ : state) {
+        if (!channel.sender()->send(request, V1_2::MeasureTiming::NO, slots).has_value() ||
+            !channel.receiver()->getBlocking().has_value()) {
+            state.SkipWithError("Burst request round trip failed");
+            break;
+        }
+    }
+}
+
+// Goes through a packet on both ends, as the result channel used to
+void BM_ResultRoundTrip_Packet(benchmark::State& state) {
+    const auto outputShapes = makeOutputShapes(static_cast<size_t>(state.range(0)));
+    ResultChannel channel;
+    for (auto _ : state) {
+        channel.sender()->sendPacket(serialize(V1_0::ErrorStatus::NONE, outputShapes, kTiming));
+        const auto packet = channel.receiver()->getPacketBlocking();
+        if (!packet.has_value() || !deserialize(packet.value()).has_value()) {
+            state.SkipWithError("Burst result round trip failed");
+            break;
+        }
+    }
+}
+
+void BM_ResultRoundTrip_InPlace(benchmark::State& state) {
+    const auto outputShapes = makeOutputShapes(static_cast<size_t>(state.range(0)));
+    ResultChannel channel;
+    for (auto _ : state) {
+        channel.sender()->send(V1_0::ErrorStatus::NONE, outputShapes, kTiming);
+        if (!channel.receiver()->getBlocking().has_value()) {
+            state.SkipWithError("Burst result round trip failed");
+            break;
+        }
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_RequestRoundTrip_Packet)->Arg(1)->Arg(4)->Arg(32)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_RequestRoundTrip_InPlace)->Arg(1)->Arg(4)->Arg(32)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_ResultRoundTrip_Packet)->Arg(1)->Arg(4)->Arg(32)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_ResultRoundTrip_InPlace)->Arg(1)->Arg(4)->Arg(32)->Unit(benchmark::kNanosecond);
+
+}  // namespace android::hardware::neuralnetworks::V1_2::utils
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <TestHarness.h>
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+#include <nnapi/IDevice.h>
+#include <nnapi/Result.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/CachingDevice.h>
+#include <nnapi/hal/CompilationCache.h>
+#include <nnapi/hal/InvalidPreparedModel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+using test_helper::TestModel;
+using test_helper::TestModelManager;
+using test_helper::TestOperandLifeTime;
+
+// Number of generated test models prepared in each iteration, those with the most constant data
+constexpr size_t kModelCount = 64;
+
+// Stand-in for the time an accelerator compiler spends on each operation
+constexpr auto kCompileTimePerOperation = std::chrono::microseconds{50};
+
+const std::string kName = "nnapi-simulated-compiler";
+const std::string kVersionString = "1";
+
+size_t getConstantSize(const TestModel& testModel) {
+    size_t size = 0;
+    for (const auto& operand : testModel.main.operands) {
+        if (operand.lifetime == TestOperandLifeTime::CONSTANT_COPY ||
+            operand.lifetime == TestOperandLifeTime::CONSTANT_REFERENCE) {
+            size += operand.data.size();
+        }
+    }
+    return size;
+}
+
+// The main subgraph of the test model, with all the constant operand values in operandValues. The
+// simulated compiler below does not validate the model, so the types are cast as they are.
+nn::Model createModel(const TestModel& testModel) {
+    nn::Model model;
+    for (const auto& testOperand : testModel.main.operands) {
+        nn::Operand operand = {.type = static_cast<nn::OperandType>(testOperand.type),
+                               .dimensions = testOperand.dimensions,
+                               .scale = testOperand.scale,
+                               .zeroPoint = testOperand.zeroPoint,
+                               .lifetime = static_cast<nn::Operand::LifeTime>(testOperand.lifetime),
+                               .location = {}};
+        if (testOperand.lifetime == TestOperandLifeTime::CONSTANT_COPY ||
+            testOperand.lifetime == TestOperandLifeTime::CONSTANT_REFERENCE) {
+            operand.lifetime = nn::Operand::LifeTime::CONSTANT_COPY;
+            operand.location = model.operandValues.append(testOperand.data.get<uint8_t>(),
+                                                          testOperand.data.size());
+        }
+        model.main.operands.push_back(std::move(operand));
+    }
+    for (const auto& testOperation : testModel.main.operations) {
+        model.main.operations.push_back({.type = static_cast<nn::OperationType>(testOperation.type),
+                                         .inputs = testOperation.inputs,
+                                         .outputs = testOperation.outputs});
+    }
+    model.main.inputIndexes = testModel.main.inputIndexes;
+    model.main.outputIndexes = testModel.main.outputIndexes;
+    model.relaxComputationFloat32toFloat16 = testModel.isRelaxed;
+    return model;
+}
+
+// The models without control flow with the most constant data, largest first
+std::vector<nn::Model> createModels() {
+    auto namedModels = TestModelManager::get().getTestModels(
+            [](const TestModel& testModel) { return testModel.referenced.empty(); });
+    std::sort(namedModels.begin(), namedModels.end(), [](const auto& a, const auto& b) {
+        return getConstantSize(*a.second) > getConstantSize(*b.second);
+    });
+    namedModels.resize(std::min(namedModels.size(), kModelCount));
+
+    std::vector<nn::Model> models;
+    models.reserve(namedModels.size());
+    for (const auto& [name, testModel] : namedModels) {
+        models.push_back(createModel(*testModel));
+    }
+    return models;
+}
+
+// Driver that needs one model cache file. Compiling a model takes kCompileTimePerOperation per
+// operation, and the compilation holds the shapes of the operands and the constant operand values.
+// Preparing a model from the cache reads the compilation back.
+class SimulatedDevice final : public nn::IDevice {
+  public:
+    SimulatedDevice()
+        : kCapabilities({.relaxedFloat32toFloat16PerformanceScalar = kPerformance,
+                         .relaxedFloat32toFloat16PerformanceTensor = kPerformance,
+                         .operandPerformance =
+                                 nn::Capabilities::OperandPerformanceTable::create({}).value(),
+                         .ifPerformance = kPerformance,
+                         .whilePerformance = kPerformance}) {}
+
+    const std::string& getName() const override { return kName; }
+    const std::string& getVersionString() const override { return kVersionString; }
+    nn::Version getFeatureLevel() const override { return nn::kVersionFeatureLevel5; }
+    nn::DeviceType getType() const override { return nn::DeviceType::ACCELERATOR; }
+    const std::vector<nn::Extension>& getSupportedExtensions() const override {
+        return kExtensions;
+    }
+    const nn::Capabilities& getCapabilities() const override { return kCapabilities; }
+    std::pair<uint32_t, uint32_t> getNumberOfCacheFilesNeeded() const override { return {1, 0}; }
+
+    nn::GeneralResult<void> wait() const override { return {}; }
+
+    nn::GeneralResult<std::vector<bool>> getSupportedOperations(
+            const nn::Model& model) const override {
+        return std::vector<bool>(model.main.operations.size(), true);
+    }
+
+    nn::GeneralResult<nn::SharedPreparedModel> prepareModel(
+            const nn::Model& model, nn::ExecutionPreference /*preference*/,
+            nn::Priority /*priority*/, nn::OptionalTimePoint /*deadline*/,
+            const std::vector<nn::SharedHandle>& modelCache,
+            const std::vector<nn::SharedHandle>& /*dataCache*/, const nn::CacheToken& /*token*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        const std::string compilation = compile(model);
+        if (!modelCache.empty() &&
+            !base::WriteStringToFd(compilation, modelCache.front()->get())) {
+            return NN_ERROR() << "Failed to write the compilation";
+        }
+        return kPreparedModel;
+    }
+
+    nn::GeneralResult<nn::SharedPreparedModel> prepareModelFromCache(
+            nn::OptionalTimePoint /*deadline*/, const std::vector<nn::SharedHandle>& modelCache,
+            const std::vector<nn::SharedHandle>& /*dataCache*/,
+            const nn::CacheToken& /*token*/) const override {
+        std::string compilation;
+        if (modelCache.size() != 1 ||
+            !base::ReadFdToString(modelCache.front()->get(), &compilation) ||
+            compilation.empty()) {
+            return NN_ERROR() << "Failed to read the compilation";
+        }
+        benchmark::DoNotOptimize(compilation);
+        return kPreparedModel;
+    }
+
+    nn::GeneralResult<nn::SharedBuffer> allocate(
+            const nn::BufferDesc& /*desc*/,
+            const std::vector<nn::SharedPreparedModel>& /*preparedModels*/,
+            const std::vector<nn::BufferRole>& /*inputRoles*/,
+            const std::vector<nn::BufferRole>& /*outputRoles*/) const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Memory domains are not supported";
+    }
+
+  private:
+    static constexpr nn::Capabilities::PerformanceInfo kPerformance = {.execTime = 1.0f,
+                                                                       .powerUsage = 1.0f};
+
+    static std::string compile(const nn::Model& model) {
+        const auto end = nn::Clock::now() + kCompileTimePerOperation * model.main.operations.size();
+        std::string compilation;
+        for (const auto& operand : model.main.operands) {
+            compilation.append(reinterpret_cast<const char*>(operand.dimensions.data()),
+                               operand.dimensions.size() * sizeof(uint32_t));
+            if (operand.lifetime == nn::Operand::LifeTime::CONSTANT_COPY) {
+                compilation.append(reinterpret_cast<const char*>(model.operandValues.data() +
+                                                                 operand.location.offset),
+                                   operand.location.length);
+            }
+        }
+        while (nn::Clock::now() < end) {
+        }
+        return compilation;
+    }
+
+    const std::vector<nn::Extension> kExtensions;
+    const nn::Capabilities kCapabilities;
+    const nn::SharedPreparedModel kPreparedModel = std::make_shared<const InvalidPreparedModel>();
+};
+
+bool prepareModels(const nn::IDevice& device, const std::vector<nn::Model>& models) {
+    for (const auto& model : models) {
+        const auto result = device.prepareModel(model, nn::ExecutionPreference::DEFAULT,
+                                                nn::Priority::DEFAULT, {}, {}, {}, {}, {}, {});
+        if (!result.has_value()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct CachingSetup {
+    base::TemporaryDir directory;
+    std::shared_ptr<CompilationCache> cache;
+    nn::SharedDevice device;
+};
+
+std::unique_ptr<CachingSetup> createCachingSetup() {
+    auto setup = std::make_unique<CachingSetup>();
+    setup->cache = CompilationCache::create({.directory = setup->directory.path}).value();
+    setup->device =
+            CachingDevice::create(std::make_shared<const SimulatedDevice>(), setup->cache).value();
+    return setup;
+}
+
+void setCounters(benchmark::State& state, size_t modelCount, const CompilationCache* cache) {
+    state.counters["models"] = static_cast<double>(modelCount);
+    if (cache != nullptr) {
+        const auto stats = cache->getStats();
+        state.counters["hits"] = static_cast<double>(stats.hits);
+        state.counters["cache_mb"] = static_cast<double>(stats.size) / (1024 * 1024);
+    }
+}
+
+// Compiles every model, without a cache
+void BM_PrepareModel_NoCache(benchmark::State& state) {
+    const auto models = createModels();
+    const SimulatedDevice device;
+    for (auto _ : state) {
+        if (!prepareModels(device, models)) {
+            state.SkipWithError("prepareModel failed");
+            break;
+        }
+    }
+    setCounters(state, models.size(), nullptr);
+}
+
+// Compiles every model into a new cache entry, as the first run after an update of the driver
+void BM_PrepareModel_Cold(benchmark::State& state) {
+    const auto models = createModels();
+    auto setup = createCachingSetup();
+    for (auto _ : state) {
+        // Entries are keyed by the model, so each iteration starts from an empty cache
+        state.PauseTiming();
+        setup = createCachingSetup();
+        state.ResumeTiming();
+        if (!prepareModels(*setup->device, models)) {
+            state.SkipWithError("prepareModel failed");
+            break;
+        }
+    }
+    setCounters(state, models.size(), setup->cache.get());
+}
+
+// Prepares every model from its verified cache entry
+void BM_PrepareModel_Warm(benchmark::State& state) {
+    const auto models = createModels();
+    const auto setup = createCachingSetup();
+    if (!prepareModels(*setup->device, models)) {
+        state.SkipWithError("prepareModel failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (!prepareModels(*setup->device, models)) {
+            state.SkipWithError("prepareModel failed");
+            break;
+        }
+    }
+    setCounters(state, models.size(), setup->cache.get());
+}
+
+}  // namespace
+
+BENCHMARK(BM_PrepareModel_NoCache)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PrepareModel_Cold)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PrepareModel_Warm)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace android::hardware::neuralnetworks::utils
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/neuralnetworks/ExecutionResult.h>
+#include <aidl/android/hardware/neuralnetworks/Request.h>
+#include <android/binder_auto_utils.h>
+#include <benchmark/benchmark.h>
+#include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/aidl/Conversions.h>
+#include <nnapi/hal/aidl/ExecutionCoalescer.h>
+#include <nnapi/hal/aidl/PreparedModel.h>
+
+#include <algorithm>
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aidl::android::hardware::neuralnetworks {
+namespace {
+
+namespace nn = ::android::nn;
+
+using Clock = std::chrono::steady_clock;
+
+// A keyword spotting model: a frame of audio features in, a score per keyword out
+constexpr uint32_t kInputSize = 40 * sizeof(float);
+constexpr uint32_t kOutputSize = 12 * sizeof(float);
+constexpr uint32_t kExecutionsPerClient = 16;
+// Cost of an execution of the fake driver: a fixed launch overhead, and a cost per batch item
+constexpr auto kLaunchTime = std::chrono::microseconds{400};
+constexpr auto kItemTime = std::chrono::microseconds{20};
+
+void spinFor(Clock::duration duration) {
+    const auto end = Clock::now() + duration;
+    while (Clock::now() < end) {
+    }
+}
+
+// Driver whose executions cost a fixed overhead plus a cost per item of their batch, as the
+// accelerators whose launch dominates the execution of small models
+class BatchingPreparedModel final : public nn::IPreparedModel {
+  public:
+    nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> execute(
+            const nn::Request& request, nn::MeasureTiming /*measure*/,
+            const nn::OptionalTimePoint& /*deadline*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        const uint32_t batchSize = request.inputs.front().dimensions.front();
+        spinFor(kLaunchTime + batchSize * kItemTime);
+        mExecutions.fetch_add(1, std::memory_order_relaxed);
+
+        std::vector<nn::OutputShape> outputShapes;
+        for (const auto& output : request.outputs) {
+            const auto& pool = std::get<nn::SharedMemory>(request.pools[output.location.poolIndex]);
+            const auto mapping = NN_TRY(nn::map(pool));
+            std::memset(static_cast<uint8_t*>(std::get<void*>(mapping.pointer)) +
+                                output.location.offset,
+                        0, output.location.length);
+            outputShapes.push_back({.dimensions = output.dimensions, .isSufficient = true});
+        }
+        return std::make_pair(std::move(outputShapes), nn::Timing{});
+    }
+
+    nn::GeneralResult<std::pair<nn::SyncFence, nn::ExecuteFencedInfoCallback>> executeFenced(
+            const nn::Request& /*request*/, const std::vector<nn::SyncFence>& /*waitFor*/,
+            nn::MeasureTiming /*measure*/, const nn::OptionalTimePoint& /*deadline*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const nn::OptionalDuration& /*timeoutDurationAfterFence*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the benchmark";
+    }
+
+    nn::GeneralResult<nn::SharedExecution> createReusableExecution(
+            const nn::Request& /*request*/, nn::MeasureTiming /*measure*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the benchmark";
+    }
+
+    nn::GeneralResult<nn::SharedBurst> configureExecutionBurst() const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the benchmark";
+    }
+
+    std::any getUnderlyingResource() const override { return {}; }
+
+    uint64_t getExecutions() const { return mExecutions.load(std::memory_order_relaxed); }
+
+  private:
+    mutable std::atomic<uint64_t> mExecutions = 0;
+};
+
+// Request of a client, with its input and output in an ashmem pool
+nn::GeneralResult<Request> createRequest() {
+    nn::Request request;
+    request.pools.push_back(NN_TRY(nn::createSharedMemory(kInputSize + kOutputSize)));
+    request.inputs.push_back({.lifetime = nn::Request::Argument::LifeTime::POOL,
+                              .location = {.poolIndex = 0, .offset = 0, .length = kInputSize},
+                              .dimensions = {1, kInputSize / sizeof(float)}});
+    request.outputs.push_back(
+            {.lifetime = nn::Request::Argument::LifeTime::POOL,
+             .location = {.poolIndex = 0, .offset = kInputSize, .length = kOutputSize},
+             .dimensions = {1, kOutputSize / sizeof(float)}});
+    return utils::convert(request);
+}
+
+double getPercentileUs(std::vector<Clock::duration> latencies, size_t percent) {
+    if (latencies.empty()) {
+        return 0;
+    }
+    const auto it = latencies.begin() + (latencies.size() - 1) * percent / 100;
+    std::nth_element(latencies.begin(), it, latencies.end());
+    return std::chrono::duration<double, std::micro>(*it).count();
+}
+
+// Concurrent clients execute small requests through the adapter, back to back. The items per
+// second give the throughput, and the percentiles the latency of each execution. Args: the
+// coalescing window in microseconds, zero to disable coalescing, and the number of clients.
+void BM_ConcurrentExecuteSynchronously(benchmark::State& state) {
+    const auto window = std::chrono::microseconds(state.range(0));
+    const auto clientCount = static_cast<size_t>(state.range(1));
+
+    const auto driver = std::make_shared<const BatchingPreparedModel>();
+    const auto coalescer = std::make_shared<const adapter::ExecutionCoalescer>(
+            driver, adapter::ExecutionCoalescer::Options{.window = window, .maxBatchSize = 8});
+    const auto preparedModel = ndk::SharedRefBase::make<adapter::PreparedModel>(
+            driver, adapter::PreparedModel::ThreadSafeRequestPoolCache::kDefaultMaxEntries,
+            coalescer);
+
+    std::vector<Request> requests;
+    for (size_t i = 0; i < clientCount; ++i) {
+        auto request = createRequest();
+        if (!request.has_value()) {
+            state.SkipWithError("createRequest failed");
+            return;
+        }
+        requests.push_back(std::move(request).value());
+    }
+
+    std::mutex mutex;
+    std::vector<Clock::duration> latencies;
+    std::atomic<bool> failed = false;
+    for (auto _ : state) {
+        std::vector<std::thread> clients;
+        clients.reserve(clientCount);
+        for (const auto& request : requests) {
+            clients.emplace_back([&preparedModel, &request, &mutex, &latencies, &failed] {
+                std::vector<Clock::duration> clientLatencies;
+                clientLatencies.reserve(kExecutionsPerClient);
+                ExecutionResult executionResult;
+                for (uint32_t i = 0; i < kExecutionsPerClient; ++i) {
+                    const auto start = Clock::now();
+                    const auto status = preparedModel->executeSynchronously(
+                            request, /*measureTiming=*/false, /*deadlineNs=*/-1,
+                            /*loopTimeoutDurationNs=*/-1, &executionResult);
+                    clientLatencies.push_back(Clock::now() - start);
+                    if (!status.isOk()) {
+                        failed = true;
+                    }
+                }
+                std::lock_guard guard(mutex);
+                latencies.insert(latencies.end(), clientLatencies.begin(), clientLatencies.end());
+            });
+        }
+        for (auto& client : clients) {
+            client.join();
+        }
+        if (failed) {
+            state.SkipWithError("executeSynchronously failed");
+            break;
+        }
+    }
+
+    const auto executions = state.iterations() * clientCount * kExecutionsPerClient;
+    state.SetItemsProcessed(executions);
+    state.counters["p50_us"] = getPercentileUs(latencies, 50);
+    state.counters["p99_us"] = getPercentileUs(latencies, 99);
+    state.counters["batch"] = static_cast<double>(executions) /
+                              static_cast<double>(std::max<uint64_t>(driver->getExecutions(), 1));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ConcurrentExecuteSynchronously)
+        ->ArgsProduct({{0, 100, 250, 1000}, {1, 4, 8, 16}})
+        ->ArgNames({"window_us", "clients"})
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+}  // namespace aidl::android::hardware::neuralnetworks
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/ThreadPoolExecutor.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Task = ThreadPoolExecutor::Task;
+using Submit = std::function<void(Task task, nn::Priority priority)>;
+
+// CPU time of a simulated compilation, on the short end of what drivers take
+constexpr auto kCompileTime = std::chrono::milliseconds(2);
+// One prepareModel in this many is of high priority
+constexpr size_t kHighPriorityInterval = 8;
+
+std::chrono::nanoseconds getThreadCpuTime() {
+    timespec time = {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+// Spins for kCompileTime of CPU time, so that the compilations slow down when the threads outnumber
+// the cores as they would on a device
+void compile() {
+    const auto end = getThreadCpuTime() + kCompileTime;
+    while (getThreadCpuTime() < end) {
+    }
+}
+
+// The prepareModel calls made at once by the clients, which tell it as they complete
+class Burst {
+  public:
+    explicit Burst(size_t size) : mRemaining(size) {}
+
+    void finish(Clock::duration latency, bool isHighPriority) {
+        std::lock_guard guard(mMutex);
+        mLatencies.push_back(latency);
+        if (isHighPriority) {
+            mHighPriorityLatencies.push_back(latency);
+        }
+        // Notified under the lock, as the burst is destroyed once wait() returns
+        if (--mRemaining == 0) {
+            mCondition.notify_all();
+        }
+    }
+
+    void wait() {
+        std::unique_lock lock(mMutex);
+        mCondition.wait(lock, [this] { return mRemaining == 0; });
+    }
+
+    void appendLatencies(std::vector<Clock::duration>* latencies,
+                         std::vector<Clock::duration>* highPriorityLatencies) {
+        std::lock_guard guard(mMutex);
+        latencies->insert(latencies->end(), mLatencies.begin(), mLatencies.end());
+        highPriorityLatencies->insert(highPriorityLatencies->end(),
+                                      mHighPriorityLatencies.begin(),
+                                      mHighPriorityLatencies.end());
+    }
+
+  private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    size_t mRemaining;
+    std::vector<Clock::duration> mLatencies;
+    std::vector<Clock::duration> mHighPriorityLatencies;
+};
+
+double getPercentileMs(std::vector<Clock::duration> latencies, size_t percent) {
+    if (latencies.empty()) {
+        return 0;
+    }
+    const auto it = latencies.begin() + (latencies.size() - 1) * percent / 100;
+    std::nth_element(latencies.begin(), it, latencies.end());
+    return std::chrono::duration<double, std::milli>(*it).count();
+}
+
+// Arg: the number of prepareModel calls made at once
+void runBursts(benchmark::State& state, const Submit& submit) {
+    const size_t burstSize = static_cast<size_t>(state.range(0));
+    std::vector<Clock::duration> latencies;
+    std::vector<Clock::duration> highPriorityLatencies;
+    for (auto _ : state) {
+        Burst burst(burstSize);
+        for (size_t i = 0; i < burstSize; ++i) {
+            const bool isHighPriority = i % kHighPriorityInterval == kHighPriorityInterval - 1;
+            const auto start = Clock::now();
+            submit(
+                    [&burst, start, isHighPriority] {
+                        compile();
+                        burst.finish(Clock::now() - start, isHighPriority);
+                    },
+                    isHighPriority ? nn::Priority::HIGH : nn::Priority::DEFAULT);
+        }
+        burst.wait();
+        burst.appendLatencies(&latencies, &highPriorityLatencies);
+    }
+    state.counters["prepares"] = benchmark::Counter(
+            static_cast<double>(state.iterations() * burstSize), benchmark::Counter::kIsRate);
+    state.counters["p50_ms"] = getPercentileMs(latencies, 50);
+    state.counters["p99_ms"] = getPercentileMs(latencies, 99);
+    state.counters["high_p99_ms"] = getPercentileMs(highPriorityLatencies, 99);
+}
+
+// The executor the adapters used before, one detached thread per task
+void BM_PrepareModel_DetachedThreads(benchmark::State& state) {
+    runBursts(state, [](Task task, nn::Priority /*priority*/) {
+        std::thread(std::move(task)).detach();
+    });
+}
+
+void BM_PrepareModel_ThreadPool(benchmark::State& state) {
+    ThreadPoolExecutor executor;
+    runBursts(state, [&executor](Task task, nn::Priority priority) {
+        executor.execute(std::move(task), {}, priority, {});
+    });
+    const auto stats = executor.getStats();
+    state.counters["threads"] = static_cast<double>(stats.threadCount);
+    state.counters["max_queue"] = static_cast<double>(stats.maxQueueDepth);
+    state.counters["wait_p99_ms"] =
+            std::chrono::duration<double, std::milli>(stats.p99WaitTime).count();
+}
+
+}  // namespace
+
+BENCHMARK(BM_PrepareModel_DetachedThreads)
+        ->Arg(8)
+        ->Arg(32)
+        ->Arg(128)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PrepareModel_ThreadPool)
+        ->Arg(8)
+        ->Arg(32)
+        ->Arg(128)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+}  // namespace android::hardware::neuralnetworks::utils
@@ -0,0 +1,461 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <nnapi/IBurst.h>
+#include <nnapi/IDevice.h>
+#include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/1.3/Conversions.h>
+#include <nnapi/hal/1.3/Device.h>
+#include <nnapi/hal/Adapter.h>
+#include <nnapi/hal/aidl/Adapter.h>
+#include <nnapi/hal/aidl/Conversions.h>
+#include <nnapi/hal/aidl/Device.h>
+#include <nnapi/hal/aidl/Utils.h>
+
+#include <any>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+namespace aidl_adapter = ::aidl::android::hardware::neuralnetworks::adapter;
+namespace aidl_utils = ::aidl::android::hardware::neuralnetworks::utils;
+namespace hidl_adapter = ::android::hardware::neuralnetworks::adapter;
+
+const std::string kName = "nnapi-fake";
+const std::string kVersionString = "1";
+
+// The stacks that a client reaches the driver through: the driver itself, or the AIDL or HIDL
+// adapter of the driver called through the matching utils client, all in the same process
+enum class Stack { CANONICAL, AIDL, HIDL };
+constexpr std::array<const char*, 3> kStackNames = {"canonical", "aidl", "hidl"};
+
+struct ModelSize {
+    const char* name;
+    uint32_t operationCount;
+    uint32_t tensorElements;
+};
+constexpr std::array<ModelSize, 3> kModelSizes = {{
+        {.name = "tiny", .operationCount = 1, .tensorElements = 4},
+        {.name = "medium", .operationCount = 64, .tensorElements = 4 * 1024},
+        {.name = "huge", .operationCount = 1024, .tensorElements = 16 * 1024},
+}};
+
+nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> fakeExecute(
+        const nn::Request& request) {
+    std::vector<nn::OutputShape> outputShapes(request.outputs.size(),
+                                              {.dimensions = {}, .isSufficient = true});
+    return std::make_pair(std::move(outputShapes), nn::Timing{});
+}
+
+// Burst that completes each execution as soon as it is launched
+class FakeBurst final : public nn::IBurst {
+  public:
+    OptionalCacheHold cacheMemory(const nn::SharedMemory& /*memory*/) const override {
+        return nullptr;
+    }
+
+    nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> execute(
+            const nn::Request& request, nn::MeasureTiming /*measure*/,
+            const nn::OptionalTimePoint& /*deadline*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return fakeExecute(request);
+    }
+
+    nn::GeneralResult<nn::SharedExecution> createReusableExecution(
+            const nn::Request& /*request*/, nn::MeasureTiming /*measure*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the benchmark";
+    }
+};
+
+// Prepared model that completes each execution as soon as it is launched, so that the benchmarks
+// only measure the layers between the client and the driver
+class FakePreparedModel final : public nn::IPreparedModel {
+  public:
+    nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> execute(
+            const nn::Request& request, nn::MeasureTiming /*measure*/,
+            const nn::OptionalTimePoint& /*deadline*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return fakeExecute(request);
+    }
+
+    nn::GeneralResult<std::pair<nn::SyncFence, nn::ExecuteFencedInfoCallback>> executeFenced(
+            const nn::Request& /*request*/, const std::vector<nn::SyncFence>& /*waitFor*/,
+            nn::MeasureTiming /*measure*/, const nn::OptionalTimePoint& /*deadline*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const nn::OptionalDuration& /*timeoutDurationAfterFence*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        nn::ExecuteFencedInfoCallback callback = []() {
+            return nn::GeneralResult<std::pair<nn::Timing, nn::Timing>>(
+                    std::make_pair(nn::Timing{}, nn::Timing{}));
+        };
+        return std::make_pair(nn::SyncFence::createAsSignaled(), std::move(callback));
+    }
+
+    nn::GeneralResult<nn::SharedExecution> createReusableExecution(
+            const nn::Request& /*request*/, nn::MeasureTiming /*measure*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the benchmark";
+    }
+
+    nn::GeneralResult<nn::SharedBurst> configureExecutionBurst() const override {
+        return std::make_shared<const FakeBurst>();
+    }
+
+    std::any getUnderlyingResource() const override { return {}; }
+};
+
+// Driver that prepares every model instantly
+class FakeDevice final : public nn::IDevice {
+  public:
+    FakeDevice()
+        : kCapabilities({.relaxedFloat32toFloat16PerformanceScalar = kPerformance,
+                         .relaxedFloat32toFloat16PerformanceTensor = kPerformance,
+                         .operandPerformance =
+                                 nn::Capabilities::OperandPerformanceTable::create({}).value(),
+                         .ifPerformance = kPerformance,
+                         .whilePerformance = kPerformance}) {}
+
+    const std::string& getName() const override { return kName; }
+    const std::string& getVersionString() const override { return kVersionString; }
+    nn::Version getFeatureLevel() const override { return nn::kVersionFeatureLevel5; }
+    nn::DeviceType getType() const override { return nn::DeviceType::ACCELERATOR; }
+    const std::vector<nn::Extension>& getSupportedExtensions() const override {
+        return kExtensions;
+    }
+    const nn::Capabilities& getCapabilities() const override { return kCapabilities; }
+    std::pair<uint32_t, uint32_t> getNumberOfCacheFilesNeeded() const override { return {0, 0}; }
+
+    nn::GeneralResult<void> wait() const override { return {}; }
+
+    nn::GeneralResult<std::vector<bool>> getSupportedOperations(
+            const nn::Model& model) const override {
+        return std::vector<bool>(model.main.operations.size(), true);
+    }
+
+    nn::GeneralResult<nn::SharedPreparedModel> prepareModel(
+            const nn::Model& /*model*/, nn::ExecutionPreference /*preference*/,
+            nn::Priority /*priority*/, nn::OptionalTimePoint /*deadline*/,
+            const std::vector<nn::SharedHandle>& /*modelCache*/,
+            const std::vector<nn::SharedHandle>& /*dataCache*/, const nn::CacheToken& /*token*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return kPreparedModel;
+    }
+
+    nn::GeneralResult<nn::SharedPreparedModel> prepareModelFromCache(
+            nn::OptionalTimePoint /*deadline*/, const std::vector<nn::SharedHandle>& /*modelCache*/,
+            const std::vector<nn::SharedHandle>& /*dataCache*/,
+            const nn::CacheToken& /*token*/) const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Compilation caching not supported";
+    }
+
+    nn::GeneralResult<nn::SharedBuffer> allocate(
+            const nn::BufferDesc& /*desc*/,
+            const std::vector<nn::SharedPreparedModel>& /*preparedModels*/,
+            const std::vector<nn::BufferRole>& /*inputRoles*/,
+            const std::vector<nn::BufferRole>& /*outputRoles*/) const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Memory domains are not supported";
+    }
+
+  private:
+    static constexpr nn::Capabilities::PerformanceInfo kPerformance = {.execTime = 1.0f,
+                                                                       .powerUsage = 1.0f};
+
+    const std::vector<nn::Extension> kExtensions;
+    const nn::Capabilities kCapabilities;
+    const nn::SharedPreparedModel kPreparedModel = std::make_shared<const FakePreparedModel>();
+};
+
+nn::GeneralResult<nn::SharedDevice> createDevice(Stack stack) {
+    auto device = std::make_shared<const FakeDevice>();
+    switch (stack) {
+        case Stack::CANONICAL:
+            return device;
+        case Stack::AIDL:
+            return aidl_utils::Device::create(kName, aidl_adapter::adapt(std::move(device)),
+                                              aidl_utils::kVersion);
+        case Stack::HIDL:
+            return V1_3::utils::Device::create(kName, hidl_adapter::adapt(std::move(device)));
+    }
+    return NN_ERROR() << "Unrecognized stack";
+}
+
+nn::Operand makeTensor(uint32_t elements, nn::Operand::LifeTime lifetime) {
+    return {.type = nn::OperandType::TENSOR_FLOAT32,
+            .dimensions = {elements},
+            .scale = 0.0f,
+            .zeroPoint = 0,
+            .lifetime = lifetime,
+            .location = {}};
+}
+
+// A chain of `operationCount` ADD operations, each adding a constant tensor to the output of the
+// previous one
+nn::Model makeModel(const ModelSize& size) {
+    nn::Model model;
+    auto& operands = model.main.operands;
+
+    const int32_t activation = 0;
+    operands.push_back({.type = nn::OperandType::INT32,
+                        .dimensions = {},
+                        .scale = 0.0f,
+                        .zeroPoint = 0,
+                        .lifetime = nn::Operand::LifeTime::CONSTANT_COPY,
+                        .location = model.operandValues.append(
+                                reinterpret_cast<const uint8_t*>(&activation),
+                                sizeof(activation))});
+    const uint32_t activationIndex = 0;
+
+    const std::vector<float> constant(size.tensorElements, 1.0f);
+    uint32_t previousIndex = static_cast<uint32_t>(operands.size());
+    operands.push_back(makeTensor(size.tensorElements, nn::Operand::LifeTime::SUBGRAPH_INPUT));
+    model.main.inputIndexes = {previousIndex};
+    for (uint32_t i = 0; i < size.operationCount; ++i) {
+        const uint32_t constantIndex = static_cast<uint32_t>(operands.size());
+        operands.push_back(makeTensor(size.tensorElements, nn::Operand::LifeTime::CONSTANT_COPY));
+        operands.back().location =
+                model.operandValues.append(reinterpret_cast<const uint8_t*>(constant.data()),
+                                           constant.size() * sizeof(float));
+
+        const bool last = i + 1 == size.operationCount;
+        const uint32_t outputIndex = static_cast<uint32_t>(operands.size());
+        operands.push_back(makeTensor(size.tensorElements,
+                                      last ? nn::Operand::LifeTime::SUBGRAPH_OUTPUT
+                                           : nn::Operand::LifeTime::TEMPORARY_VARIABLE));
+        model.main.operations.push_back({.type = nn::OperationType::ADD,
+                                          .inputs = {previousIndex, constantIndex, activationIndex},
+                                          .outputs = {outputIndex}});
+        previousIndex = outputIndex;
+    }
+    model.main.outputIndexes = {previousIndex};
+    return model;
+}
+
+// The input and the output of the model, both in one memory pool
+nn::GeneralResult<nn::Request> makeRequest(const ModelSize& size) {
+    const uint32_t tensorBytes = size.tensorElements * sizeof(float);
+    auto memory = NN_TRY(nn::createSharedMemory(2 * tensorBytes));
+    return nn::Request{
+            .inputs = {{.lifetime = nn::Request::Argument::LifeTime::POOL,
+                        .location = {.poolIndex = 0, .offset = 0, .length = tensorBytes},
+                        .dimensions = {}}},
+            .outputs = {{.lifetime = nn::Request::Argument::LifeTime::POOL,
+                         .location = {.poolIndex = 0, .offset = tensorBytes, .length = tensorBytes},
+                         .dimensions = {}}},
+            .pools = {std::move(memory)}};
+}
+
+nn::GeneralResult<nn::SharedPreparedModel> prepareModel(const nn::IDevice& device,
+                                                        const nn::Model& model) {
+    return device.prepareModel(model, nn::ExecutionPreference::DEFAULT, nn::Priority::DEFAULT, {},
+                               {}, {}, {}, {}, {});
+}
+
+// Everything an execution benchmark needs, created outside of its timed loop
+struct ExecutionSetup {
+    nn::SharedDevice device;
+    nn::SharedPreparedModel preparedModel;
+    nn::Request request;
+};
+
+nn::GeneralResult<ExecutionSetup> createExecutionSetup(Stack stack, const ModelSize& size) {
+    auto device = NN_TRY(createDevice(stack));
+    auto preparedModel = NN_TRY(prepareModel(*device, makeModel(size)));
+    auto request = NN_TRY(makeRequest(size));
+    return ExecutionSetup{.device = std::move(device),
+                          .preparedModel = std::move(preparedModel),
+                          .request = std::move(request)};
+}
+
+void setLabel(benchmark::State& state, const char* layer, const ModelSize& size) {
+    state.SetLabel(std::string(layer) + "/" + size.name);
+}
+
+// All of the benchmarks below take the same args: the stack, and the index of the model size
+
+void BM_PrepareModel(benchmark::State& state) {
+    const auto stack = static_cast<Stack>(state.range(0));
+    const auto& size = kModelSizes[state.range(1)];
+    setLabel(state, kStackNames[state.range(0)], size);
+    const auto device = createDevice(stack);
+    if (!device.has_value()) {
+        state.SkipWithError("createDevice failed");
+        return;
+    }
+    const auto model = makeModel(size);
+
+    for (auto _ : state) {
+        if (!prepareModel(*device.value(), model).has_value()) {
+            state.SkipWithError("prepareModel failed");
+            break;
+        }
+    }
+}
+
+void BM_Execute(benchmark::State& state) {
+    const auto& size = kModelSizes[state.range(1)];
+    setLabel(state, kStackNames[state.range(0)], size);
+    const auto setup = createExecutionSetup(static_cast<Stack>(state.range(0)), size);
+    if (!setup.has_value()) {
+        state.SkipWithError("createExecutionSetup failed");
+        return;
+    }
+    const auto& [device, preparedModel, request] = setup.value();
+
+    for (auto _ : state) {
+        if (!preparedModel->execute(request, nn::MeasureTiming::NO, {}, {}, {}, {}).has_value()) {
+            state.SkipWithError("execute failed");
+            break;
+        }
+    }
+}
+
+// Launches the execution and retrieves its timing once it has completed
+void BM_ExecuteFenced(benchmark::State& state) {
+    const auto& size = kModelSizes[state.range(1)];
+    setLabel(state, kStackNames[state.range(0)], size);
+    const auto setup = createExecutionSetup(static_cast<Stack>(state.range(0)), size);
+    if (!setup.has_value()) {
+        state.SkipWithError("createExecutionSetup failed");
+        return;
+    }
+    const auto& [device, preparedModel, request] = setup.value();
+
+    for (auto _ : state) {
+        const auto result = preparedModel->executeFenced(request, {}, nn::MeasureTiming::NO, {},
+                                                         {}, {}, {}, {});
+        if (!result.has_value() ||
+            result.value().first.syncWait({}) != nn::SyncFence::FenceState::SIGNALED ||
+            !result.value().second().has_value()) {
+            state.SkipWithError("executeFenced failed");
+            break;
+        }
+    }
+}
+
+void BM_BurstExecute(benchmark::State& state) {
+    const auto& size = kModelSizes[state.range(1)];
+    setLabel(state, kStackNames[state.range(0)], size);
+    const auto setup = createExecutionSetup(static_cast<Stack>(state.range(0)), size);
+    if (!setup.has_value()) {
+        state.SkipWithError("createExecutionSetup failed");
+        return;
+    }
+    const auto& [device, preparedModel, request] = setup.value();
+    const auto burst = preparedModel->configureExecutionBurst();
+    if (!burst.has_value()) {
+        state.SkipWithError("configureExecutionBurst failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        if (!burst.value()->execute(request, nn::MeasureTiming::NO, {}, {}, {}, {}).has_value()) {
+            state.SkipWithError("burst execute failed");
+            break;
+        }
+    }
+}
+
+// Converts the model to the HAL type and back, as the client and the adapter of the stack do in
+// prepareModel
+void BM_ModelConversion(benchmark::State& state) {
+    const auto stack = static_cast<Stack>(state.range(0));
+    const auto& size = kModelSizes[state.range(1)];
+    setLabel(state, kStackNames[state.range(0)], size);
+    const auto model = makeModel(size);
+
+    for (auto _ : state) {
+        const bool converted =
+                stack == Stack::AIDL
+                        ? nn::convert(aidl_utils::convert(model).value()).has_value()
+                        : nn::convert(V1_3::utils::convert(model).value()).has_value();
+        if (!converted) {
+            state.SkipWithError("conversion failed");
+            break;
+        }
+    }
+}
+
+// Converts the request to the HAL type and back, as the client and the adapter of the stack do in
+// execute
+void BM_RequestConversion(benchmark::State& state) {
+    const auto stack = static_cast<Stack>(state.range(0));
+    const auto& size = kModelSizes[state.range(1)];
+    setLabel(state, kStackNames[state.range(0)], size);
+    const auto request = makeRequest(size);
+    if (!request.has_value()) {
+        state.SkipWithError("makeRequest failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        const bool converted =
+                stack == Stack::AIDL
+                        ? nn::convert(aidl_utils::convert(request.value()).value()).has_value()
+                        : nn::convert(V1_3::utils::convert(request.value()).value()).has_value();
+        if (!converted) {
+            state.SkipWithError("conversion failed");
+            break;
+        }
+    }
+}
+
+void StacksAndSizes(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgsProduct({{0, 1, 2}, {0, 1, 2}})->ArgNames({"stack", "size"});
+}
+
+void HalsAndSizes(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgsProduct({{static_cast<int>(Stack::AIDL), static_cast<int>(Stack::HIDL)},
+                            {0, 1, 2}})
+            ->ArgNames({"stack", "size"});
+}
+
+}  // namespace
+
+BENCHMARK(BM_PrepareModel)->Apply(StacksAndSizes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Execute)->Apply(StacksAndSizes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ExecuteFenced)->Apply(StacksAndSizes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BurstExecute)->Apply(StacksAndSizes)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ModelConversion)->Apply(HalsAndSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RequestConversion)->Apply(HalsAndSizes)->Unit(benchmark::kMicrosecond);
+
+}  // namespace android::hardware::neuralnetworks::utils
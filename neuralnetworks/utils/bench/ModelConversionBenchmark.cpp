@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/neuralnetworks/Model.h>
+#include <benchmark/benchmark.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/CommonUtils.h>
+#include <nnapi/hal/aidl/Conversions.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+namespace aidl_utils = ::aidl::android::hardware::neuralnetworks::utils;
+
+// The weights of a transformer layer are split in tensors of this size
+constexpr size_t kTensorSize = 4 * 1024 * 1024;
+
+size_t getResidentBytes() {
+    size_t totalPages = 0;
+    size_t residentPages = 0;
+    std::ifstream("/proc/self/statm") >> totalPages >> residentPages;
+    return residentPages * static_cast<size_t>(getpagesize());
+}
+
+// A model with `size` bytes of constant operand values, all in CONSTANT_COPY operands
+nn::Model makeModel(size_t size) {
+    nn::Model model;
+    const std::vector<uint8_t> tensor(kTensorSize, 1);
+    for (size_t i = 0; i < size / kTensorSize; ++i) {
+        model.main.operands.push_back({
+                .type = nn::OperandType::TENSOR_QUANT8_ASYMM,
+                .dimensions = {static_cast<uint32_t>(kTensorSize)},
+                .scale = 1.0f,
+                .zeroPoint = 0,
+                .lifetime = nn::Operand::LifeTime::CONSTANT_COPY,
+                .location = model.operandValues.append(tensor.data(), tensor.size()),
+        });
+    }
+    return model;
+}
+
+// Converts the model as prepareModel does on both ends of the IPC, to the AIDL model in the client
+// and back to the canonical model in the adapter. Args: the size of the constant operand values in
+// MiB, and whether the large ones are moved to shared memory first.
+void BM_PrepareModelConversion(benchmark::State& state) {
+    const auto model = makeModel(static_cast<size_t>(state.range(0)) * 1024 * 1024);
+    const bool moveToShared = state.range(1) != 0;
+    const size_t baseline = getResidentBytes();
+    size_t peak = 0;
+
+    for (auto _ : state) {
+        std::optional<nn::Model> maybeModelInShared;
+        const nn::Model* modelToSend = &model;
+        if (moveToShared) {
+            modelToSend = &moveLargeConstantsToShared(&model, kLargeConstantThreshold,
+                                                      &maybeModelInShared)
+                                   .value()
+                                   .get();
+        }
+        const auto aidlModel = aidl_utils::unvalidatedConvert(*modelToSend).value();
+        const auto adapterModel = nn::unvalidatedConvert(aidlModel).value();
+        benchmark::DoNotOptimize(adapterModel);
+
+        // Every copy of the operand values is alive at this point
+        peak = std::max(peak, getResidentBytes());
+    }
+
+    state.counters["rss_mb"] =
+            static_cast<double>(peak > baseline ? peak - baseline : 0) / (1024 * 1024);
+}
+
+}  // namespace
+
+BENCHMARK(BM_PrepareModelConversion)
+        ->ArgsProduct({{16, 128}, {0, 1}})
+        ->ArgNames({"mb", "shared"})
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+}  // namespace android::hardware::neuralnetworks::utils
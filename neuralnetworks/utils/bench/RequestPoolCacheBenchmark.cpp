@@ -0,0 +1,151 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/neuralnetworks/ExecutionResult.h>
+#include <aidl/android/hardware/neuralnetworks/Request.h>
+#include <android-base/thread_annotations.h>
+#include <android/binder_auto_utils.h>
+#include <benchmark/benchmark.h>
+#include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/aidl/Conversions.h>
+#include <nnapi/hal/aidl/PreparedModel.h>
+
+#include <any>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace aidl::android::hardware::neuralnetworks {
+namespace {
+
+namespace nn = ::android::nn;
+
+constexpr uint32_t kPoolSize = 64 * 1024;
+
+// Driver that maps the memory pools of each request, and keeps the mapping of a memory for as
+// long as the memory is alive, as drivers do for the memories of bursts and reusable executions.
+class MappingPreparedModel final : public nn::IPreparedModel {
+  public:
+    nn::ExecutionResult<std::pair<std::vector<nn::OutputShape>, nn::Timing>> execute(
+            const nn::Request& request, nn::MeasureTiming /*measure*/,
+            const nn::OptionalTimePoint& /*deadline*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        std::lock_guard guard(mMutex);
+        std::erase_if(mMappings, [](const auto& entry) { return entry.second.first.expired(); });
+        for (const auto& pool : request.pools) {
+            const auto& memory = std::get<nn::SharedMemory>(pool);
+            if (mMappings.count(memory.get()) == 0) {
+                auto mapping = NN_TRY(nn::map(memory));
+                mMappings.emplace(memory.get(), std::make_pair(memory, std::move(mapping)));
+            }
+        }
+        return std::make_pair(std::vector<nn::OutputShape>{}, nn::Timing{});
+    }
+
+    nn::GeneralResult<std::pair<nn::SyncFence, nn::ExecuteFencedInfoCallback>> executeFenced(
+            const nn::Request& /*request*/, const std::vector<nn::SyncFence>& /*waitFor*/,
+            nn::MeasureTiming /*measure*/, const nn::OptionalTimePoint& /*deadline*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const nn::OptionalDuration& /*timeoutDurationAfterFence*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the benchmark";
+    }
+
+    nn::GeneralResult<nn::SharedExecution> createReusableExecution(
+            const nn::Request& /*request*/, nn::MeasureTiming /*measure*/,
+            const nn::OptionalDuration& /*loopTimeoutDuration*/,
+            const std::vector<nn::TokenValuePair>& /*hints*/,
+            const std::vector<nn::ExtensionNameAndPrefix>& /*extensionNameToPrefix*/)
+            const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the benchmark";
+    }
+
+    nn::GeneralResult<nn::SharedBurst> configureExecutionBurst() const override {
+        return NN_ERROR(nn::ErrorStatus::GENERAL_FAILURE) << "Not used by the benchmark";
+    }
+
+    std::any getUnderlyingResource() const override { return {}; }
+
+  private:
+    mutable std::mutex mMutex;
+    mutable std::map<const nn::Memory*, std::pair<std::weak_ptr<const nn::Memory>, nn::Mapping>>
+            mMappings GUARDED_BY(mMutex);
+};
+
+// Request with an input and an output in each of `poolCount` ashmem pools. The adapter only
+// caches the pools when ashmem is backed by memfd, as the regions of /dev/ashmem share an inode.
+nn::GeneralResult<Request> createRequest(uint32_t poolCount) {
+    nn::Request request;
+    for (uint32_t i = 0; i < poolCount; ++i) {
+        request.pools.push_back(NN_TRY(nn::createSharedMemory(kPoolSize)));
+        request.inputs.push_back(
+                {.lifetime = nn::Request::Argument::LifeTime::POOL,
+                 .location = {.poolIndex = i, .offset = 0, .length = kPoolSize / 2},
+                 .dimensions = {}});
+        request.outputs.push_back(
+                {.lifetime = nn::Request::Argument::LifeTime::POOL,
+                 .location = {.poolIndex = i, .offset = kPoolSize / 2, .length = kPoolSize / 2},
+                 .dimensions = {}});
+    }
+    return utils::convert(request);
+}
+
+// Executes a request through the adapter, as a client that cannot use a burst does. Args: the
+// number of memory pools of the request, and whether the adapter caches the converted pools.
+void BM_ExecuteSynchronously(benchmark::State& state) {
+    const auto poolCount = static_cast<uint32_t>(state.range(0));
+    const bool cached = state.range(1) != 0;
+    const auto request = createRequest(poolCount);
+    if (!request.has_value()) {
+        state.SkipWithError("createRequest failed");
+        return;
+    }
+    const auto preparedModel = ndk::SharedRefBase::make<adapter::PreparedModel>(
+            std::make_shared<const MappingPreparedModel>(),
+            cached ? adapter::PreparedModel::ThreadSafeRequestPoolCache::kDefaultMaxEntries : 0);
+
+    ExecutionResult executionResult;
+    for (auto _ : state) {
+        const auto status = preparedModel->executeSynchronously(
+                request.value(), /*measureTiming=*/false, /*deadlineNs=*/-1,
+                /*loopTimeoutDurationNs=*/-1, &executionResult);
+        if (!status.isOk()) {
+            state.SkipWithError("executeSynchronously failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ExecuteSynchronously)
+        ->ArgsProduct({{1, 8, 32}, {0, 1}})
+        ->ArgNames({"pools", "cached"})
+        ->Unit(benchmark::kMicrosecond);
+
+}  // namespace aidl::android::hardware::neuralnetworks
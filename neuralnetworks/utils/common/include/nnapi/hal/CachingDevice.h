@@ -0,0 +1,103 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_CACHING_DEVICE_H
+#define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_CACHING_DEVICE_H
+
+#include "nnapi/hal/CompilationCache.h"
+
+#include <nnapi/IBuffer.h>
+#include <nnapi/IDevice.h>
+#include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
+#include <nnapi/Types.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+
+/**
+ * Device that keeps the compilations of the device it wraps in a CompilationCache.
+ *
+ * A driver wraps its nn::IDevice in a CachingDevice before passing it to adapter::adapt. The
+ * driver then only has to write its compilation to the cache files in prepareModel and read it
+ * back in prepareModelFromCache, and its compilations are cached even when the client does not
+ * provide cache files.
+ *
+ * prepareModel is forwarded unchanged when the client provides cache files, when the device does
+ * not need cache files, or when a memory pool of the model cannot be mapped. Otherwise the token
+ * of the client is ignored, as the HAL requires without cache files, and the cache entry is keyed
+ * by a SHA-256 digest of the model, including its constant data, and of the preference, priority,
+ * hints and extension prefixes it is compiled with. Clients compiling the same model therefore
+ * share its entry, and no client can reach the compilation of a different model. A cached
+ * compilation is prepared with prepareModelFromCache, and the model is compiled into a new cache
+ * entry if there is none or if preparing it from the cache fails. The driver is given the digest
+ * as the cache token in both cases.
+ *
+ * The model is hashed on every such prepareModel, which reads all of its constant data.
+ * prepareModelFromCache is always forwarded unchanged, as there is no model to identify the entry.
+ */
+class CachingDevice final : public nn::IDevice {
+    struct PrivateConstructorTag {};
+
+  public:
+    static nn::GeneralResult<std::shared_ptr<const CachingDevice>> create(
+            nn::SharedDevice device, std::shared_ptr<CompilationCache> cache);
+
+    CachingDevice(PrivateConstructorTag tag, nn::SharedDevice device,
+                  std::shared_ptr<CompilationCache> cache);
+
+    const std::string& getName() const override;
+    const std::string& getVersionString() const override;
+    nn::Version getFeatureLevel() const override;
+    nn::DeviceType getType() const override;
+    const std::vector<nn::Extension>& getSupportedExtensions() const override;
+    const nn::Capabilities& getCapabilities() const override;
+    std::pair<uint32_t, uint32_t> getNumberOfCacheFilesNeeded() const override;
+
+    nn::GeneralResult<void> wait() const override;
+
+    nn::GeneralResult<std::vector<bool>> getSupportedOperations(
+            const nn::Model& model) const override;
+
+    nn::GeneralResult<nn::SharedPreparedModel> prepareModel(
+            const nn::Model& model, nn::ExecutionPreference preference, nn::Priority priority,
+            nn::OptionalTimePoint deadline, const std::vector<nn::SharedHandle>& modelCache,
+            const std::vector<nn::SharedHandle>& dataCache, const nn::CacheToken& token,
+            const std::vector<nn::TokenValuePair>& hints,
+            const std::vector<nn::ExtensionNameAndPrefix>& extensionNameToPrefix) const override;
+
+    nn::GeneralResult<nn::SharedPreparedModel> prepareModelFromCache(
+            nn::OptionalTimePoint deadline, const std::vector<nn::SharedHandle>& modelCache,
+            const std::vector<nn::SharedHandle>& dataCache,
+            const nn::CacheToken& token) const override;
+
+    nn::GeneralResult<nn::SharedBuffer> allocate(
+            const nn::BufferDesc& desc, const std::vector<nn::SharedPreparedModel>& preparedModels,
+            const std::vector<nn::BufferRole>& inputRoles,
+            const std::vector<nn::BufferRole>& outputRoles) const override;
+
+  private:
+    const nn::SharedDevice kDevice;
+    const std::shared_ptr<CompilationCache> kCache;
+};
+
+}  // namespace android::hardware::neuralnetworks::utils
+
+#endif  // ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_CACHING_DEVICE_H
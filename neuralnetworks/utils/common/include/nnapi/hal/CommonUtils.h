@@ -22,6 +22,7 @@
 #include <nnapi/Types.h>
 
 #include <functional>
+#include <optional>
 #include <vector>
 
 // Shorthands
@@ -48,6 +49,29 @@ nn::Capabilities::OperandPerformanceTable makeQuantized8PerformanceConsistentWit
         const nn::Capabilities::PerformanceInfo& float32Performance,
         const nn::Capabilities::PerformanceInfo& quantized8Performance);
 
+/**
+ * Operand values of at least this many bytes are sent to the driver in shared memory instead of
+ * inline in the model.
+ */
+constexpr size_t kLargeConstantThreshold = 64 * 1024;
+
+/**
+ * Moves the values of the CONSTANT_COPY operands of at least `threshold` bytes into a new shared
+ * memory pool, turning them into CONSTANT_REFERENCE operands.
+ *
+ * The inline operand values of a model are copied in each conversion to and from the HAL types and
+ * in the IPC, which for models with large weights doubles the peak memory of prepareModel. The
+ * values in shared memory are copied only once, here, and are mapped by the driver.
+ *
+ * @param model Model to be moved.
+ * @param threshold Size from which an operand value is moved to shared memory.
+ * @param maybeModelInSharedOut Out parameter holding the model with the moved values, if any.
+ * @return The model with the large values in shared memory, which is either `*model` if it has
+ *     none, or `**maybeModelInSharedOut` otherwise.
+ */
+nn::GeneralResult<std::reference_wrapper<const nn::Model>> moveLargeConstantsToShared(
+        const nn::Model* model, size_t threshold, std::optional<nn::Model>* maybeModelInSharedOut);
+
 using nn::convertRequestFromPointerToShared;
 using nn::flushDataFromPointerToShared;
 using nn::hasNoPointerData;
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_COMPILATION_CACHE_H
+#define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_COMPILATION_CACHE_H
+
+#include <android-base/thread_annotations.h>
+#include <nnapi/IDevice.h>
+#include <nnapi/Result.h>
+#include <nnapi/Types.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+
+/**
+ * Persistent cache of the compilations of a driver, kept in a directory.
+ *
+ * An entry holds the model cache and data cache files a driver writes in prepareModel and reads in
+ * prepareModelFromCache. It is keyed by a token identifying the compilation and by the name and
+ * version of the device, so that an updated driver does not read the compilations of the previous
+ * version. The cache is shared by all the clients of the driver, so the token must identify what
+ * was compiled rather than be chosen by a client: see CachingDevice.
+ *
+ * Each entry is a directory holding the cache files and a manifest. The manifest records the key,
+ * and the size and CRC32 of each file, and is itself checksummed. The files are verified through a
+ * read-only mapping before they are handed to the driver, and a corrupted entry is removed. The
+ * entries are written in a temporary directory renamed once complete, so that a crash never
+ * leaves a partial entry.
+ *
+ * The least recently used entries are evicted to keep the cache within its size and entry limits.
+ * The cache is safe to use from multiple threads, but not from multiple processes.
+ */
+class CompilationCache final {
+    struct PrivateConstructorTag {};
+
+  public:
+    struct Options {
+        std::string directory;
+        // Total size of the cache files and manifests of the entries
+        uint64_t maxSize = 256 * 1024 * 1024;
+        size_t maxEntries = 256;
+    };
+
+    struct Key {
+        nn::CacheToken token;
+        // Name and version string of the device
+        std::string deviceId;
+    };
+
+    struct Files {
+        std::vector<nn::SharedHandle> modelCache;
+        std::vector<nn::SharedHandle> dataCache;
+        // Generation of the entry the files were looked up from
+        uint64_t generation = 0;
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        // Entries removed because they failed verification
+        uint64_t corrupted;
+        uint64_t evictions;
+        size_t entryCount;
+        uint64_t size;
+    };
+
+    /**
+     * Entry being written by a driver, which is discarded unless committed.
+     */
+    class PendingEntry final {
+      public:
+        PendingEntry(PendingEntry&& other) noexcept;
+        PendingEntry& operator=(PendingEntry&& other) = delete;
+        ~PendingEntry();
+
+        const Files& getFiles() const { return mFiles; }
+
+      private:
+        friend class CompilationCache;
+        PendingEntry(Key key, std::string directory, Files files);
+
+        Key mKey;
+        std::string mDirectory;
+        Files mFiles;
+    };
+
+    static nn::GeneralResult<std::shared_ptr<CompilationCache>> create(Options options);
+
+    static Key makeKey(const nn::IDevice& device, const nn::CacheToken& token);
+
+    CompilationCache(PrivateConstructorTag tag, Options options);
+
+    /**
+     * Opens the cache files of an entry for reading.
+     *
+     * @return The files of the entry, or std::nullopt if there is no entry for the key, if the
+     *     entry does not have the given number of files, or if it fails verification.
+     */
+    std::optional<Files> lookup(const Key& key, std::pair<uint32_t, uint32_t> numberOfFiles)
+            EXCLUDES(mMutex);
+
+    /**
+     * Creates the empty cache files of a new entry, for the driver to write in prepareModel.
+     */
+    nn::GeneralResult<PendingEntry> begin(const Key& key,
+                                          std::pair<uint32_t, uint32_t> numberOfFiles)
+            EXCLUDES(mMutex);
+
+    /**
+     * Checksums the files of the entry and publishes it, replacing any entry of the same key and
+     * evicting the least recently used entries over the limits.
+     */
+    nn::GeneralResult<void> commit(PendingEntry entry) EXCLUDES(mMutex);
+
+    /**
+     * Removes the entry the files were looked up from, unless it has been replaced since.
+     */
+    void remove(const Key& key, const Files& files) EXCLUDES(mMutex);
+
+    Stats getStats() const EXCLUDES(mMutex);
+
+  private:
+    struct Entry {
+        uint64_t size;
+        // Distinguishes the entry from any later entry of the same key
+        uint64_t generation;
+        std::list<std::string>::iterator lruIt;
+    };
+
+    nn::GeneralResult<void> load() EXCLUDES(mMutex);
+    // Removes the entry, unless it is not of `generation` when one is given
+    void removeLocked(const std::string& name,
+                      std::optional<uint64_t> generation = std::nullopt) REQUIRES(mMutex);
+    void evictLocked(const std::string& keep) REQUIRES(mMutex);
+
+    const Options kOptions;
+    mutable std::mutex mMutex;
+    // The entries by directory name, and the names from the most to the least recently used
+    std::map<std::string, Entry> mEntries GUARDED_BY(mMutex);
+    std::list<std::string> mLru GUARDED_BY(mMutex);
+    uint64_t mSize GUARDED_BY(mMutex) = 0;
+    uint64_t mNextPendingId GUARDED_BY(mMutex) = 0;
+    uint64_t mNextGeneration GUARDED_BY(mMutex) = 0;
+    Stats mStats GUARDED_BY(mMutex) = {};
+};
+
+}  // namespace android::hardware::neuralnetworks::utils
+
+#endif  // ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_COMPILATION_CACHE_H
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_THREAD_POOL_EXECUTOR_H
+#define ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_THREAD_POOL_EXECUTOR_H
+
+#include <android-base/thread_annotations.h>
+#include <nnapi/Types.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+
+/**
+ * Runs tasks on a fixed number of worker threads, in order of priority and then of deadline.
+ *
+ * A task whose deadline passes while it waits for a worker is shed: its onDeadlineMissed closure
+ * runs instead, which is expected to report the missed deadline to the client. The tasks waiting
+ * when the executor is destroyed are all run or shed before the destructor returns, so it must not
+ * be destroyed from one of its own tasks.
+ */
+class ThreadPoolExecutor final {
+  public:
+    using Task = std::function<void()>;
+
+    struct Stats {
+        size_t threadCount;
+        // Tasks waiting for a worker
+        size_t queueDepth;
+        size_t maxQueueDepth;
+        uint64_t executed;
+        uint64_t shed;
+        // Time from execute() to the start of the task, for the executed tasks
+        nn::Duration totalWaitTime;
+        nn::Duration maxWaitTime;
+        // Over the last kWaitTimeWindow executed tasks
+        nn::Duration p50WaitTime;
+        nn::Duration p99WaitTime;
+    };
+
+    static constexpr size_t kWaitTimeWindow = 1024;
+
+    // One worker per core, bounded to [2, 8]
+    static size_t getDefaultThreadCount();
+
+    explicit ThreadPoolExecutor(size_t threadCount = getDefaultThreadCount());
+    ~ThreadPoolExecutor();
+
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+    /**
+     * Queues a task. A task without deadline, or without onDeadlineMissed closure, is never shed
+     * and runs after the tasks of the same priority which have a deadline.
+     */
+    void execute(Task task, Task onDeadlineMissed, nn::Priority priority,
+                 nn::OptionalTimePoint deadline) EXCLUDES(mMutex);
+
+    Stats getStats() const EXCLUDES(mMutex);
+
+  private:
+    // Ordered so that the first key is the next task to run
+    struct Key {
+        nn::Priority priority;
+        nn::TimePoint deadline;
+        uint64_t sequence;
+
+        bool operator<(const Key& other) const;
+    };
+
+    using DeadlineIndex = std::multimap<nn::TimePoint, Key>;
+
+    struct Entry {
+        Task task;
+        Task onDeadlineMissed;
+        nn::TimePoint queuedTime;
+        std::optional<DeadlineIndex::iterator> deadlineIt;
+    };
+
+    void workerLoop() EXCLUDES(mMutex);
+    Task takeNextLocked(nn::TimePoint now) REQUIRES(mMutex);
+
+    std::vector<std::thread> mThreads;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mIsStopping GUARDED_BY(mMutex) = false;
+    uint64_t mNextSequence GUARDED_BY(mMutex) = 0;
+    std::map<Key, Entry> mQueue GUARDED_BY(mMutex);
+    // The queued tasks which can be shed, by deadline
+    DeadlineIndex mDeadlines GUARDED_BY(mMutex);
+
+    size_t mMaxQueueDepth GUARDED_BY(mMutex) = 0;
+    uint64_t mExecuted GUARDED_BY(mMutex) = 0;
+    uint64_t mShed GUARDED_BY(mMutex) = 0;
+    nn::Duration mTotalWaitTime GUARDED_BY(mMutex){};
+    nn::Duration mMaxWaitTime GUARDED_BY(mMutex){};
+    std::vector<nn::Duration> mRecentWaitTimes GUARDED_BY(mMutex);
+};
+
+}  // namespace android::hardware::neuralnetworks::utils
+
+#endif  // ANDROID_HARDWARE_INTERFACES_NEURALNETWORKS_UTILS_COMMON_THREAD_POOL_EXECUTOR_H
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CachingDevice.h"
+
+#include "CompilationCache.h"
+
+#include <android-base/logging.h>
+#include <nnapi/IBuffer.h>
+#include <nnapi/IDevice.h>
+#include <nnapi/IPreparedModel.h>
+#include <nnapi/Result.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/Types.h>
+#include <openssl/sha.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+static_assert(SHA256_DIGEST_LENGTH == nn::kByteSizeOfCacheToken);
+
+class Hasher {
+  public:
+    Hasher() { SHA256_Init(&mContext); }
+
+    void update(const void* data, size_t size) { SHA256_Update(&mContext, data, size); }
+
+    template <typename Type>
+    std::enable_if_t<std::is_arithmetic_v<Type> || std::is_enum_v<Type>> update(Type value) {
+        update(&value, sizeof(value));
+    }
+
+    template <typename Type>
+    std::enable_if_t<std::is_arithmetic_v<Type>> update(const std::vector<Type>& values) {
+        update(values.size());
+        update(values.data(), values.size() * sizeof(Type));
+    }
+
+    void update(const std::string& value) {
+        update(value.size());
+        update(value.data(), value.size());
+    }
+
+    nn::CacheToken finish() {
+        nn::CacheToken digest;
+        SHA256_Final(digest.data(), &mContext);
+        return digest;
+    }
+
+  private:
+    SHA256_CTX mContext;
+};
+
+void hash(Hasher* hasher, const nn::Operand& operand) {
+    hasher->update(operand.type);
+    hasher->update(operand.dimensions);
+    hasher->update(operand.scale);
+    hasher->update(operand.zeroPoint);
+    hasher->update(operand.lifetime);
+    hasher->update(operand.location.poolIndex);
+    hasher->update(operand.location.offset);
+    hasher->update(operand.location.length);
+    hasher->update(operand.location.padding);
+    hasher->update(operand.extraParams.index());
+    if (const auto* channelQuant =
+                std::get_if<nn::Operand::SymmPerChannelQuantParams>(&operand.extraParams)) {
+        hasher->update(channelQuant->scales);
+        hasher->update(channelQuant->channelDim);
+    } else if (const auto* extension =
+                       std::get_if<nn::Operand::ExtensionParams>(&operand.extraParams)) {
+        hasher->update(*extension);
+    }
+}
+
+void hash(Hasher* hasher, const nn::Model::Subgraph& subgraph) {
+    hasher->update(subgraph.operands.size());
+    for (const auto& operand : subgraph.operands) {
+        hash(hasher, operand);
+    }
+    hasher->update(subgraph.operations.size());
+    for (const auto& operation : subgraph.operations) {
+        hasher->update(operation.type);
+        hasher->update(operation.inputs);
+        hasher->update(operation.outputs);
+    }
+    hasher->update(subgraph.inputIndexes);
+    hasher->update(subgraph.outputIndexes);
+}
+
+void hash(Hasher* hasher, const std::vector<nn::ExtensionNameAndPrefix>& extensionNameToPrefix) {
+    hasher->update(extensionNameToPrefix.size());
+    for (const auto& [name, prefix] : extensionNameToPrefix) {
+        hasher->update(name);
+        hasher->update(prefix);
+    }
+}
+
+// Hashes the contents of the memory pools, or returns false if one of them cannot be mapped
+bool hashPools(Hasher* hasher, const std::vector<nn::SharedMemory>& pools) {
+    hasher->update(pools.size());
+    for (const auto& pool : pools) {
+        if (pool == nullptr) {
+            return false;
+        }
+        const auto mapping = nn::map(pool);
+        if (!mapping.has_value()) {
+            return false;
+        }
+        const void* data = std::visit([](auto* pointer) -> const void* { return pointer; },
+                                      mapping->pointer);
+        hasher->update(mapping->size);
+        hasher->update(data, mapping->size);
+    }
+    return true;
+}
+
+// Digest of everything the compilation of the model depends on, or std::nullopt if a memory pool
+// of the model cannot be read. Unlike the cache token of a client, which only has to be unique
+// among the models of that client, it identifies the compilation across all the clients.
+std::optional<nn::CacheToken> getCompilationDigest(
+        const nn::Model& model, nn::ExecutionPreference preference, nn::Priority priority,
+        const std::vector<nn::TokenValuePair>& hints,
+        const std::vector<nn::ExtensionNameAndPrefix>& extensionNameToPrefix) {
+    Hasher hasher;
+    hash(&hasher, model.main);
+    hasher.update(model.referenced.size());
+    for (const auto& subgraph : model.referenced) {
+        hash(&hasher, subgraph);
+    }
+    hasher.update(model.operandValues.size());
+    hasher.update(model.operandValues.data(), model.operandValues.size());
+    if (!hashPools(&hasher, model.pools)) {
+        return std::nullopt;
+    }
+    hasher.update(model.relaxComputationFloat32toFloat16);
+    hash(&hasher, model.extensionNameToPrefix);
+
+    hasher.update(preference);
+    hasher.update(priority);
+    hasher.update(hints.size());
+    for (const auto& [token, value] : hints) {
+        hasher.update(token);
+        hasher.update(value);
+    }
+    hash(&hasher, extensionNameToPrefix);
+    return hasher.finish();
+}
+
+}  // namespace
+
+nn::GeneralResult<std::shared_ptr<const CachingDevice>> CachingDevice::create(
+        nn::SharedDevice device, std::shared_ptr<CompilationCache> cache) {
+    if (device == nullptr || cache == nullptr) {
+        return NN_ERROR(nn::ErrorStatus::INVALID_ARGUMENT)
+               << "utils::CachingDevice::create must have non-empty device and cache";
+    }
+    return std::make_shared<const CachingDevice>(PrivateConstructorTag{}, std::move(device),
+                                                 std::move(cache));
+}
+
+CachingDevice::CachingDevice(PrivateConstructorTag /*tag*/, nn::SharedDevice device,
+                             std::shared_ptr<CompilationCache> cache)
+    : kDevice(std::move(device)), kCache(std::move(cache)) {
+    CHECK(kDevice != nullptr);
+    CHECK(kCache != nullptr);
+}
+
+const std::string& CachingDevice::getName() const {
+    return kDevice->getName();
+}
+
+const std::string& CachingDevice::getVersionString() const {
+    return kDevice->getVersionString();
+}
+
+nn::Version CachingDevice::getFeatureLevel() const {
+    return kDevice->getFeatureLevel();
+}
+
+nn::DeviceType CachingDevice::getType() const {
+    return kDevice->getType();
+}
+
+const std::vector<nn::Extension>& CachingDevice::getSupportedExtensions() const {
+    return kDevice->getSupportedExtensions();
+}
+
+const nn::Capabilities& CachingDevice::getCapabilities() const {
+    return kDevice->getCapabilities();
+}
+
+std::pair<uint32_t, uint32_t> CachingDevice::getNumberOfCacheFilesNeeded() const {
+    return kDevice->getNumberOfCacheFilesNeeded();
+}
+
+nn::GeneralResult<void> CachingDevice::wait() const {
+    return kDevice->wait();
+}
+
+nn::GeneralResult<std::vector<bool>> CachingDevice::getSupportedOperations(
+        const nn::Model& model) const {
+    return kDevice->getSupportedOperations(model);
+}
+
+nn::GeneralResult<nn::SharedPreparedModel> CachingDevice::prepareModel(
+        const nn::Model& model, nn::ExecutionPreference preference, nn::Priority priority,
+        nn::OptionalTimePoint deadline, const std::vector<nn::SharedHandle>& modelCache,
+        const std::vector<nn::SharedHandle>& dataCache, const nn::CacheToken& token,
+        const std::vector<nn::TokenValuePair>& hints,
+        const std::vector<nn::ExtensionNameAndPrefix>& extensionNameToPrefix) const {
+    const auto numberOfFiles = kDevice->getNumberOfCacheFilesNeeded();
+    const bool needsFiles = numberOfFiles.first > 0 || numberOfFiles.second > 0;
+    const auto digest = modelCache.empty() && dataCache.empty() && needsFiles
+                                ? getCompilationDigest(model, preference, priority, hints,
+                                                       extensionNameToPrefix)
+                                : std::nullopt;
+    if (!digest.has_value()) {
+        return kDevice->prepareModel(model, preference, priority, deadline, modelCache, dataCache,
+                                     token, hints, extensionNameToPrefix);
+    }
+
+    // The token of the client is ignored as it provides no cache files, and the driver is given
+    // the digest as the token of the cache entry instead
+    const auto key = CompilationCache::makeKey(*kDevice, *digest);
+    if (const auto files = kCache->lookup(key, numberOfFiles)) {
+        auto result = kDevice->prepareModelFromCache(deadline, files->modelCache, files->dataCache,
+                                                     *digest);
+        if (result.has_value()) {
+            return result;
+        }
+        // The driver rejected the entry, so it is replaced by a new compilation
+        LOG(WARNING) << "utils::CachingDevice failed to prepare model from cache: "
+                     << result.error().message;
+        kCache->remove(key, *files);
+    }
+
+    auto maybeEntry = kCache->begin(key, numberOfFiles);
+    if (!maybeEntry.has_value()) {
+        LOG(WARNING) << "utils::CachingDevice failed to create cache entry: "
+                     << maybeEntry.error().message;
+        return kDevice->prepareModel(model, preference, priority, deadline, modelCache, dataCache,
+                                     token, hints, extensionNameToPrefix);
+    }
+    auto entry = std::move(maybeEntry).value();
+    const auto& files = entry.getFiles();
+    auto preparedModel = NN_TRY(kDevice->prepareModel(model, preference, priority, deadline,
+                                                      files.modelCache, files.dataCache, *digest,
+                                                      hints, extensionNameToPrefix));
+    if (auto result = kCache->commit(std::move(entry)); !result.has_value()) {
+        LOG(WARNING) << "utils::CachingDevice failed to commit cache entry: "
+                     << result.error().message;
+    }
+    return preparedModel;
+}
+
+nn::GeneralResult<nn::SharedPreparedModel> CachingDevice::prepareModelFromCache(
+        nn::OptionalTimePoint deadline, const std::vector<nn::SharedHandle>& modelCache,
+        const std::vector<nn::SharedHandle>& dataCache, const nn::CacheToken& token) const {
+    // Without the model, the cache entry cannot be identified
+    return kDevice->prepareModelFromCache(deadline, modelCache, dataCache, token);
+}
+
+nn::GeneralResult<nn::SharedBuffer> CachingDevice::allocate(
+        const nn::BufferDesc& desc, const std::vector<nn::SharedPreparedModel>& preparedModels,
+        const std::vector<nn::BufferRole>& inputRoles,
+        const std::vector<nn::BufferRole>& outputRoles) const {
+    return kDevice->allocate(desc, preparedModels, inputRoles, outputRoles);
+}
+
+}  // namespace android::hardware::neuralnetworks::utils
@@ -31,6 +31,50 @@
 #include <vector>
 
 namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+bool isLargeConstant(const nn::Operand& operand, size_t threshold) {
+    return operand.lifetime == nn::Operand::LifeTime::CONSTANT_COPY &&
+           operand.location.length >= threshold;
+}
+
+bool hasLargeConstant(const nn::Model::Subgraph& subgraph, size_t threshold) {
+    return std::any_of(subgraph.operands.begin(), subgraph.operands.end(),
+                       [threshold](const auto& operand) {
+                           return isLargeConstant(operand, threshold);
+                       });
+}
+
+// Relocates the CONSTANT_COPY operands of the subgraph, the large ones into the memory and the
+// others into the new operand values
+nn::GeneralResult<void> relocateConstants(const nn::Model::OperandValues& oldOperandValues,
+                                          size_t threshold, nn::Model::Subgraph* subgraph,
+                                          nn::ConstantMemoryBuilder* memoryBuilder,
+                                          nn::Model::OperandValues* newOperandValues) {
+    for (auto& operand : subgraph->operands) {
+        if (operand.lifetime != nn::Operand::LifeTime::CONSTANT_COPY) {
+            continue;
+        }
+        const auto& location = operand.location;
+        if (location.offset > oldOperandValues.size() ||
+            location.length > oldOperandValues.size() - location.offset) {
+            return NN_ERROR(nn::ErrorStatus::INVALID_ARGUMENT)
+                   << "Operand value of " << location.length << " bytes at offset "
+                   << location.offset << " exceeds the " << oldOperandValues.size()
+                   << " bytes of operand values";
+        }
+        const uint8_t* data = oldOperandValues.data() + location.offset;
+        if (isLargeConstant(operand, threshold)) {
+            operand.lifetime = nn::Operand::LifeTime::CONSTANT_REFERENCE;
+            operand.location = memoryBuilder->append(data, location.length);
+        } else {
+            operand.location = newOperandValues->append(data, location.length);
+        }
+    }
+    return {};
+}
+
+}  // namespace
 
 nn::Capabilities::OperandPerformanceTable makeQuantized8PerformanceConsistentWithP(
         const nn::Capabilities::PerformanceInfo& float32Performance,
@@ -51,4 +95,44 @@ nn::Capabilities::OperandPerformanceTable makeQuantized8PerformanceConsistentWit
             .value();
 }
 
+nn::GeneralResult<std::reference_wrapper<const nn::Model>> moveLargeConstantsToShared(
+        const nn::Model* model, size_t threshold, std::optional<nn::Model>* maybeModelInSharedOut) {
+    CHECK(model != nullptr);
+    CHECK(maybeModelInSharedOut != nullptr);
+
+    const auto hasLargeConstantIn = [threshold](const nn::Model::Subgraph& subgraph) {
+        return hasLargeConstant(subgraph, threshold);
+    };
+    if (!hasLargeConstantIn(model->main) &&
+        std::none_of(model->referenced.begin(), model->referenced.end(), hasLargeConstantIn)) {
+        return *model;
+    }
+
+    // Only the subgraphs are copied, as the operand values are what this avoids copying. The
+    // memory builder copies the large values when it finishes.
+    auto main = model->main;
+    auto referenced = model->referenced;
+    const auto poolIndex = static_cast<uint32_t>(model->pools.size());
+    nn::ConstantMemoryBuilder memoryBuilder(poolIndex);
+    nn::Model::OperandValues operandValues;
+    NN_TRY(relocateConstants(model->operandValues, threshold, &main, &memoryBuilder,
+                             &operandValues));
+    for (auto& subgraph : referenced) {
+        NN_TRY(relocateConstants(model->operandValues, threshold, &subgraph, &memoryBuilder,
+                                 &operandValues));
+    }
+    auto memory = NN_TRY(memoryBuilder.finish());
+
+    auto pools = model->pools;
+    pools.push_back(std::move(memory));
+    return maybeModelInSharedOut->emplace(nn::Model{
+            .main = std::move(main),
+            .referenced = std::move(referenced),
+            .operandValues = std::move(operandValues),
+            .pools = std::move(pools),
+            .relaxComputationFloat32toFloat16 = model->relaxComputationFloat32toFloat16,
+            .extensionNameToPrefix = model->extensionNameToPrefix,
+    });
+}
+
 }  // namespace android::hardware::neuralnetworks::utils
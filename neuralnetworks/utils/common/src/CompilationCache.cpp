@@ -0,0 +1,538 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CompilationCache.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <nnapi/IDevice.h>
+#include <nnapi/Result.h>
+#include <nnapi/Types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr uint32_t kManifestMagic = 0x4343'4e4e;  // "NNCC"
+constexpr uint32_t kManifestVersion = 1;
+constexpr char kManifestName[] = "manifest";
+constexpr char kPendingInfix[] = ".pending";
+
+constexpr std::array<uint32_t, 256> makeCrc32Table() {
+    std::array<uint32_t, 256> table = {};
+    for (uint32_t i = 0; i < table.size(); ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB8'8320 : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr auto kCrc32Table = makeCrc32Table();
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFF'FFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc = kCrc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint64_t fnv1a(const std::string& value) {
+    uint64_t hash = 0xcbf2'9ce4'8422'2325;
+    for (const char c : value) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100'0000'01b3;
+    }
+    return hash;
+}
+
+// Name of the directory of the entry, which does not contain kPendingInfix
+std::string getEntryName(const CompilationCache::Key& key) {
+    std::string name;
+    for (const uint8_t byte : key.token) {
+        name += base::StringPrintf("%02x", byte);
+    }
+    const auto deviceHash = static_cast<unsigned long long>(fnv1a(key.deviceId));
+    return name + base::StringPrintf("-%016llx", deviceHash);
+}
+
+std::string getFileName(const char* prefix, size_t index) {
+    return prefix + std::to_string(index);
+}
+
+struct FileInfo {
+    uint64_t size;
+    uint32_t crc;
+};
+
+struct Manifest {
+    nn::CacheToken token;
+    std::string deviceId;
+    std::vector<FileInfo> modelCache;
+    std::vector<FileInfo> dataCache;
+};
+
+template <typename Type>
+void append(std::string* buffer, const Type& value) {
+    buffer->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// The manifest is in the native byte order, as the cache never leaves the device
+std::string serialize(const Manifest& manifest) {
+    std::string buffer;
+    append(&buffer, kManifestMagic);
+    append(&buffer, kManifestVersion);
+    append(&buffer, manifest.token);
+    append(&buffer, static_cast<uint32_t>(manifest.deviceId.size()));
+    buffer += manifest.deviceId;
+    for (const auto* infos : {&manifest.modelCache, &manifest.dataCache}) {
+        append(&buffer, static_cast<uint32_t>(infos->size()));
+        for (const auto& info : *infos) {
+            append(&buffer, info.size);
+            append(&buffer, info.crc);
+        }
+    }
+    append(&buffer, crc32(reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size()));
+    return buffer;
+}
+
+class ManifestReader {
+  public:
+    explicit ManifestReader(const std::string& buffer) : mBuffer(buffer) {}
+
+    template <typename Type>
+    bool read(Type* value) {
+        if (mBuffer.size() - mOffset < sizeof(Type)) {
+            return false;
+        }
+        std::memcpy(value, mBuffer.data() + mOffset, sizeof(Type));
+        mOffset += sizeof(Type);
+        return true;
+    }
+
+    bool read(std::string* value, size_t size) {
+        if (mBuffer.size() - mOffset < size) {
+            return false;
+        }
+        value->assign(mBuffer, mOffset, size);
+        mOffset += size;
+        return true;
+    }
+
+    size_t offset() const { return mOffset; }
+
+  private:
+    const std::string& mBuffer;
+    size_t mOffset = 0;
+};
+
+std::optional<Manifest> deserialize(const std::string& buffer) {
+    ManifestReader reader(buffer);
+    Manifest manifest;
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t deviceIdSize = 0;
+    if (!reader.read(&magic) || magic != kManifestMagic || !reader.read(&version) ||
+        version != kManifestVersion || !reader.read(&manifest.token) ||
+        !reader.read(&deviceIdSize) || !reader.read(&manifest.deviceId, deviceIdSize)) {
+        return std::nullopt;
+    }
+    for (auto* infos : {&manifest.modelCache, &manifest.dataCache}) {
+        uint32_t count = 0;
+        if (!reader.read(&count) || count > nn::kMaxNumberOfCacheFiles) {
+            return std::nullopt;
+        }
+        infos->resize(count);
+        for (auto& info : *infos) {
+            if (!reader.read(&info.size) || !reader.read(&info.crc)) {
+                return std::nullopt;
+            }
+        }
+    }
+    const size_t checksummedSize = reader.offset();
+    uint32_t crc = 0;
+    if (!reader.read(&crc) || reader.offset() != buffer.size() ||
+        crc != crc32(reinterpret_cast<const uint8_t*>(buffer.data()), checksummedSize)) {
+        return std::nullopt;
+    }
+    return manifest;
+}
+
+// Checksums the whole file through a read-only mapping
+std::optional<FileInfo> checksumFile(int fd) {
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size < 0) {
+        return std::nullopt;
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        return FileInfo{.size = 0, .crc = crc32(nullptr, 0)};
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return std::nullopt;
+    }
+    const uint32_t crc = crc32(static_cast<const uint8_t*>(data), size);
+    munmap(data, size);
+    return FileInfo{.size = size, .crc = crc};
+}
+
+std::optional<std::string> readFile(int fd) {
+    std::string buffer;
+    if (!base::ReadFdToString(fd, &buffer)) {
+        return std::nullopt;
+    }
+    return buffer;
+}
+
+nn::GeneralResult<nn::SharedHandle> openFile(const fs::path& path, int flags) {
+    auto fd = base::unique_fd(open(path.c_str(), flags | O_CLOEXEC, S_IRUSR | S_IWUSR));
+    if (!fd.ok()) {
+        return NN_ERROR() << "Failed to open " << path << ": " << strerror(errno);
+    }
+    return std::make_shared<const nn::Handle>(std::move(fd));
+}
+
+nn::GeneralResult<std::vector<nn::SharedHandle>> openFiles(const fs::path& directory,
+                                                           const char* prefix, size_t count,
+                                                           int flags) {
+    std::vector<nn::SharedHandle> handles;
+    handles.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        handles.push_back(NN_TRY(openFile(directory / getFileName(prefix, i), flags)));
+    }
+    return handles;
+}
+
+// Checksums the files of a pending entry
+std::optional<std::vector<FileInfo>> checksumFiles(const std::vector<nn::SharedHandle>& handles) {
+    std::vector<FileInfo> infos;
+    infos.reserve(handles.size());
+    for (const auto& handle : handles) {
+        auto info = checksumFile(handle->get());
+        if (!info.has_value()) {
+            return std::nullopt;
+        }
+        infos.push_back(*info);
+    }
+    return infos;
+}
+
+bool matches(const std::vector<nn::SharedHandle>& handles, const std::vector<FileInfo>& infos) {
+    return std::equal(handles.begin(), handles.end(), infos.begin(), infos.end(),
+                      [](const nn::SharedHandle& handle, const FileInfo& expected) {
+                          const auto actual = checksumFile(handle->get());
+                          return actual.has_value() && actual->size == expected.size &&
+                                 actual->crc == expected.crc;
+                      });
+}
+
+uint64_t getSize(const Manifest& manifest, size_t manifestSize) {
+    uint64_t size = manifestSize;
+    for (const auto* infos : {&manifest.modelCache, &manifest.dataCache}) {
+        for (const auto& info : *infos) {
+            size += info.size;
+        }
+    }
+    return size;
+}
+
+}  // namespace
+
+CompilationCache::PendingEntry::PendingEntry(Key key, std::string directory, Files files)
+    : mKey(std::move(key)), mDirectory(std::move(directory)), mFiles(std::move(files)) {}
+
+CompilationCache::PendingEntry::PendingEntry(PendingEntry&& other) noexcept
+    : mKey(std::move(other.mKey)),
+      mDirectory(std::exchange(other.mDirectory, {})),
+      mFiles(std::move(other.mFiles)) {}
+
+CompilationCache::PendingEntry::~PendingEntry() {
+    if (!mDirectory.empty()) {
+        std::error_code ec;
+        fs::remove_all(mDirectory, ec);
+    }
+}
+
+nn::GeneralResult<std::shared_ptr<CompilationCache>> CompilationCache::create(Options options) {
+    if (options.directory.empty()) {
+        return NN_ERROR(nn::ErrorStatus::INVALID_ARGUMENT)
+               << "utils::CompilationCache::create must have a directory";
+    }
+    auto cache = std::make_shared<CompilationCache>(PrivateConstructorTag{}, std::move(options));
+    NN_TRY(cache->load());
+    return cache;
+}
+
+CompilationCache::Key CompilationCache::makeKey(const nn::IDevice& device,
+                                                const nn::CacheToken& token) {
+    // The name of a device cannot contain a null character, so the ID is unambiguous
+    std::string deviceId = device.getName();
+    deviceId += '\0';
+    deviceId += device.getVersionString();
+    return {.token = token, .deviceId = std::move(deviceId)};
+}
+
+CompilationCache::CompilationCache(PrivateConstructorTag /*tag*/, Options options)
+    : kOptions(std::move(options)) {}
+
+nn::GeneralResult<void> CompilationCache::load() {
+    std::error_code ec;
+    const fs::path directory = kOptions.directory;
+    fs::create_directories(directory, ec);
+    if (ec) {
+        return NN_ERROR() << "Failed to create " << directory << ": " << ec.message();
+    }
+
+    struct Found {
+        fs::file_time_type time;
+        std::string name;
+        uint64_t size;
+    };
+    std::vector<Found> found;
+    auto it = fs::directory_iterator(directory, ec);
+    for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        const auto& dirEntry = *it;
+        const std::string name = dirEntry.path().filename();
+        const fs::path manifestPath = dirEntry.path() / kManifestName;
+        auto manifestFd = base::unique_fd(open(manifestPath.c_str(), O_RDONLY | O_CLOEXEC));
+        const auto buffer = manifestFd.ok() ? readFile(manifestFd.get()) : std::nullopt;
+        const auto manifest = buffer.has_value() ? deserialize(*buffer) : std::nullopt;
+
+        // Leftovers of entries never committed are removed, and so are entries without a valid
+        // manifest. The files of the other entries are verified when they are looked up.
+        if (name.find(kPendingInfix) != std::string::npos || !manifest.has_value() ||
+            getEntryName({.token = manifest->token, .deviceId = manifest->deviceId}) != name) {
+            LOG(INFO) << "utils::CompilationCache removing invalid entry " << dirEntry.path();
+            std::error_code removeEc;
+            fs::remove_all(dirEntry.path(), removeEc);
+            continue;
+        }
+        std::error_code timeEc;
+        found.push_back({.time = fs::last_write_time(manifestPath, timeEc),
+                         .name = name,
+                         .size = getSize(*manifest, buffer->size())});
+    }
+    if (ec) {
+        return NN_ERROR() << "Failed to read " << directory << ": " << ec.message();
+    }
+
+    // The time of the manifest is that of the last use of the entry
+    std::sort(found.begin(), found.end(),
+              [](const Found& a, const Found& b) { return a.time > b.time; });
+
+    std::lock_guard guard(mMutex);
+    for (auto& [time, name, size] : found) {
+        mLru.push_back(name);
+        mEntries.emplace(std::move(name), Entry{.size = size,
+                                                .generation = mNextGeneration++,
+                                                .lruIt = std::prev(mLru.end())});
+        mSize += size;
+    }
+    evictLocked({});
+    return {};
+}
+
+std::optional<CompilationCache::Files> CompilationCache::lookup(
+        const Key& key, std::pair<uint32_t, uint32_t> numberOfFiles) {
+    const auto [numModelCache, numDataCache] = numberOfFiles;
+    const std::string name = getEntryName(key);
+    const fs::path directory = fs::path(kOptions.directory) / name;
+
+    base::unique_fd manifestFd;
+    Files files;
+    {
+        std::lock_guard guard(mMutex);
+        const auto it = mEntries.find(name);
+        if (it == mEntries.end()) {
+            ++mStats.misses;
+            return std::nullopt;
+        }
+        mLru.splice(mLru.begin(), mLru, it->second.lruIt);
+        files.generation = it->second.generation;
+
+        // The files are opened while the entry cannot be evicted. Once open, they remain readable
+        // even if the entry is removed.
+        manifestFd.reset(open((directory / kManifestName).c_str(), O_RDONLY | O_CLOEXEC));
+        auto modelCache = openFiles(directory, "model", numModelCache, O_RDONLY);
+        auto dataCache = openFiles(directory, "data", numDataCache, O_RDONLY);
+        if (manifestFd.ok() && modelCache.has_value() && dataCache.has_value()) {
+            files.modelCache = std::move(modelCache).value();
+            files.dataCache = std::move(dataCache).value();
+        } else {
+            manifestFd.reset();
+        }
+    }
+
+    // The files are verified without holding the lock, as this reads them entirely
+    const auto buffer = manifestFd.ok() ? readFile(manifestFd.get()) : std::nullopt;
+    const auto manifest = buffer.has_value() ? deserialize(*buffer) : std::nullopt;
+    const bool valid = manifest.has_value() && manifest->token == key.token &&
+                       manifest->deviceId == key.deviceId &&
+                       matches(files.modelCache, manifest->modelCache) &&
+                       matches(files.dataCache, manifest->dataCache);
+
+    std::lock_guard guard(mMutex);
+    if (!valid) {
+        // The entry may have been replaced while it was verified, and the new entry is kept
+        LOG(WARNING) << "utils::CompilationCache removing corrupted entry " << directory;
+        removeLocked(name, files.generation);
+        ++mStats.corrupted;
+        ++mStats.misses;
+        return std::nullopt;
+    }
+    // Records the use of the entry for the next process
+    futimens(manifestFd.get(), nullptr);
+    ++mStats.hits;
+    return files;
+}
+
+nn::GeneralResult<CompilationCache::PendingEntry> CompilationCache::begin(
+        const Key& key, std::pair<uint32_t, uint32_t> numberOfFiles) {
+    const auto [numModelCache, numDataCache] = numberOfFiles;
+    if (numModelCache > nn::kMaxNumberOfCacheFiles || numDataCache > nn::kMaxNumberOfCacheFiles) {
+        return NN_ERROR(nn::ErrorStatus::INVALID_ARGUMENT)
+               << "Too many cache files: " << numModelCache << " model cache and " << numDataCache
+               << " data cache files";
+    }
+
+    uint64_t pendingId = 0;
+    {
+        std::lock_guard guard(mMutex);
+        pendingId = mNextPendingId++;
+    }
+    const fs::path directory = fs::path(kOptions.directory) /
+                               (getEntryName(key) + kPendingInfix + std::to_string(pendingId));
+    if (mkdir(directory.c_str(), S_IRWXU) != 0) {
+        return NN_ERROR() << "Failed to create " << directory << ": " << strerror(errno);
+    }
+
+    // The entry removes the directory if creating the files fails
+    PendingEntry entry(key, directory, {});
+    constexpr int kFlags = O_RDWR | O_CREAT | O_EXCL;
+    entry.mFiles.modelCache = NN_TRY(openFiles(directory, "model", numModelCache, kFlags));
+    entry.mFiles.dataCache = NN_TRY(openFiles(directory, "data", numDataCache, kFlags));
+    return entry;
+}
+
+nn::GeneralResult<void> CompilationCache::commit(PendingEntry entry) {
+    auto modelCache = checksumFiles(entry.mFiles.modelCache);
+    auto dataCache = checksumFiles(entry.mFiles.dataCache);
+    if (!modelCache.has_value() || !dataCache.has_value()) {
+        return NN_ERROR() << "Failed to checksum the cache files in " << entry.mDirectory;
+    }
+    const Manifest manifest = {.token = entry.mKey.token,
+                               .deviceId = entry.mKey.deviceId,
+                               .modelCache = std::move(modelCache).value(),
+                               .dataCache = std::move(dataCache).value()};
+    const std::string buffer = serialize(manifest);
+    const uint64_t size = getSize(manifest, buffer.size());
+    if (size > kOptions.maxSize) {
+        return NN_ERROR() << "Cache entry of " << size << " bytes exceeds the cache size limit of "
+                          << kOptions.maxSize << " bytes";
+    }
+
+    // The files are not synced: an entry torn by a crash fails verification and is removed
+    const fs::path manifestPath = fs::path(entry.mDirectory) / kManifestName;
+    const auto manifestFd = NN_TRY(openFile(manifestPath, O_WRONLY | O_CREAT | O_EXCL));
+    if (!base::WriteFully(manifestFd->get(), buffer.data(), buffer.size())) {
+        return NN_ERROR() << "Failed to write " << manifestPath << ": " << strerror(errno);
+    }
+
+    const std::string name = getEntryName(entry.mKey);
+    std::lock_guard guard(mMutex);
+    removeLocked(name);
+    const fs::path directory = fs::path(kOptions.directory) / name;
+    if (rename(entry.mDirectory.c_str(), directory.c_str()) != 0) {
+        return NN_ERROR() << "Failed to rename " << entry.mDirectory << " to " << directory << ": "
+                          << strerror(errno);
+    }
+    entry.mDirectory.clear();
+
+    mLru.push_front(name);
+    mEntries.emplace(name, Entry{.size = size,
+                                 .generation = mNextGeneration++,
+                                 .lruIt = mLru.begin()});
+    mSize += size;
+    evictLocked(name);
+    return {};
+}
+
+void CompilationCache::remove(const Key& key, const Files& files) {
+    std::lock_guard guard(mMutex);
+    removeLocked(getEntryName(key), files.generation);
+}
+
+CompilationCache::Stats CompilationCache::getStats() const {
+    std::lock_guard guard(mMutex);
+    Stats stats = mStats;
+    stats.entryCount = mEntries.size();
+    stats.size = mSize;
+    return stats;
+}
+
+void CompilationCache::removeLocked(const std::string& name,
+                                    std::optional<uint64_t> generation) {
+    const auto it = mEntries.find(name);
+    if (it == mEntries.end() || (generation.has_value() && it->second.generation != *generation)) {
+        return;
+    }
+    mSize -= it->second.size;
+    mLru.erase(it->second.lruIt);
+    mEntries.erase(it);
+
+    std::error_code ec;
+    const fs::path directory = fs::path(kOptions.directory) / name;
+    fs::remove_all(directory, ec);
+    if (ec) {
+        LOG(ERROR) << "utils::CompilationCache failed to remove " << directory << ": "
+                   << ec.message();
+    }
+}
+
+void CompilationCache::evictLocked(const std::string& keep) {
+    while (!mLru.empty() && mLru.back() != keep &&
+           (mEntries.size() > kOptions.maxEntries || mSize > kOptions.maxSize)) {
+        const std::string name = mLru.back();
+        removeLocked(name);
+        ++mStats.evictions;
+    }
+}
+
+}  // namespace android::hardware::neuralnetworks::utils
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ThreadPoolExecutor.h"
+
+#include <android-base/logging.h>
+#include <nnapi/Types.h>
+
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+constexpr size_t kMinThreadCount = 2;
+constexpr size_t kMaxThreadCount = 8;
+
+nn::Duration getPercentile(std::vector<nn::Duration> durations, size_t percent) {
+    if (durations.empty()) {
+        return {};
+    }
+    const auto it = durations.begin() + (durations.size() - 1) * percent / 100;
+    std::nth_element(durations.begin(), it, durations.end());
+    return *it;
+}
+
+}  // namespace
+
+bool ThreadPoolExecutor::Key::operator<(const Key& other) const {
+    if (priority != other.priority) {
+        return priority > other.priority;
+    }
+    if (deadline != other.deadline) {
+        return deadline < other.deadline;
+    }
+    return sequence < other.sequence;
+}
+
+size_t ThreadPoolExecutor::getDefaultThreadCount() {
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), kMinThreadCount,
+                              kMaxThreadCount);
+}
+
+ThreadPoolExecutor::ThreadPoolExecutor(size_t threadCount) {
+    CHECK_GT(threadCount, 0u);
+    mThreads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back(&ThreadPoolExecutor::workerLoop, this);
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+    {
+        std::lock_guard guard(mMutex);
+        mIsStopping = true;
+    }
+    mCondition.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void ThreadPoolExecutor::execute(Task task, Task onDeadlineMissed, nn::Priority priority,
+                                 nn::OptionalTimePoint deadline) {
+    CHECK(task != nullptr);
+    {
+        std::lock_guard guard(mMutex);
+        const Key key = {
+                .priority = priority,
+                .deadline = deadline.value_or(nn::TimePoint::max()),
+                .sequence = mNextSequence++,
+        };
+        Entry entry = {
+                .task = std::move(task),
+                .onDeadlineMissed = std::move(onDeadlineMissed),
+                .queuedTime = nn::Clock::now(),
+                .deadlineIt = std::nullopt,
+        };
+        if (deadline.has_value() && entry.onDeadlineMissed != nullptr) {
+            entry.deadlineIt = mDeadlines.emplace(*deadline, key);
+        }
+        mQueue.emplace(key, std::move(entry));
+        mMaxQueueDepth = std::max(mMaxQueueDepth, mQueue.size());
+    }
+    mCondition.notify_one();
+}
+
+ThreadPoolExecutor::Stats ThreadPoolExecutor::getStats() const {
+    std::lock_guard guard(mMutex);
+    return {
+            .threadCount = mThreads.size(),
+            .queueDepth = mQueue.size(),
+            .maxQueueDepth = mMaxQueueDepth,
+            .executed = mExecuted,
+            .shed = mShed,
+            .totalWaitTime = mTotalWaitTime,
+            .maxWaitTime = mMaxWaitTime,
+            .p50WaitTime = getPercentile(mRecentWaitTimes, 50),
+            .p99WaitTime = getPercentile(mRecentWaitTimes, 99),
+    };
+}
+
+void ThreadPoolExecutor::workerLoop() {
+    std::unique_lock lock(mMutex);
+    while (true) {
+        while (mQueue.empty() && !mIsStopping) {
+            mCondition.wait(lock);
+        }
+        // The queue is drained before the workers exit
+        if (mQueue.empty()) {
+            return;
+        }
+        Task task = takeNextLocked(nn::Clock::now());
+        lock.unlock();
+        task();
+        // Release what the task captured before taking the lock again
+        task = nullptr;
+        lock.lock();
+    }
+}
+
+ThreadPoolExecutor::Task ThreadPoolExecutor::takeNextLocked(nn::TimePoint now) {
+    // The expired tasks are shed first, so that their clients are told right away instead of
+    // after the tasks ahead of them
+    if (!mDeadlines.empty() && mDeadlines.begin()->first < now) {
+        auto node = mQueue.extract(mDeadlines.begin()->second);
+        mDeadlines.erase(mDeadlines.begin());
+        ++mShed;
+        return std::move(node.mapped().onDeadlineMissed);
+    }
+
+    auto node = mQueue.extract(mQueue.begin());
+    Entry& entry = node.mapped();
+    if (entry.deadlineIt.has_value()) {
+        mDeadlines.erase(*entry.deadlineIt);
+    }
+    const nn::Duration waitTime = now - entry.queuedTime;
+    ++mExecuted;
+    mTotalWaitTime += waitTime;
+    mMaxWaitTime = std::max(mMaxWaitTime, waitTime);
+    if (mRecentWaitTimes.size() < kWaitTimeWindow) {
+        mRecentWaitTimes.push_back(waitTime);
+    } else {
+        mRecentWaitTimes[mExecuted % kWaitTimeWindow] = waitTime;
+    }
+    return std::move(entry.task);
+}
+
+}  // namespace android::hardware::neuralnetworks::utils
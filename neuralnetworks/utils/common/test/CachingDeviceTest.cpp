@@ -0,0 +1,252 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <gmock/gmock.h>
+#include <nnapi/TypeUtils.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/CachingDevice.h>
+#include <nnapi/hal/CompilationCache.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "MockDevice.h"
+#include "MockPreparedModel.h"
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Ne;
+using ::testing::Return;
+using ::testing::SizeIs;
+
+using SharedMockDevice = std::shared_ptr<const nn::MockDevice>;
+
+const std::string kName = "Google-MockV1";
+const std::string kVersionString = "version1";
+constexpr auto kNumberOfCacheFilesNeeded = std::pair<uint32_t, uint32_t>(1, 2);
+
+nn::CacheToken makeToken() {
+    nn::CacheToken token = {};
+    token.fill(7);
+    return token;
+}
+
+SharedMockDevice createConfiguredMockDevice() {
+    auto mockDevice = std::make_shared<const nn::MockDevice>();
+    constexpr auto getName_ret = []() -> const std::string& { return kName; };
+    constexpr auto getVersionString_ret = []() -> const std::string& { return kVersionString; };
+    EXPECT_CALL(*mockDevice, getName()).WillRepeatedly(getName_ret);
+    EXPECT_CALL(*mockDevice, getVersionString()).WillRepeatedly(getVersionString_ret);
+    EXPECT_CALL(*mockDevice, getNumberOfCacheFilesNeeded())
+            .WillRepeatedly(Return(kNumberOfCacheFilesNeeded));
+    return mockDevice;
+}
+
+// Writes the compilation into the cache files, as a driver does in prepareModel
+constexpr auto writeCache = [](const auto& /*model*/, auto /*preference*/, auto /*priority*/,
+                               const auto& /*deadline*/, const auto& modelCache,
+                               const auto& dataCache, const auto& /*token*/, const auto& /*hints*/,
+                               const auto& /*extensionNameToPrefix*/) {
+    for (const auto* handles : {&modelCache, &dataCache}) {
+        for (const auto& handle : *handles) {
+            base::WriteStringToFd("compilation", handle->get());
+        }
+    }
+    return nn::SharedPreparedModel(std::make_shared<const nn::MockPreparedModel>());
+};
+
+const auto kReturnGeneralFailure = [](const auto&... /*args*/) {
+    return nn::error(nn::ErrorStatus::GENERAL_FAILURE);
+};
+
+std::tuple<SharedMockDevice, std::shared_ptr<CompilationCache>,
+           std::shared_ptr<const CachingDevice>>
+setup(const std::string& directory) {
+    auto mockDevice = createConfiguredMockDevice();
+    auto cache = CompilationCache::create({.directory = directory}).value();
+    auto device = CachingDevice::create(mockDevice, cache).value();
+    return std::make_tuple(std::move(mockDevice), std::move(cache), std::move(device));
+}
+
+}  // namespace
+
+TEST(CachingDeviceTest, invalidCache) {
+    // run test
+    const auto result = CachingDevice::create(createConfiguredMockDevice(), nullptr);
+
+    // verify result
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error().code, nn::ErrorStatus::INVALID_ARGUMENT);
+}
+
+TEST(CachingDeviceTest, prepareModelWithCacheFilesIsForwarded) {
+    // setup call
+    const base::TemporaryDir dir;
+    const auto [mockDevice, cache, device] = setup(dir.path);
+    const base::TemporaryFile file;
+    const auto handle = std::make_shared<const nn::Handle>(base::unique_fd(dup(file.fd)));
+    const std::vector<nn::SharedHandle> modelCache = {handle};
+    const std::vector<nn::SharedHandle> dataCache = {handle, handle};
+    EXPECT_CALL(*mockDevice,
+                prepareModel(_, _, _, _, ElementsAre(handle), SizeIs(2), makeToken(), _, _))
+            .Times(1)
+            .WillOnce(writeCache);
+
+    // run test
+    const auto result =
+            device->prepareModel({}, {}, {}, {}, modelCache, dataCache, makeToken(), {}, {});
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(cache->getStats().entryCount, 0u);
+}
+
+TEST(CachingDeviceTest, prepareModelCompilesIntoCache) {
+    // setup call
+    const base::TemporaryDir dir;
+    const auto [mockDevice, cache, device] = setup(dir.path);
+    EXPECT_CALL(*mockDevice, prepareModel(_, _, _, _, SizeIs(1), SizeIs(2), Ne(makeToken()), _, _))
+            .Times(1)
+            .WillOnce(writeCache);
+
+    // run test
+    const auto result = device->prepareModel({}, {}, {}, {}, {}, {}, makeToken(), {}, {});
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(cache->getStats().entryCount, 1u);
+}
+
+TEST(CachingDeviceTest, prepareModelPreparesFromCacheWhateverTheToken) {
+    // setup call
+    const base::TemporaryDir dir;
+    const auto [mockDevice, cache, device] = setup(dir.path);
+    const auto mockPreparedModel = std::make_shared<const nn::MockPreparedModel>();
+    EXPECT_CALL(*mockDevice, prepareModel(_, _, _, _, _, _, _, _, _))
+            .Times(1)
+            .WillOnce(writeCache);
+    EXPECT_CALL(*mockDevice, prepareModelFromCache(_, SizeIs(1), SizeIs(2), _))
+            .Times(1)
+            .WillOnce(Return(mockPreparedModel));
+    ASSERT_TRUE(device->prepareModel({}, {}, {}, {}, {}, {}, makeToken(), {}, {}).has_value());
+
+    // run test
+    const auto result = device->prepareModel({}, {}, {}, {}, {}, {}, {}, {}, {});
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(result.value(), mockPreparedModel);
+    EXPECT_EQ(cache->getStats().hits, 1u);
+}
+
+TEST(CachingDeviceTest, prepareModelDoesNotShareEntryOfOtherModelWithSameToken) {
+    // setup call
+    const base::TemporaryDir dir;
+    const auto [mockDevice, cache, device] = setup(dir.path);
+    EXPECT_CALL(*mockDevice, prepareModel(_, _, _, _, SizeIs(1), SizeIs(2), _, _, _))
+            .Times(2)
+            .WillRepeatedly(writeCache);
+    EXPECT_CALL(*mockDevice, prepareModelFromCache(_, _, _, _)).Times(0);
+    ASSERT_TRUE(device->prepareModel({}, {}, {}, {}, {}, {}, makeToken(), {}, {}).has_value());
+    nn::Model otherModel;
+    otherModel.relaxComputationFloat32toFloat16 = true;
+
+    // run test
+    const auto result =
+            device->prepareModel(otherModel, {}, {}, {}, {}, {}, makeToken(), {}, {});
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(cache->getStats().entryCount, 2u);
+}
+
+TEST(CachingDeviceTest, prepareModelDoesNotShareEntryOfOtherPreference) {
+    // setup call
+    const base::TemporaryDir dir;
+    const auto [mockDevice, cache, device] = setup(dir.path);
+    EXPECT_CALL(*mockDevice, prepareModel(_, _, _, _, SizeIs(1), SizeIs(2), _, _, _))
+            .Times(2)
+            .WillRepeatedly(writeCache);
+    EXPECT_CALL(*mockDevice, prepareModelFromCache(_, _, _, _)).Times(0);
+    ASSERT_TRUE(device->prepareModel({}, nn::ExecutionPreference::LOW_POWER, {}, {}, {}, {},
+                                     makeToken(), {}, {})
+                        .has_value());
+
+    // run test
+    const auto result = device->prepareModel({}, nn::ExecutionPreference::SUSTAINED_SPEED, {}, {},
+                                             {}, {}, makeToken(), {}, {});
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(cache->getStats().entryCount, 2u);
+}
+
+TEST(CachingDeviceTest, prepareModelFromCacheWithoutFilesIsForwarded) {
+    // setup call
+    const base::TemporaryDir dir;
+    const auto [mockDevice, cache, device] = setup(dir.path);
+    EXPECT_CALL(*mockDevice, prepareModel(_, _, _, _, _, _, _, _, _))
+            .Times(1)
+            .WillOnce(writeCache);
+    EXPECT_CALL(*mockDevice, prepareModelFromCache(_, SizeIs(0), SizeIs(0), makeToken()))
+            .Times(1)
+            .WillOnce(kReturnGeneralFailure);
+    ASSERT_TRUE(device->prepareModel({}, {}, {}, {}, {}, {}, makeToken(), {}, {}).has_value());
+
+    // run test
+    const auto result = device->prepareModelFromCache({}, {}, {}, makeToken());
+
+    // verify result
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error().code, nn::ErrorStatus::GENERAL_FAILURE);
+}
+
+TEST(CachingDeviceTest, prepareModelRecompilesRejectedEntry) {
+    // setup call
+    const base::TemporaryDir dir;
+    const auto [mockDevice, cache, device] = setup(dir.path);
+    EXPECT_CALL(*mockDevice, prepareModel(_, _, _, _, _, _, _, _, _))
+            .Times(2)
+            .WillRepeatedly(writeCache);
+    EXPECT_CALL(*mockDevice, prepareModelFromCache(_, _, _, _))
+            .Times(1)
+            .WillOnce(kReturnGeneralFailure);
+    ASSERT_TRUE(device->prepareModel({}, {}, {}, {}, {}, {}, makeToken(), {}, {}).has_value());
+
+    // run test
+    const auto result = device->prepareModel({}, {}, {}, {}, {}, {}, makeToken(), {}, {});
+
+    // verify result
+    ASSERT_TRUE(result.has_value())
+            << "Failed with " << result.error().code << ": " << result.error().message;
+    EXPECT_EQ(cache->getStats().entryCount, 1u);
+}
+
+}  // namespace android::hardware::neuralnetworks::utils
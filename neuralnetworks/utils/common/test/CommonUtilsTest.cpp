@@ -0,0 +1,127 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/CommonUtils.h>
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <variant>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+constexpr size_t kThreshold = 1024;
+
+// Adds a CONSTANT_COPY operand of `size` bytes, each set to `value`, to the subgraph
+void addConstant(nn::Model* model, nn::Model::Subgraph* subgraph, size_t size, uint8_t value) {
+    const std::vector<uint8_t> data(size, value);
+    subgraph->operands.push_back({
+            .type = nn::OperandType::TENSOR_QUANT8_ASYMM,
+            .dimensions = {static_cast<uint32_t>(size)},
+            .scale = 1.0f,
+            .zeroPoint = 0,
+            .lifetime = nn::Operand::LifeTime::CONSTANT_COPY,
+            .location = model->operandValues.append(data.data(), data.size()),
+    });
+}
+
+// Whether the value of the operand is `size` bytes, each set to `value`
+bool hasValue(const nn::Model& model, const nn::Operand& operand, size_t size, uint8_t value) {
+    const uint8_t* data = nullptr;
+    std::optional<nn::Mapping> mapping;
+    if (operand.lifetime == nn::Operand::LifeTime::CONSTANT_COPY) {
+        data = model.operandValues.data() + operand.location.offset;
+    } else {
+        mapping = nn::map(model.pools.at(operand.location.poolIndex)).value();
+        std::visit([&data](auto* pointer) { data = static_cast<const uint8_t*>(pointer); },
+                   mapping->pointer);
+        data += operand.location.offset;
+    }
+    const std::vector<uint8_t> expected(size, value);
+    return operand.location.length == size && std::memcmp(data, expected.data(), size) == 0;
+}
+
+}  // namespace
+
+TEST(CommonUtilsTest, moveLargeConstantsToSharedKeepsSmallModel) {
+    // setup test
+    nn::Model model;
+    addConstant(&model, &model.main, kThreshold - 1, 1);
+    std::optional<nn::Model> maybeModelInShared;
+
+    // run test
+    const auto result = moveLargeConstantsToShared(&model, kThreshold, &maybeModelInShared);
+
+    // verify result
+    ASSERT_TRUE(result.has_value()) << result.error().message;
+    EXPECT_EQ(&result.value().get(), &model);
+    EXPECT_FALSE(maybeModelInShared.has_value());
+}
+
+TEST(CommonUtilsTest, moveLargeConstantsToSharedMovesLargeValues) {
+    // setup test
+    nn::Model model;
+    addConstant(&model, &model.main, 16, 1);
+    addConstant(&model, &model.main, kThreshold, 2);
+    model.referenced.emplace_back();
+    addConstant(&model, &model.referenced.back(), 2 * kThreshold, 3);
+    addConstant(&model, &model.referenced.back(), 8, 4);
+    std::optional<nn::Model> maybeModelInShared;
+
+    // run test
+    const auto result = moveLargeConstantsToShared(&model, kThreshold, &maybeModelInShared);
+
+    // verify result
+    ASSERT_TRUE(result.has_value()) << result.error().message;
+    ASSERT_TRUE(maybeModelInShared.has_value());
+    const nn::Model& modelInShared = result.value();
+    EXPECT_EQ(&modelInShared, &maybeModelInShared.value());
+    ASSERT_EQ(modelInShared.pools.size(), 1u);
+    EXPECT_LT(modelInShared.operandValues.size(), kThreshold);
+
+    const auto& mainOperands = modelInShared.main.operands;
+    const auto& referencedOperands = modelInShared.referenced.at(0).operands;
+    EXPECT_EQ(mainOperands[0].lifetime, nn::Operand::LifeTime::CONSTANT_COPY);
+    EXPECT_EQ(mainOperands[1].lifetime, nn::Operand::LifeTime::CONSTANT_REFERENCE);
+    EXPECT_EQ(referencedOperands[0].lifetime, nn::Operand::LifeTime::CONSTANT_REFERENCE);
+    EXPECT_EQ(referencedOperands[1].lifetime, nn::Operand::LifeTime::CONSTANT_COPY);
+    EXPECT_TRUE(hasValue(modelInShared, mainOperands[0], 16, 1));
+    EXPECT_TRUE(hasValue(modelInShared, mainOperands[1], kThreshold, 2));
+    EXPECT_TRUE(hasValue(modelInShared, referencedOperands[0], 2 * kThreshold, 3));
+    EXPECT_TRUE(hasValue(modelInShared, referencedOperands[1], 8, 4));
+}
+
+TEST(CommonUtilsTest, moveLargeConstantsToSharedRejectsValueOutOfRange) {
+    // setup test
+    nn::Model model;
+    addConstant(&model, &model.main, kThreshold, 1);
+    model.main.operands[0].location.offset = kThreshold;
+    std::optional<nn::Model> maybeModelInShared;
+
+    // run test
+    const auto result = moveLargeConstantsToShared(&model, kThreshold, &maybeModelInShared);
+
+    // verify result
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error().code, nn::ErrorStatus::INVALID_ARGUMENT);
+}
+
+}  // namespace android::hardware::neuralnetworks::utils
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gmock/gmock.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/CompilationCache.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+constexpr std::pair<uint32_t, uint32_t> kNumberOfFiles = {1, 2};
+const std::string kDeviceId = std::string("device\0version1", 15);
+
+CompilationCache::Key makeKey(uint8_t tokenByte) {
+    nn::CacheToken token = {};
+    token.fill(tokenByte);
+    return {.token = token, .deviceId = kDeviceId};
+}
+
+std::shared_ptr<CompilationCache> createCache(const std::string& directory, size_t maxEntries = 8) {
+    return CompilationCache::create({.directory = directory, .maxEntries = maxEntries}).value();
+}
+
+// Writes a file of `size` bytes set to `value` in each of the cache files of the entry
+void fillFiles(const CompilationCache::PendingEntry& entry, size_t size, char value) {
+    const std::string data(size, value);
+    for (const auto* handles : {&entry.getFiles().modelCache, &entry.getFiles().dataCache}) {
+        for (const auto& handle : *handles) {
+            ASSERT_TRUE(base::WriteFully(handle->get(), data.data(), data.size()));
+        }
+    }
+}
+
+void addEntry(CompilationCache* cache, const CompilationCache::Key& key, char value) {
+    auto entry = cache->begin(key, kNumberOfFiles).value();
+    fillFiles(entry, 64, value);
+    const auto result = cache->commit(std::move(entry));
+    ASSERT_TRUE(result.has_value()) << result.error().message;
+}
+
+std::string readHandle(const nn::SharedHandle& handle) {
+    std::string data;
+    EXPECT_EQ(lseek(handle->get(), 0, SEEK_SET), 0);
+    EXPECT_TRUE(base::ReadFdToString(handle->get(), &data));
+    return data;
+}
+
+size_t countEntries(const std::string& directory) {
+    size_t count = 0;
+    for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator(directory)) {
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace
+
+TEST(CompilationCacheTest, lookupWithoutEntryMisses) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = createCache(dir.path);
+
+    // run test
+    const auto files = cache->lookup(makeKey(1), kNumberOfFiles);
+
+    // verify result
+    EXPECT_FALSE(files.has_value());
+    EXPECT_EQ(cache->getStats().misses, 1u);
+}
+
+TEST(CompilationCacheTest, lookupReturnsCommittedFiles) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = createCache(dir.path);
+    addEntry(cache.get(), makeKey(1), 'a');
+
+    // run test
+    const auto files = cache->lookup(makeKey(1), kNumberOfFiles);
+
+    // verify result
+    ASSERT_TRUE(files.has_value());
+    ASSERT_EQ(files->modelCache.size(), kNumberOfFiles.first);
+    ASSERT_EQ(files->dataCache.size(), kNumberOfFiles.second);
+    EXPECT_EQ(readHandle(files->modelCache[0]), std::string(64, 'a'));
+    EXPECT_EQ(readHandle(files->dataCache[1]), std::string(64, 'a'));
+    EXPECT_EQ(cache->getStats().hits, 1u);
+    EXPECT_FALSE(cache->lookup(makeKey(2), kNumberOfFiles).has_value());
+}
+
+TEST(CompilationCacheTest, lookupRemovesCorruptedEntry) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = createCache(dir.path);
+    addEntry(cache.get(), makeKey(1), 'a');
+    for (const auto& file : std::filesystem::recursive_directory_iterator(dir.path)) {
+        if (file.path().filename() == "data1") {
+            std::ofstream(file.path(), std::ios::in | std::ios::out) << 'b';
+        }
+    }
+
+    // run test
+    const auto files = cache->lookup(makeKey(1), kNumberOfFiles);
+
+    // verify result
+    EXPECT_FALSE(files.has_value());
+    const auto stats = cache->getStats();
+    EXPECT_EQ(stats.corrupted, 1u);
+    EXPECT_EQ(stats.entryCount, 0u);
+    EXPECT_EQ(countEntries(dir.path), 0u);
+}
+
+TEST(CompilationCacheTest, removeKeepsReplacingEntry) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = createCache(dir.path);
+    addEntry(cache.get(), makeKey(1), 'a');
+    const auto stale = cache->lookup(makeKey(1), kNumberOfFiles);
+    ASSERT_TRUE(stale.has_value());
+    addEntry(cache.get(), makeKey(1), 'b');
+
+    // run test
+    cache->remove(makeKey(1), *stale);
+
+    // verify result
+    const auto files = cache->lookup(makeKey(1), kNumberOfFiles);
+    ASSERT_TRUE(files.has_value());
+    EXPECT_EQ(readHandle(files->modelCache[0]), std::string(64, 'b'));
+}
+
+TEST(CompilationCacheTest, removeRemovesLookedUpEntry) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = createCache(dir.path);
+    addEntry(cache.get(), makeKey(1), 'a');
+    const auto files = cache->lookup(makeKey(1), kNumberOfFiles);
+    ASSERT_TRUE(files.has_value());
+
+    // run test
+    cache->remove(makeKey(1), *files);
+
+    // verify result
+    EXPECT_FALSE(cache->lookup(makeKey(1), kNumberOfFiles).has_value());
+    EXPECT_EQ(countEntries(dir.path), 0u);
+}
+
+TEST(CompilationCacheTest, lookupWithOtherNumberOfFilesMisses) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = createCache(dir.path);
+    addEntry(cache.get(), makeKey(1), 'a');
+
+    // run test
+    const auto files = cache->lookup(makeKey(1), {1, 1});
+
+    // verify result
+    EXPECT_FALSE(files.has_value());
+}
+
+TEST(CompilationCacheTest, commitEvictsLeastRecentlyUsed) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = createCache(dir.path, /*maxEntries=*/2);
+    addEntry(cache.get(), makeKey(1), 'a');
+    addEntry(cache.get(), makeKey(2), 'b');
+    ASSERT_TRUE(cache->lookup(makeKey(1), kNumberOfFiles).has_value());
+
+    // run test
+    addEntry(cache.get(), makeKey(3), 'c');
+
+    // verify result
+    EXPECT_EQ(cache->getStats().evictions, 1u);
+    EXPECT_EQ(countEntries(dir.path), 2u);
+    EXPECT_TRUE(cache->lookup(makeKey(1), kNumberOfFiles).has_value());
+    EXPECT_FALSE(cache->lookup(makeKey(2), kNumberOfFiles).has_value());
+    EXPECT_TRUE(cache->lookup(makeKey(3), kNumberOfFiles).has_value());
+}
+
+TEST(CompilationCacheTest, commitRejectsEntryOverSizeLimit) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = CompilationCache::create({.directory = dir.path, .maxSize = 1024}).value();
+    auto entry = cache->begin(makeKey(1), kNumberOfFiles).value();
+    fillFiles(entry, 1024, 'a');
+
+    // run test
+    const auto result = cache->commit(std::move(entry));
+
+    // verify result
+    EXPECT_FALSE(result.has_value());
+    EXPECT_EQ(cache->getStats().entryCount, 0u);
+    EXPECT_EQ(countEntries(dir.path), 0u);
+}
+
+TEST(CompilationCacheTest, uncommittedEntryIsDiscarded) {
+    // setup test
+    const base::TemporaryDir dir;
+    const auto cache = createCache(dir.path);
+
+    // run test
+    {
+        const auto entry = cache->begin(makeKey(1), kNumberOfFiles).value();
+        fillFiles(entry, 64, 'a');
+    }
+
+    // verify result
+    EXPECT_EQ(countEntries(dir.path), 0u);
+    EXPECT_FALSE(cache->lookup(makeKey(1), kNumberOfFiles).has_value());
+}
+
+TEST(CompilationCacheTest, createLoadsEntriesFromDirectory) {
+    // setup test
+    const base::TemporaryDir dir;
+    addEntry(createCache(dir.path).get(), makeKey(1), 'a');
+
+    // run test
+    const auto cache = createCache(dir.path);
+
+    // verify result
+    EXPECT_EQ(cache->getStats().entryCount, 1u);
+    const auto files = cache->lookup(makeKey(1), kNumberOfFiles);
+    ASSERT_TRUE(files.has_value());
+    EXPECT_EQ(readHandle(files->modelCache[0]), std::string(64, 'a'));
+}
+
+}  // namespace android::hardware::neuralnetworks::utils
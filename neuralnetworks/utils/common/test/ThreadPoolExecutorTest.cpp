@@ -0,0 +1,195 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <nnapi/Types.h>
+#include <nnapi/hal/ThreadPoolExecutor.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace android::hardware::neuralnetworks::utils {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+using namespace std::chrono_literals;
+
+// Keeps a worker of an executor busy until release() is called, so that the tasks queued meanwhile
+// are ordered before any of them runs on a single worker
+class Blocker {
+  public:
+    explicit Blocker(ThreadPoolExecutor* executor) {
+        std::promise<void> started;
+        auto isStarted = started.get_future();
+        executor->execute(
+                [this, &started] {
+                    started.set_value();
+                    mRelease.get_future().wait();
+                },
+                {}, nn::Priority::HIGH, {});
+        isStarted.wait();
+    }
+    ~Blocker() { release(); }
+
+    void release() {
+        if (!mIsReleased) {
+            mIsReleased = true;
+            mRelease.set_value();
+        }
+    }
+
+  private:
+    std::promise<void> mRelease;
+    bool mIsReleased = false;
+};
+
+class Recorder {
+  public:
+    ThreadPoolExecutor::Task record(std::string name) {
+        return [this, name = std::move(name)] {
+            std::lock_guard guard(mMutex);
+            mNames.push_back(name);
+        };
+    }
+
+    std::vector<std::string> getNames() {
+        std::lock_guard guard(mMutex);
+        return mNames;
+    }
+
+  private:
+    std::mutex mMutex;
+    std::vector<std::string> mNames;
+};
+
+}  // namespace
+
+TEST(ThreadPoolExecutorTest, runsTask) {
+    // setup test
+    ThreadPoolExecutor executor(2);
+    std::promise<void> done;
+
+    // run test
+    executor.execute([&done] { done.set_value(); }, {}, nn::Priority::DEFAULT, {});
+
+    // verify result
+    EXPECT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+}
+
+TEST(ThreadPoolExecutorTest, ordersByPriorityThenDeadline) {
+    // setup test
+    Recorder recorder;
+    const auto now = nn::Clock::now();
+    {
+        ThreadPoolExecutor executor(1);
+        Blocker blocker(&executor);
+
+        // run test
+        executor.execute(recorder.record("low"), {}, nn::Priority::LOW, {});
+        executor.execute(recorder.record("medium-none"), {}, nn::Priority::MEDIUM, {});
+        executor.execute(recorder.record("medium-late"), {}, nn::Priority::MEDIUM, now + 1h);
+        executor.execute(recorder.record("medium-early"), {}, nn::Priority::MEDIUM, now + 1min);
+        executor.execute(recorder.record("high"), {}, nn::Priority::HIGH, {});
+        blocker.release();
+    }
+
+    // verify result
+    EXPECT_THAT(recorder.getNames(),
+                ElementsAre("high", "medium-early", "medium-late", "medium-none", "low"));
+}
+
+TEST(ThreadPoolExecutorTest, shedsExpiredTask) {
+    // setup test
+    Recorder recorder;
+    ThreadPoolExecutor::Stats stats;
+    {
+        ThreadPoolExecutor executor(1);
+        Blocker blocker(&executor);
+        const auto deadline = nn::Clock::now() + 10ms;
+
+        // run test
+        executor.execute(recorder.record("expired"), recorder.record("missed"),
+                         nn::Priority::MEDIUM, deadline);
+        executor.execute(recorder.record("unshedable"), {}, nn::Priority::MEDIUM, deadline);
+        executor.execute(recorder.record("on-time"), recorder.record("missed-on-time"),
+                         nn::Priority::LOW, nn::Clock::now() + 1h);
+        std::this_thread::sleep_for(20ms);
+        blocker.release();
+        while (executor.getStats().queueDepth > 0) {
+            std::this_thread::sleep_for(1ms);
+        }
+        stats = executor.getStats();
+    }
+
+    // verify result
+    EXPECT_THAT(recorder.getNames(), ElementsAre("missed", "unshedable", "on-time"));
+    EXPECT_EQ(stats.shed, 1u);
+}
+
+TEST(ThreadPoolExecutorTest, drainsQueueOnDestruction) {
+    // setup test
+    Recorder recorder;
+    {
+        ThreadPoolExecutor executor(2);
+        Blocker blocker(&executor);
+
+        // run test
+        executor.execute(recorder.record("a"), {}, nn::Priority::LOW, {});
+        executor.execute(recorder.record("b"), {}, nn::Priority::LOW, {});
+        blocker.release();
+    }
+
+    // verify result
+    EXPECT_THAT(recorder.getNames(), UnorderedElementsAre("a", "b"));
+}
+
+TEST(ThreadPoolExecutorTest, reportsQueueDepthAndWaitTime) {
+    // setup test
+    ThreadPoolExecutor executor(1);
+    auto blocker = std::make_unique<Blocker>(&executor);
+    for (int i = 0; i < 3; ++i) {
+        executor.execute([] {}, {}, nn::Priority::DEFAULT, {});
+    }
+
+    // run test
+    const auto queuedStats = executor.getStats();
+    std::this_thread::sleep_for(10ms);
+    blocker.reset();
+    while (executor.getStats().executed < 4) {
+        std::this_thread::sleep_for(1ms);
+    }
+    const auto stats = executor.getStats();
+
+    // verify result
+    EXPECT_EQ(queuedStats.threadCount, 1u);
+    EXPECT_EQ(queuedStats.queueDepth, 3u);
+    EXPECT_EQ(stats.queueDepth, 0u);
+    EXPECT_EQ(stats.maxQueueDepth, 3u);
+    EXPECT_EQ(stats.shed, 0u);
+    EXPECT_GE(stats.maxWaitTime, 10ms);
+    EXPECT_GE(stats.p99WaitTime, 10ms);
+    EXPECT_LE(stats.p50WaitTime, stats.maxWaitTime);
+    EXPECT_GE(stats.totalWaitTime, 3 * 10ms);
+}
+
+}  // namespace android::hardware::neuralnetworks::utils
@@ -41,10 +41,13 @@ using AidlMQ = AidlMessageQueue<int8_t, SynchronizedReadWrite>;
 using AidlMQDesc = MQDescriptor<int8_t, SynchronizedReadWrite>;
 
 #define WAIT_TIMEOUT 3000000000
+// Polls the input while recorded data is pending, as the DVR playback thread does
+#define RECORD_WAIT_TIMEOUT 10000000
 
 Demux::Demux(int32_t demuxId, uint32_t filterTypes) {
     mDemuxId = demuxId;
     mFilterTypes = filterTypes;
+    mFilterCallbackDispatcher = std::make_shared<FilterCallbackDispatcher>();
 }
 
 void Demux::setTunerService(std::shared_ptr<Tuner> tuner) {
@@ -53,6 +56,11 @@ void Demux::setTunerService(std::shared_ptr<Tuner> tuner) {
 
 Demux::~Demux() {
     ALOGV("%s", __FUNCTION__);
+    {
+        std::unique_lock<std::mutex> lock(mIsIptvThreadRunningMutex);
+        mIsIptvReadThreadExiting = true;
+        mIsIptvThreadRunningCv.notify_all();
+    }
     if (mDemuxIptvReadThread.joinable()) {
         mDemuxIptvReadThread.join();
     }
@@ -175,6 +183,50 @@ void Demux::readIptvThreadLoop(dtv_plugin* interface, dtv_streamer* streamer, si
     }
 }
 
+void Demux::readIptvIngestThreadLoop(int timeout_ms, int buffer_timeout) {
+    std::unique_ptr<Timer> fullBufferTimer;
+    IptvIngest::Sink sink = [&](std::span<const std::span<const int8_t>> payloads) {
+        size_t writtenCount = 0;
+        int result = mDvrPlayback->writePlaybackFMQ(payloads, &writtenCount);
+        switch (result) {
+            case DVR_WRITE_FAILURE_REASON_FMQ_FULL:
+                if (!mIsIptvDvrFMQFull) {
+                    mIsIptvDvrFMQFull = true;
+                    fullBufferTimer = std::make_unique<Timer>();
+                }
+                break;
+            case DVR_WRITE_FAILURE_REASON_UNKNOWN:
+                ALOGE("Failed to write data into DVR FMQ for unknown reason");
+                break;
+            case DVR_WRITE_SUCCESS:
+                mIsIptvDvrFMQFull = false;
+                break;
+            default:
+                ALOGI("Invalid DVR Status");
+        }
+        return writtenCount;
+    };
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(mIsIptvThreadRunningMutex);
+        mIsIptvThreadRunningCv.wait(
+                lock, [this] { return mIsIptvReadThreadRunning || mIsIptvReadThreadExiting; });
+        if (mIsIptvReadThreadExiting) {
+            break;
+        }
+        if (mIsIptvDvrFMQFull && fullBufferTimer->get_elapsed_time_ms() > buffer_timeout) {
+            ALOGE("DVR FMQ has not been flushed within timeout of %d ms", buffer_timeout);
+            break;
+        }
+        // No datagram within the timeout is a gap in the stream, which goes on until the demux
+        // stops; only a socket error ends it
+        if (mIptvIngest->receive(timeout_ms, sink) < 0) {
+            ALOGE("[Demux] Cannot read data from the socket");
+            break;
+        }
+    }
+}
+
 ::ndk::ScopedAStatus Demux::setFrontendDataSource(int32_t in_frontendId) {
     ALOGV("%s", __FUNCTION__);
 
@@ -204,6 +256,23 @@ void Demux::readIptvThreadLoop(dtv_plugin* interface, dtv_streamer* streamer, si
             ALOGI("DVR instance created");
         }
 
+        // call read_stream on the socket to populate the buffer with TS data
+        // while thread is alive, keep reading data
+        int timeout_ms = 20;
+        int buffer_timeout = 10000;  // 10s
+
+        // udp:// and rtp:// streams are received in batches with the RTP packets reordered.
+        // A batch is bounded by the DVR FMQ, which holds only a few datagrams.
+        size_t batchSize = std::max<size_t>(1, IPTV_BUFFER_SIZE / (TS_SIZE * 7));
+        mIptvIngest = IptvIngest::open(mFrontend->getIptvContentUrl(), batchSize);
+        if (mIptvIngest != nullptr && mDvrPlayback != nullptr) {
+            ALOGI("[Demux] Receiving %s without the plugin",
+                  mFrontend->getIptvContentUrl().c_str());
+            mDemuxIptvReadThread = std::thread(&Demux::readIptvIngestThreadLoop, this, timeout_ms,
+                                               buffer_timeout);
+            return ::ndk::ScopedAStatus::ok();
+        }
+
         // get plugin interface from frontend
         dtv_plugin* interface = mFrontend->getIptvPluginInterface();
         if (interface == nullptr) {
@@ -226,10 +295,6 @@ void Demux::readIptvThreadLoop(dtv_plugin* interface, dtv_streamer* streamer, si
         string transport_desc = mFrontend->getIptvTransportDescription();
         ALOGI("[Demux] getIptvTransportDescription(): transport_desc: %s", transport_desc.c_str());
 
-        // call read_stream on the socket to populate the buffer with TS data
-        // while thread is alive, keep reading data
-        int timeout_ms = 20;
-        int buffer_timeout = 10000;  // 10s
         mDemuxIptvReadThread = std::thread(&Demux::readIptvThreadLoop, this, interface, streamer,
                                            IPTV_BUFFER_SIZE, timeout_ms, buffer_timeout);
     }
@@ -356,6 +421,7 @@ void Demux::readIptvThreadLoop(dtv_plugin* interface, dtv_streamer* streamer, si
     mPlaybackFilterIds.clear();
     mRecordFilterIds.clear();
     mFilters.clear();
+    updatePidFilterTable();
     mLastUsedFilterId = -1;
     if (mTuner != nullptr) {
         mTuner->removeDemux(mDemuxId);
@@ -388,40 +454,97 @@ void Demux::readIptvThreadLoop(dtv_plugin* interface, dtv_streamer* streamer, si
     mPlaybackFilterIds.erase(filterId);
     mRecordFilterIds.erase(filterId);
     mFilters.erase(filterId);
+    updatePidFilterTable();
 
     return ::ndk::ScopedAStatus::ok();
 }
 
-void Demux::startBroadcastTsFilter(vector<int8_t> data) {
-    set<int64_t>::iterator it;
-    uint16_t pid = ((data[1] & 0x1f) << 8) | ((data[2] & 0xff));
+void PidFilterTable::add(uint16_t pid, std::shared_ptr<Filter> filter) {
+    int16_t& slot = mSlots[pid & (kPidCount - 1)];
+    if (slot < 0) {
+        slot = mFilterLists.size();
+        mFilterLists.emplace_back();
+    }
+    mFilterLists[slot].push_back(std::move(filter));
+}
+
+std::shared_ptr<const PidFilterTable> Demux::getPidFilterTable() {
+    std::lock_guard<std::mutex> lock(mPidFilterTableLock);
+    return mPidFilterTable;
+}
+
+void Demux::updatePidFilterTable() {
+    // The old table and record filters may hold the last reference to a removed filter, which
+    // calls back into the demux when it is destroyed. They are declared before the lock so that
+    // they are released after it.
+    std::shared_ptr<const PidFilterTable> oldTable;
+    map<int64_t, std::shared_ptr<Filter>> recordFilters;
+    map<int64_t, std::shared_ptr<Filter>> oldRecordFilters;
+    // Concurrent updates are serialized, so that a table built before a filter was started or
+    // stopped never replaces a table built after
+    std::lock_guard<std::mutex> updateLock(mPidFilterTableUpdateLock);
+
+    std::shared_ptr<PidFilterTable> table = std::make_shared<PidFilterTable>();
+    for (int64_t filterId : mPlaybackFilterIds) {
+        auto it = mFilters.find(filterId);
+        if (it == mFilters.end() || it->second == nullptr) {
+            continue;
+        }
+        const std::shared_ptr<Filter>& filter = it->second;
+        if (filter->isStarted() && filter->isTpidConfigured()) {
+            table->add(filter->getTpid(), filter);
+        }
+    }
+
+    oldTable = std::move(table);
+    {
+        std::lock_guard<std::mutex> lock(mPidFilterTableLock);
+        mPidFilterTable.swap(oldTable);
+    }
+
+    if (mDvrRecord != nullptr) {
+        for (int64_t filterId : mRecordFilterIds) {
+            auto it = mFilters.find(filterId);
+            if (it != mFilters.end() && it->second != nullptr && it->second->isStarted() &&
+                it->second->isTpidConfigured()) {
+                recordFilters[filterId] = it->second;
+            }
+        }
+        oldRecordFilters = mDvrRecord->updateRecordFilters(recordFilters);
+    }
+}
+
+void Demux::startBroadcastTsFilter(std::span<const int8_t> packet) {
+    startBroadcastTsFilter(*getPidFilterTable(), packet);
+}
+
+void Demux::startBroadcastTsFilter(const PidFilterTable& table,
+                                   std::span<const int8_t> packet) {
+    uint16_t pid = ((packet[1] & 0x1f) << 8) | ((packet[2] & 0xff));
     if (DEBUG_DEMUX) {
         ALOGW("[Demux] start ts filter pid: %d", pid);
     }
-    for (it = mPlaybackFilterIds.begin(); it != mPlaybackFilterIds.end(); it++) {
-        if (pid == mFilters[*it]->getTpid()) {
-            mFilters[*it]->updateFilterOutput(data);
-        }
+    const vector<std::shared_ptr<Filter>>* filters = table.find(pid);
+    if (filters == nullptr) {
+        return;
+    }
+    for (const auto& filter : *filters) {
+        filter->updateFilterOutput(packet);
     }
 }
 
-void Demux::sendFrontendInputToRecord(vector<int8_t> data) {
-    set<int64_t>::iterator it;
+void Demux::sendFrontendInputToRecord(std::span<const int8_t> packet) {
     if (DEBUG_DEMUX) {
         ALOGW("[Demux] update record filter output");
     }
-    for (it = mRecordFilterIds.begin(); it != mRecordFilterIds.end(); it++) {
-        mFilters[*it]->updateRecordOutput(data);
+    if (mDvrRecord != nullptr) {
+        mDvrRecord->recordPacket(packet);
     }
 }
 
-void Demux::sendFrontendInputToRecord(vector<int8_t> data, uint16_t pid, uint64_t pts) {
-    sendFrontendInputToRecord(data);
-    set<int64_t>::iterator it;
-    for (it = mRecordFilterIds.begin(); it != mRecordFilterIds.end(); it++) {
-        if (pid == mFilters[*it]->getTpid()) {
-            mFilters[*it]->updatePts(pts);
-        }
+void Demux::sendFrontendInputToRecord(std::span<const int8_t> frame, uint16_t pid, int64_t pts) {
+    if (mDvrRecord != nullptr) {
+        mDvrRecord->recordFrame(pid, pts, frame);
     }
 }
 
@@ -439,17 +562,20 @@ bool Demux::startBroadcastFilterDispatcher() {
 }
 
 bool Demux::startRecordFilterDispatcher() {
-    set<int64_t>::iterator it;
-
-    for (it = mRecordFilterIds.begin(); it != mRecordFilterIds.end(); it++) {
-        if (!mFilters[*it]->startRecordFilterHandler().isOk()) {
-            return false;
-        }
+    if (mDvrRecord != nullptr) {
+        mDvrRecord->writeRecordOutput(false /* isFlush */);
     }
-
     return true;
 }
 
+size_t Demux::getRecordSpace() {
+    return mDvrRecord != nullptr ? mDvrRecord->getRecordSpace() : SIZE_MAX;
+}
+
+bool Demux::hasPendingRecordData() {
+    return mDvrRecord != nullptr && mDvrRecord->hasPendingRecordData();
+}
+
 ::ndk::ScopedAStatus Demux::startFilterHandler(int64_t filterId) {
     return mFilters[filterId]->startFilterHandler();
 }
@@ -505,15 +631,24 @@ void Demux::frontendInputThreadLoop() {
 
     while (mFrontendInputThreadRunning) {
         uint32_t efState = 0;
+        bool isRecordPending = mIsRecording && hasPendingRecordData();
         ::android::status_t status = mDvrPlayback->getDvrEventFlag()->wait(
-                static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY), &efState, WAIT_TIMEOUT,
+                static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY), &efState,
+                isRecordPending ? RECORD_WAIT_TIMEOUT : WAIT_TIMEOUT,
                 true /* retry on spurious wake */);
+        bool isEs = mDvrPlayback->getSettings().get<DvrSettings::Tag::playback>().dataFormat ==
+                    DataFormat::ES;
         if (status != ::android::OK) {
-            ALOGD("[Demux] wait for data ready on the playback FMQ");
-            continue;
+            if (!isRecordPending) {
+                ALOGD("[Demux] wait for data ready on the playback FMQ");
+                continue;
+            }
+            if (isEs) {
+                startRecordFilterDispatcher();
+                continue;
+            }
         }
-        if (mDvrPlayback->getSettings().get<DvrSettings::Tag::playback>().dataFormat ==
-            DataFormat::ES) {
+        if (isEs) {
             if (!mDvrPlayback->processEsDataOnPlayback(true /*isVirtualFrontend*/, mIsRecording)) {
                 ALOGE("[Demux] playback es data failed to be filtered. Ending thread");
                 break;
@@ -561,6 +696,7 @@ binder_status_t Demux::dump(int fd, const char** args, uint32_t numArgs) {
             it->second->dump(fd, args, numArgs);
         }
     }
+    mFilterCallbackDispatcher->dump(fd);
     {
         dprintf(fd, "  TimeFilter:\n");
         if (mTimeFilter != nullptr) {
@@ -579,9 +715,16 @@ binder_status_t Demux::dump(int fd, const char** args, uint32_t numArgs) {
             mDvrRecord->dump(fd, args, numArgs);
         }
     }
+    if (mIptvIngest != nullptr) {
+        mIptvIngest->dump(fd);
+    }
     return STATUS_OK;
 }
 
+std::shared_ptr<FilterCallbackDispatcher> Demux::getFilterCallbackDispatcher() {
+    return mFilterCallbackDispatcher;
+}
+
 bool Demux::attachRecordFilter(int64_t filterId) {
     if (mFilters[filterId] == nullptr || mDvrRecord == nullptr ||
         !mFilters[filterId]->isRecordFilter()) {
@@ -590,6 +733,7 @@ bool Demux::attachRecordFilter(int64_t filterId) {
 
     mRecordFilterIds.insert(filterId);
     mFilters[filterId]->attachFilterToRecord(mDvrRecord);
+    updatePidFilterTable();
 
     return true;
 }
@@ -601,6 +745,7 @@ bool Demux::detachRecordFilter(int64_t filterId) {
 
     mRecordFilterIds.erase(filterId);
     mFilters[filterId]->detachFilterFromRecord();
+    updatePidFilterTable();
 
     return true;
 }
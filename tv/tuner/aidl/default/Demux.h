@@ -21,13 +21,16 @@
 
 #include <fmq/AidlMessageQueue.h>
 #include <math.h>
+#include <array>
 #include <atomic>
 #include <set>
+#include <span>
 #include <thread>
 
 #include "Dvr.h"
 #include "Filter.h"
 #include "Frontend.h"
+#include "IptvIngest.h"
 #include "TimeFilter.h"
 #include "Timer.h"
 #include "Tuner.h"
@@ -52,10 +55,46 @@ using AidlMQDesc = MQDescriptor<int8_t, SynchronizedReadWrite>;
 
 class Dvr;
 class Filter;
+class FilterCallbackDispatcher;
 class Frontend;
 class TimeFilter;
 class Tuner;
 
+/**
+ * Maps each of the 8192 TS PIDs to the started playback filters on that PID, so a packet is
+ * dispatched with a single lookup instead of comparing the PID of every filter.
+ *
+ * A table is immutable once published by the Demux. The dispatcher holds on to a snapshot for a
+ * whole batch of packets, and the filters in it stay alive until the snapshot is released even
+ * if they are stopped or closed in the meantime.
+ */
+class PidFilterTable {
+  public:
+    static constexpr int kPidCount = 8192;
+
+    PidFilterTable() { mSlots.fill(-1); }
+
+    void add(uint16_t pid, std::shared_ptr<Filter> filter);
+
+    // Returns the filters on the pid, or nullptr if there is none
+    const vector<std::shared_ptr<Filter>>* find(uint16_t pid) const {
+        int slot = findSlot(pid);
+        return slot < 0 ? nullptr : &mFilterLists[slot];
+    }
+
+    // Returns the index of the filter list of the pid in [0, size()), or -1 if there is none
+    int findSlot(uint16_t pid) const { return mSlots[pid & (kPidCount - 1)]; }
+    const vector<std::shared_ptr<Filter>>& getFilters(int slot) const { return mFilterLists[slot]; }
+    size_t size() const { return mFilterLists.size(); }
+
+    bool empty() const { return mFilterLists.empty(); }
+
+  private:
+    // Index into mFilterLists for each PID, -1 if there is no filter on it
+    std::array<int16_t, kPidCount> mSlots;
+    vector<vector<std::shared_ptr<Filter>>> mFilterLists;
+};
+
 class DvrPlaybackCallback : public BnDvrCallback {
   public:
     virtual ::ndk::ScopedAStatus onPlaybackStatus(PlaybackStatus status) override {
@@ -105,6 +144,8 @@ class Demux : public BnDemux {
     void startFrontendInputLoop();
     void readIptvThreadLoop(dtv_plugin* interface, dtv_streamer* streamer, size_t size,
                             int timeout_ms, int buffer_timeout);
+    // Reads the IPTV stream with mIptvIngest instead of the plugin
+    void readIptvIngestThreadLoop(int timeout_ms, int buffer_timeout);
 
     /**
      * A dispatcher to read and dispatch input data to all the started filters.
@@ -112,11 +153,30 @@ class Demux : public BnDemux {
      * Note that recording filters are not included.
      */
     bool startBroadcastFilterDispatcher();
-    void startBroadcastTsFilter(vector<int8_t> data);
+    void startBroadcastTsFilter(std::span<const int8_t> packet);
+    void startBroadcastTsFilter(const PidFilterTable& table, std::span<const int8_t> packet);
 
-    void sendFrontendInputToRecord(vector<int8_t> data);
-    void sendFrontendInputToRecord(vector<int8_t> data, uint16_t pid, uint64_t pts);
+    /**
+     * Returns the current PID dispatch table. Callers dispatching several packets should get the
+     * table once and use it for all of them.
+     */
+    std::shared_ptr<const PidFilterTable> getPidFilterTable();
+    /**
+     * Rebuilds the PID dispatch table from the started playback filters, and the streams of the
+     * record DVR from the started record filters. Must be called whenever a filter is started,
+     * stopped, configured, removed, attached to or detached from the record DVR.
+     */
+    void updatePidFilterTable();
+
+    // The dispatcher of the filter events of all the filters of the demux
+    std::shared_ptr<FilterCallbackDispatcher> getFilterCallbackDispatcher();
+
+    void sendFrontendInputToRecord(std::span<const int8_t> packet);
+    void sendFrontendInputToRecord(std::span<const int8_t> frame, uint16_t pid, int64_t pts);
     bool startRecordFilterDispatcher();
+    // Bytes the record DVR can take before the input has to wait, SIZE_MAX without one
+    size_t getRecordSpace();
+    bool hasPendingRecordData();
 
     void getDemuxInfo(DemuxInfo* demuxInfo);
     int32_t getDemuxId();
@@ -179,6 +239,16 @@ class Demux : public BnDemux {
      */
     std::map<int64_t, std::shared_ptr<Filter>> mFilters;
 
+    /**
+     * PID dispatch table of the started playback filters, see updatePidFilterTable().
+     */
+    std::mutex mPidFilterTableLock;
+    std::shared_ptr<const PidFilterTable> mPidFilterTable = std::make_shared<PidFilterTable>();
+    // Held across a whole updatePidFilterTable()
+    std::mutex mPidFilterTableUpdateLock;
+
+    std::shared_ptr<FilterCallbackDispatcher> mFilterCallbackDispatcher;
+
     /**
      * Local reference to the opened Timer Filter instance.
      */
@@ -197,6 +267,11 @@ class Demux : public BnDemux {
     // track whether the DVR FMQ for IPTV Playback is full
     bool mIsIptvDvrFMQFull = false;
 
+    /**
+     * Receiver of the udp:// and rtp:// IPTV streams, which the plugin reads otherwise.
+     */
+    std::unique_ptr<IptvIngest> mIptvIngest;
+
     /**
      * If a specific filter's writing loop is still running
      */
@@ -207,6 +282,8 @@ class Demux : public BnDemux {
      * Controls IPTV reading thread status
      */
     bool mIsIptvReadThreadRunning;
+    // Set when the demux is destroyed, ends the IptvIngest reading thread
+    bool mIsIptvReadThreadExiting = false;
     std::mutex mIsIptvThreadRunningMutex;
     std::condition_variable mIsIptvThreadRunningCv;
 
@@ -20,6 +20,7 @@
 #include <aidl/android/hardware/tv/tuner/DemuxQueueNotifyBits.h>
 #include <aidl/android/hardware/tv/tuner/Result.h>
 
+#include <inttypes.h>
 #include <utils/Log.h>
 #include "Dvr.h"
 
@@ -30,6 +31,9 @@ namespace tv {
 namespace tuner {
 
 #define WAIT_TIMEOUT 3000000000
+// While recorded data is pending, the input is polled to write it out and to read what the
+// record engine had no space for
+#define RECORD_WAIT_TIMEOUT 10000000
 
 Dvr::Dvr(DvrType type, uint32_t bufferSize, const std::shared_ptr<IDvrCallback>& cb,
          std::shared_ptr<Demux> demux) {
@@ -134,6 +138,10 @@ Dvr::~Dvr() {
     // thread should always be joinable if it is running,
     // so it should be safe to assume recording stopped.
     mDemux->setIsRecording(false);
+    if (mType == DvrType::RECORD) {
+        // The last chunk is written without waiting for it to fill up
+        writeRecordOutput(true /* isFlush */);
+    }
 
     return ::ndk::ScopedAStatus::ok();
 }
@@ -142,6 +150,10 @@ Dvr::~Dvr() {
     ALOGV("%s", __FUNCTION__);
 
     mRecordStatus = RecordStatus::DATA_READY;
+    {
+        std::lock_guard<std::mutex> lock(mRecordLock);
+        mRecordEngine.clear();
+    }
 
     return ::ndk::ScopedAStatus::ok();
 }
@@ -189,6 +201,11 @@ binder_status_t Dvr::dump(int fd, const char** /* args */, uint32_t /* numArgs *
     dprintf(fd, "    Dvr:\n");
     dprintf(fd, "      mType: %hhd\n", mType);
     dprintf(fd, "      mDvrThreadRunning: %d\n", (bool)mDvrThreadRunning);
+    mPlaybackReader.dump(fd);
+    if (mType == DvrType::RECORD) {
+        std::lock_guard<std::mutex> lock(mRecordLock);
+        mRecordEngine.dump(fd);
+    }
     return STATUS_OK;
 }
 
@@ -197,12 +214,21 @@ void Dvr::playbackThreadLoop() {
 
     while (mDvrThreadRunning) {
         uint32_t efState = 0;
-        ::android::status_t status =
-                mDvrEventFlag->wait(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY),
-                                    &efState, WAIT_TIMEOUT, true /* retry on spurious wake */);
+        bool isRecordPending = mDemux->isRecording() && mDemux->hasPendingRecordData();
+        ::android::status_t status = mDvrEventFlag->wait(
+                static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY), &efState,
+                isRecordPending ? RECORD_WAIT_TIMEOUT : WAIT_TIMEOUT,
+                true /* retry on spurious wake */);
+        bool isEs = mDvrSettings.get<DvrSettings::Tag::playback>().dataFormat == DataFormat::ES;
         if (status != ::android::OK) {
-            ALOGD("[Dvr] wait for data ready on the playback FMQ");
-            continue;
+            if (!isRecordPending) {
+                ALOGD("[Dvr] wait for data ready on the playback FMQ");
+                continue;
+            }
+            if (isEs) {
+                mDemux->startRecordFilterDispatcher();
+                continue;
+            }
         }
 
         // If the both dvr playback and dvr record are created, the playback will be treated as
@@ -211,7 +237,7 @@ void Dvr::playbackThreadLoop() {
         bool isRecording = mDemux->isRecording();
         bool isVirtualFrontend = isRecording;
 
-        if (mDvrSettings.get<DvrSettings::Tag::playback>().dataFormat == DataFormat::ES) {
+        if (isEs) {
             if (!processEsDataOnPlayback(isVirtualFrontend, isRecording)) {
                 ALOGE("[Dvr] playback es data failed to be filtered. Ending thread");
                 break;
@@ -285,30 +311,145 @@ PlaybackStatus Dvr::checkPlaybackStatusChange(uint32_t availableToWrite, uint32_
 }
 
 bool Dvr::readPlaybackFMQ(bool isVirtualFrontend, bool isRecording) {
-    // Read playback data from the input FMQ
-    size_t size = mDvrMQ->availableToRead();
     int64_t playbackPacketSize = mDvrSettings.get<DvrSettings::Tag::playback>().packetSize;
-    vector<int8_t> dataOutputBuffer;
-    dataOutputBuffer.resize(playbackPacketSize);
-    // Dispatch the packet to the PID matching filter output buffer
-    for (int i = 0; i < size / playbackPacketSize; i++) {
-        if (!mDvrMQ->read(dataOutputBuffer.data(), playbackPacketSize)) {
-            return false;
-        }
-        if (isVirtualFrontend) {
-            if (isRecording) {
-                mDemux->sendFrontendInputToRecord(dataOutputBuffer);
-            } else {
-                mDemux->startBroadcastTsFilter(dataOutputBuffer);
+    if (!PlaybackReader::isSupportedPacketSize(playbackPacketSize)) {
+        ALOGE("[Dvr] unsupported playback packet size %" PRId64, playbackPacketSize);
+        return false;
+    }
+    if (isVirtualFrontend && isRecording) {
+        // The packets the record engine has no space for are left in the FMQ until it does
+        size_t packetCount = mDemux->getRecordSpace() / TS_SIZE;
+        size_t maxSize = packetCount > SIZE_MAX / playbackPacketSize
+                                 ? SIZE_MAX
+                                 : packetCount * playbackPacketSize;
+        return mPlaybackReader.read(*mDvrMQ, playbackPacketSize, maxSize,
+                                    [this](std::span<const int8_t> packet) {
+                                        mDemux->sendFrontendInputToRecord(packet);
+                                    });
+    }
+    // The same table is used for the whole read, filters started meanwhile get the next one
+    std::shared_ptr<const PidFilterTable> pidFilterTable = mDemux->getPidFilterTable();
+    return mPlaybackReader.read(*mDvrMQ, playbackPacketSize, *pidFilterTable);
+}
+
+template <typename OnPacket>
+bool PlaybackReader::readPackets(DvrMQ& dvrMQ, int64_t packetSize, size_t maxSize,
+                                 OnPacket&& onPacket, size_t* readSize) {
+    static constexpr int8_t kSyncByte = 0x47;
+
+    *readSize = 0;
+    size_t packetLength = static_cast<size_t>(packetSize);
+    size_t size = std::min(dvrMQ.availableToRead(), maxSize);
+    if (size < packetLength) {
+        return true;
+    }
+    DvrMQ::MemTransaction tx;
+    if (!dvrMQ.beginRead(size, &tx)) {
+        return false;
+    }
+    // The readable data is split in two regions when it wraps around the end of the FMQ
+    const int8_t* first = tx.getFirstRegion().getAddress();
+    size_t firstLength = tx.getFirstRegion().getLength();
+    const int8_t* second = tx.getSecondRegion().getAddress();
+    auto byteAt = [&](size_t offset) {
+        return offset < firstLength ? first[offset] : second[offset - firstLength];
+    };
+    auto isSynced = [&](size_t offset) {
+        return byteAt(offset) == kSyncByte &&
+               (offset + packetLength >= size || byteAt(offset + packetLength) == kSyncByte);
+    };
+
+    // The sync byte is after the timestamp in 192 bytes packets, first otherwise
+    size_t syncOffset = packetLength == 192 ? 4 : 0;
+    size_t offset = 0;
+    uint64_t packetCount = 0;
+    while (offset + packetLength <= size) {
+        size_t start = offset + syncOffset;
+        if (byteAt(start) != kSyncByte) {
+            size_t lostOffset = offset;
+            while (offset + packetLength <= size && !isSynced(offset + syncOffset)) {
+                offset++;
             }
+            mResyncCount++;
+            mDroppedBytes += offset - lostOffset;
+            continue;
+        }
+
+        if (start + TS_SIZE <= firstLength) {
+            onPacket(std::span<const int8_t>(first + start, TS_SIZE));
+        } else if (start >= firstLength) {
+            onPacket(std::span<const int8_t>(second + start - firstLength, TS_SIZE));
         } else {
-            startTpidFilter(dataOutputBuffer);
+            size_t head = firstLength - start;
+            memcpy(mWrappedPacket.data(), first + start, head);
+            memcpy(mWrappedPacket.data() + head, second, TS_SIZE - head);
+            onPacket(std::span<const int8_t>(mWrappedPacket));
         }
+        packetCount++;
+        offset += packetLength;
     }
 
+    mPacketCount += packetCount;
+    *readSize = offset;
     return true;
 }
 
+bool PlaybackReader::read(DvrMQ& dvrMQ, int64_t packetSize, const PidFilterTable& table) {
+    if (mRuns.size() < table.size()) {
+        mRuns.resize(table.size());
+    }
+    size_t readSize;
+    if (!readPackets(
+                dvrMQ, packetSize, SIZE_MAX,
+                [&](std::span<const int8_t> packet) { queuePacket(table, packet); }, &readSize)) {
+        return false;
+    }
+    // The queued packets point into the FMQ until the read is committed
+    dispatchPackets(table);
+    return readSize == 0 || dvrMQ.commitRead(readSize);
+}
+
+bool PlaybackReader::read(DvrMQ& dvrMQ, int64_t packetSize, size_t maxSize,
+                          const std::function<void(std::span<const int8_t>)>& onPacket) {
+    size_t readSize;
+    if (!readPackets(dvrMQ, packetSize, maxSize, onPacket, &readSize)) {
+        return false;
+    }
+    return readSize == 0 || dvrMQ.commitRead(readSize);
+}
+
+void PlaybackReader::queuePacket(const PidFilterTable& table, std::span<const int8_t> packet) {
+    uint16_t pid = ((packet[1] & 0x1f) << 8) | (packet[2] & 0xff);
+    int slot = table.findSlot(pid);
+    if (slot < 0) {
+        return;
+    }
+    vector<std::span<const int8_t>>& runs = mRuns[slot];
+    if (runs.empty()) {
+        mQueuedSlots.push_back(slot);
+    } else if (runs.back().data() + runs.back().size() == packet.data()) {
+        runs.back() = std::span<const int8_t>(runs.back().data(), runs.back().size() + TS_SIZE);
+        return;
+    }
+    runs.push_back(packet);
+}
+
+void PlaybackReader::dispatchPackets(const PidFilterTable& table) {
+    for (int slot : mQueuedSlots) {
+        for (const auto& filter : table.getFilters(slot)) {
+            filter->updateFilterOutput(mRuns[slot]);
+        }
+        mRuns[slot].clear();
+    }
+    mQueuedSlots.clear();
+}
+
+void PlaybackReader::dump(int fd) {
+    dprintf(fd, "      mPlaybackReader: packets %" PRIu64 ", resyncs %" PRIu64
+                ", dropped bytes %" PRIu64 "\n",
+            mPacketCount.load(), mResyncCount.load(), mDroppedBytes.load());
+}
+
 bool Dvr::processEsDataOnPlayback(bool isVirtualFrontend, bool isRecording) {
     // Read ES from the DVR FMQ
     // Note that currently we only provides ES with metaData in a specific format to be parsed.
@@ -413,7 +554,7 @@ bool Dvr::processEsDataOnPlayback(bool isVirtualFrontend, bool isRecording) {
                 }
             }
         } else {
-            mDemux->sendFrontendInputToRecord(frameData, pid, static_cast<uint64_t>(esMeta[i].pts));
+            mDemux->sendFrontendInputToRecord(frameData, pid, esMeta[i].pts);
         }
         startFilterDispatcher(isVirtualFrontend, isRecording);
         frameData.clear();
@@ -429,19 +570,6 @@ void Dvr::getMetaDataValue(int& index, int8_t* dataOutputBuffer, int& value) {
     }
 }
 
-void Dvr::startTpidFilter(vector<int8_t> data) {
-    map<int64_t, std::shared_ptr<Filter>>::iterator it;
-    for (it = mFilters.begin(); it != mFilters.end(); it++) {
-        uint16_t pid = ((data[1] & 0x1f) << 8) | ((data[2] & 0xff));
-        if (DEBUG_DVR) {
-            ALOGW("[Dvr] start ts filter pid: %d", pid);
-        }
-        if (pid == mDemux->getFilterTpid(it->first)) {
-            mDemux->updateFilterOutput(it->first, data);
-        }
-    }
-}
-
 bool Dvr::startFilterDispatcher(bool isVirtualFrontend, bool isRecording) {
     if (isVirtualFrontend) {
         if (isRecording) {
@@ -480,20 +608,108 @@ int Dvr::writePlaybackFMQ(void* buf, size_t size) {
     return DVR_WRITE_FAILURE_REASON_UNKNOWN;
 }
 
-bool Dvr::writeRecordFMQ(const vector<int8_t>& data) {
+int Dvr::writePlaybackFMQ(std::span<const std::span<const int8_t>> payloads,
+                          size_t* writtenCount) {
     lock_guard<mutex> lock(mWriteLock);
-    if (mRecordStatus == RecordStatus::OVERFLOW) {
+    *writtenCount = 0;
+    if (mPlaybackStatus == PlaybackStatus::SPACE_FULL) {
         ALOGW("[Dvr] stops writing and wait for the client side flushing.");
-        return true;
+        return DVR_WRITE_FAILURE_REASON_FMQ_FULL;
     }
-    if (mDvrMQ->write(data.data(), data.size())) {
-        mDvrEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY));
-        maySendRecordStatusCallback();
-        return true;
+    size_t available = mDvrMQ->availableToWrite();
+    size_t count = 0;
+    size_t size = 0;
+    while (count < payloads.size() && size + payloads[count].size() <= available) {
+        size += payloads[count++].size();
+    }
+    if (count == 0) {
+        maySendIptvPlaybackStatusCallback();
+        return DVR_WRITE_FAILURE_REASON_FMQ_FULL;
+    }
+
+    DvrMQ::MemTransaction tx;
+    if (!mDvrMQ->beginWrite(size, &tx)) {
+        maySendIptvPlaybackStatusCallback();
+        return DVR_WRITE_FAILURE_REASON_UNKNOWN;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!tx.copyTo(payloads[i].data(), offset, payloads[i].size())) {
+            maySendIptvPlaybackStatusCallback();
+            return DVR_WRITE_FAILURE_REASON_UNKNOWN;
+        }
+        offset += payloads[i].size();
     }
+    if (!mDvrMQ->commitWrite(size)) {
+        maySendIptvPlaybackStatusCallback();
+        return DVR_WRITE_FAILURE_REASON_UNKNOWN;
+    }
+    *writtenCount = count;
+    mDvrEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY));
+    maySendIptvPlaybackStatusCallback();
+    return count == payloads.size() ? DVR_WRITE_SUCCESS : DVR_WRITE_FAILURE_REASON_FMQ_FULL;
+}
 
-    maySendRecordStatusCallback();
-    return false;
+std::map<int64_t, std::shared_ptr<Filter>> Dvr::updateRecordFilters(
+        const std::map<int64_t, std::shared_ptr<Filter>>& filters) {
+    std::vector<std::pair<int64_t, RecordEngine::StreamSettings>> streams;
+    for (const auto& [filterId, filter] : filters) {
+        streams.emplace_back(filterId, filter->getRecordStreamSettings());
+    }
+    std::map<int64_t, std::shared_ptr<Filter>> oldFilters;
+    {
+        std::lock_guard<std::mutex> lock(mRecordLock);
+        mRecordEngine.setStreams(streams);
+        oldFilters.swap(mRecordFilters);
+        mRecordFilters = filters;
+    }
+    return oldFilters;
+}
+
+void Dvr::recordPacket(std::span<const int8_t> packet) {
+    std::lock_guard<std::mutex> lock(mRecordLock);
+    mRecordEngine.recordPacket(packet);
+}
+
+void Dvr::recordFrame(uint16_t pid, int64_t pts, std::span<const int8_t> frame) {
+    std::lock_guard<std::mutex> lock(mRecordLock);
+    mRecordEngine.recordFrame(pid, pts, frame);
+}
+
+size_t Dvr::getRecordSpace() {
+    std::lock_guard<std::mutex> lock(mRecordLock);
+    return mRecordEngine.getAvailableSpace();
+}
+
+bool Dvr::hasPendingRecordData() {
+    std::lock_guard<std::mutex> lock(mRecordLock);
+    return mRecordEngine.hasPendingData();
+}
+
+void Dvr::writeRecordOutput(bool isFlush) {
+    std::lock_guard<std::mutex> recordLock(mRecordLock);
+    if (!mRecordEngine.hasPendingData() || mDvrMQ == nullptr) {
+        return;
+    }
+    RecordEngine::Writer writer = [this](std::span<const int8_t> data) -> size_t {
+        lock_guard<mutex> lock(mWriteLock);
+        // Whatever the FMQ has no space for stays in the engine, which holds back the input
+        size_t size = std::min(data.size(), mDvrMQ->availableToWrite());
+        if (size == 0 || !mDvrMQ->write(data.data(), size)) {
+            maySendRecordStatusCallback();
+            return 0;
+        }
+        mDvrEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY));
+        maySendRecordStatusCallback();
+        return size;
+    };
+    RecordEngine::IndexSink sink = [this](const RecordEngine::IndexEntry& entry) {
+        auto it = mRecordFilters.find(entry.streamId);
+        if (it != mRecordFilters.end()) {
+            it->second->onRecordIndex(entry);
+        }
+    };
+    mRecordEngine.write(writer, sink, isFlush);
 }
 
 void Dvr::maySendRecordStatusCallback() {
@@ -21,11 +21,15 @@
 
 #include <fmq/AidlMessageQueue.h>
 #include <math.h>
+#include <array>
 #include <atomic>
+#include <functional>
 #include <set>
+#include <span>
 #include <thread>
 #include "Demux.h"
 #include "Frontend.h"
+#include "RecordEngine.h"
 #include "Tuner.h"
 
 using namespace std;
@@ -66,8 +70,52 @@ struct MediaEsMetaData {
 class Demux;
 class Filter;
 class Frontend;
+class PidFilterTable;
 class Tuner;
 
+/**
+ * Reads the TS packets of the playback FMQ in place and dispatches them to the filters in batches.
+ *
+ * The packet size comes from the playback settings: 188 bytes, 192 bytes with a 4 bytes
+ * timestamp prefix, or 188 bytes followed by parity bytes such as the 204 bytes RS coded format.
+ * Only the 188 bytes TS packet is passed on. When the sync byte is lost, the reader skips to the
+ * next position where two consecutive packets start with it.
+ */
+class PlaybackReader {
+  public:
+    static bool isSupportedPacketSize(int64_t packetSize) { return packetSize >= TS_SIZE; }
+
+    /**
+     * Dispatches all the complete packets of the FMQ to the filters of the table. Each filter gets
+     * the packets of its PID with a single append. A trailing partial packet is left in the FMQ.
+     *
+     * Return false if the FMQ can't be read.
+     */
+    bool read(DvrMQ& dvrMQ, int64_t packetSize, const PidFilterTable& table);
+    // Same as above, but passes the packets one by one to onPacket, reading at most maxSize bytes
+    bool read(DvrMQ& dvrMQ, int64_t packetSize, size_t maxSize,
+              const std::function<void(std::span<const int8_t>)>& onPacket);
+
+    void dump(int fd);
+
+  private:
+    template <typename OnPacket>
+    bool readPackets(DvrMQ& dvrMQ, int64_t packetSize, size_t maxSize, OnPacket&& onPacket,
+                     size_t* readSize);
+    void queuePacket(const PidFilterTable& table, std::span<const int8_t> packet);
+    void dispatchPackets(const PidFilterTable& table);
+
+    // Runs of contiguous packets queued for each slot of the PidFilterTable
+    vector<vector<std::span<const int8_t>>> mRuns;
+    vector<int> mQueuedSlots;
+    // The packet wrapping around the end of the FMQ, which is the only one that is copied
+    std::array<int8_t, TS_SIZE> mWrappedPacket;
+
+    std::atomic<uint64_t> mPacketCount = 0;
+    std::atomic<uint64_t> mResyncCount = 0;
+    std::atomic<uint64_t> mDroppedBytes = 0;
+};
+
 class Dvr : public BnDvr {
   public:
     Dvr(DvrType type, uint32_t bufferSize, const std::shared_ptr<IDvrCallback>& cb,
@@ -94,7 +142,31 @@ class Dvr : public BnDvr {
      */
     bool createDvrMQ();
     int writePlaybackFMQ(void* buf, size_t size);
-    bool writeRecordFMQ(const std::vector<int8_t>& data);
+    /**
+     * Writes the largest prefix of payloads that fits in the FMQ, copying each one into the FMQ
+     * regions in a single transaction.
+     *
+     * writtenCount is set to the number of payloads written.
+     */
+    int writePlaybackFMQ(std::span<const std::span<const int8_t>> payloads, size_t* writtenCount);
+    /**
+     * Replaces the record filters, which select the PIDs the record engine records and get the
+     * events of its index. Returns the replaced filters, which may hold the last reference to a
+     * removed filter: the caller must release them without holding a lock that the filter takes
+     * when it is destroyed.
+     */
+    std::map<int64_t, std::shared_ptr<Filter>> updateRecordFilters(
+            const std::map<int64_t, std::shared_ptr<Filter>>& filters);
+    void recordPacket(std::span<const int8_t> packet);
+    void recordFrame(uint16_t pid, int64_t pts, std::span<const int8_t> frame);
+    // Bytes which can be recorded before the record FMQ has to be read
+    size_t getRecordSpace();
+    bool hasPendingRecordData();
+    /**
+     * Writes the chunks of recorded data which are ready into the record FMQ, and queues the
+     * record events of the index entries written with them.
+     */
+    void writeRecordOutput(bool isFlush);
     bool addPlaybackFilter(int64_t filterId, std::shared_ptr<Filter> filter);
     bool removePlaybackFilter(int64_t filterId);
     bool readPlaybackFMQ(bool isVirtualFrontend, bool isRecording);
@@ -111,6 +183,7 @@ class Dvr : public BnDvr {
     uint32_t mBufferSize;
     std::shared_ptr<IDvrCallback> mCallback;
     std::map<int64_t, std::shared_ptr<Filter>> mFilters;
+    std::map<int64_t, std::shared_ptr<Filter>> mRecordFilters;
 
     void deleteEventFlag();
     bool readDataFromMQ();
@@ -122,15 +195,12 @@ class Dvr : public BnDvr {
                                              int64_t highThreshold, int64_t lowThreshold);
     RecordStatus checkRecordStatusChange(uint32_t availableToWrite, uint32_t availableToRead,
                                          int64_t highThreshold, int64_t lowThreshold);
-    /**
-     * A dispatcher to read and dispatch input data to all the started filters.
-     * Each filter handler handles the data filtering/output writing/filterEvent updating.
-     */
-    void startTpidFilter(vector<int8_t> data);
     void playbackThreadLoop();
 
     unique_ptr<DvrMQ> mDvrMQ;
     EventFlag* mDvrEventFlag;
+    PlaybackReader mPlaybackReader;
+    RecordEngine mRecordEngine;
     /**
      * Demux callbacks used on filter events or IO buffer status
      */
@@ -157,6 +227,10 @@ class Dvr : public BnDvr {
      */
     std::mutex mPlaybackStatusLock;
     std::mutex mRecordStatusLock;
+    /**
+     * Lock to protect the record engine and filters, taken before mWriteLock
+     */
+    std::mutex mRecordLock;
 
     const bool DEBUG_DVR = false;
 };
@@ -23,7 +23,9 @@
 #include <aidl/android/hardware/tv/tuner/Result.h>
 #include <aidlcommonsupport/NativeHandle.h>
 #include <inttypes.h>
+#include <sys/mman.h>
 #include <utils/Log.h>
+#include <bit>
 
 #include "Filter.h"
 
@@ -35,30 +37,233 @@ namespace tuner {
 
 #define WAIT_TIMEOUT 3000000000
 
-FilterCallbackScheduler::FilterCallbackScheduler(const std::shared_ptr<IFilterCallback>& cb)
+FilterCallbackDispatcher::FilterCallbackDispatcher()
+    : mStartTime(Clock::now()), mRateWindowStart(mStartTime) {}
+
+FilterCallbackDispatcher::~FilterCallbackDispatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mIsRunning = false;
+    }
+    mCv.notify_all();
+    if (mThread.joinable()) {
+        // The thread releases the last reference after a callback, then returns right away
+        if (mThread.get_id() == std::this_thread::get_id()) {
+            mThread.detach();
+        } else {
+            mThread.join();
+        }
+    }
+}
+
+void FilterCallbackDispatcher::registerScheduler(FilterCallbackScheduler* scheduler) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mRegistrations[scheduler] = {kNoTick, false};
+    // The thread is started with the first filter, most demuxes never open one
+    if (!mThread.joinable()) {
+        mIsRunning = true;
+        mThread = std::thread(&FilterCallbackDispatcher::threadLoop, this);
+    }
+}
+
+void FilterCallbackDispatcher::unregisterScheduler(FilterCallbackScheduler* scheduler) {
+    std::unique_lock<std::mutex> lock(mLock);
+    mRegistrations.erase(scheduler);
+    // The timer entries of the scheduler are dropped when their tick comes
+    std::erase(mReadySchedulers, scheduler);
+    if (mThread.get_id() != std::this_thread::get_id()) {
+        mCv.wait(lock, [&] { return mDeliveringScheduler != scheduler; });
+    }
+}
+
+void FilterCallbackDispatcher::schedule(FilterCallbackScheduler* scheduler,
+                                        Clock::time_point deadline) {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mRegistrations.find(scheduler);
+    if (it == mRegistrations.end() || it->second.isReady) {
+        return;
+    }
+    Registration& registration = it->second;
+    uint64_t deadlineTick = getTick(deadline);
+    if (registration.deadlineTick <= deadlineTick) {
+        return;
+    }
+
+    registration.deadlineTick = deadlineTick;
+    if (deadlineTick <= getTick(Clock::now())) {
+        registration.isReady = true;
+        mReadySchedulers.push_back(scheduler);
+    } else {
+        mWheel[deadlineTick % kWheelSize].push_back({scheduler, deadlineTick});
+        mTimerCount++;
+    }
+    mCv.notify_all();
+}
+
+void FilterCallbackDispatcher::dump(int fd) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Clock::time_point now = Clock::now();
+    uint64_t callbacksPerSecond = mCallbacksPerSecond;
+    int64_t windowMs =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - mRateWindowStart).count();
+    if (windowMs >= 1000) {
+        // No callback since the end of the last window
+        callbacksPerSecond = mRateWindowCallbacks * 1000 / windowMs;
+    }
+    dprintf(fd,
+            "  Filter callbacks: %zu filters, %" PRIu64 " callbacks, %" PRIu64 " events, %" PRIu64
+            " callbacks/s, %zu timers\n",
+            mRegistrations.size(), mCallbackCount, mEventCount, callbacksPerSecond, mTimerCount);
+    dprintf(fd, "  Filter callback batch sizes:");
+    for (size_t i = 0; i < kBatchSizeBuckets; i++) {
+        if (i == 0) {
+            dprintf(fd, " 1: %" PRIu64, mBatchSizeHistogram[i]);
+        } else if (i == kBatchSizeBuckets - 1) {
+            dprintf(fd, ", %d+: %" PRIu64, 1 << i, mBatchSizeHistogram[i]);
+        } else {
+            dprintf(fd, ", %d-%d: %" PRIu64, 1 << i, (2 << i) - 1, mBatchSizeHistogram[i]);
+        }
+    }
+    dprintf(fd, "\n");
+}
+
+void FilterCallbackDispatcher::threadLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (mIsRunning) {
+        advanceWheelLocked(getTick(Clock::now()));
+        if (mReadySchedulers.empty()) {
+            uint64_t nextTick = getNextDeadlineTickLocked();
+            if (nextTick == kNoTick) {
+                mCv.wait(lock);
+            } else {
+                mCv.wait_until(lock, mStartTime + std::chrono::milliseconds(nextTick));
+            }
+            continue;
+        }
+
+        // The callback may release the last filter, and with it the last other reference to the
+        // dispatcher, so the dispatcher is kept alive until the callback is accounted for
+        std::shared_ptr<FilterCallbackDispatcher> self = weak_from_this().lock();
+        if (self == nullptr) {
+            // Being destroyed on another thread, which joins this one
+            break;
+        }
+        FilterCallbackScheduler* scheduler = mReadySchedulers.front();
+        mReadySchedulers.pop_front();
+        mRegistrations[scheduler] = {kNoTick, false};
+        mDeliveringScheduler = scheduler;
+        lock.unlock();
+        size_t eventCount = scheduler->deliverEvents();
+        lock.lock();
+        mDeliveringScheduler = nullptr;
+        if (eventCount > 0) {
+            recordCallbackLocked(eventCount, Clock::now());
+        }
+        // Wake up the unregisterScheduler() waiting for the callback
+        mCv.notify_all();
+
+        lock.unlock();
+        std::weak_ptr<FilterCallbackDispatcher> weakSelf = self;
+        self.reset();
+        if (weakSelf.expired()) {
+            // Destroyed, on this thread or on another one joining it: no member is usable
+            return;
+        }
+        lock.lock();
+    }
+}
+
+// Rounded up, so that a callback is never sent before its deadline
+uint64_t FilterCallbackDispatcher::getTick(Clock::time_point time) const {
+    if (time <= mStartTime) {
+        return 0;
+    }
+    return static_cast<uint64_t>(
+            std::chrono::ceil<std::chrono::milliseconds>(time - mStartTime).count());
+}
+
+void FilterCallbackDispatcher::advanceWheelLocked(uint64_t nowTick) {
+    if (nowTick <= mWheelTick) {
+        return;
+    }
+    // Each slot holds the deadlines of all the revolutions, so one turn visits them all
+    uint64_t slotCount = std::min<uint64_t>(nowTick - mWheelTick, kWheelSize);
+    for (uint64_t tick = nowTick - slotCount + 1; tick <= nowTick && mTimerCount > 0; tick++) {
+        vector<TimerEntry>& slot = mWheel[tick % kWheelSize];
+        for (size_t i = 0; i < slot.size();) {
+            TimerEntry entry = slot[i];
+            if (entry.deadlineTick > nowTick) {
+                i++;
+                continue;
+            }
+            slot[i] = slot.back();
+            slot.pop_back();
+            mTimerCount--;
+
+            // Entries replaced by an earlier deadline, or of a removed filter, are stale
+            auto it = mRegistrations.find(entry.scheduler);
+            if (it != mRegistrations.end() && !it->second.isReady &&
+                it->second.deadlineTick == entry.deadlineTick) {
+                it->second.isReady = true;
+                mReadySchedulers.push_back(entry.scheduler);
+            }
+        }
+    }
+    mWheelTick = nowTick;
+}
+
+uint64_t FilterCallbackDispatcher::getNextDeadlineTickLocked() const {
+    uint64_t nextTick = kNoTick;
+    if (mTimerCount == 0) {
+        return nextTick;
+    }
+    for (const vector<TimerEntry>& slot : mWheel) {
+        for (const TimerEntry& entry : slot) {
+            nextTick = std::min(nextTick, entry.deadlineTick);
+        }
+    }
+    return nextTick;
+}
+
+void FilterCallbackDispatcher::recordCallbackLocked(size_t eventCount, Clock::time_point now) {
+    mCallbackCount++;
+    mEventCount += eventCount;
+    size_t bucket = std::bit_width(eventCount) - 1;
+    mBatchSizeHistogram[std::min(bucket, kBatchSizeBuckets - 1)]++;
+
+    int64_t windowMs =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - mRateWindowStart).count();
+    if (windowMs >= 1000) {
+        mCallbacksPerSecond = mRateWindowCallbacks * 1000 / windowMs;
+        mRateWindowStart = now;
+        mRateWindowCallbacks = 0;
+    }
+    mRateWindowCallbacks++;
+}
+
+FilterCallbackScheduler::FilterCallbackScheduler(
+        const std::shared_ptr<IFilterCallback>& cb,
+        std::shared_ptr<FilterCallbackDispatcher> dispatcher)
     : mCallback(cb),
-      mIsConditionMet(false),
+      mDispatcher(std::move(dispatcher)),
       mDataLength(0),
       mTimeDelayInMs(0),
       mDataSizeDelayInBytes(0) {
-    start();
+    mDispatcher->registerScheduler(this);
 }
 
 FilterCallbackScheduler::~FilterCallbackScheduler() {
-    stop();
+    mDispatcher->unregisterScheduler(this);
 }
 
 void FilterCallbackScheduler::onFilterEvent(DemuxFilterEvent&& event) {
-    std::unique_lock<std::mutex> lock(mLock);
-    mCallbackBuffer.push_back(std::move(event));
-    mDataLength += getDemuxFilterEventDataLength(event);
-
-    if (isDataSizeDelayConditionMetLocked()) {
-        mIsConditionMet = true;
-        // unlock, so thread is not immediately blocked when it is notified.
-        lock.unlock();
-        mCv.notify_all();
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mCallbackBuffer.empty()) {
+        mFirstEventTime = Clock::now();
     }
+    mDataLength += getDemuxFilterEventDataLength(event);
+    mCallbackBuffer.push_back(std::move(event));
+    scheduleLocked();
 }
 
 void FilterCallbackScheduler::onFilterStatus(const DemuxFilterStatus& status) {
@@ -68,79 +273,61 @@ void FilterCallbackScheduler::onFilterStatus(const DemuxFilterStatus& status) {
 }
 
 void FilterCallbackScheduler::flushEvents() {
-    std::unique_lock<std::mutex> lock(mLock);
+    std::lock_guard<std::mutex> lock(mLock);
     mCallbackBuffer.clear();
     mDataLength = 0;
 }
 
 void FilterCallbackScheduler::setTimeDelayHint(int timeDelay) {
-    std::unique_lock<std::mutex> lock(mLock);
+    std::lock_guard<std::mutex> lock(mLock);
     mTimeDelayInMs = timeDelay;
-    // always notify condition variable to update timeout
-    mIsConditionMet = true;
-    lock.unlock();
-    mCv.notify_all();
+    // The pending events are sent with the new deadline if it is earlier
+    scheduleLocked();
 }
 
 void FilterCallbackScheduler::setDataSizeDelayHint(int dataSizeDelay) {
-    std::unique_lock<std::mutex> lock(mLock);
+    std::lock_guard<std::mutex> lock(mLock);
     mDataSizeDelayInBytes = dataSizeDelay;
-    if (isDataSizeDelayConditionMetLocked()) {
-        mIsConditionMet = true;
-        lock.unlock();
-        mCv.notify_all();
-    }
+    scheduleLocked();
 }
 
 bool FilterCallbackScheduler::hasCallbackRegistered() const {
     return mCallback != nullptr;
 }
 
-void FilterCallbackScheduler::start() {
-    mIsRunning = true;
-    mCallbackThread = std::thread(&FilterCallbackScheduler::threadLoop, this);
-}
-
-void FilterCallbackScheduler::stop() {
-    mIsRunning = false;
-    if (mCallbackThread.joinable()) {
-        {
-            std::lock_guard<std::mutex> lock(mLock);
-            mIsConditionMet = true;
-        }
-        mCv.notify_all();
-        mCallbackThread.join();
+size_t FilterCallbackScheduler::deliverEvents() {
+    // mDeliveryBuffer is only used on the dispatcher thread, the lock is not held during the
+    // callback so that the filter can keep adding events.
+    std::unique_lock<std::mutex> lock(mLock);
+    mScheduledDeadline = Clock::time_point::max();
+    if (mCallbackBuffer.empty()) {
+        return 0;
     }
-}
+    mDeliveryBuffer.swap(mCallbackBuffer);
+    mDataLength = 0;
+    Clock::time_point now = Clock::now();
+    mLastCallbackTime = now;
+    updateAdaptiveDelayLocked(now);
+    lock.unlock();
 
-void FilterCallbackScheduler::threadLoop() {
-    while (mIsRunning) {
-        threadLoopOnce();
+    size_t eventCount = mDeliveryBuffer.size();
+    if (mCallback) {
+        mCallback->onFilterEvent(mDeliveryBuffer);
     }
-}
+    mDeliveryBuffer.clear();
 
-void FilterCallbackScheduler::threadLoopOnce() {
-    std::unique_lock<std::mutex> lock(mLock);
-    if (mTimeDelayInMs > 0) {
-        // Note: predicate protects from lost and spurious wakeups
-        mCv.wait_for(lock, std::chrono::milliseconds(mTimeDelayInMs),
-                     [this] { return mIsConditionMet; });
-    } else {
-        // Note: predicate protects from lost and spurious wakeups
-        mCv.wait(lock, [this] { return mIsConditionMet; });
+    // Events added during the callback
+    lock.lock();
+    if (!mCallbackBuffer.empty()) {
+        mFirstEventTime = now;
+        scheduleLocked();
     }
-    mIsConditionMet = false;
+    return eventCount;
+}
 
-    // condition_variable wait locks mutex on timeout / notify
-    // Note: if stop() has been called in the meantime, do not send more filter
-    // events.
-    if (mIsRunning && !mCallbackBuffer.empty()) {
-        if (mCallback) {
-            mCallback->onFilterEvent(mCallbackBuffer);
-        }
-        mCallbackBuffer.clear();
-        mDataLength = 0;
-    }
+int FilterCallbackScheduler::getAdaptiveDelayMs() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mAdaptiveDelayMs;
 }
 
 // mLock needs to be held to call this function
@@ -159,6 +346,41 @@ bool FilterCallbackScheduler::isDataSizeDelayConditionMetLocked() {
     return mDataLength >= mDataSizeDelayInBytes;
 }
 
+// mLock needs to be held to call this function
+void FilterCallbackScheduler::scheduleLocked() {
+    if (mCallbackBuffer.empty()) {
+        return;
+    }
+    Clock::time_point deadline;
+    if (isDataSizeDelayConditionMetLocked()) {
+        // Right away, unless the filter is over its callback rate
+        deadline = mLastCallbackTime + std::chrono::milliseconds(mAdaptiveDelayMs);
+    } else if (mTimeDelayInMs > 0) {
+        deadline = mFirstEventTime + std::chrono::milliseconds(mTimeDelayInMs);
+    } else {
+        return;
+    }
+    // Most events come while a callback is already scheduled, without going to the dispatcher
+    if (deadline < mScheduledDeadline) {
+        mScheduledDeadline = deadline;
+        mDispatcher->schedule(this, deadline);
+    }
+}
+
+// mLock needs to be held to call this function
+void FilterCallbackScheduler::updateAdaptiveDelayLocked(Clock::time_point now) {
+    if (now - mRateWindowStart >= std::chrono::seconds(1)) {
+        if (mRateWindowCallbacks > kMaxCallbacksPerSecond) {
+            mAdaptiveDelayMs = std::min(std::max(1, mAdaptiveDelayMs * 2), kMaxAdaptiveDelayMs);
+        } else if (mRateWindowCallbacks < kMaxCallbacksPerSecond / 2) {
+            mAdaptiveDelayMs /= 2;
+        }
+        mRateWindowStart = now;
+        mRateWindowCallbacks = 0;
+    }
+    mRateWindowCallbacks++;
+}
+
 int FilterCallbackScheduler::getDemuxFilterEventDataLength(const DemuxFilterEvent& event) {
     // there is a risk that dataLength could be a negative value, but it
     // *should* be safe to assume that it is always positive.
@@ -187,10 +409,95 @@ int FilterCallbackScheduler::getDemuxFilterEventDataLength(const DemuxFilterEven
     }
 }
 
+std::unique_ptr<AvMemoryRing> AvMemoryRing::create(int fd, size_t capacity) {
+    void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 /*offset*/);
+    if (data == MAP_FAILED) {
+        ALOGE("[Filter] fail to map av memory %d", errno);
+        ::close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<AvMemoryRing>(
+            new AvMemoryRing(fd, static_cast<uint8_t*>(data), capacity));
+}
+
+AvMemoryRing::AvMemoryRing(int fd, uint8_t* data, size_t capacity)
+    : mFd(fd), mData(data), mCapacity(capacity) {}
+
+AvMemoryRing::~AvMemoryRing() {
+    munmap(mData, mCapacity);
+    ::close(mFd);
+}
+
+bool AvMemoryRing::allocate(int64_t dataId, size_t length, size_t* offset) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mSlices.empty()) {
+        mHead = 0;
+    }
+    size_t tail = mSlices.empty() ? 0 : mSlices.front().offset;
+    bool isWrapped = !mSlices.empty() && mSlices.back().offset < tail;
+
+    if (!isWrapped && mHead + length <= mCapacity) {
+        *offset = mHead;
+    } else if (!isWrapped && length <= tail) {
+        // Not enough room before the end, start again from the beginning
+        *offset = 0;
+    } else if (isWrapped && mHead + length <= tail) {
+        *offset = mHead;
+    } else {
+        mFullCount++;
+        return false;
+    }
+
+    mSlices.push_back({dataId, *offset, length, false});
+    mHead = *offset + length;
+    mBytesInUse += length;
+    mPeakBytesInUse = std::max(mPeakBytesInUse, mBytesInUse);
+    mAllocations++;
+    return true;
+}
+
+bool AvMemoryRing::release(int64_t dataId) {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = std::find_if(mSlices.begin(), mSlices.end(), [dataId](const Slice& slice) {
+        return slice.dataId == dataId && !slice.isReleased;
+    });
+    if (it == mSlices.end()) {
+        return false;
+    }
+    it->isReleased = true;
+    mBytesInUse -= it->length;
+    mReleases++;
+    while (!mSlices.empty() && mSlices.front().isReleased) {
+        mSlices.pop_front();
+    }
+    return true;
+}
+
+void AvMemoryRing::releaseAll() {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (const Slice& slice : mSlices) {
+        if (!slice.isReleased) {
+            mReleases++;
+        }
+    }
+    mSlices.clear();
+    mBytesInUse = 0;
+}
+
+void AvMemoryRing::dump(int fd) {
+    std::lock_guard<std::mutex> lock(mLock);
+    dprintf(fd, "      AV memory: %zu/%zu bytes in use, peak %zu, %zu slices\n", mBytesInUse,
+            mCapacity, mPeakBytesInUse, mSlices.size());
+    dprintf(fd,
+            "      AV memory: %" PRIu64 " allocations, %" PRIu64 " releases, %" PRIu64
+            " allocations failed on full memory\n",
+            mAllocations, mReleases, mFullCount);
+}
+
 Filter::Filter(DemuxFilterType type, int64_t filterId, uint32_t bufferSize,
                const std::shared_ptr<IFilterCallback>& cb, std::shared_ptr<Demux> demux)
     : mDemux(demux),
-      mCallbackScheduler(cb),
+      mCallbackScheduler(cb, demux->getFilterCallbackDispatcher()),
       mFilterId(filterId),
       mBufferSize(bufferSize),
       mType(type) {
@@ -210,6 +517,14 @@ Filter::Filter(DemuxFilterType type, int64_t filterId, uint32_t bufferSize,
                 DemuxTsFilterType::RECORD) {
                 mIsRecordFilter = true;
             }
+            if (mType.subType.get<DemuxFilterSubType::Tag::tsFilterType>() ==
+                DemuxTsFilterType::SECTION) {
+                mTsParser = std::make_unique<TsParser>(TsParser::Mode::SECTION);
+            } else if (mIsMediaFilter ||
+                       mType.subType.get<DemuxFilterSubType::Tag::tsFilterType>() ==
+                               DemuxTsFilterType::PES) {
+                mTsParser = std::make_unique<TsParser>(TsParser::Mode::PES);
+            }
             break;
         case DemuxFilterMainType::MMTP:
             if (mType.subType.get<DemuxFilterSubType::Tag::mmtpFilterType>() ==
@@ -303,9 +618,19 @@ Filter::~Filter() {
 
     mFilterSettings = in_settings;
     switch (mType.mainType) {
-        case DemuxFilterMainType::TS:
-            mTpid = in_settings.get<DemuxFilterSettings::Tag::ts>().tpid;
+        case DemuxFilterMainType::TS: {
+            const DemuxTsFilterSettings& tsSettings =
+                    in_settings.get<DemuxFilterSettings::Tag::ts>();
+            mTpid = tsSettings.tpid;
+            mIsTpidConfigured = true;
+            if (tsSettings.filterSettings.getTag() ==
+                DemuxTsFilterSettingsFilterSettings::Tag::section) {
+                configureSectionEngine(
+                        tsSettings.filterSettings
+                                .get<DemuxTsFilterSettingsFilterSettings::Tag::section>());
+            }
             break;
+        }
         case DemuxFilterMainType::MMTP:
             break;
         case DemuxFilterMainType::IP:
@@ -319,6 +644,9 @@ Filter::~Filter() {
     }
 
     mConfigured = true;
+    if (mIsStarted) {
+        mDemux->updatePidFilterTable();
+    }
     return ::ndk::ScopedAStatus::ok();
 }
 
@@ -360,6 +688,14 @@ Filter::~Filter() {
         mCallbackScheduler.onFilterEvent(std::move(event));
     }
 
+    {
+        // A restarted filter delivers its sections again
+        std::lock_guard<std::mutex> lock(mFilterOutputLock);
+        mSectionEngine.reset();
+    }
+    mIsStarted = true;
+    mDemux->updatePidFilterTable();
+
     return startFilterLoop();
 }
 
@@ -371,7 +707,19 @@ Filter::~Filter() {
         mDemux->setIptvThreadRunning(false);
     }
 
-    mFilterThreadRunning = false;
+    if (mIsStarted) {
+        mIsStarted = false;
+        mDemux->updatePidFilterTable();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mFilterEventsLock);
+        mFilterThreadRunning = false;
+    }
+    mFilterEventsCv.notify_all();
+    if (mFilterEventsFlag != nullptr) {
+        mFilterEventsFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_CONSUMED));
+    }
     if (mFilterThread.joinable()) {
         mFilterThread.join();
     }
@@ -389,6 +737,16 @@ Filter::~Filter() {
     int8_t* buffer = new int8_t[size];
     mFilterMQ->read(buffer, size);
     delete[] buffer;
+    {
+        // Also drop the input that has been dispatched but not handled yet
+        std::lock_guard<std::mutex> lock(mFilterOutputLock);
+        mFilterOutput.clear();
+        mPesOutput.clear();
+        mPesOutputPts = 0;
+        if (mTsParser != nullptr) {
+            mTsParser->reset();
+        }
+    }
     mFilterStatus = DemuxFilterStatus::DATA_READY;
 
     return ::ndk::ScopedAStatus::ok();
@@ -397,18 +755,25 @@ Filter::~Filter() {
 ::ndk::ScopedAStatus Filter::releaseAvHandle(const NativeHandle& in_avMemory, int64_t in_avDataId) {
     ALOGV("%s", __FUNCTION__);
 
+    AvMemoryRing* avMemoryRing = getAvMemoryRing();
+    if (avMemoryRing != nullptr && avMemoryRing->release(in_avDataId)) {
+        return ::ndk::ScopedAStatus::ok();
+    }
+
     if ((mSharedAvMemHandle != nullptr) && (in_avMemory.fds.size() > 0) &&
         (sameFile(in_avMemory.fds[0].get(), mSharedAvMemHandle->data[0]))) {
+        // The client is done with the shared memory, and so with all the events in it
         freeSharedAvHandle();
+        mUsingSharedAvMem = false;
+        avMemoryRing->releaseAll();
         return ::ndk::ScopedAStatus::ok();
     }
 
-    if (mDataId2Avfd.find(in_avDataId) == mDataId2Avfd.end()) {
+    // The test media events and the events sent before a releaseAll() have no slice to release
+    if (in_avDataId <= 0 || in_avDataId >= mLastUsedDataId) {
         return ::ndk::ScopedAStatus::fromServiceSpecificError(
                 static_cast<int32_t>(Result::INVALID_ARGUMENT));
     }
-
-    ::close(mDataId2Avfd[in_avDataId]);
     return ::ndk::ScopedAStatus::ok();
 }
 
@@ -447,20 +812,19 @@ Filter::~Filter() {
         return ::ndk::ScopedAStatus::ok();
     }
 
-    int av_fd = createAvIonFd(BUFFER_SIZE);
-    if (av_fd < 0) {
+    AvMemoryRing* avMemoryRing = getAvMemoryRing();
+    if (avMemoryRing == nullptr) {
         return ::ndk::ScopedAStatus::fromServiceSpecificError(
                 static_cast<int32_t>(Result::OUT_OF_MEMORY));
     }
 
-    mSharedAvMemHandle = createNativeHandle(av_fd);
+    // The media events then point into the shared memory with a handle without fd
+    mSharedAvMemHandle = createNativeHandle(avMemoryRing->getFd());
     if (mSharedAvMemHandle == nullptr) {
-        ::close(av_fd);
         *_aidl_return = 0;
         return ::ndk::ScopedAStatus::fromServiceSpecificError(
                 static_cast<int32_t>(Result::UNKNOWN_ERROR));
     }
-    ::close(av_fd);
     mUsingSharedAvMem = true;
 
     *out_avMemory = ::android::dupToAidl(mSharedAvMemHandle);
@@ -578,83 +942,58 @@ void Filter::filterThreadLoop() {
 
     // For the first time of filter output, implementation needs to send the filter
     // Event Callback without waiting for the DATA_CONSUMED to init the process.
-    while (mFilterThreadRunning) {
+    {
         std::unique_lock<std::mutex> lock(mFilterEventsLock);
-        if (mFilterEvents.size() == 0) {
-            lock.unlock();
-            if (DEBUG_FILTER) {
-                ALOGD("[Filter] wait for filter data output.");
-            }
-            usleep(1000 * 1000);
-            continue;
+        mFilterEventsCv.wait(lock,
+                             [this] { return !mFilterThreadRunning || !mFilterEvents.empty(); });
+        if (!mFilterThreadRunning) {
+            ALOGD("[Filter] filter thread ended.");
+            return;
         }
 
         // After successfully write, send a callback and wait for the read to be done
-        if (mCallbackScheduler.hasCallbackRegistered()) {
-            if (mConfigured) {
-                auto startEvent =
-                        DemuxFilterEvent::make<DemuxFilterEvent::Tag::startId>(mStartId++);
-                mCallbackScheduler.onFilterEvent(std::move(startEvent));
-                mConfigured = false;
-            }
-
-            // lock is still being held
-            for (auto&& event : mFilterEvents) {
-                mCallbackScheduler.onFilterEvent(std::move(event));
-            }
-        } else {
+        if (!mCallbackScheduler.hasCallbackRegistered()) {
             ALOGD("[Filter] filter callback is not configured yet.");
             mFilterThreadRunning = false;
             return;
         }
-
+        if (mConfigured) {
+            auto startEvent = DemuxFilterEvent::make<DemuxFilterEvent::Tag::startId>(mStartId++);
+            mCallbackScheduler.onFilterEvent(std::move(startEvent));
+            mConfigured = false;
+        }
+        for (auto&& event : mFilterEvents) {
+            mCallbackScheduler.onFilterEvent(std::move(event));
+        }
         mFilterEvents.clear();
         mFilterStatus = DemuxFilterStatus::DATA_READY;
         mCallbackScheduler.onFilterStatus(mFilterStatus);
-        break;
     }
 
+    // The events are then handed over as long as the filter runs, each time the client consumed
+    // the data of the previous ones
     while (mFilterThreadRunning) {
         uint32_t efState = 0;
-        // We do not wait for the last round of written data to be read to finish the thread
-        // because the VTS can verify the reading itself.
-        for (int i = 0; i < SECTION_WRITE_COUNT; i++) {
-            if (!mFilterThreadRunning) {
-                break;
-            }
-            while (mFilterThreadRunning && mIsUsingFMQ) {
-                ::android::status_t status = mFilterEventsFlag->wait(
-                        static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_CONSUMED), &efState,
-                        WAIT_TIMEOUT, true /* retry on spurious wake */);
-                if (status != ::android::OK) {
-                    ALOGD("[Filter] wait for data consumed");
-                    continue;
-                }
-                break;
+        while (mFilterThreadRunning && mIsUsingFMQ) {
+            ::android::status_t status = mFilterEventsFlag->wait(
+                    static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_CONSUMED), &efState,
+                    WAIT_TIMEOUT, true /* retry on spurious wake */);
+            if (status != ::android::OK) {
+                ALOGD("[Filter] wait for data consumed");
+                continue;
             }
+            break;
+        }
 
-            maySendFilterStatusCallback();
-
-            while (mFilterThreadRunning) {
-                std::lock_guard<std::mutex> lock(mFilterEventsLock);
-                if (mFilterEvents.size() == 0) {
-                    continue;
-                }
-                // After successfully write, send a callback and wait for the read to be done
-                for (auto&& event : mFilterEvents) {
-                    mCallbackScheduler.onFilterEvent(std::move(event));
-                }
-                mFilterEvents.clear();
-                break;
-            }
-            // We do not wait for the last read to be done
-            // VTS can verify the read result itself.
-            if (i == SECTION_WRITE_COUNT - 1) {
-                ALOGD("[Filter] filter %" PRIu64 " writing done. Ending thread", mFilterId);
-                break;
-            }
+        maySendFilterStatusCallback();
+
+        std::unique_lock<std::mutex> lock(mFilterEventsLock);
+        mFilterEventsCv.wait(lock,
+                             [this] { return !mFilterThreadRunning || !mFilterEvents.empty(); });
+        for (auto&& event : mFilterEvents) {
+            mCallbackScheduler.onFilterEvent(std::move(event));
         }
-        break;
+        mFilterEvents.clear();
     }
     ALOGD("[Filter] filter thread ended.");
 }
@@ -676,6 +1015,38 @@ binder_status_t Filter::dump(int fd, const char** /* args */, uint32_t /* numArg
     dprintf(fd, "      mIsRecordFilter: %d\n", mIsRecordFilter);
     dprintf(fd, "      mIsUsingFMQ: %d\n", mIsUsingFMQ);
     dprintf(fd, "      mFilterThreadRunning: %d\n", (bool)mFilterThreadRunning);
+    dprintf(fd, "      Callback adaptive delay: %d ms\n", mCallbackScheduler.getAdaptiveDelayMs());
+    if (mTsParser != nullptr) {
+        const TsParser::Stats& stats = mTsParser->getStats();
+        dprintf(fd,
+                "      mTsParser: packets %" PRIu64 ", units %" PRIu64 ", invalid %" PRIu64
+                ", transport errors %" PRIu64 ", scrambled %" PRIu64 ", duplicates %" PRIu64
+                ", continuity errors %" PRIu64 ", malformed units %" PRIu64 "\n",
+                stats.packets, stats.units, stats.invalidPackets, stats.transportErrors,
+                stats.scrambledPackets, stats.duplicatePackets, stats.continuityErrors,
+                stats.malformedUnits);
+    }
+    if (mTsParser != nullptr && mTsParser->getMode() == TsParser::Mode::SECTION) {
+        std::lock_guard<std::mutex> lock(mFilterOutputLock);
+        const SectionEngine::Stats& stats = mSectionEngine.getStats();
+        dprintf(fd,
+                "      mSectionEngine: sections %" PRIu64 ", delivered %" PRIu64
+                ", crc errors %" PRIu64 ", malformed %" PRIu64 ", filtered %" PRIu64
+                ", repeated %" PRIu64 ", after done %" PRIu64 "\n",
+                stats.sections, stats.delivered, stats.crcErrors, stats.malformed,
+                stats.filtered, stats.repeated, stats.done);
+    }
+    if (mIsMediaFilter) {
+        {
+            std::lock_guard<std::mutex> lock(mAvMemoryRingLock);
+            if (mAvMemoryRing != nullptr) {
+                mAvMemoryRing->dump(fd);
+            }
+        }
+        dprintf(fd, "      mUsingSharedAvMem: %d\n", mUsingSharedAvMem);
+        dprintf(fd, "      Pending av bytes: %zu, dropped av bytes: %" PRIu64 "\n",
+                mPesOutput.size(), mDroppedAvBytes);
+    }
     return STATUS_OK;
 }
 
@@ -715,19 +1086,29 @@ uint16_t Filter::getTpid() {
     return mTpid;
 }
 
-void Filter::updateFilterOutput(vector<int8_t>& data) {
+void Filter::updateFilterOutput(std::span<const int8_t> data) {
     std::lock_guard<std::mutex> lock(mFilterOutputLock);
     mFilterOutput.insert(mFilterOutput.end(), data.begin(), data.end());
 }
 
-void Filter::updatePts(uint64_t pts) {
+void Filter::updateFilterOutput(const vector<std::span<const int8_t>>& runs) {
+    size_t size = 0;
+    for (const auto& run : runs) {
+        size += run.size();
+    }
     std::lock_guard<std::mutex> lock(mFilterOutputLock);
-    mPts = pts;
+    size += mFilterOutput.size();
+    if (mFilterOutput.capacity() < size) {
+        mFilterOutput.reserve(std::max(size, mFilterOutput.capacity() * 2));
+    }
+    for (const auto& run : runs) {
+        mFilterOutput.insert(mFilterOutput.end(), run.begin(), run.end());
+    }
 }
 
-void Filter::updateRecordOutput(vector<int8_t>& data) {
-    std::lock_guard<std::mutex> lock(mRecordFilterOutputLock);
-    mRecordFilterOutput.insert(mRecordFilterOutput.end(), data.begin(), data.end());
+void Filter::updatePts(uint64_t pts) {
+    std::lock_guard<std::mutex> lock(mFilterOutputLock);
+    mPts = pts;
 }
 
 ::ndk::ScopedAStatus Filter::startFilterHandler() {
@@ -798,67 +1179,32 @@ void Filter::updateRecordOutput(vector<int8_t>& data) {
         return ::ndk::ScopedAStatus::ok();
     }
 
-    for (int i = 0; i < mFilterOutput.size(); i += 188) {
-        if (mPesSizeLeft == 0) {
-            uint32_t prefix = (mFilterOutput[i + 4] << 16) | (mFilterOutput[i + 5] << 8) |
-                              mFilterOutput[i + 6];
-            if (DEBUG_FILTER) {
-                ALOGD("[Filter] prefix %d", prefix);
-            }
-            if (prefix == 0x000001) {
-                // TODO handle mulptiple Pes filters
-                mPesSizeLeft = (static_cast<uint8_t>(mFilterOutput[i + 8]) << 8) |
-                               static_cast<uint8_t>(mFilterOutput[i + 9]);
-                mPesSizeLeft += 6;
-                if (DEBUG_FILTER) {
-                    ALOGD("[Filter] pes data length %d", mPesSizeLeft);
-                }
-            } else {
-                continue;
-            }
-        }
-
-        uint32_t endPoint = min(184u, mPesSizeLeft);
-        // append data and check size
-        vector<int8_t>::const_iterator first = mFilterOutput.begin() + i + 4;
-        vector<int8_t>::const_iterator last = mFilterOutput.begin() + i + 4 + endPoint;
-        mPesOutput.insert(mPesOutput.end(), first, last);
-        // size does not match then continue
-        mPesSizeLeft -= endPoint;
-        if (DEBUG_FILTER) {
-            ALOGD("[Filter] pes data left %d", mPesSizeLeft);
-        }
-        if (mPesSizeLeft > 0) {
-            continue;
-        }
-        // size match then create event
-        if (!writeDataToFilterMQ(mPesOutput)) {
-            ALOGD("[Filter] pes data write failed");
-            mFilterOutput.clear();
-            return ::ndk::ScopedAStatus::fromServiceSpecificError(
-                    static_cast<int32_t>(Result::INVALID_ARGUMENT));
+    bool isWritten = true;
+    mTsParser->parse(mFilterOutput, [&](const TsParser::Unit& pes) {
+        if (!writeDataToFilterMQ(pes.data)) {
+            isWritten = false;
+            return false;
         }
         maySendFilterStatusCallback();
         DemuxFilterPesEvent pesEvent;
         pesEvent = {
-                // temp dump meta data
-                .streamId = static_cast<int32_t>(mPesOutput[3]),
-                .dataLength = static_cast<int32_t>(mPesOutput.size()),
+                .streamId = pes.streamId,
+                .dataLength = static_cast<int32_t>(pes.data.size()),
         };
         if (DEBUG_FILTER) {
             ALOGD("[Filter] assembled pes data length %d", pesEvent.dataLength);
         }
 
-        {
-            std::lock_guard<std::mutex> lock(mFilterEventsLock);
-            mFilterEvents.push_back(DemuxFilterEvent::make<DemuxFilterEvent::Tag::pes>(pesEvent));
-        }
-
-        mPesOutput.clear();
-    }
-
+        queueFilterEvent(DemuxFilterEvent::make<DemuxFilterEvent::Tag::pes>(pesEvent));
+        return true;
+    });
     mFilterOutput.clear();
 
+    if (!isWritten) {
+        ALOGD("[Filter] pes data write failed");
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::INVALID_ARGUMENT));
+    }
     return ::ndk::ScopedAStatus::ok();
 }
 
@@ -880,119 +1226,180 @@ void Filter::updateRecordOutput(vector<int8_t>& data) {
     // with the existing data. This method is used when processing ES files.
     ::ndk::ScopedAStatus result;
     if (mPts) {
-        result = createMediaFilterEventWithIon(mFilterOutput);
-        if (result.isOk()) {
-            mFilterOutput.clear();
+        result = createMediaFilterEventWithIon(mFilterOutput, mPts);
+        if (mFilterOutput.empty()) {
+            mPts = 0;
         }
         return result;
     }
 
-    for (int i = 0; i < mFilterOutput.size(); i += 188) {
-        // Every packet has a 4 Byte TS Header preceding it
-        uint32_t headerSize = 4;
-
-        if (mPesSizeLeft == 0) {
-            // Packet Start Code Prefix is defined as the first 3 bytes of
-            // the PES Header and should always have the value 0x000001
-            uint32_t prefix = (static_cast<uint8_t>(mFilterOutput[i + 4]) << 16) |
-                              (static_cast<uint8_t>(mFilterOutput[i + 5]) << 8) |
-                              static_cast<uint8_t>(mFilterOutput[i + 6]);
-            if (DEBUG_FILTER) {
-                ALOGD("[Filter] prefix %d", prefix);
-            }
-            if (prefix == 0x000001) {
-                // TODO handle multiple Pes filters
-                // Location of PES fields from ISO/IEC 13818-1 Section 2.4.3.6
-                mPesSizeLeft = (static_cast<uint8_t>(mFilterOutput[i + 8]) << 8) |
-                               static_cast<uint8_t>(mFilterOutput[i + 9]);
-                bool hasPts = static_cast<uint8_t>(mFilterOutput[i + 11]) & 0x80;
-                uint8_t optionalFieldsLength = static_cast<uint8_t>(mFilterOutput[i + 12]);
-                headerSize += 9 + optionalFieldsLength;
-
-                if (hasPts) {
-                    // Pts is a 33-bit field which is stored across 5 bytes, with
-                    // bits in between as reserved fields which must be ignored
-                    mPts = 0;
-                    mPts |= (static_cast<uint8_t>(mFilterOutput[i + 13]) & 0x0e) << 29;
-                    mPts |= (static_cast<uint8_t>(mFilterOutput[i + 14]) & 0xff) << 22;
-                    mPts |= (static_cast<uint8_t>(mFilterOutput[i + 15]) & 0xfe) << 14;
-                    mPts |= (static_cast<uint8_t>(mFilterOutput[i + 16]) & 0xff) << 7;
-                    mPts |= (static_cast<uint8_t>(mFilterOutput[i + 17]) & 0xfe) >> 1;
-                }
-
-                if (DEBUG_FILTER) {
-                    ALOGD("[Filter] pes data length %d", mPesSizeLeft);
-                }
-            } else {
-                continue;
-            }
+    mTsParser->parse(mFilterOutput, [&](const TsParser::Unit& pes) {
+        // The event carries the PTS of the first PES packet in its data
+        if (mPesOutput.empty() && pes.hasPts) {
+            mPesOutputPts = pes.pts;
         }
-
-        uint32_t endPoint = min(188u - headerSize, mPesSizeLeft);
-        // append data and check size
-        vector<int8_t>::const_iterator first = mFilterOutput.begin() + i + headerSize;
-        vector<int8_t>::const_iterator last = mFilterOutput.begin() + i + headerSize + endPoint;
-        mPesOutput.insert(mPesOutput.end(), first, last);
-        // size does not match then continue
-        mPesSizeLeft -= endPoint;
+        std::span<const int8_t> payload = pes.payload();
+        mPesOutput.insert(mPesOutput.end(), payload.begin(), payload.end());
         if (DEBUG_FILTER) {
-            ALOGD("[Filter] pes data left %d", mPesSizeLeft);
+            ALOGD("[Filter] pes payload length %zu", payload.size());
         }
-        if (mPesSizeLeft > 0 || mAvBufferCopyCount++ < 10) {
-            continue;
+        if (mAvBufferCopyCount++ < 10) {
+            return true;
         }
 
-        result = createMediaFilterEventWithIon(mPesOutput);
-        if (!result.isOk()) {
-            mFilterOutput.clear();
-            return result;
+        // The output is kept for the next PES packet if there is no AV memory for it yet
+        result = createMediaFilterEventWithIon(mPesOutput, mPesOutputPts);
+        if (mPesOutput.empty()) {
+            mPesOutputPts = 0;
+            mAvBufferCopyCount = 0;
         }
-    }
-
+        return result.isOk();
+    });
     mFilterOutput.clear();
 
-    return ::ndk::ScopedAStatus::ok();
+    return result;
 }
 
-::ndk::ScopedAStatus Filter::createMediaFilterEventWithIon(vector<int8_t>& output) {
-    if (mUsingSharedAvMem) {
-        if (mSharedAvMemHandle == nullptr) {
-            return ::ndk::ScopedAStatus::fromServiceSpecificError(
-                    static_cast<int32_t>(Result::UNKNOWN_ERROR));
+AvMemoryRing* Filter::getAvMemoryRing() {
+    std::lock_guard<std::mutex> lock(mAvMemoryRingLock);
+    if (mAvMemoryRing == nullptr) {
+        int size = mIsMediaFilter ? BUFFER_SIZE : TEST_AV_BUFFER_SIZE;
+        int av_fd = createAvIonFd(size);
+        if (av_fd < 0) {
+            return nullptr;
         }
-        return createShareMemMediaEvents(output);
+        mAvMemoryRing = AvMemoryRing::create(av_fd, size);
     }
-
-    return createIndependentMediaEvents(output);
+    return mAvMemoryRing.get();
 }
 
-::ndk::ScopedAStatus Filter::startRecordFilterHandler() {
-    std::lock_guard<std::mutex> lock(mRecordFilterOutputLock);
-    if (mRecordFilterOutput.empty()) {
+// Copies the output into the AV memory and sends a media event for it. The output is cleared once
+// it is sent, or dropped if the client holds on to the AV memory for too long.
+::ndk::ScopedAStatus Filter::createMediaFilterEventWithIon(vector<int8_t>& output, int64_t pts) {
+    AvMemoryRing* avMemoryRing = getAvMemoryRing();
+    if (avMemoryRing == nullptr || (mUsingSharedAvMem && mSharedAvMemHandle == nullptr)) {
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::UNKNOWN_ERROR));
+    }
+
+    if (output.empty()) {
         return ::ndk::ScopedAStatus::ok();
     }
 
-    if (mDvr == nullptr || !mDvr->writeRecordFMQ(mRecordFilterOutput)) {
-        ALOGD("[Filter] dvr fails to write into record FMQ.");
+    int64_t dataId = mLastUsedDataId;
+    size_t offset;
+    if (!avMemoryRing->allocate(dataId, output.size(), &offset)) {
+        // Back-pressure: wait for the client to release AV memory, up to a quarter of it
+        if (output.size() > avMemoryRing->getCapacity() / 4) {
+            ALOGW("[Filter] no av memory released, dropping %zu bytes", output.size());
+            mDroppedAvBytes += output.size();
+            output.clear();
+        }
+        return ::ndk::ScopedAStatus::ok();
+    }
+    mLastUsedDataId++;
+    memcpy(avMemoryRing->getData() + offset, output.data(), output.size());
+
+    // With shared memory, the event handle has no fd and only the offset locates the data
+    native_handle_t* nativeHandle = createNativeHandle(mUsingSharedAvMem ? -1
+                                                                         : avMemoryRing->getFd());
+    if (nativeHandle == NULL) {
+        avMemoryRing->release(dataId);
         return ::ndk::ScopedAStatus::fromServiceSpecificError(
                 static_cast<int32_t>(Result::UNKNOWN_ERROR));
     }
 
-    DemuxFilterTsRecordEvent recordEvent;
-    recordEvent = {
-            .byteNumber = static_cast<int64_t>(mRecordFilterOutput.size()),
-            .pts = (mPts == 0) ? static_cast<int64_t>(time(NULL)) * 900000 : mPts,
-            .firstMbInSlice = 0,  // random address
+    // Create mediaEvent and send callback
+    auto event = DemuxFilterEvent::make<DemuxFilterEvent::Tag::media>();
+    auto& mediaEvent = event.get<DemuxFilterEvent::Tag::media>();
+    mediaEvent.avMemory = ::android::dupToAidl(nativeHandle);
+    mediaEvent.offset = static_cast<int64_t>(offset);
+    mediaEvent.dataLength = static_cast<int64_t>(output.size());
+    mediaEvent.avDataId = dataId;
+    if (pts) {
+        mediaEvent.pts = pts;
+    }
+
+    queueFilterEvent(std::move(event));
+
+    // Clear and log
+    native_handle_close(nativeHandle);
+    native_handle_delete(nativeHandle);
+    if (DEBUG_FILTER) {
+        ALOGD("[Filter] av data length %zu at offset %zu", output.size(), offset);
+    }
+    output.clear();
+    return ::ndk::ScopedAStatus::ok();
+}
+
+RecordEngine::StreamSettings Filter::getRecordStreamSettings() {
+    RecordEngine::StreamSettings settings = {
+            .pid = mTpid,
+            .tsIndexMask = 0,
+            .scIndexType = DemuxRecordScIndexType::NONE,
+            .scIndexMask = 0,
     };
+    if (mFilterSettings.getTag() != DemuxFilterSettings::Tag::ts) {
+        return settings;
+    }
+    const DemuxTsFilterSettingsFilterSettings& filterSettings =
+            mFilterSettings.get<DemuxFilterSettings::Tag::ts>().filterSettings;
+    if (filterSettings.getTag() != DemuxTsFilterSettingsFilterSettings::Tag::record) {
+        return settings;
+    }
+    const DemuxFilterRecordSettings& recordSettings =
+            filterSettings.get<DemuxTsFilterSettingsFilterSettings::Tag::record>();
+    settings.tsIndexMask = recordSettings.tsIndexMask;
+    settings.scIndexType = recordSettings.scIndexType;
+    switch (recordSettings.scIndexMask.getTag()) {
+        case DemuxFilterScIndexMask::Tag::scIndex:
+            settings.scIndexMask =
+                    recordSettings.scIndexMask.get<DemuxFilterScIndexMask::Tag::scIndex>();
+            break;
+        case DemuxFilterScIndexMask::Tag::scAvc:
+            settings.scIndexMask =
+                    recordSettings.scIndexMask.get<DemuxFilterScIndexMask::Tag::scAvc>();
+            break;
+        case DemuxFilterScIndexMask::Tag::scHevc:
+            settings.scIndexMask =
+                    recordSettings.scIndexMask.get<DemuxFilterScIndexMask::Tag::scHevc>();
+            break;
+        case DemuxFilterScIndexMask::Tag::scVvc:
+            settings.scIndexMask =
+                    recordSettings.scIndexMask.get<DemuxFilterScIndexMask::Tag::scVvc>();
+            break;
+    }
+    return settings;
+}
 
-    {
-        std::lock_guard<std::mutex> lock(mFilterEventsLock);
-        mFilterEvents.push_back(
-                DemuxFilterEvent::make<DemuxFilterEvent::Tag::tsRecord>(recordEvent));
+void Filter::onRecordIndex(const RecordEngine::IndexEntry& entry) {
+    DemuxFilterScIndexMask scIndexMask;
+    switch (getRecordStreamSettings().scIndexType) {
+        case DemuxRecordScIndexType::SC_AVC:
+            scIndexMask.set<DemuxFilterScIndexMask::Tag::scAvc>(entry.scIndexMask);
+            break;
+        case DemuxRecordScIndexType::SC_HEVC:
+            scIndexMask.set<DemuxFilterScIndexMask::Tag::scHevc>(entry.scIndexMask);
+            break;
+        case DemuxRecordScIndexType::SC_VVC:
+            scIndexMask.set<DemuxFilterScIndexMask::Tag::scVvc>(entry.scIndexMask);
+            break;
+        default:
+            scIndexMask.set<DemuxFilterScIndexMask::Tag::scIndex>(entry.scIndexMask);
+            break;
     }
+    DemuxPid pid;
+    pid.set<DemuxPid::Tag::tPid>(entry.pid);
+    DemuxFilterTsRecordEvent recordEvent = {
+            .pid = pid,
+            .tsIndexMask = entry.tsIndexMask,
+            .scIndexMask = scIndexMask,
+            .byteNumber = static_cast<int64_t>(entry.byteNumber),
+            .pts = entry.pts == RecordEngine::kNoPts ? 0 : entry.pts,
+            .firstMbInSlice = entry.firstMbInSlice,
+    };
 
-    mRecordFilterOutput.clear();
-    return ::ndk::ScopedAStatus::ok();
+    queueFilterEvent(DemuxFilterEvent::make<DemuxFilterEvent::Tag::tsRecord>(recordEvent));
 }
 
 ::ndk::ScopedAStatus Filter::startPcrFilterHandler() {
@@ -1005,71 +1412,80 @@ void Filter::updateRecordOutput(vector<int8_t>& data) {
     return ::ndk::ScopedAStatus::ok();
 }
 
+void Filter::configureSectionEngine(const DemuxFilterSectionSettings& settings) {
+    SectionEngine::Settings engineSettings = {
+            .isCheckCrc = settings.isCheckCrc,
+            .isRepeat = settings.isRepeat,
+    };
+    switch (settings.condition.getTag()) {
+        case DemuxFilterSectionSettingsCondition::Tag::tableInfo: {
+            const auto& tableInfo =
+                    settings.condition.get<DemuxFilterSectionSettingsCondition::Tag::tableInfo>();
+            engineSettings.hasTableCondition = true;
+            engineSettings.tableId = static_cast<uint8_t>(tableInfo.tableId);
+            engineSettings.version = static_cast<uint32_t>(tableInfo.version);
+            break;
+        }
+        case DemuxFilterSectionSettingsCondition::Tag::sectionBits: {
+            const auto& sectionBits =
+                    settings.condition.get<DemuxFilterSectionSettingsCondition::Tag::sectionBits>();
+            engineSettings.filter.assign(sectionBits.filter.begin(), sectionBits.filter.end());
+            engineSettings.mask.assign(sectionBits.mask.begin(), sectionBits.mask.end());
+            engineSettings.mode.assign(sectionBits.mode.begin(), sectionBits.mode.end());
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mFilterOutputLock);
+    mSectionEngine.configure(engineSettings);
+}
+
 // Read PSI (Program Specific Information) Sections from TransportStreams
 // as defined in ISO/IEC 13818-1 Section 2.4.4
 bool Filter::writeSectionsAndCreateEvent(vector<int8_t>& data) {
-    // TODO check how many sections has been read
-    ALOGD("[Filter] section handler");
-
-    // Transport Stream Packets are 188 bytes long, as defined in the
-    // Introduction of ISO/IEC 13818-1
-    for (int i = 0; i < data.size(); i += 188) {
-        if (mSectionSizeLeft == 0) {
-            // Location for sectionSize as defined by Section 2.4.4
-            // Note that the first 4 bytes skipped are the TsHeader
-            mSectionSizeLeft = ((static_cast<uint8_t>(data[i + 5]) & 0x0f) << 8) |
-                               static_cast<uint8_t>(data[i + 6]);
-            mSectionSizeLeft += 3;
+    if (DEBUG_FILTER) {
+        ALOGD("[Filter] section handler");
+    }
+
+    return mTsParser->parse(data, [&](const TsParser::Unit& section) {
+        SectionHeader header;
+        SectionEngine::Verdict verdict = mSectionEngine.filter(section.data, &header);
+        if (verdict != SectionEngine::Verdict::DELIVER) {
             if (DEBUG_FILTER) {
-                ALOGD("[Filter] section data length %d", mSectionSizeLeft);
+                ALOGD("[Filter] section not delivered: %d", static_cast<int>(verdict));
             }
+            return true;
         }
-
-        // 184 bytes per packet is derived by subtracting the 4 byte length of
-        // the TsHeader from its 188 byte packet size
-        uint32_t endPoint = min(184u, mSectionSizeLeft);
-        // append data and check size
-        vector<int8_t>::const_iterator first = data.begin() + i + 4;
-        vector<int8_t>::const_iterator last = data.begin() + i + 4 + endPoint;
-        mSectionOutput.insert(mSectionOutput.end(), first, last);
-        // size does not match then continue
-        mSectionSizeLeft -= endPoint;
-        if (DEBUG_FILTER) {
-            ALOGD("[Filter] section data left %d", mSectionSizeLeft);
-        }
-        if (mSectionSizeLeft > 0) {
-            continue;
-        }
-
-        if (!writeDataToFilterMQ(mSectionOutput)) {
-            mSectionOutput.clear();
+        if (!writeDataToFilterMQ(section.data)) {
+            // Not committed, so the next repeat of the section is delivered instead
             return false;
         }
+        mSectionEngine.commit(section.data, header);
 
-        DemuxFilterSectionEvent secEvent;
-        secEvent = {
-                // temp dump meta data
-                .tableId = 0,
-                .version = 1,
-                .sectionNum = 1,
-                .dataLength = static_cast<int32_t>(mSectionOutput.size()),
+        DemuxFilterSectionEvent secEvent = {
+                .tableId = header.tableId,
+                .version = header.version,
+                .sectionNum = header.sectionNumber,
+                .dataLength = static_cast<int32_t>(section.data.size()),
         };
         if (DEBUG_FILTER) {
             ALOGD("[Filter] assembled section data length %" PRIu64, secEvent.dataLength);
         }
 
-        {
-            std::lock_guard<std::mutex> lock(mFilterEventsLock);
-            mFilterEvents.push_back(
-                    DemuxFilterEvent::make<DemuxFilterEvent::Tag::section>(secEvent));
-        }
-        mSectionOutput.clear();
-    }
+        queueFilterEvent(DemuxFilterEvent::make<DemuxFilterEvent::Tag::section>(secEvent));
+        return true;
+    });
+}
 
-    return true;
+void Filter::queueFilterEvent(DemuxFilterEvent&& event) {
+    {
+        std::lock_guard<std::mutex> lock(mFilterEventsLock);
+        mFilterEvents.push_back(std::move(event));
+    }
+    mFilterEventsCv.notify_one();
 }
 
-bool Filter::writeDataToFilterMQ(const std::vector<int8_t>& data) {
+bool Filter::writeDataToFilterMQ(std::span<const int8_t> data) {
     std::lock_guard<std::mutex> lock(mWriteLock);
     if (mFilterMQ->write(data.data(), data.size())) {
         return true;
@@ -1101,16 +1517,6 @@ int Filter::createAvIonFd(int size) {
     return av_fd;
 }
 
-uint8_t* Filter::getIonBuffer(int fd, int size) {
-    uint8_t* avBuf = static_cast<uint8_t*>(
-            mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 /*offset*/));
-    if (avBuf == MAP_FAILED) {
-        ALOGE("[Filter] fail to allocate buffer %d", errno);
-        return NULL;
-    }
-    return avBuf;
-}
-
 native_handle_t* Filter::createNativeHandle(int fd) {
     native_handle_t* nativeHandle;
     if (fd < 0) {
@@ -1129,102 +1535,6 @@ native_handle_t* Filter::createNativeHandle(int fd) {
     return nativeHandle;
 }
 
-::ndk::ScopedAStatus Filter::createIndependentMediaEvents(vector<int8_t>& output) {
-    int av_fd = createAvIonFd(output.size());
-    if (av_fd == -1) {
-        return ::ndk::ScopedAStatus::fromServiceSpecificError(
-                static_cast<int32_t>(Result::UNKNOWN_ERROR));
-    }
-    // copy the filtered data to the buffer
-    uint8_t* avBuffer = getIonBuffer(av_fd, output.size());
-    if (avBuffer == NULL) {
-        return ::ndk::ScopedAStatus::fromServiceSpecificError(
-                static_cast<int32_t>(Result::UNKNOWN_ERROR));
-    }
-    memcpy(avBuffer, output.data(), output.size() * sizeof(uint8_t));
-
-    native_handle_t* nativeHandle = createNativeHandle(av_fd);
-    if (nativeHandle == NULL) {
-        return ::ndk::ScopedAStatus::fromServiceSpecificError(
-                static_cast<int32_t>(Result::UNKNOWN_ERROR));
-    }
-
-    // Create a dataId and add a <dataId, av_fd> pair into the dataId2Avfd map
-    uint64_t dataId = mLastUsedDataId++ /*createdUID*/;
-    mDataId2Avfd[dataId] = dup(av_fd);
-
-    // Create mediaEvent and send callback
-    auto event = DemuxFilterEvent::make<DemuxFilterEvent::Tag::media>();
-    auto& mediaEvent = event.get<DemuxFilterEvent::Tag::media>();
-    mediaEvent.avMemory = ::android::dupToAidl(nativeHandle);
-    mediaEvent.dataLength = static_cast<int64_t>(output.size());
-    mediaEvent.avDataId = static_cast<int64_t>(dataId);
-    if (mPts) {
-        mediaEvent.pts = mPts;
-        mPts = 0;
-    }
-
-    {
-        std::lock_guard<std::mutex> lock(mFilterEventsLock);
-        mFilterEvents.push_back(std::move(event));
-    }
-
-    // Clear and log
-    native_handle_close(nativeHandle);
-    native_handle_delete(nativeHandle);
-    output.clear();
-    mAvBufferCopyCount = 0;
-    if (DEBUG_FILTER) {
-        ALOGD("[Filter] av data length %d", static_cast<int32_t>(output.size()));
-    }
-    return ::ndk::ScopedAStatus::ok();
-}
-
-::ndk::ScopedAStatus Filter::createShareMemMediaEvents(vector<int8_t>& output) {
-    // copy the filtered data to the shared buffer
-    uint8_t* sharedAvBuffer =
-            getIonBuffer(mSharedAvMemHandle->data[0], output.size() + mSharedAvMemOffset);
-    if (sharedAvBuffer == NULL) {
-        return ::ndk::ScopedAStatus::fromServiceSpecificError(
-                static_cast<int32_t>(Result::UNKNOWN_ERROR));
-    }
-    memcpy(sharedAvBuffer + mSharedAvMemOffset, output.data(), output.size() * sizeof(uint8_t));
-
-    // Create a memory handle with numFds == 0
-    native_handle_t* nativeHandle = createNativeHandle(-1);
-    if (nativeHandle == NULL) {
-        return ::ndk::ScopedAStatus::fromServiceSpecificError(
-                static_cast<int32_t>(Result::UNKNOWN_ERROR));
-    }
-
-    // Create mediaEvent and send callback
-    auto event = DemuxFilterEvent::make<DemuxFilterEvent::Tag::media>();
-    auto& mediaEvent = event.get<DemuxFilterEvent::Tag::media>();
-    mediaEvent.avMemory = ::android::dupToAidl(nativeHandle);
-    mediaEvent.offset = mSharedAvMemOffset;
-    mediaEvent.dataLength = static_cast<int64_t>(output.size());
-    if (mPts) {
-        mediaEvent.pts = mPts;
-        mPts = 0;
-    }
-
-    {
-        std::lock_guard<std::mutex> lock(mFilterEventsLock);
-        mFilterEvents.push_back(std::move(event));
-    }
-
-    mSharedAvMemOffset += output.size();
-
-    // Clear and log
-    native_handle_close(nativeHandle);
-    native_handle_delete(nativeHandle);
-    output.clear();
-    if (DEBUG_FILTER) {
-        ALOGD("[Filter] shared av data length %d", static_cast<int32_t>(output.size()));
-    }
-    return ::ndk::ScopedAStatus::ok();
-}
-
 bool Filter::sameFile(int fd1, int fd2) {
     struct stat stat1, stat2;
     if (fstat(fd1, &stat1) < 0 || fstat(fd2, &stat2) < 0) {
@@ -1281,23 +1591,19 @@ void Filter::createMediaEvent(vector<DemuxFilterEvent>& events, bool isAudioPres
         mediaEvent.extraMetaData.set<DemuxFilterMediaEventExtraMetaData::Tag::audio>(audio);
     }
 
-    int av_fd = createAvIonFd(BUFFER_SIZE);
-    if (av_fd == -1) {
+    // The test event points to the start of the AV memory, without a slice of it
+    AvMemoryRing* avMemoryRing = getAvMemoryRing();
+    if (avMemoryRing == nullptr) {
         return;
     }
 
-    native_handle_t* nativeHandle = createNativeHandle(av_fd);
+    native_handle_t* nativeHandle = createNativeHandle(avMemoryRing->getFd());
     if (nativeHandle == nullptr) {
-        ::close(av_fd);
         ALOGE("[Filter] Failed to create native_handle %d", errno);
         return;
     }
 
-    // Create a dataId and add a <dataId, av_fd> pair into the dataId2Avfd map
-    uint64_t dataId = mLastUsedDataId++ /*createdUID*/;
-    mDataId2Avfd[dataId] = dup(av_fd);
-
-    mediaEvent.avDataId = static_cast<int64_t>(dataId);
+    mediaEvent.avDataId = mLastUsedDataId++;
     mediaEvent.avMemory = ::android::dupToAidl(nativeHandle);
 
     events.push_back(DemuxFilterEvent::make<DemuxFilterEvent::Tag::media>(std::move(mediaEvent)));
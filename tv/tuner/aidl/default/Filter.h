@@ -26,14 +26,23 @@
 #include <ion/ion.h>
 #include <math.h>
 #include <sys/stat.h>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <set>
+#include <span>
 #include <thread>
+#include <unordered_map>
 
 #include "Demux.h"
 #include "Dvr.h"
 #include "Frontend.h"
+#include "RecordEngine.h"
+#include "SectionEngine.h"
+#include "TsParser.h"
 
 using namespace std;
 
@@ -52,13 +61,104 @@ using ::android::hardware::EventFlag;
 using FilterMQ = AidlMessageQueue<int8_t, SynchronizedReadWrite>;
 
 const uint32_t BUFFER_SIZE = 0x800000;  // 8 MB
+// AV memory of the filters which are not media filters, only used by the test media events
+const uint32_t TEST_AV_BUFFER_SIZE = 0x1000;  // 4 KB
 
 class Demux;
 class Dvr;
 
+class FilterCallbackScheduler;
+
+/**
+ * Delivers the filter events of all the filters of a Demux from a single thread.
+ *
+ * Each filter batches its events in its FilterCallbackScheduler, which asks the dispatcher for a
+ * callback at the deadline its delay hints give. Deadlines in the future are kept in a timer
+ * wheel with 1ms ticks, so that the thread only wakes up for the next one.
+ *
+ * Must be owned by a std::shared_ptr: the thread holds a reference during each callback, which
+ * may release the last other one.
+ */
+class FilterCallbackDispatcher final
+    : public std::enable_shared_from_this<FilterCallbackDispatcher> {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    FilterCallbackDispatcher();
+    ~FilterCallbackDispatcher();
+
+    void registerScheduler(FilterCallbackScheduler* scheduler);
+    // Waits for the callback in progress of the scheduler, if any
+    void unregisterScheduler(FilterCallbackScheduler* scheduler);
+
+    // Asks for a callback of the scheduler at the deadline, or earlier if already asked
+    void schedule(FilterCallbackScheduler* scheduler, Clock::time_point deadline);
+
+    void dump(int fd);
+
+  private:
+    static constexpr size_t kWheelSize = 256;
+    // Batch sizes of 1, 2-3, 4-7, ... 128 and more events
+    static constexpr size_t kBatchSizeBuckets = 8;
+
+    struct Registration {
+        // Tick of the pending callback, kNoTick if there is none
+        uint64_t deadlineTick;
+        bool isReady;
+    };
+    struct TimerEntry {
+        FilterCallbackScheduler* scheduler;
+        uint64_t deadlineTick;
+    };
+
+    static constexpr uint64_t kNoTick = UINT64_MAX;
+
+    void threadLoop();
+    uint64_t getTick(Clock::time_point time) const;
+    // Moves the schedulers whose deadline has passed to mReadySchedulers
+    void advanceWheelLocked(uint64_t nowTick);
+    uint64_t getNextDeadlineTickLocked() const;
+    void recordCallbackLocked(size_t eventCount, Clock::time_point now);
+
+    Clock::time_point mStartTime;
+
+    // mLock protects all the members below
+    std::mutex mLock;
+    std::condition_variable mCv;
+    std::thread mThread;
+    bool mIsRunning = false;
+    std::unordered_map<FilterCallbackScheduler*, Registration> mRegistrations;
+    std::array<vector<TimerEntry>, kWheelSize> mWheel;
+    size_t mTimerCount = 0;
+    uint64_t mWheelTick = 0;
+    std::deque<FilterCallbackScheduler*> mReadySchedulers;
+    // The scheduler whose callback is in progress, outside of mLock
+    FilterCallbackScheduler* mDeliveringScheduler = nullptr;
+
+    uint64_t mCallbackCount = 0;
+    uint64_t mEventCount = 0;
+    std::array<uint64_t, kBatchSizeBuckets> mBatchSizeHistogram = {};
+    // Callbacks per second, over the last complete second
+    Clock::time_point mRateWindowStart;
+    uint64_t mRateWindowCallbacks = 0;
+    uint64_t mCallbacksPerSecond = 0;
+};
+
+/**
+ * Batches the events of a filter until its delay hints are met, then has them delivered by the
+ * FilterCallbackDispatcher of its Demux.
+ *
+ * A filter sending more than kMaxCallbacksPerSecond callbacks gets an adaptive delay between its
+ * callbacks, doubled every second it stays over the limit and halved when it is back under half
+ * of it. The events it sends under load are then grouped in fewer, larger callbacks.
+ */
 class FilterCallbackScheduler final {
   public:
-    FilterCallbackScheduler(const std::shared_ptr<IFilterCallback>& cb);
+    static constexpr int kMaxCallbacksPerSecond = 200;
+    static constexpr int kMaxAdaptiveDelayMs = 40;
+
+    FilterCallbackScheduler(const std::shared_ptr<IFilterCallback>& cb,
+                            std::shared_ptr<FilterCallbackDispatcher> dispatcher);
     ~FilterCallbackScheduler();
 
     void onFilterEvent(DemuxFilterEvent&& event);
@@ -71,32 +171,97 @@ class FilterCallbackScheduler final {
 
     void flushEvents();
 
-  private:
-    void start();
-    void stop();
+    // Called by the dispatcher, return the number of events delivered
+    size_t deliverEvents();
 
-    void threadLoop();
-    void threadLoopOnce();
+    int getAdaptiveDelayMs();
 
-    // function needs to be called while holding mLock
+  private:
+    using Clock = FilterCallbackDispatcher::Clock;
+
+    // functions need to be called while holding mLock
     bool isDataSizeDelayConditionMetLocked();
+    void scheduleLocked();
+    void updateAdaptiveDelayLocked(Clock::time_point now);
 
     static int getDemuxFilterEventDataLength(const DemuxFilterEvent& event);
 
   private:
     std::shared_ptr<IFilterCallback> mCallback;
-    std::thread mCallbackThread;
-    std::atomic<bool> mIsRunning;
+    std::shared_ptr<FilterCallbackDispatcher> mDispatcher;
 
-    // mLock protects mCallbackBuffer, mIsConditionMet, mCv, mDataLength,
-    // mTimeDelayInMs, and mDataSizeDelayInBytes
+    // mLock protects all the members below
     std::mutex mLock;
     std::vector<DemuxFilterEvent> mCallbackBuffer;
-    bool mIsConditionMet;
-    std::condition_variable mCv;
+    std::vector<DemuxFilterEvent> mDeliveryBuffer;
     int mDataLength;
     int mTimeDelayInMs;
     int mDataSizeDelayInBytes;
+    // Time of the oldest event in mCallbackBuffer
+    Clock::time_point mFirstEventTime;
+    // Deadline asked to the dispatcher for the pending events, max if none
+    Clock::time_point mScheduledDeadline = Clock::time_point::max();
+    Clock::time_point mLastCallbackTime;
+    int mAdaptiveDelayMs = 0;
+    Clock::time_point mRateWindowStart;
+    int mRateWindowCallbacks = 0;
+};
+
+/**
+ * AV memory allocated and mapped once per filter, which the media events point into with an
+ * offset and a length.
+ *
+ * Slices are allocated at the head of the ring and reclaimed from its tail, once the client
+ * released them through IFilter::releaseAvHandle. A slice released out of order is reclaimed
+ * together with the older ones.
+ */
+class AvMemoryRing final {
+  public:
+    // Takes ownership of the fd, return nullptr if it can't be mapped
+    static std::unique_ptr<AvMemoryRing> create(int fd, size_t capacity);
+    ~AvMemoryRing();
+
+    int getFd() const { return mFd; }
+    size_t getCapacity() const { return mCapacity; }
+    uint8_t* getData() { return mData; }
+
+    /**
+     * Allocates a contiguous slice for the data of an event.
+     *
+     * Return false if the slices in use leave no room, the caller should retry after a release.
+     */
+    bool allocate(int64_t dataId, size_t length, size_t* offset);
+    // Return false if no slice in use has the dataId
+    bool release(int64_t dataId);
+    void releaseAll();
+
+    void dump(int fd);
+
+  private:
+    AvMemoryRing(int fd, uint8_t* data, size_t capacity);
+
+    struct Slice {
+        int64_t dataId;
+        size_t offset;
+        size_t length;
+        bool isReleased;
+    };
+
+    int mFd;
+    uint8_t* mData;
+    size_t mCapacity;
+
+    // mLock protects all the members below
+    std::mutex mLock;
+    // From the tail to the head of the ring
+    std::deque<Slice> mSlices;
+    size_t mHead = 0;
+    size_t mBytesInUse = 0;
+    size_t mPeakBytesInUse = 0;
+    uint64_t mAllocations = 0;
+    uint64_t mReleases = 0;
+    // Allocations which failed for lack of room
+    uint64_t mFullCount = 0;
 };
 
 class Filter : public BnFilter {
@@ -136,11 +301,17 @@ class Filter : public BnFilter {
      */
     bool createFilterMQ();
     uint16_t getTpid();
-    void updateFilterOutput(vector<int8_t>& data);
-    void updateRecordOutput(vector<int8_t>& data);
+    bool isTpidConfigured() { return mIsTpidConfigured; }
+    bool isStarted() { return mIsStarted; }
+    void updateFilterOutput(std::span<const int8_t> data);
+    // Appends the runs of packets under a single lock
+    void updateFilterOutput(const vector<std::span<const int8_t>>& runs);
     void updatePts(uint64_t pts);
     ::ndk::ScopedAStatus startFilterHandler();
-    ::ndk::ScopedAStatus startRecordFilterHandler();
+    // The PID and index masks the record engine of the DVR records this filter with
+    RecordEngine::StreamSettings getRecordStreamSettings();
+    // Queues the record event of an index entry of the recorded data
+    void onRecordIndex(const RecordEngine::IndexEntry& entry);
     void attachFilterToRecord(const std::shared_ptr<Dvr> dvr);
     void detachFilterFromRecord();
     void freeSharedAvHandle();
@@ -167,14 +338,16 @@ class Filter : public BnFilter {
     DemuxFilterSettings mFilterSettings;
 
     uint16_t mTpid;
+    bool mIsTpidConfigured = false;
+    // Whether the filter is between start() and stop(), only started filters receive TS data
+    std::atomic<bool> mIsStarted = false;
     std::shared_ptr<IFilter> mDataSource;
     bool mIsDataSourceDemux = true;
     vector<int8_t> mFilterOutput;
-    vector<int8_t> mRecordFilterOutput;
     int64_t mPts = 0;
     unique_ptr<FilterMQ> mFilterMQ;
     bool mIsUsingFMQ = false;
-    EventFlag* mFilterEventsFlag;
+    EventFlag* mFilterEventsFlag = nullptr;
     vector<DemuxFilterEvent> mFilterEvents;
 
     // Thread handlers
@@ -187,12 +360,6 @@ class Filter : public BnFilter {
      */
     std::atomic<bool> mFilterThreadRunning;
 
-    /**
-     * How many times a filter should write
-     * TODO make this dynamic/random/can take as a parameter
-     */
-    const uint16_t SECTION_WRITE_COUNT = 10;
-
     bool DEBUG_FILTER = false;
 
     /**
@@ -209,8 +376,11 @@ class Filter : public BnFilter {
     ::ndk::ScopedAStatus startFilterLoop();
 
     void deleteEventFlag();
-    bool writeDataToFilterMQ(const std::vector<int8_t>& data);
+    bool writeDataToFilterMQ(std::span<const int8_t> data);
+    // Queues an event for the filter thread to hand over to the callback scheduler
+    void queueFilterEvent(DemuxFilterEvent&& event);
     bool readDataFromMQ();
+    void configureSectionEngine(const DemuxFilterSectionSettings& settings);
     bool writeSectionsAndCreateEvent(vector<int8_t>& data);
     void maySendFilterStatusCallback();
     DemuxFilterStatus checkFilterStatusChange(uint32_t availableToWrite, uint32_t availableToRead,
@@ -224,11 +394,9 @@ class Filter : public BnFilter {
     void filterThreadLoop();
 
     int createAvIonFd(int size);
-    uint8_t* getIonBuffer(int fd, int size);
     native_handle_t* createNativeHandle(int fd);
-    ::ndk::ScopedAStatus createMediaFilterEventWithIon(vector<int8_t>& output);
-    ::ndk::ScopedAStatus createIndependentMediaEvents(vector<int8_t>& output);
-    ::ndk::ScopedAStatus createShareMemMediaEvents(vector<int8_t>& output);
+    AvMemoryRing* getAvMemoryRing();
+    ::ndk::ScopedAStatus createMediaFilterEventWithIon(vector<int8_t>& output, int64_t pts);
     bool sameFile(int fd1, int fd2);
 
     void createMediaEvent(vector<DemuxFilterEvent>&, bool isAudioPresentation);
@@ -251,31 +419,33 @@ class Filter : public BnFilter {
      */
     // TODO make each filter separate event lock
     std::mutex mFilterEventsLock;
+    // Notified when an event is queued or the filter thread stops
+    std::condition_variable mFilterEventsCv;
     /**
      * Lock to protect writes to the input status
      */
     std::mutex mFilterStatusLock;
     std::mutex mFilterOutputLock;
-    std::mutex mRecordFilterOutputLock;
-
-    // handle single Section filter
-    uint32_t mSectionSizeLeft = 0;
-    vector<int8_t> mSectionOutput;
 
-    // temp handle single PES filter
-    // TODO handle mulptiple Pes filters
-    uint32_t mPesSizeLeft = 0;
+    // Assembles the sections or PES packets of the TS filters which output them
+    std::unique_ptr<TsParser> mTsParser;
+    // Selects the sections of the TS section filters, under mFilterOutputLock
+    SectionEngine mSectionEngine;
+    // Payloads of the PES packets to send in the next media event, and the PTS of the first one
     vector<int8_t> mPesOutput;
+    int64_t mPesOutputPts = 0;
 
-    // A map from data id to ion handle
-    std::map<uint64_t, int> mDataId2Avfd;
-    uint64_t mLastUsedDataId = 1;
+    // The AV memory of the media events, created on first use under mAvMemoryRingLock
+    std::mutex mAvMemoryRingLock;
+    std::unique_ptr<AvMemoryRing> mAvMemoryRing;
+    std::atomic<int64_t> mLastUsedDataId = 1;
     int mAvBufferCopyCount = 0;
+    // Media data dropped because the client didn't release enough AV memory
+    uint64_t mDroppedAvBytes = 0;
 
     // Shared A/V memory handle
     native_handle_t* mSharedAvMemHandle = nullptr;
     bool mUsingSharedAvMem = false;
-    int64_t mSharedAvMemOffset = 0;
 
     uint32_t mAudioStreamType;
     uint32_t mVideoStreamType;
@@ -18,6 +18,7 @@
 #define LOG_TAG "android.hardware.tv.tuner-service.example-Frontend"
 
 #include <aidl/android/hardware/tv/tuner/Result.h>
+#include <inttypes.h>
 #include <utils/Log.h>
 
 #include "Frontend.h"
@@ -28,6 +29,21 @@ namespace hardware {
 namespace tv {
 namespace tuner {
 
+namespace {
+
+// Directory of the TS files the virtual frontends lock on during a blind scan, named after their
+// frequency in Hz
+const char* kScanChannelDirectory = "/data/vendor/tuner/scan";
+constexpr VirtualScanTuner::Timing kVirtualScanTiming = {
+        .lockTime = std::chrono::milliseconds(10),
+        .probeTime = std::chrono::milliseconds(1),
+};
+constexpr auto kScanLockTimeout = std::chrono::milliseconds(50);
+// The simulated channel is this far above the frequency of the scan settings
+constexpr int64_t kBlindScanOffset = 100 * 1000;
+
+}  // namespace
+
 Frontend::Frontend(FrontendType type, int32_t id) {
     mType = type;
     mId = id;
@@ -269,6 +285,7 @@ void Frontend::readTuneByte(dtv_streamer* streamer, void* buf, size_t buf_size,
                     static_cast<int32_t>(Result::INVALID_ARGUMENT));
         }
         mIptvTransportDescription = transport_desc;
+        mIptvContentUrl = content_url;
 
         // create a streamer and open it for reading data
         dtv_streamer* streamer = mIptvPluginInterface->create_streamer();
@@ -311,10 +328,18 @@ void Frontend::readTuneByte(dtv_streamer* streamer, void* buf, size_t buf_size,
     if (mScanThread.joinable()) {
         mScanThread.join();
     }
+    if (!reserveForScan()) {
+        ALOGW("[   WARN   ] Frontend %d is scanning for another frontend", mId);
+        return ::ndk::ScopedAStatus::fromServiceSpecificError(
+                static_cast<int32_t>(Result::UNAVAILABLE));
+    }
 
     mFrontendSettings = in_settings;
     mFrontendScanType = in_type;
-    mScanThread = std::thread(&Frontend::scanThreadLoop, this);
+    mScanThread = std::thread([this] {
+        scanThreadLoop();
+        releaseFromScan();
+    });
 
     return ::ndk::ScopedAStatus::ok();
 }
@@ -325,6 +350,10 @@ void Frontend::setTunerService(std::shared_ptr<Tuner> tuner) {
 
 void Frontend::scanThreadLoop() {
     if (mIsLocked) {
+        if (!mPendingScanFrequencies.empty()) {
+            reportNextScanFrequency();
+            return;
+        }
         FrontendScanMessage msg;
         msg.set<FrontendScanMessage::Tag::isEnd>(true);
         mCallback->onScanMessage(FrontendScanMessageType::END, msg);
@@ -332,40 +361,55 @@ void Frontend::scanThreadLoop() {
     }
 
     int64_t frequency = 0;
+    int64_t endFrequency = 0;
     switch (mFrontendSettings.getTag()) {
         case FrontendSettings::Tag::analog:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::analog>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::analog>().endFrequency;
             break;
         case FrontendSettings::Tag::atsc:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::atsc>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::atsc>().endFrequency;
             break;
         case FrontendSettings::Tag::atsc3:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::atsc3>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::atsc3>().endFrequency;
             break;
         case FrontendSettings::Tag::dvbs:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::dvbs>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::dvbs>().endFrequency;
             break;
         case FrontendSettings::Tag::dvbc:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::dvbc>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::dvbc>().endFrequency;
             break;
         case FrontendSettings::Tag::dvbt:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::dvbt>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::dvbt>().endFrequency;
             break;
         case FrontendSettings::Tag::isdbs:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::isdbs>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::isdbs>().endFrequency;
             break;
         case FrontendSettings::Tag::isdbs3:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::isdbs3>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::isdbs3>().endFrequency;
             break;
         case FrontendSettings::Tag::isdbt:
             frequency = mFrontendSettings.get<FrontendSettings::Tag::isdbt>().frequency;
+            endFrequency = mFrontendSettings.get<FrontendSettings::Tag::isdbt>().endFrequency;
             break;
         default:
             break;
     }
 
+    if (mFrontendScanType == FrontendScanType::SCAN_BLIND && endFrequency > frequency) {
+        blindScanThreadLoop(frequency, endFrequency);
+        return;
+    }
+
     if (mFrontendScanType == FrontendScanType::SCAN_BLIND) {
-        frequency += 100 * 1000;
+        frequency += kBlindScanOffset;
     }
 
     {
@@ -496,13 +540,113 @@ void Frontend::scanThreadLoop() {
     }
 }
 
+void Frontend::blindScanThreadLoop(int64_t startFrequency, int64_t endFrequency) {
+    std::map<int64_t, std::string> channels =
+            VirtualScanTuner::loadChannels(kScanChannelDirectory);
+    // The channel of the settings, as the scan of a single frequency finds it
+    channels.emplace(startFrequency + kBlindScanOffset, "");
+
+    // The idle frontends of the same type take their share of the frequencies
+    vector<std::shared_ptr<Frontend>> frontends;
+    if (mTuner != nullptr) {
+        for (const auto& frontend : mTuner->getIdleFrontends(mType)) {
+            if (frontend.get() != this && frontend->reserveForScan()) {
+                frontends.push_back(frontend);
+            }
+        }
+    }
+    std::vector<std::shared_ptr<ScanTuner>> tuners = {
+            std::make_shared<VirtualScanTuner>(mId, channels, kVirtualScanTiming)};
+    for (const auto& frontend : frontends) {
+        tuners.push_back(std::make_shared<VirtualScanTuner>(frontend->getFrontendId(), channels,
+                                                            kVirtualScanTiming));
+    }
+    ScanEngine* engine;
+    {
+        std::lock_guard<std::mutex> lock(mScanEngineLock);
+        mScanEngine = std::make_unique<ScanEngine>(tuners);
+        engine = mScanEngine.get();
+    }
+
+    ScanEngine::Settings settings = {
+            .bands = {{startFrequency, endFrequency, getScanStep()}},
+            .lockTimeout = kScanLockTimeout,
+    };
+    vector<ScanEngine::Channel> found = engine->scan(settings, nullptr, [this](int32_t percent) {
+        FrontendScanMessage msg;
+        msg.set<FrontendScanMessage::Tag::progressPercent>(percent);
+        mCallback->onScanMessage(FrontendScanMessageType::PROGRESS_PERCENT, msg);
+    });
+    for (const auto& frontend : frontends) {
+        frontend->releaseFromScan();
+    }
+    ALOGI("[Frontend] blind scan of %d found %zu channels with %zu frontends in %" PRId64 " ms",
+          mId, found.size(), tuners.size(),
+          std::chrono::duration_cast<std::chrono::milliseconds>(engine->getStats().scanTime)
+                  .count());
+
+    mPendingScanFrequencies.clear();
+    for (const auto& channel : found) {
+        mPendingScanFrequencies.push_back(channel.frequency);
+    }
+    if (mPendingScanFrequencies.empty()) {
+        FrontendScanMessage msg;
+        msg.set<FrontendScanMessage::Tag::isEnd>(true);
+        mCallback->onScanMessage(FrontendScanMessageType::END, msg);
+        return;
+    }
+    reportNextScanFrequency();
+}
+
+void Frontend::reportNextScanFrequency() {
+    {
+        FrontendScanMessage msg;
+        vector<int64_t> frequencies = {mPendingScanFrequencies.front()};
+        msg.set<FrontendScanMessage::Tag::frequencies>(frequencies);
+        mCallback->onScanMessage(FrontendScanMessageType::FREQUENCY, msg);
+    }
+    mPendingScanFrequencies.pop_front();
+
+    {
+        FrontendScanMessage msg;
+        msg.set<FrontendScanMessage::Tag::isLocked>(true);
+        mCallback->onScanMessage(FrontendScanMessageType::LOCKED, msg);
+        mIsLocked = true;
+    }
+}
+
+int64_t Frontend::getScanStep() {
+    // The channel spacing of the band plans of each standard
+    switch (mType) {
+        case FrontendType::ATSC:
+        case FrontendType::ATSC3:
+        case FrontendType::ISDBT:
+        case FrontendType::ANALOG:
+            return 6 * 1000 * 1000;
+        case FrontendType::DVBT:
+        case FrontendType::DVBC:
+        case FrontendType::DTMB:
+            return 8 * 1000 * 1000;
+        default:
+            // Satellite transponders are searched in wider steps
+            return 20 * 1000 * 1000;
+    }
+}
+
 ::ndk::ScopedAStatus Frontend::stopScan() {
     ALOGV("%s", __FUNCTION__);
 
+    {
+        std::lock_guard<std::mutex> lock(mScanEngineLock);
+        if (mScanEngine != nullptr) {
+            mScanEngine->stop();
+        }
+    }
     if (mScanThread.joinable()) {
         mScanThread.join();
     }
 
+    mPendingScanFrequencies.clear();
     mIsLocked = false;
     return ::ndk::ScopedAStatus::ok();
 }
@@ -1014,6 +1158,12 @@ binder_status_t Frontend::dump(int fd, const char** /* args */, uint32_t /* numA
     dprintf(fd, "    mType: %d\n", mType);
     dprintf(fd, "    mIsLocked: %d\n", mIsLocked);
     dprintf(fd, "    mCiCamId: %d\n", mCiCamId);
+    {
+        std::lock_guard<std::mutex> lock(mScanEngineLock);
+        if (mScanEngine != nullptr) {
+            mScanEngine->dump(fd);
+        }
+    }
     dprintf(fd, "    mFrontendStatusCaps:");
     for (int i = 0; i < mFrontendStatusCaps.size(); i++) {
         dprintf(fd, "        %d\n", mFrontendStatusCaps[i]);
@@ -1074,6 +1224,10 @@ string Frontend::getIptvTransportDescription() {
     return mIptvTransportDescription;
 }
 
+string Frontend::getIptvContentUrl() {
+    return mIptvContentUrl;
+}
+
 dtv_streamer* Frontend::getIptvPluginStreamer() {
     return mIptvPluginStreamer;
 }
@@ -17,9 +17,13 @@
 #pragma once
 
 #include <aidl/android/hardware/tv/tuner/BnFrontend.h>
+#include <atomic>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <thread>
+#include "ScanEngine.h"
 #include "Tuner.h"
 #include "dtv_plugin.h"
 
@@ -63,9 +67,18 @@ class Frontend : public BnFrontend {
     string getSourceFile();
     dtv_plugin* getIptvPluginInterface();
     string getIptvTransportDescription();
+    string getIptvContentUrl();
     dtv_streamer* getIptvPluginStreamer();
     void readTuneByte(dtv_streamer* streamer, void* buf, size_t size, int timeout_ms);
     bool isLocked();
+    bool isScanning() { return mIsScanning; }
+    /**
+     * Reserves the frontend for the scan of another one.
+     *
+     * Return false if it is already scanning.
+     */
+    bool reserveForScan() { return !mIsScanning.exchange(true); }
+    void releaseFromScan() { mIsScanning = false; }
     void getFrontendInfo(FrontendInfo* _aidl_return);
     void setTunerService(std::shared_ptr<Tuner> tuner);
 
@@ -73,6 +86,11 @@ class Frontend : public BnFrontend {
     virtual ~Frontend();
     bool supportsSatellite();
     void scanThreadLoop();
+    // Scans from startFrequency to endFrequency with this frontend and the idle ones of its type
+    void blindScanThreadLoop(int64_t startFrequency, int64_t endFrequency);
+    int64_t getScanStep();
+    // Reports the next channel found by the blind scan, which then waits for the next scan()
+    void reportNextScanFrequency();
 
     std::shared_ptr<IFrontendCallback> mCallback;
     std::shared_ptr<Tuner> mTuner;
@@ -81,6 +99,12 @@ class Frontend : public BnFrontend {
     bool mIsLocked = false;
     int32_t mCiCamId;
     std::thread mScanThread;
+    std::atomic<bool> mIsScanning = false;
+    // The engine of the last blind scan over a frequency range, kept for the dump
+    std::unique_ptr<ScanEngine> mScanEngine;
+    std::mutex mScanEngineLock;
+    // The channels of the blind scan which are not reported yet
+    std::deque<int64_t> mPendingScanFrequencies;
     FrontendSettings mFrontendSettings;
     FrontendScanType mFrontendScanType;
     std::ifstream mFrontendData;
@@ -88,6 +112,7 @@ class Frontend : public BnFrontend {
     vector<FrontendStatusType> mFrontendStatusCaps;
     dtv_plugin* mIptvPluginInterface;
     string mIptvTransportDescription;
+    string mIptvContentUrl;
     dtv_streamer* mIptvPluginStreamer;
     std::thread mIptvFrontendTuneThread;
 };
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "android.hardware.tv.tuner-service.example-IptvIngest"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include "IptvIngest.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+namespace {
+
+constexpr uint8_t kTsSyncByte = 0x47;
+constexpr size_t kRtpHeaderSize = 12;
+// A sequence number this far behind the expected one means that the sender restarted
+constexpr int kRtpRestartDistance = 1000;
+// Absorbs the bursts of a stream of a few tens of Mbit/s while the thread is not scheduled
+constexpr int kSocketReceiveBufferSize = 4 * 1024 * 1024;
+
+}  // namespace
+
+std::unique_ptr<IptvIngest> IptvIngest::open(const std::string& uri, size_t batchSize) {
+    std::string address;
+    if (uri.starts_with("udp://") || uri.starts_with("rtp://")) {
+        address = uri.substr(6);
+    } else {
+        return nullptr;
+    }
+    if (address.starts_with("@")) {
+        address = address.substr(1);
+    }
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        return nullptr;
+    }
+    int port = atoi(address.c_str() + colon + 1);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (port <= 0 || port > 0xffff ||
+        inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr) != 1) {
+        return nullptr;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        ALOGE("[IptvIngest] Failed to create socket %d", errno);
+        return nullptr;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int bufferSize = kSocketReceiveBufferSize;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ALOGE("[IptvIngest] Failed to bind %s %d", uri.c_str(), errno);
+        ::close(fd);
+        return nullptr;
+    }
+    if (IN_MULTICAST(ntohl(addr.sin_addr.s_addr))) {
+        struct ip_mreq request = {};
+        request.imr_multiaddr = addr.sin_addr;
+        request.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) < 0) {
+            ALOGE("[IptvIngest] Failed to join %s %d", uri.c_str(), errno);
+            ::close(fd);
+            return nullptr;
+        }
+    }
+    return std::make_unique<IptvIngest>(fd, batchSize);
+}
+
+IptvIngest::IptvIngest(int fd, size_t batchSize)
+    : mFd(fd),
+      mBatchSize(batchSize),
+      mBuffers(batchSize * kMaxDatagramSize),
+      mMessages(batchSize),
+      mIovecs(batchSize),
+      mHeldPackets(kReorderSlots) {
+    for (size_t i = 0; i < mBatchSize; i++) {
+        mIovecs[i].iov_base = mBuffers.data() + i * kMaxDatagramSize;
+        mIovecs[i].iov_len = kMaxDatagramSize;
+        memset(&mMessages[i], 0, sizeof(mMessages[i]));
+        mMessages[i].msg_hdr.msg_iov = &mIovecs[i];
+        mMessages[i].msg_hdr.msg_iovlen = 1;
+    }
+    mOutput.reserve(mBatchSize + kReorderSlots);
+}
+
+IptvIngest::~IptvIngest() {
+    ::close(mFd);
+}
+
+ssize_t IptvIngest::receive(int timeoutMs, const Sink& sink) {
+    struct pollfd pollFd = {.fd = mFd, .events = POLLIN, .revents = 0};
+    int ready = poll(&pollFd, 1, timeoutMs);
+    if (ready <= 0) {
+        if (ready < 0 && errno != EINTR) {
+            ALOGE("[IptvIngest] Failed to poll socket %d", errno);
+            return -1;
+        }
+        return 0;
+    }
+
+    int count = recvmmsg(mFd, mMessages.data(), mBatchSize, MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        ALOGE("[IptvIngest] Failed to receive datagrams %d", errno);
+        return -1;
+    }
+
+    ssize_t bytes = 0;
+    for (int i = 0; i < count; i++) {
+        size_t length = mMessages[i].msg_len;
+        bytes += length;
+        if (mMessages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            mStats.truncatedDatagrams++;
+            continue;
+        }
+        processDatagram(std::span<const int8_t>(mBuffers.data() + i * kMaxDatagramSize, length),
+                        sink);
+    }
+    // The payloads point into the receive buffers, which the next batch overwrites
+    flush(sink);
+
+    mStats.batches++;
+    mStats.datagrams += count;
+    mStats.bytes += bytes;
+    return bytes;
+}
+
+void IptvIngest::processDatagram(std::span<const int8_t> datagram, const Sink& sink) {
+    if (datagram.empty()) {
+        return;
+    }
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(datagram.data());
+    if (bytes[0] == kTsSyncByte) {
+        // TS directly over UDP, without sequence numbers to reorder with
+        output(datagram);
+        return;
+    }
+
+    // RTP version 2 carrying MPEG-2 TS
+    size_t size = datagram.size();
+    if (size < kRtpHeaderSize || (bytes[0] >> 6) != 2 ||
+        (bytes[1] & 0x7f) != kRtpPayloadTypeMp2t) {
+        mStats.skippedDatagrams++;
+        return;
+    }
+    size_t headerSize = kRtpHeaderSize + 4 * (bytes[0] & 0x0f);
+    if (bytes[0] & 0x10) {
+        // The extension header is followed by its length in 32 bits words
+        if (headerSize + 4 > size) {
+            mStats.skippedDatagrams++;
+            return;
+        }
+        headerSize += 4 + 4 * (bytes[headerSize + 2] << 8 | bytes[headerSize + 3]);
+    }
+    size_t end = size;
+    if (bytes[0] & 0x20) {
+        // The last byte counts the padding bytes, itself included
+        end = bytes[size - 1] <= size ? size - bytes[size - 1] : 0;
+    }
+    if (headerSize >= end) {
+        mStats.skippedDatagrams++;
+        return;
+    }
+
+    uint16_t sequenceNumber = static_cast<uint16_t>(bytes[2] << 8 | bytes[3]);
+    uint32_t ssrc = static_cast<uint32_t>(bytes[8]) << 24 | static_cast<uint32_t>(bytes[9]) << 16 |
+                    static_cast<uint32_t>(bytes[10]) << 8 | bytes[11];
+    processRtp(sequenceNumber, ssrc, datagram.subspan(headerSize, end - headerSize), sink);
+}
+
+void IptvIngest::flush(const Sink& sink) {
+    if (mOutput.empty()) {
+        return;
+    }
+    size_t consumed = sink(mOutput);
+    for (size_t i = consumed; i < mOutput.size(); i++) {
+        mStats.droppedBytes += mOutput[i].size();
+    }
+    mOutput.clear();
+}
+
+void IptvIngest::dump(int fd) {
+    dprintf(fd,
+            "  IptvIngest: %" PRIu64 " datagrams in %" PRIu64 " batches, %" PRIu64
+            " bytes, %" PRIu64 " dropped bytes, %" PRIu64 " truncated, %" PRIu64 " skipped\n",
+            mStats.datagrams, mStats.batches, mStats.bytes, mStats.droppedBytes,
+            mStats.truncatedDatagrams, mStats.skippedDatagrams);
+    dprintf(fd, "  IptvIngest RTP: %" PRIu64 " lost, %" PRIu64 " reordered, %" PRIu64 " late\n",
+            mStats.rtpLost, mStats.rtpReordered, mStats.rtpLate);
+}
+
+void IptvIngest::processRtp(uint16_t sequenceNumber, uint32_t ssrc,
+                            std::span<const int8_t> payload, const Sink& sink) {
+    int16_t distance = static_cast<int16_t>(sequenceNumber - mNextSequenceNumber);
+    if (!mHasSequence || ssrc != mSsrc || distance < -kRtpRestartDistance) {
+        // A new sender, or the same one restarted: the held packets are still sent in order
+        resetSequence();
+        mHasSequence = true;
+        mSsrc = ssrc;
+        mNextSequenceNumber = sequenceNumber;
+        distance = 0;
+    }
+
+    if (distance < 0) {
+        mStats.rtpLate++;
+        return;
+    }
+    if (distance == 0) {
+        output(payload);
+        mNextSequenceNumber++;
+        releaseHeldPackets();
+        return;
+    }
+    if (static_cast<size_t>(distance) >= kReorderSlots) {
+        // Too far ahead to wait for the packets in between
+        while (mHeldCount > 0) {
+            skipToNextHeldPacket();
+        }
+        mStats.rtpLost += static_cast<uint16_t>(sequenceNumber - mNextSequenceNumber);
+        output(payload);
+        mNextSequenceNumber = sequenceNumber + 1;
+        return;
+    }
+
+    hold(sequenceNumber, payload, sink);
+    while (mHeldCount >= kMaxHeldPackets) {
+        skipToNextHeldPacket();
+    }
+}
+
+void IptvIngest::hold(uint16_t sequenceNumber, std::span<const int8_t> payload,
+                      const Sink& sink) {
+    HeldPacket& packet = mHeldPackets[sequenceNumber % kReorderSlots];
+    if (packet.isHeld) {
+        // Only the same packet can be there, as the held ones are less than kReorderSlots ahead
+        mStats.rtpLate++;
+        return;
+    }
+    // The queued payloads may point to this slot since its last packet was released
+    flush(sink);
+    memcpy(packet.data.data(), payload.data(), payload.size());
+    packet.isHeld = true;
+    packet.sequenceNumber = sequenceNumber;
+    packet.length = payload.size();
+    mHeldCount++;
+    mStats.rtpReordered++;
+}
+
+void IptvIngest::releaseHeldPackets() {
+    while (mHeldCount > 0) {
+        HeldPacket& packet = mHeldPackets[mNextSequenceNumber % kReorderSlots];
+        if (!packet.isHeld || packet.sequenceNumber != mNextSequenceNumber) {
+            return;
+        }
+        output(std::span<const int8_t>(packet.data.data(), packet.length));
+        packet.isHeld = false;
+        mHeldCount--;
+        mNextSequenceNumber++;
+    }
+}
+
+void IptvIngest::skipToNextHeldPacket() {
+    for (size_t skipped = 1; skipped < kReorderSlots; skipped++) {
+        uint16_t sequenceNumber = static_cast<uint16_t>(mNextSequenceNumber + skipped);
+        const HeldPacket& packet = mHeldPackets[sequenceNumber % kReorderSlots];
+        if (packet.isHeld && packet.sequenceNumber == sequenceNumber) {
+            mStats.rtpLost += skipped;
+            mNextSequenceNumber = sequenceNumber;
+            releaseHeldPackets();
+            return;
+        }
+    }
+}
+
+void IptvIngest::resetSequence() {
+    // The held packets are output, and the gaps before them counted as lost
+    while (mHeldCount > 0) {
+        skipToNextHeldPacket();
+    }
+    mHasSequence = false;
+}
+
+void IptvIngest::output(std::span<const int8_t> payload) {
+    mOutput.push_back(payload);
+}
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
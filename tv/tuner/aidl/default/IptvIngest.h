@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <array>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+/**
+ * Receives a transport stream sent over UDP or RTP, unicast or multicast.
+ *
+ * Datagrams are read in batches with recvmmsg(). RTP packets (RFC 3550) carrying MPEG-2 TS
+ * (RFC 2250) are put back in sequence order by a small reorder buffer, and a packet still missing
+ * after kMaxHeldPackets later ones is counted as lost. Packets of other payload types, such as
+ * SMPTE 2022-1 FEC sent on the same port, are skipped: losses are not repaired.
+ *
+ * The TS payloads of a batch are handed to the sink in order, as spans into the receive buffers,
+ * so that they are copied once into their destination.
+ */
+class IptvIngest {
+  public:
+    static constexpr size_t kDefaultBatchSize = 32;
+    // Larger than the usual MTU, and a whole number of TS packets after an RTP header
+    static constexpr size_t kMaxDatagramSize = 2048;
+    static constexpr size_t kReorderSlots = 64;
+    static constexpr size_t kMaxHeldPackets = 16;
+    static constexpr uint8_t kRtpPayloadTypeMp2t = 33;
+
+    struct Stats {
+        uint64_t batches;
+        uint64_t datagrams;
+        uint64_t bytes;
+        // Payload bytes the sink had no room for
+        uint64_t droppedBytes;
+        uint64_t truncatedDatagrams;
+        // Datagrams which are neither TS nor RTP carrying TS, FEC packets included
+        uint64_t skippedDatagrams;
+        uint64_t rtpLost;
+        uint64_t rtpReordered;
+        // Duplicates, and packets coming after their place was declared lost
+        uint64_t rtpLate;
+    };
+
+    /**
+     * Receives the TS payloads of consecutive datagrams, in order.
+     *
+     * Return the number of payloads consumed from the front, the others are dropped.
+     */
+    using Sink = std::function<size_t(std::span<const std::span<const int8_t>> payloads)>;
+
+    /**
+     * Opens a socket receiving the stream of a udp:// or rtp:// URI with an IPv4 address, like
+     * "udp://239.1.1.1:1234" or "rtp://@239.1.1.1:5000". The multicast group is joined.
+     *
+     * Return nullptr if the URI is not supported or the socket can't be bound.
+     */
+    static std::unique_ptr<IptvIngest> open(const std::string& uri,
+                                            size_t batchSize = kDefaultBatchSize);
+
+    // Takes ownership of a bound datagram socket
+    IptvIngest(int fd, size_t batchSize);
+    ~IptvIngest();
+
+    /**
+     * Waits up to timeoutMs for datagrams, and passes the payloads of the ones received to sink.
+     *
+     * Return the number of bytes received, 0 on timeout, or -1 on error.
+     */
+    ssize_t receive(int timeoutMs, const Sink& sink);
+
+    /**
+     * Queues the payload of a datagram for the sink, or holds it until the ones before it come.
+     * The datagram must stay valid until the next flush.
+     */
+    void processDatagram(std::span<const int8_t> datagram, const Sink& sink);
+    // Passes the queued payloads to the sink
+    void flush(const Sink& sink);
+
+    const Stats& getStats() const { return mStats; }
+    void dump(int fd);
+
+  private:
+    struct HeldPacket {
+        bool isHeld = false;
+        uint16_t sequenceNumber = 0;
+        size_t length = 0;
+        std::array<int8_t, kMaxDatagramSize> data;
+    };
+
+    void processRtp(uint16_t sequenceNumber, uint32_t ssrc, std::span<const int8_t> payload,
+                    const Sink& sink);
+    void hold(uint16_t sequenceNumber, std::span<const int8_t> payload, const Sink& sink);
+    // Outputs the held packets following mNextSequenceNumber
+    void releaseHeldPackets();
+    // Skips the missing packets up to the next held one
+    void skipToNextHeldPacket();
+    void resetSequence();
+    void output(std::span<const int8_t> payload);
+
+    int mFd;
+    size_t mBatchSize;
+    std::vector<int8_t> mBuffers;
+    std::vector<struct mmsghdr> mMessages;
+    std::vector<struct iovec> mIovecs;
+
+    // Payloads given to the sink on the next flush, which may point into mHeldPackets
+    std::vector<std::span<const int8_t>> mOutput;
+
+    bool mHasSequence = false;
+    uint16_t mNextSequenceNumber = 0;
+    uint32_t mSsrc = 0;
+    size_t mHeldCount = 0;
+    std::vector<HeldPacket> mHeldPackets;
+
+    Stats mStats = {};
+};
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
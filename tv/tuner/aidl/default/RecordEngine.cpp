@@ -0,0 +1,522 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/tv/tuner/DemuxScAvcIndex.h>
+#include <aidl/android/hardware/tv/tuner/DemuxScHevcIndex.h>
+#include <aidl/android/hardware/tv/tuner/DemuxScIndex.h>
+#include <aidl/android/hardware/tv/tuner/DemuxScVvcIndex.h>
+#include <aidl/android/hardware/tv/tuner/DemuxTsIndex.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "RecordEngine.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+namespace {
+
+constexpr size_t kTsPacketSize = 188;
+constexpr size_t kTsHeaderSize = 4;
+constexpr size_t kPesHeaderSize = 9;
+
+int32_t bit(DemuxTsIndex index) {
+    return static_cast<int32_t>(index);
+}
+
+// The DemuxTsIndex bits of the flags of the adaptation field, from the most significant one
+constexpr std::array<DemuxTsIndex, 8> kAdaptationFlagIndexes = {
+        DemuxTsIndex::DISCONTINUITY_INDICATOR, DemuxTsIndex::RANDOM_ACCESS_INDICATOR,
+        DemuxTsIndex::PRIORITY_INDICATOR,      DemuxTsIndex::PCR_FLAG,
+        DemuxTsIndex::OPCR_FLAG,               DemuxTsIndex::SPLICING_POINT_FLAG,
+        DemuxTsIndex::PRIVATE_DATA,            DemuxTsIndex::ADAPTATION_EXTENSION_FLAG,
+};
+
+int32_t getScramblingIndex(uint8_t scrambling) {
+    switch (scrambling) {
+        case 0:
+            return bit(DemuxTsIndex::CHANGE_TO_NOT_SCRAMBLED);
+        case 2:
+            return bit(DemuxTsIndex::CHANGE_TO_EVEN_SCRAMBLED);
+        case 3:
+            return bit(DemuxTsIndex::CHANGE_TO_ODD_SCRAMBLED);
+        default:
+            return 0;
+    }
+}
+
+// Reads an unsigned Exp-Golomb code, ignoring the emulation prevention bytes
+bool readUe(const uint8_t* data, size_t size, size_t* bitPosition, uint32_t* value) {
+    int leadingZeros = 0;
+    while (true) {
+        if (*bitPosition >= size * 8 || leadingZeros > 31) {
+            return false;
+        }
+        bool isOne = (data[*bitPosition / 8] >> (7 - *bitPosition % 8)) & 1;
+        (*bitPosition)++;
+        if (isOne) {
+            break;
+        }
+        leadingZeros++;
+    }
+    uint32_t suffix = 0;
+    for (int i = 0; i < leadingZeros; i++) {
+        if (*bitPosition >= size * 8) {
+            return false;
+        }
+        suffix = suffix << 1 | ((data[*bitPosition / 8] >> (7 - *bitPosition % 8)) & 1);
+        (*bitPosition)++;
+    }
+    *value = (1u << leadingZeros) - 1 + suffix;
+    return true;
+}
+
+int32_t getMpeg2Index(const uint8_t* header, size_t length) {
+    constexpr uint8_t kPictureStartCode = 0x00;
+    constexpr uint8_t kSequenceHeaderCode = 0xb3;
+    if (header[0] == kSequenceHeaderCode) {
+        return static_cast<int32_t>(DemuxScIndex::SEQUENCE);
+    }
+    if (header[0] != kPictureStartCode || length < 3) {
+        return 0;
+    }
+    switch ((header[2] >> 3) & 0x07) {
+        case 1:
+            return static_cast<int32_t>(DemuxScIndex::I_FRAME);
+        case 2:
+            return static_cast<int32_t>(DemuxScIndex::P_FRAME);
+        case 3:
+            return static_cast<int32_t>(DemuxScIndex::B_FRAME);
+        default:
+            return 0;
+    }
+}
+
+int32_t getAvcIndex(const uint8_t* header, size_t length, int32_t* firstMbInSlice) {
+    constexpr uint8_t kNonIdrSlice = 1;
+    constexpr uint8_t kIdrSlice = 5;
+    uint8_t type = header[0] & 0x1f;
+    if (type != kNonIdrSlice && type != kIdrSlice) {
+        return 0;
+    }
+    size_t bitPosition = 0;
+    uint32_t firstMb;
+    uint32_t sliceType;
+    if (!readUe(header + 1, length - 1, &bitPosition, &firstMb) ||
+        !readUe(header + 1, length - 1, &bitPosition, &sliceType)) {
+        return 0;
+    }
+    *firstMbInSlice = static_cast<int32_t>(firstMb);
+    constexpr std::array<DemuxScAvcIndex, 5> kSliceTypes = {
+            DemuxScAvcIndex::P_SLICE,  DemuxScAvcIndex::B_SLICE,  DemuxScAvcIndex::I_SLICE,
+            DemuxScAvcIndex::SP_SLICE, DemuxScAvcIndex::SI_SLICE,
+    };
+    return static_cast<int32_t>(kSliceTypes[sliceType % kSliceTypes.size()]);
+}
+
+int32_t getHevcIndex(const uint8_t* header) {
+    switch ((header[0] >> 1) & 0x3f) {
+        case 16:
+            return static_cast<int32_t>(DemuxScHevcIndex::SLICE_CE_BLA_W_LP);
+        case 17:
+            return static_cast<int32_t>(DemuxScHevcIndex::SLICE_BLA_W_RADL);
+        case 18:
+            return static_cast<int32_t>(DemuxScHevcIndex::SLICE_BLA_N_LP);
+        case 19:
+            return static_cast<int32_t>(DemuxScHevcIndex::SLICE_IDR_W_RADL);
+        case 20:
+            return static_cast<int32_t>(DemuxScHevcIndex::SLICE_IDR_N_LP);
+        case 21:
+            return static_cast<int32_t>(DemuxScHevcIndex::SLICE_TRAIL_CRA);
+        case 33:
+            return static_cast<int32_t>(DemuxScHevcIndex::SPS);
+        case 35:
+            return static_cast<int32_t>(DemuxScHevcIndex::AUD);
+        default:
+            return 0;
+    }
+}
+
+int32_t getVvcIndex(const uint8_t* header, size_t length) {
+    if (length < 2) {
+        return 0;
+    }
+    switch ((header[1] >> 3) & 0x1f) {
+        case 7:
+            return static_cast<int32_t>(DemuxScVvcIndex::SLICE_IDR_W_RADL);
+        case 8:
+            return static_cast<int32_t>(DemuxScVvcIndex::SLICE_IDR_N_LP);
+        case 9:
+            return static_cast<int32_t>(DemuxScVvcIndex::SLICE_CRA);
+        case 10:
+            return static_cast<int32_t>(DemuxScVvcIndex::SLICE_GDR);
+        case 14:
+            return static_cast<int32_t>(DemuxScVvcIndex::VPS);
+        case 15:
+            return static_cast<int32_t>(DemuxScVvcIndex::SPS);
+        case 20:
+            return static_cast<int32_t>(DemuxScVvcIndex::AUD);
+        default:
+            return 0;
+    }
+}
+
+}  // namespace
+
+RecordEngine::RecordEngine() {
+    mPidSlots.fill(-1);
+}
+
+void RecordEngine::setStreams(const std::vector<std::pair<int64_t, StreamSettings>>& streams) {
+    std::vector<Stream> oldStreams = std::move(mStreams);
+    mStreams.clear();
+    mPidSlots.fill(-1);
+    mPidStreams.clear();
+    for (const auto& [id, settings] : streams) {
+        auto it = std::find_if(oldStreams.begin(), oldStreams.end(), [&](const Stream& stream) {
+            return stream.id == id && stream.settings.pid == settings.pid;
+        });
+        // A stream still recorded keeps its state, the first packet is not indexed again
+        Stream stream;
+        if (it != oldStreams.end()) {
+            stream = *it;
+        }
+        stream.id = id;
+        stream.settings = settings;
+        uint16_t pid = settings.pid & 0x1fff;
+        if (mPidSlots[pid] < 0) {
+            mPidSlots[pid] = static_cast<int16_t>(mPidStreams.size());
+            mPidStreams.emplace_back();
+        }
+        mPidStreams[mPidSlots[pid]].push_back(mStreams.size());
+        mStreams.push_back(stream);
+    }
+}
+
+void RecordEngine::recordPacket(std::span<const int8_t> packet) {
+    if (packet.size() < kTsPacketSize) {
+        return;
+    }
+    uint16_t pid = ((packet[1] & 0x1f) << 8) | (packet[2] & 0xff);
+    int slot = mPidSlots[pid];
+    if (slot < 0) {
+        return;
+    }
+    uint64_t byteNumber = mStats.recordedBytes;
+    if (!append(packet.first(kTsPacketSize))) {
+        return;
+    }
+    for (size_t index : mPidStreams[slot]) {
+        indexPacket(mStreams[index], packet, byteNumber);
+    }
+}
+
+void RecordEngine::recordFrame(uint16_t pid, int64_t pts, std::span<const int8_t> frame) {
+    int slot = mPidSlots[pid & 0x1fff];
+    if (slot < 0) {
+        return;
+    }
+    uint64_t byteNumber = mStats.recordedBytes;
+    if (!append(frame)) {
+        return;
+    }
+    for (size_t index : mPidStreams[slot]) {
+        Stream& stream = mStreams[index];
+        stream.pts = pts;
+        addEntry({
+                .streamId = stream.id,
+                .pid = pid,
+                .tsIndexMask = bit(DemuxTsIndex::PAYLOAD_UNIT_START_INDICATOR) &
+                               stream.settings.tsIndexMask,
+                .scIndexMask = 0,
+                .byteNumber = byteNumber,
+                .pts = pts,
+                .firstMbInSlice = 0,
+        });
+    }
+}
+
+size_t RecordEngine::getAvailableSpace() const {
+    size_t pending = mStats.recordedBytes - mStats.writtenBytes;
+    return kMaxChunks * kChunkSize > pending ? kMaxChunks * kChunkSize - pending : 0;
+}
+
+void RecordEngine::write(const Writer& writer, const IndexSink& sink, bool isFlush) {
+    Clock::time_point now = Clock::now();
+    while (!mChunks.empty()) {
+        Chunk& chunk = mChunks.front();
+        bool isFull = chunk.data.size() == kChunkSize;
+        size_t pending = chunk.data.size() - chunk.written;
+        if (pending == 0 ||
+            (!isFull && !isFlush && now - chunk.pendingSince < kMaxChunkDelay)) {
+            break;
+        }
+        size_t written = writer(std::span<const int8_t>(chunk.data).subspan(chunk.written));
+        chunk.written += written;
+        mStats.writtenBytes += written;
+        mStats.writes++;
+        if (written < pending) {
+            mStats.stalledWrites++;
+            chunk.pendingSince = now;
+            break;
+        }
+        if (!isFull) {
+            // More data goes to the last chunk
+            break;
+        }
+        mFreeBuffers.push_back(std::move(chunk.data));
+        mChunks.pop_front();
+    }
+
+    while (!mIndex.empty() && mIndex.front().byteNumber < mStats.writtenBytes) {
+        sink(mIndex.front());
+        mIndex.pop_front();
+    }
+}
+
+void RecordEngine::clear() {
+    for (Chunk& chunk : mChunks) {
+        mFreeBuffers.push_back(std::move(chunk.data));
+    }
+    mChunks.clear();
+    mIndex.clear();
+    mStats.writtenBytes = mStats.recordedBytes;
+}
+
+void RecordEngine::dump(int fd) {
+    dprintf(fd,
+            "      RecordEngine: %zu streams, recorded %" PRIu64 " bytes, written %" PRIu64
+            " bytes in %" PRIu64 " writes (%" PRIu64 " stalled), %" PRIu64
+            " index entries, dropped %" PRIu64 " bytes\n",
+            mStreams.size(), mStats.recordedBytes, mStats.writtenBytes, mStats.writes,
+            mStats.stalledWrites, mStats.indexEntries, mStats.droppedBytes);
+}
+
+bool RecordEngine::append(std::span<const int8_t> data) {
+    if (data.size() > getAvailableSpace()) {
+        mStats.droppedBytes += data.size();
+        return false;
+    }
+    while (!data.empty()) {
+        if (mChunks.empty() || mChunks.back().data.size() == kChunkSize) {
+            Chunk chunk;
+            if (!mFreeBuffers.empty()) {
+                chunk.data = std::move(mFreeBuffers.back());
+                mFreeBuffers.pop_back();
+                chunk.data.clear();
+            } else {
+                chunk.data.reserve(kChunkSize);
+            }
+            mChunks.push_back(std::move(chunk));
+        }
+        Chunk& chunk = mChunks.back();
+        if (chunk.written == chunk.data.size()) {
+            chunk.pendingSince = Clock::now();
+        }
+        size_t length = std::min(data.size(), kChunkSize - chunk.data.size());
+        chunk.data.insert(chunk.data.end(), data.begin(), data.begin() + length);
+        data = data.subspan(length);
+        mStats.recordedBytes += length;
+    }
+    return true;
+}
+
+void RecordEngine::indexPacket(Stream& stream, std::span<const int8_t> packet,
+                               uint64_t byteNumber) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(packet.data());
+    IndexEntry entry = {
+            .streamId = stream.id,
+            .pid = stream.settings.pid,
+            .tsIndexMask = 0,
+            .scIndexMask = 0,
+            .byteNumber = byteNumber,
+            .pts = stream.pts,
+            .firstMbInSlice = 0,
+    };
+
+    int32_t tsIndex = 0;
+    if (stream.isFirstPacket) {
+        tsIndex |= bit(DemuxTsIndex::FIRST_PACKET);
+        stream.isFirstPacket = false;
+    }
+    bool isUnitStart = (bytes[1] & 0x40) != 0;
+    if (isUnitStart) {
+        tsIndex |= bit(DemuxTsIndex::PAYLOAD_UNIT_START_INDICATOR);
+    }
+    uint8_t scrambling = bytes[3] >> 6;
+    if (scrambling != stream.scrambling) {
+        tsIndex |= getScramblingIndex(scrambling);
+        stream.scrambling = scrambling;
+    }
+    uint8_t adaptationFieldControl = (bytes[3] >> 4) & 0x03;
+    size_t payloadOffset = kTsHeaderSize;
+    if (adaptationFieldControl & 0x02) {
+        uint8_t adaptationFieldLength = bytes[4];
+        if (adaptationFieldLength > 0) {
+            for (size_t i = 0; i < kAdaptationFlagIndexes.size(); i++) {
+                if (bytes[5] & (0x80 >> i)) {
+                    tsIndex |= bit(kAdaptationFlagIndexes[i]);
+                }
+            }
+        }
+        payloadOffset += 1 + adaptationFieldLength;
+    }
+    entry.tsIndexMask = tsIndex & stream.settings.tsIndexMask;
+
+    // The start codes can't be found in scrambled payloads
+    if (stream.settings.scIndexType != DemuxRecordScIndexType::NONE &&
+        (adaptationFieldControl & 0x01) && payloadOffset < kTsPacketSize && scrambling == 0) {
+        const uint8_t* payload = bytes + payloadOffset;
+        size_t size = kTsPacketSize - payloadOffset;
+        if (isUnitStart && size >= kPesHeaderSize && payload[0] == 0 && payload[1] == 0 &&
+            payload[2] == 1) {
+            // The PES header is skipped, so that only the start codes of the ES are indexed
+            if (stream.isInStartCode) {
+                endStartCode(stream, &entry);
+            }
+            stream.zeroCount = 0;
+            size_t esOffset = kPesHeaderSize + payload[8];
+            if ((payload[7] & 0x80) && size >= 14) {
+                stream.pts = static_cast<int64_t>(payload[9] & 0x0e) << 29 |
+                             static_cast<int64_t>(payload[10]) << 22 |
+                             static_cast<int64_t>(payload[11] & 0xfe) << 14 |
+                             static_cast<int64_t>(payload[12]) << 7 | payload[13] >> 1;
+                entry.pts = stream.pts;
+            }
+            payload += std::min(esOffset, size);
+            size -= std::min(esOffset, size);
+        }
+        scanPayload(stream, payload, size, byteNumber, &entry);
+        entry.scIndexMask &= stream.settings.scIndexMask;
+    }
+
+    if (entry.tsIndexMask != 0 || entry.scIndexMask != 0) {
+        addEntry(entry);
+    }
+}
+
+void RecordEngine::scanPayload(Stream& stream, const uint8_t* payload, size_t size,
+                               uint64_t byteNumber, IndexEntry* entry) {
+    if (stream.isInStartCode) {
+        // The header of a start code at the end of the previous packet continues here
+        size_t length = std::min(kStartCodeHeaderSize - stream.startCodeHeaderLength, size);
+        memcpy(stream.startCodeHeader.data() + stream.startCodeHeaderLength, payload, length);
+        stream.startCodeHeaderLength += length;
+        if (stream.startCodeHeaderLength == kStartCodeHeaderSize) {
+            endStartCode(stream, entry);
+        }
+    }
+
+    size_t offset = 0;
+    while (offset < size) {
+        // Start codes are found by their 0x01 byte, which is rare in the compressed data
+        const uint8_t* one =
+                static_cast<const uint8_t*>(memchr(payload + offset, 0x01, size - offset));
+        if (one == nullptr) {
+            break;
+        }
+        size_t position = one - payload;
+        // The zero bytes of the prefix may be at the end of the previous packet
+        size_t zeroCount = 0;
+        while (zeroCount < 2 && zeroCount < position && payload[position - zeroCount - 1] == 0) {
+            zeroCount++;
+        }
+        bool isStartCode =
+                zeroCount == 2 || (zeroCount == position && zeroCount + stream.zeroCount >= 2);
+        if (isStartCode) {
+            if (stream.isInStartCode) {
+                endStartCode(stream, entry);
+            }
+            stream.isInStartCode = true;
+            stream.startCodeByteNumber = byteNumber;
+            stream.startCodeHeaderLength = std::min(kStartCodeHeaderSize, size - position - 1);
+            memcpy(stream.startCodeHeader.data(), one + 1, stream.startCodeHeaderLength);
+            if (stream.startCodeHeaderLength == kStartCodeHeaderSize) {
+                endStartCode(stream, entry);
+            }
+        }
+        offset = position + 1;
+    }
+
+    if (size >= 2) {
+        stream.zeroCount = payload[size - 1] != 0 ? 0 : payload[size - 2] != 0 ? 1 : 2;
+    } else if (size == 1) {
+        stream.zeroCount = payload[0] != 0 ? 0 : std::min(stream.zeroCount + 1, 2);
+    }
+}
+
+void RecordEngine::endStartCode(Stream& stream, IndexEntry* entry) {
+    stream.isInStartCode = false;
+    const uint8_t* header = stream.startCodeHeader.data();
+    size_t length = stream.startCodeHeaderLength;
+    if (length == 0) {
+        return;
+    }
+    int32_t firstMbInSlice = 0;
+    int32_t scIndex = 0;
+    switch (stream.settings.scIndexType) {
+        case DemuxRecordScIndexType::SC:
+            scIndex = getMpeg2Index(header, length);
+            break;
+        case DemuxRecordScIndexType::SC_AVC:
+            scIndex = getAvcIndex(header, length, &firstMbInSlice);
+            break;
+        case DemuxRecordScIndexType::SC_HEVC:
+            scIndex = getHevcIndex(header);
+            break;
+        case DemuxRecordScIndexType::SC_VVC:
+            scIndex = getVvcIndex(header, length);
+            break;
+        default:
+            break;
+    }
+    scIndex &= stream.settings.scIndexMask;
+    if (scIndex == 0) {
+        return;
+    }
+    if (stream.startCodeByteNumber == entry->byteNumber) {
+        entry->scIndexMask |= scIndex;
+        entry->firstMbInSlice = firstMbInSlice;
+        return;
+    }
+    // The start code began in an earlier packet, which gets its own entry
+    addEntry({
+            .streamId = stream.id,
+            .pid = stream.settings.pid,
+            .tsIndexMask = 0,
+            .scIndexMask = scIndex,
+            .byteNumber = stream.startCodeByteNumber,
+            .pts = stream.pts,
+            .firstMbInSlice = firstMbInSlice,
+    });
+}
+
+void RecordEngine::addEntry(const IndexEntry& entry) {
+    mIndex.push_back(entry);
+    mStats.indexEntries++;
+}
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/tv/tuner/DemuxRecordScIndexType.h>
+
+#include <stdint.h>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+/**
+ * Records the TS packets of the PIDs selected by the record filters of a DVR, and indexes them in
+ * the same pass.
+ *
+ * The recorded packets are coalesced into chunks of kChunkSize bytes, which are written out whole
+ * unless the data has been waiting for kMaxChunkDelay. At most kMaxChunks are held: when the
+ * consumer is slow, getAvailableSpace() goes down to 0 and the producer must wait rather than
+ * the data being dropped.
+ *
+ * The index entries of a stream carry the DemuxTsIndex bits of the TS header and adaptation field
+ * of its packets, and the start code bits of the DemuxScIndex, DemuxScAvcIndex, DemuxScHevcIndex or
+ * DemuxScVvcIndex masks found in their payload. They are released once their packet is written.
+ */
+class RecordEngine {
+  public:
+    // 1024 TS packets, which is also 47 pages of 4KB
+    static constexpr size_t kChunkSize = 1024 * 188;
+    static constexpr size_t kMaxChunks = 4;
+    static constexpr std::chrono::milliseconds kMaxChunkDelay{20};
+    static constexpr int64_t kNoPts = -1;
+
+    struct StreamSettings {
+        uint16_t pid;
+        int32_t tsIndexMask;
+        DemuxRecordScIndexType scIndexType;
+        int32_t scIndexMask;
+    };
+
+    struct IndexEntry {
+        int64_t streamId;
+        uint16_t pid;
+        int32_t tsIndexMask;
+        int32_t scIndexMask;
+        // Offset of the indexed packet in the recorded data
+        uint64_t byteNumber;
+        // The last PTS of the stream, or kNoPts
+        int64_t pts;
+        int32_t firstMbInSlice;
+    };
+
+    struct Stats {
+        uint64_t recordedBytes;
+        uint64_t writtenBytes;
+        uint64_t writes;
+        // Writes the consumer took only part of, because it was full
+        uint64_t stalledWrites;
+        uint64_t indexEntries;
+        // Recorded while getAvailableSpace() was 0
+        uint64_t droppedBytes;
+    };
+
+    /**
+     * Writes data to the consumer.
+     *
+     * Return the number of bytes written from the front, which is less than the size of data when
+     * the consumer is full.
+     */
+    using Writer = std::function<size_t(std::span<const int8_t> data)>;
+    using IndexSink = std::function<void(const IndexEntry& entry)>;
+
+    RecordEngine();
+
+    // Replaces the recorded streams, keyed by an id such as the filter id
+    void setStreams(const std::vector<std::pair<int64_t, StreamSettings>>& streams);
+    bool hasStreams() const { return !mStreams.empty(); }
+
+    // Records a 188 bytes TS packet if a stream selects its PID
+    void recordPacket(std::span<const int8_t> packet);
+    // Records an ES frame of a stream, which is indexed by its PTS only
+    void recordFrame(uint16_t pid, int64_t pts, std::span<const int8_t> frame);
+
+    // Bytes which can be recorded before the consumer has to catch up
+    size_t getAvailableSpace() const;
+    bool hasPendingData() const { return mStats.recordedBytes > mStats.writtenBytes; }
+
+    /**
+     * Writes the complete chunks, and the last one when its data is kMaxChunkDelay old or isFlush,
+     * then passes the index entries of the written data to sink.
+     */
+    void write(const Writer& writer, const IndexSink& sink, bool isFlush);
+    // Drops the pending data and index entries
+    void clear();
+
+    const Stats& getStats() const { return mStats; }
+    void dump(int fd);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t kStartCodeHeaderSize = 8;
+
+    struct Stream {
+        int64_t id = 0;
+        StreamSettings settings = {};
+        bool isFirstPacket = true;
+        uint8_t scrambling = 0;
+        int64_t pts = kNoPts;
+        // Zero bytes at the end of the payload so far, up to 2, for the start codes across packets
+        uint8_t zeroCount = 0;
+        // The bytes following the last start code, until kStartCodeHeaderSize are known
+        bool isInStartCode = false;
+        uint64_t startCodeByteNumber = 0;
+        size_t startCodeHeaderLength = 0;
+        std::array<uint8_t, kStartCodeHeaderSize> startCodeHeader = {};
+    };
+
+    struct Chunk {
+        std::vector<int8_t> data;
+        size_t written = 0;
+        // When the oldest data not written yet was recorded
+        Clock::time_point pendingSince;
+    };
+
+    bool append(std::span<const int8_t> data);
+    void indexPacket(Stream& stream, std::span<const int8_t> packet, uint64_t byteNumber);
+    void scanPayload(Stream& stream, const uint8_t* payload, size_t size, uint64_t byteNumber,
+                     IndexEntry* entry);
+    // Indexes the start code of the header collected so far
+    void endStartCode(Stream& stream, IndexEntry* entry);
+    void addEntry(const IndexEntry& entry);
+
+    std::vector<Stream> mStreams;
+    // Index in mPidStreams for each PID, -1 if none records it
+    std::array<int16_t, 0x2000> mPidSlots;
+    std::vector<std::vector<size_t>> mPidStreams;
+
+    std::deque<Chunk> mChunks;
+    std::vector<std::vector<int8_t>> mFreeBuffers;
+    std::deque<IndexEntry> mIndex;
+
+    Stats mStats = {};
+};
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
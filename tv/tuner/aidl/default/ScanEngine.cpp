@@ -0,0 +1,262 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "android.hardware.tv.tuner-service.example-ScanEngine"
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utils/Log.h>
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#include "ScanEngine.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+namespace {
+
+constexpr size_t kTsPacketSize = 188;
+// Packets checked for the sync byte when locking on a TS file
+constexpr size_t kSyncPacketCount = 3;
+
+// Return true if the file starts with kSyncPacketCount synchronized TS packets
+bool isTsFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char packets[kTsPacketSize * kSyncPacketCount];
+    if (!file.read(packets, sizeof(packets))) {
+        return false;
+    }
+    for (size_t i = 0; i < kSyncPacketCount; i++) {
+        if (packets[i * kTsPacketSize] != 0x47) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+VirtualScanTuner::VirtualScanTuner(int32_t id, std::map<int64_t, std::string> channels,
+                                   Timing timing)
+    : mId(id), mChannels(std::move(channels)), mTiming(timing) {}
+
+std::map<int64_t, std::string> VirtualScanTuner::loadChannels(const std::string& directory) {
+    std::map<int64_t, std::string> channels;
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return channels;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        char* end = nullptr;
+        int64_t frequency = strtoll(entry->d_name, &end, 10);
+        if (frequency > 0 && end != nullptr && strcmp(end, ".ts") == 0) {
+            channels[frequency] = directory + "/" + entry->d_name;
+        }
+    }
+    closedir(dir);
+    return channels;
+}
+
+bool VirtualScanTuner::hasSignal(int64_t startFrequency, int64_t endFrequency) {
+    std::this_thread::sleep_for(mTiming.probeTime);
+    auto it = mChannels.lower_bound(startFrequency);
+    return it != mChannels.end() && it->first < endFrequency;
+}
+
+bool VirtualScanTuner::tryLock(int64_t frequency, int64_t searchRange,
+                               std::chrono::milliseconds timeout, int64_t* lockedFrequency) {
+    auto it = mChannels.lower_bound(frequency - searchRange / 2);
+    if (it == mChannels.end() || it->first >= frequency - searchRange / 2 + searchRange ||
+        (!it->second.empty() && !isTsFile(it->second))) {
+        std::this_thread::sleep_for(timeout);
+        return false;
+    }
+    std::this_thread::sleep_for(std::min(mTiming.lockTime, timeout));
+    *lockedFrequency = it->first;
+    return true;
+}
+
+ScanEngine::ScanEngine(std::vector<std::shared_ptr<ScanTuner>> tuners)
+    : mTuners(std::move(tuners)) {}
+
+std::vector<ScanEngine::Channel> ScanEngine::scan(const Settings& settings,
+                                                  const OnChannel& onChannel,
+                                                  const OnProgress& onProgress) {
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mSegments.clear();
+        // The bands come from the client, so their size is bounded before they are split
+        size_t frequencyCount = 0;
+        bool truncated = false;
+        for (const Band& band : settings.bands) {
+            if (band.step <= 0 || band.startFrequency < 0 ||
+                band.endFrequency > INT64_MAX - band.step) {
+                ALOGW("[ScanEngine] Invalid band from %" PRId64 " to %" PRId64 " by %" PRId64,
+                      band.startFrequency, band.endFrequency, band.step);
+                continue;
+            }
+            for (int64_t frequency = band.startFrequency; frequency <= band.endFrequency;
+                 frequency += band.step) {
+                if (frequencyCount == kMaxFrequencies) {
+                    truncated = true;
+                    break;
+                }
+                frequencyCount++;
+                int64_t searchStart = frequency - band.step / 2;
+                if (mSegments.empty() || mSegments.back().frequencies.size() == kSegmentSize ||
+                    mSegments.back().step != band.step ||
+                    mSegments.back().endFrequency != searchStart) {
+                    mSegments.push_back({searchStart, searchStart, band.step, {}});
+                }
+                mSegments.back().frequencies.push_back(frequency);
+                mSegments.back().endFrequency = searchStart + band.step;
+                if (band.endFrequency - frequency < band.step) {
+                    break;
+                }
+            }
+        }
+        if (truncated) {
+            ALOGW("[ScanEngine] Scanning only the first %zu frequencies", kMaxFrequencies);
+        }
+        mNextSegment = 0;
+        mScannedSegments = 0;
+        mChannels.clear();
+        mStats = {};
+        for (const auto& tuner : mTuners) {
+            mStats.tuners.push_back({tuner->getId(), std::chrono::nanoseconds(0), 0, 0});
+        }
+    }
+    mIsStopped = false;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < mTuners.size(); i++) {
+        threads.emplace_back(&ScanEngine::scanSegments, this, i, std::cref(settings),
+                             std::cref(onChannel), std::cref(onProgress));
+    }
+    // The calling thread scans with the first frontend
+    if (!mTuners.empty()) {
+        scanSegments(0, settings, onChannel, onProgress);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    mStats.scanTime = std::chrono::steady_clock::now() - start;
+    std::sort(mChannels.begin(), mChannels.end(),
+              [](const Channel& a, const Channel& b) { return a.frequency < b.frequency; });
+    return mChannels;
+}
+
+void ScanEngine::stop() {
+    mIsStopped = true;
+}
+
+ScanEngine::Stats ScanEngine::getStats() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mStats;
+}
+
+void ScanEngine::dump(int fd) {
+    std::lock_guard<std::mutex> lock(mLock);
+    double scanSeconds = std::chrono::duration<double>(mStats.scanTime).count();
+    dprintf(fd,
+            "    ScanEngine: %zu channels in %.3f s, %" PRIu64 " frequencies, %" PRIu64
+            " skipped\n",
+            mChannels.size(), scanSeconds, mStats.frequencies, mStats.skippedFrequencies);
+    for (const TunerStats& tuner : mStats.tuners) {
+        double busySeconds = std::chrono::duration<double>(tuner.busyTime).count();
+        dprintf(fd,
+                "      Frontend %d: %" PRIu64 " lock attempts, %" PRIu64
+                " locks, %.1f%% utilization\n",
+                tuner.tunerId, tuner.lockAttempts, tuner.locks,
+                scanSeconds > 0 ? 100.0 * busySeconds / scanSeconds : 0.0);
+    }
+}
+
+void ScanEngine::scanSegments(size_t tunerIndex, const Settings& settings,
+                              const OnChannel& onChannel, const OnProgress& onProgress) {
+    ScanTuner& tuner = *mTuners[tunerIndex];
+    while (!isDone(settings)) {
+        size_t index = mNextSegment++;
+        if (index >= mSegments.size()) {
+            return;
+        }
+        const Segment& segment = mSegments[index];
+        auto busyStart = std::chrono::steady_clock::now();
+        bool hasSignal = tuner.hasSignal(segment.startFrequency, segment.endFrequency);
+        uint64_t lockAttempts = 0;
+        for (size_t i = 0; hasSignal && i < segment.frequencies.size() && !isDone(settings);
+             i++) {
+            int64_t frequency = 0;
+            lockAttempts++;
+            if (!tuner.tryLock(segment.frequencies[i], segment.step, settings.lockTimeout,
+                               &frequency)) {
+                continue;
+            }
+            Channel channel = {.frequency = frequency, .tunerId = tuner.getId()};
+            std::lock_guard<std::mutex> lock(mLock);
+            if (settings.maxChannels > 0 && mChannels.size() >= settings.maxChannels) {
+                break;
+            }
+            mChannels.push_back(channel);
+            mStats.tuners[tunerIndex].locks++;
+            if (onChannel) {
+                onChannel(channel);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mLock);
+        TunerStats& stats = mStats.tuners[tunerIndex];
+        stats.busyTime += std::chrono::steady_clock::now() - busyStart;
+        stats.lockAttempts += lockAttempts;
+        mStats.frequencies += segment.frequencies.size();
+        if (!hasSignal) {
+            mStats.skippedFrequencies += segment.frequencies.size();
+        }
+        mScannedSegments++;
+        if (onProgress) {
+            onProgress(static_cast<int32_t>(100 * mScannedSegments / mSegments.size()));
+        }
+    }
+}
+
+bool ScanEngine::isDone(const Settings& settings) {
+    if (mIsStopped) {
+        return true;
+    }
+    if (settings.maxChannels == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    return mChannels.size() >= settings.maxChannels;
+}
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+/**
+ * A frontend taking part in a scan. Its methods are called from the scan thread of the frontend
+ * only.
+ */
+class ScanTuner {
+  public:
+    virtual ~ScanTuner() = default;
+
+    virtual int32_t getId() = 0;
+    /**
+     * Measures the signal power from startFrequency up to endFrequency excluded, which is much
+     * quicker than a lock attempt on each channel there.
+     *
+     * Return false if there is no signal. A tuner which can't measure it returns true.
+     */
+    virtual bool hasSignal(int64_t startFrequency, int64_t endFrequency) = 0;
+    /**
+     * Searches a signal within searchRange centered on frequency, as a blind scan does, and sets
+     * lockedFrequency to its center.
+     *
+     * Return true if the frontend locks on one before the timeout.
+     */
+    virtual bool tryLock(int64_t frequency, int64_t searchRange,
+                         std::chrono::milliseconds timeout, int64_t* lockedFrequency) = 0;
+};
+
+/**
+ * A frontend whose channels are TS files, for scanning without RF input.
+ *
+ * A channel locks after lockTime if its file starts with synchronized TS packets, or right away if
+ * it has no file. The other frequencies take the whole timeout to fail, as on a real frontend.
+ */
+class VirtualScanTuner : public ScanTuner {
+  public:
+    struct Timing {
+        std::chrono::milliseconds lockTime;
+        std::chrono::milliseconds probeTime;
+    };
+
+    VirtualScanTuner(int32_t id, std::map<int64_t, std::string> channels, Timing timing);
+
+    /**
+     * Reads the channels of a directory, whose files are named after their frequency in Hz such
+     * as 474000000.ts.
+     */
+    static std::map<int64_t, std::string> loadChannels(const std::string& directory);
+
+    int32_t getId() override { return mId; }
+    bool hasSignal(int64_t startFrequency, int64_t endFrequency) override;
+    bool tryLock(int64_t frequency, int64_t searchRange, std::chrono::milliseconds timeout,
+                 int64_t* lockedFrequency) override;
+
+  private:
+    int32_t mId;
+    std::map<int64_t, std::string> mChannels;
+    Timing mTiming;
+};
+
+/**
+ * Scans a frequency plan with several frontends at once.
+ *
+ * The plan is split into segments of kSegmentSize frequencies, which the frontends take in turn
+ * from a shared queue so that a frontend which skips an empty segment moves on to the next one
+ * instead of idling. The signal power of a segment is measured first and the lock attempts are
+ * made only if there is some. The channels found are merged in frequency order.
+ */
+class ScanEngine {
+  public:
+    static constexpr size_t kSegmentSize = 4;
+    // Frequencies scanned at most, far more than the channels of any band plan. The frequencies
+    // of the bands past this are not scanned.
+    static constexpr size_t kMaxFrequencies = 16384;
+
+    /**
+     * A range of a channel plan, searched in steps from startFrequency to endFrequency included.
+     * Each lock attempt searches the step around its frequency. A band with a negative start
+     * frequency or a step which is not positive is not scanned.
+     */
+    struct Band {
+        int64_t startFrequency;
+        int64_t endFrequency;
+        int64_t step;
+    };
+
+    struct Settings {
+        std::vector<Band> bands;
+        std::chrono::milliseconds lockTimeout{100};
+        // Ends the scan once this many channels are found, 0 for no limit
+        size_t maxChannels = 0;
+    };
+
+    struct Channel {
+        // The center frequency the frontend locked on
+        int64_t frequency;
+        int32_t tunerId;
+    };
+
+    struct TunerStats {
+        int32_t tunerId;
+        // Time spent in hasSignal() and tryLock()
+        std::chrono::nanoseconds busyTime;
+        uint64_t lockAttempts;
+        uint64_t locks;
+    };
+
+    struct Stats {
+        std::chrono::nanoseconds scanTime;
+        uint64_t frequencies;
+        // Frequencies of the segments without signal, which had no lock attempt
+        uint64_t skippedFrequencies;
+        std::vector<TunerStats> tuners;
+    };
+
+    // Called for each channel as it is found, and with the progress in percent
+    using OnChannel = std::function<void(const Channel& channel)>;
+    using OnProgress = std::function<void(int32_t percent)>;
+
+    explicit ScanEngine(std::vector<std::shared_ptr<ScanTuner>> tuners);
+
+    /**
+     * Scans the plan with one thread per frontend, and returns once it is done or stop() is
+     * called. The callbacks are serialized.
+     *
+     * Return the channels found, in frequency order.
+     */
+    std::vector<Channel> scan(const Settings& settings, const OnChannel& onChannel,
+                              const OnProgress& onProgress);
+    // Makes scan() return after the lock attempts in progress
+    void stop();
+
+    Stats getStats();
+    void dump(int fd);
+
+  private:
+    struct Segment {
+        // The range the lock attempts search, endFrequency excluded
+        int64_t startFrequency;
+        int64_t endFrequency;
+        int64_t step;
+        std::vector<int64_t> frequencies;
+    };
+
+    void scanSegments(size_t tunerIndex, const Settings& settings, const OnChannel& onChannel,
+                      const OnProgress& onProgress);
+    bool isDone(const Settings& settings);
+
+    std::vector<std::shared_ptr<ScanTuner>> mTuners;
+    std::atomic<bool> mIsStopped = false;
+
+    std::vector<Segment> mSegments;
+    std::atomic<size_t> mNextSegment = 0;
+
+    // Protects the results and the stats, and serializes the callbacks
+    std::mutex mLock;
+    std::vector<Channel> mChannels;
+    size_t mScannedSegments = 0;
+    Stats mStats = {};
+};
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+
+#include "SectionEngine.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+namespace {
+
+constexpr uint32_t kCrc32Polynomial = 0x04c11db7;
+
+// kCrc32Tables[k][b] is the CRC of the byte b followed by k zero bytes
+using Crc32Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Crc32Tables makeCrc32Tables() {
+    Crc32Tables tables = {};
+    for (uint32_t b = 0; b < 256; b++) {
+        uint32_t crc = b << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ kCrc32Polynomial : crc << 1;
+        }
+        tables[0][b] = crc;
+    }
+    for (size_t k = 1; k < tables.size(); k++) {
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t previous = tables[k - 1][b];
+            tables[k][b] = (previous << 8) ^ tables[0][previous >> 24];
+        }
+    }
+    return tables;
+}
+
+constexpr Crc32Tables kCrc32Tables = makeCrc32Tables();
+
+// The DVB time_offset_section has a CRC_32 despite its short header
+constexpr uint8_t kTimeOffsetTableId = 0x73;
+
+// The bytes of the section bits are compared to the section without its section_length
+size_t getSectionBitsOffset(size_t index) {
+    return index == 0 ? 0 : index + 2;
+}
+
+}  // namespace
+
+uint32_t crc32Mpeg2(std::span<const int8_t> data, uint32_t crc) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    size_t size = data.size();
+    const auto& t = kCrc32Tables;
+    while (size >= 8) {
+        crc ^= static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 |
+               static_cast<uint32_t>(bytes[2]) << 8 | bytes[3];
+        crc = t[7][crc >> 24] ^ t[6][(crc >> 16) & 0xff] ^ t[5][(crc >> 8) & 0xff] ^
+              t[4][crc & 0xff] ^ t[3][bytes[4]] ^ t[2][bytes[5]] ^ t[1][bytes[6]] ^ t[0][bytes[7]];
+        bytes += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc << 8) ^ t[0][(crc >> 24) ^ *bytes++];
+    }
+    return crc;
+}
+
+bool SectionHeader::parse(std::span<const int8_t> section, SectionHeader* header) {
+    if (section.size() < kShortHeaderSize) {
+        return false;
+    }
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(section.data());
+    header->tableId = bytes[0];
+    header->hasSyntax = (bytes[1] & 0x80) != 0;
+    if (!header->hasSyntax) {
+        header->tableIdExtension = 0;
+        header->version = 0;
+        header->isCurrent = true;
+        header->sectionNumber = 0;
+        header->lastSectionNumber = 0;
+        return true;
+    }
+
+    if (section.size() < kLongHeaderSize + kCrcSize) {
+        return false;
+    }
+    header->tableIdExtension = static_cast<uint16_t>(bytes[3] << 8 | bytes[4]);
+    header->version = (bytes[5] >> 1) & 0x1f;
+    header->isCurrent = (bytes[5] & 0x01) != 0;
+    header->sectionNumber = bytes[6];
+    header->lastSectionNumber = bytes[7];
+    return true;
+}
+
+void SectionEngine::configure(const Settings& settings) {
+    mSettings = settings;
+    reset();
+}
+
+SectionEngine::Verdict SectionEngine::filter(std::span<const int8_t> section,
+                                             SectionHeader* header) {
+    mStats.sections++;
+    if (mIsDone) {
+        mStats.done++;
+        return Verdict::DONE;
+    }
+    if (!SectionHeader::parse(section, header)) {
+        mStats.malformed++;
+        return Verdict::MALFORMED;
+    }
+    if (!matches(section, *header)) {
+        mStats.filtered++;
+        return Verdict::FILTERED;
+    }
+    // A repeat is dropped whatever its CRC, so only the sections to deliver are checked
+    if (isRepeated(section, *header)) {
+        mStats.repeated++;
+        return Verdict::REPEATED;
+    }
+    bool hasCrc = header->hasSyntax || header->tableId == kTimeOffsetTableId;
+    if (mSettings.isCheckCrc && hasCrc && crc32Mpeg2(section) != 0) {
+        mStats.crcErrors++;
+        return Verdict::CRC_ERROR;
+    }
+    return Verdict::DELIVER;
+}
+
+void SectionEngine::commit(std::span<const int8_t> section, const SectionHeader& header) {
+    recordDelivered(section, header);
+
+    if (!mSettings.isRepeat) {
+        // A table filter stops after its first complete table, a bits filter after one section
+        mIsDone = !mSettings.hasTableCondition || !header.hasSyntax || updateFirstTable(header);
+    }
+    mStats.delivered++;
+}
+
+void SectionEngine::reset() {
+    mDelivered.clear();
+    mFirstTable = {};
+    mIsDone = false;
+}
+
+bool SectionEngine::matches(std::span<const int8_t> section, const SectionHeader& header) const {
+    if (mSettings.hasTableCondition) {
+        if (header.tableId != mSettings.tableId) {
+            return false;
+        }
+        return mSettings.version == kAnyVersion ||
+               (header.hasSyntax && header.version == mSettings.version);
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(section.data());
+    bool hasNegativeBits = false;
+    bool hasNegativeMatch = false;
+    for (size_t i = 0; i < mSettings.filter.size() && i < mSettings.mask.size(); i++) {
+        uint8_t mask = mSettings.mask[i];
+        if (mask == 0) {
+            continue;
+        }
+        size_t offset = getSectionBitsOffset(i);
+        if (offset >= section.size()) {
+            return false;
+        }
+        uint8_t mode = i < mSettings.mode.size() ? mSettings.mode[i] : 0;
+        uint8_t diff = (bytes[offset] ^ mSettings.filter[i]) & mask;
+        // Positive bits must all be equal, and one of the negative bits at least must differ
+        if ((diff & ~mode) != 0) {
+            return false;
+        }
+        hasNegativeBits |= (mask & mode) != 0;
+        hasNegativeMatch |= (diff & mode) != 0;
+    }
+    return !hasNegativeBits || hasNegativeMatch;
+}
+
+namespace {
+
+uint32_t getSectionKey(const SectionHeader& header) {
+    return static_cast<uint32_t>(header.tableId) << 24 |
+           static_cast<uint32_t>(header.tableIdExtension) << 8 | header.sectionNumber;
+}
+
+uint32_t getSectionCrc(std::span<const int8_t> section) {
+    const uint8_t* crcBytes = reinterpret_cast<const uint8_t*>(section.data()) + section.size() -
+                              SectionHeader::kCrcSize;
+    return static_cast<uint32_t>(crcBytes[0]) << 24 | static_cast<uint32_t>(crcBytes[1]) << 16 |
+           static_cast<uint32_t>(crcBytes[2]) << 8 | crcBytes[3];
+}
+
+}  // namespace
+
+bool SectionEngine::isRepeated(std::span<const int8_t> section,
+                               const SectionHeader& header) const {
+    if (!header.hasSyntax) {
+        // Without a version, there is no telling a repeat from an update
+        return false;
+    }
+    auto it = mDelivered.find(getSectionKey(header));
+    return it != mDelivered.end() && it->second.version == header.version &&
+           it->second.crc == getSectionCrc(section);
+}
+
+void SectionEngine::recordDelivered(std::span<const int8_t> section, const SectionHeader& header) {
+    if (header.hasSyntax) {
+        mDelivered[getSectionKey(header)] = {header.version, getSectionCrc(section)};
+    }
+}
+
+bool SectionEngine::updateFirstTable(const SectionHeader& header) {
+    FirstTable& table = mFirstTable;
+    bool isSameTable = table.isSet && header.tableId == table.tableId &&
+                       header.tableIdExtension == table.tableIdExtension;
+    if (!table.isSet || (isSameTable && header.version != table.version)) {
+        // A new version of the table restarts the collection of its sections
+        table = {
+                .isSet = true,
+                .tableId = header.tableId,
+                .tableIdExtension = header.tableIdExtension,
+                .version = header.version,
+                .lastSectionNumber = header.lastSectionNumber,
+                .sectionNumbers = {},
+        };
+    } else if (!isSameTable) {
+        return false;
+    }
+    table.sectionNumbers.set(header.sectionNumber);
+    for (int number = 0; number <= table.lastSectionNumber; number++) {
+        if (!table.sectionNumbers.test(number)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <bitset>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+/**
+ * Computes the CRC32 of ISO/IEC 13818-1 Annex A, which is 0 over a whole section including its
+ * CRC_32 field. Eight bytes are processed per step with the slicing-by-8 tables.
+ */
+uint32_t crc32Mpeg2(std::span<const int8_t> data, uint32_t crc = 0xffffffff);
+
+/**
+ * Header of a PSI section as defined in ISO/IEC 13818-1 Section 2.4.4.
+ */
+struct SectionHeader {
+    static constexpr size_t kShortHeaderSize = 3;
+    static constexpr size_t kLongHeaderSize = 8;
+    static constexpr size_t kCrcSize = 4;
+
+    uint8_t tableId;
+    // The section has the long header, with a version and a CRC_32
+    bool hasSyntax;
+    // Long header only
+    uint16_t tableIdExtension;
+    uint8_t version;
+    bool isCurrent;
+    uint8_t sectionNumber;
+    uint8_t lastSectionNumber;
+
+    /**
+     * Parses the header of a complete section.
+     *
+     * Return false if the section is too short for its header.
+     */
+    static bool parse(std::span<const int8_t> section, SectionHeader* header);
+};
+
+/**
+ * Filters the sections assembled by a TsParser for one section filter.
+ *
+ * A section is delivered if its CRC is valid, it matches the configured condition, and it was not
+ * delivered before. Sections are identified by table_id, table_id_extension and section_number, and
+ * one is delivered again only when its version_number or its CRC changes, so the sections a
+ * multiplex repeats every few hundred milliseconds reach the client once. Without isRepeat, the
+ * filter stops after the first complete table.
+ */
+class SectionEngine {
+  public:
+    static constexpr uint32_t kAnyVersion = 0xffffffff;
+
+    struct Settings {
+        bool isCheckCrc = false;
+        bool isRepeat = true;
+
+        // The condition is either a table...
+        bool hasTableCondition = false;
+        uint8_t tableId = 0;
+        // kAnyVersion to match all the versions
+        uint32_t version = kAnyVersion;
+
+        // ...or section bits, which follow the Linux DVB section filters: byte 0 is compared to
+        // the table_id and the next ones to the section from byte 3, after the section_length.
+        std::vector<uint8_t> filter;
+        std::vector<uint8_t> mask;
+        std::vector<uint8_t> mode;
+    };
+
+    enum class Verdict {
+        DELIVER,
+        CRC_ERROR,
+        // Too short for its header
+        MALFORMED,
+        // Does not match the condition
+        FILTERED,
+        REPEATED,
+        // The filter is done with its table and isRepeat is false
+        DONE,
+    };
+
+    struct Stats {
+        uint64_t sections;
+        uint64_t delivered;
+        uint64_t crcErrors;
+        uint64_t malformed;
+        uint64_t filtered;
+        uint64_t repeated;
+        uint64_t done;
+    };
+
+    void configure(const Settings& settings);
+
+    /**
+     * Decides whether a complete section is delivered to the client, and parses its header.
+     * A section to deliver is only recorded as delivered by commit(), once it reached the client.
+     */
+    Verdict filter(std::span<const int8_t> section, SectionHeader* header);
+
+    /**
+     * Records a section that filter() decided to deliver as delivered, so that its repeats are
+     * dropped. A section that could not be delivered is not committed and is delivered again.
+     */
+    void commit(std::span<const int8_t> section, const SectionHeader& header);
+
+    // Forgets the delivered sections, so that they are delivered again
+    void reset();
+
+    const Stats& getStats() const { return mStats; }
+
+  private:
+    struct DeliveredSection {
+        uint8_t version;
+        uint32_t crc;
+    };
+    // The sections delivered for the table the filter stops after
+    struct FirstTable {
+        bool isSet = false;
+        uint8_t tableId = 0;
+        uint16_t tableIdExtension = 0;
+        uint8_t version = 0;
+        uint8_t lastSectionNumber = 0;
+        std::bitset<256> sectionNumbers;
+    };
+
+    bool matches(std::span<const int8_t> section, const SectionHeader& header) const;
+    bool isRepeated(std::span<const int8_t> section, const SectionHeader& header) const;
+    void recordDelivered(std::span<const int8_t> section, const SectionHeader& header);
+    // Return true when the first complete table has been delivered
+    bool updateFirstTable(const SectionHeader& header);
+
+    Settings mSettings;
+    // Keyed by table_id, table_id_extension and section_number
+    std::unordered_map<uint32_t, DeliveredSection> mDelivered;
+    FirstTable mFirstTable;
+    bool mIsDone = false;
+    Stats mStats = {};
+};
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
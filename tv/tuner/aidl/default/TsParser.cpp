@@ -0,0 +1,357 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TsParser.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+namespace {
+
+constexpr uint8_t kSyncByte = 0x47;
+// Enough for any PES packet with a PES_packet_length, unbounded ones grow the buffer
+constexpr size_t kPesBufferSize = 6 + 0xffff;
+// Largest private section, 12 bits section_length with its first 2 bits set to 0 plus 3 bytes
+constexpr size_t kMaxSectionSize = 4096;
+constexpr uint8_t kSectionStuffing = 0xff;
+
+inline uint8_t u8(std::span<const int8_t> data, size_t offset) {
+    return static_cast<uint8_t>(data[offset]);
+}
+
+// Reads a 33 bits PTS or DTS, stored across 5 bytes with marker bits in between
+int64_t readTimestamp(std::span<const int8_t> data, size_t offset) {
+    return (static_cast<int64_t>((u8(data, offset) >> 1) & 0x07) << 30) |
+           (static_cast<int64_t>(u8(data, offset + 1)) << 22) |
+           (static_cast<int64_t>(u8(data, offset + 2) >> 1) << 15) |
+           (static_cast<int64_t>(u8(data, offset + 3)) << 7) |
+           static_cast<int64_t>(u8(data, offset + 4) >> 1);
+}
+
+// Streams whose PES packets have no optional header, see Table 2-21 of ISO/IEC 13818-1
+bool hasPesOptionalHeader(uint8_t streamId) {
+    switch (streamId) {
+        case 0xbc:  // program_stream_map
+        case 0xbe:  // padding_stream
+        case 0xbf:  // private_stream_2
+        case 0xf0:  // ECM_stream
+        case 0xf1:  // EMM_stream
+        case 0xf2:  // DSMCC_stream
+        case 0xf8:  // ITU-T Rec. H.222.1 type E
+        case 0xff:  // program_stream_directory
+            return false;
+        default:
+            return true;
+    }
+}
+
+}  // namespace
+
+bool TsPacketHeader::parse(std::span<const int8_t> packet, TsPacketHeader* header) {
+    if (packet.size() < kPacketSize || u8(packet, 0) != kSyncByte) {
+        return false;
+    }
+    header->transportError = u8(packet, 1) & 0x80;
+    header->payloadUnitStart = u8(packet, 1) & 0x40;
+    header->pid = ((u8(packet, 1) & 0x1f) << 8) | u8(packet, 2);
+    header->scramblingControl = (u8(packet, 3) >> 6) & 0x03;
+    header->continuityCounter = u8(packet, 3) & 0x0f;
+    header->discontinuity = false;
+
+    uint8_t adaptationFieldControl = (u8(packet, 3) >> 4) & 0x03;
+    if (adaptationFieldControl == 0) {
+        // Reserved value, the packet is to be discarded
+        return false;
+    }
+    header->hasPayload = adaptationFieldControl & 0x01;
+    header->payloadOffset = 4;
+    if (adaptationFieldControl & 0x02) {
+        size_t adaptationFieldLength = u8(packet, 4);
+        // The adaptation field fills the packet when there is no payload
+        size_t maxLength = header->hasPayload ? kPacketSize - 6 : kPacketSize - 5;
+        if (adaptationFieldLength > maxLength ||
+            (!header->hasPayload && adaptationFieldLength != maxLength)) {
+            return false;
+        }
+        if (adaptationFieldLength > 0) {
+            header->discontinuity = u8(packet, 5) & 0x80;
+        }
+        header->payloadOffset += 1 + adaptationFieldLength;
+    }
+    return true;
+}
+
+TsParser::TsParser(Mode mode) : mMode(mode) {}
+
+bool TsParser::parse(std::span<const int8_t> packets, const UnitCallback& onUnit) {
+    for (size_t i = 0; i + TsPacketHeader::kPacketSize <= packets.size();
+         i += TsPacketHeader::kPacketSize) {
+        std::span<const int8_t> packet = packets.subspan(i, TsPacketHeader::kPacketSize);
+        mStats.packets++;
+
+        TsPacketHeader header;
+        if (!TsPacketHeader::parse(packet, &header)) {
+            mStats.invalidPackets++;
+            continue;
+        }
+        PidState& state = getPidState(header.pid);
+        if (header.transportError) {
+            // The payload can't be trusted, so neither can the unit it belongs to
+            mStats.transportErrors++;
+            dropUnit(state, false);
+            continue;
+        }
+        if (!checkContinuity(state, header) || !header.hasPayload) {
+            continue;
+        }
+        if (header.scramblingControl != 0) {
+            mStats.scrambledPackets++;
+            dropUnit(state, false);
+            continue;
+        }
+
+        std::span<const int8_t> payload = packet.subspan(header.payloadOffset);
+        bool isParsing = mMode == Mode::PES
+                                 ? parsePesPayload(state, header.pid, header.payloadUnitStart,
+                                                   payload, onUnit)
+                                 : parseSectionPayload(state, header.pid, header.payloadUnitStart,
+                                                       payload, onUnit);
+        if (!isParsing) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TsParser::reset() {
+    mPidStates.clear();
+    mLastPidState = nullptr;
+}
+
+TsParser::PidState& TsParser::getPidState(uint16_t pid) {
+    if (mLastPidState == nullptr || mLastPid != pid) {
+        auto [it, isNew] = mPidStates.try_emplace(pid);
+        if (isNew) {
+            it->second.data.reserve(mMode == Mode::PES ? kPesBufferSize : 2 * kMaxSectionSize);
+        }
+        mLastPidState = &it->second;
+        mLastPid = pid;
+    }
+    return *mLastPidState;
+}
+
+// Returns false if the packet is to be skipped
+bool TsParser::checkContinuity(PidState& state, const TsPacketHeader& header) {
+    // The counter only increments on packets with a payload
+    if (!header.hasPayload) {
+        return true;
+    }
+    bool hadCounter = state.hasContinuityCounter;
+    uint8_t lastCounter = state.continuityCounter;
+    state.hasContinuityCounter = true;
+    state.continuityCounter = header.continuityCounter;
+    if (!hadCounter || header.discontinuity) {
+        return true;
+    }
+    if (header.continuityCounter == lastCounter) {
+        // A packet may be sent twice in a row, the copy is dropped
+        mStats.duplicatePackets++;
+        return false;
+    }
+    if (header.continuityCounter != ((lastCounter + 1) & 0x0f)) {
+        mStats.continuityErrors++;
+        dropUnit(state, false);
+    }
+    return true;
+}
+
+bool TsParser::parsePesPayload(PidState& state, uint16_t pid, bool unitStart,
+                               std::span<const int8_t> payload, const UnitCallback& onUnit) {
+    if (unitStart) {
+        if (state.isAssembling) {
+            if (state.isPesLengthKnown && state.pesLength == 0) {
+                // An unbounded PES packet ends where the next one starts
+                if (!emitPes(state, pid, state.data.size(), onUnit)) {
+                    return false;
+                }
+            } else {
+                dropUnit(state, true);
+            }
+        }
+        state.data.clear();
+        state.isAssembling = true;
+        state.isPesLengthKnown = false;
+        state.pesLength = 0;
+    } else if (!state.isAssembling) {
+        // Wait for the start of the next PES packet
+        return true;
+    }
+    state.data.insert(state.data.end(), payload.begin(), payload.end());
+
+    if (!state.isPesLengthKnown && state.data.size() >= 6) {
+        std::span<const int8_t> data(state.data);
+        if (u8(data, 0) != 0x00 || u8(data, 1) != 0x00 || u8(data, 2) != 0x01) {
+            dropUnit(state, true);
+            return true;
+        }
+        size_t length = (u8(data, 4) << 8) | u8(data, 5);
+        state.pesLength = length == 0 ? 0 : 6 + length;
+        state.isPesLengthKnown = true;
+    }
+    if (state.pesLength > 0 && state.data.size() >= state.pesLength) {
+        return emitPes(state, pid, state.pesLength, onUnit);
+    }
+    return true;
+}
+
+bool TsParser::emitPes(PidState& state, uint16_t pid, size_t length,
+                       const UnitCallback& onUnit) {
+    std::span<const int8_t> data(state.data.data(), length);
+    state.isAssembling = false;
+
+    Unit unit = {
+            .pid = pid,
+            .data = data,
+            .discontinuity = state.lostData,
+            .streamId = u8(data, 3),
+            .headerLength = 6,
+            .hasPts = false,
+            .pts = 0,
+            .hasDts = false,
+            .dts = 0,
+    };
+    if (hasPesOptionalHeader(unit.streamId)) {
+        if (data.size() < 9 || data.size() < 9 + static_cast<size_t>(u8(data, 8))) {
+            dropUnit(state, true);
+            return true;
+        }
+        unit.headerLength = 9 + u8(data, 8);
+        uint8_t ptsDtsFlags = u8(data, 7) >> 6;
+        if ((ptsDtsFlags & 0x02) && unit.headerLength >= 14) {
+            unit.hasPts = true;
+            unit.pts = readTimestamp(data, 9);
+        }
+        if (ptsDtsFlags == 0x03 && unit.headerLength >= 19) {
+            unit.hasDts = true;
+            unit.dts = readTimestamp(data, 14);
+        }
+    }
+
+    state.lostData = false;
+    mStats.units++;
+    return onUnit(unit);
+}
+
+bool TsParser::parseSectionPayload(PidState& state, uint16_t pid, bool unitStart,
+                                   std::span<const int8_t> payload, const UnitCallback& onUnit) {
+    if (unitStart) {
+        // The pointer_field gives where the first section starts, after the end of the previous
+        size_t pointer = u8(payload, 0);
+        if (1 + pointer > payload.size()) {
+            dropUnit(state, true);
+            return true;
+        }
+        if (state.isAssembling) {
+            state.data.insert(state.data.end(), payload.begin() + 1,
+                              payload.begin() + 1 + pointer);
+            if (!emitSections(state, pid, onUnit)) {
+                return false;
+            }
+            if (state.isAssembling && state.data.size() > state.sectionStart) {
+                // The previous section should have ended before the new one
+                dropUnit(state, true);
+            }
+        }
+        state.data.clear();
+        state.sectionStart = 0;
+        state.isAssembling = true;
+        payload = payload.subspan(1 + pointer);
+    } else if (!state.isAssembling) {
+        // Wait for the start of the next section
+        return true;
+    }
+    state.data.insert(state.data.end(), payload.begin(), payload.end());
+    return emitSections(state, pid, onUnit);
+}
+
+bool TsParser::emitSections(PidState& state, uint16_t pid, const UnitCallback& onUnit) {
+    std::span<const int8_t> data(state.data);
+    while (state.isAssembling && data.size() - state.sectionStart >= 3) {
+        std::span<const int8_t> section = data.subspan(state.sectionStart);
+        if (u8(section, 0) == kSectionStuffing) {
+            // The rest of the packet is stuffing, the next section starts in a later packet
+            state.isAssembling = false;
+            state.data.clear();
+            state.sectionStart = 0;
+            return true;
+        }
+        size_t length = 3 + (((u8(section, 1) & 0x0f) << 8) | u8(section, 2));
+        if (length > kMaxSectionSize) {
+            dropUnit(state, true);
+            break;
+        }
+        if (section.size() < length) {
+            break;
+        }
+
+        Unit unit = {
+                .pid = pid,
+                .data = section.first(length),
+                .discontinuity = state.lostData,
+                .streamId = 0,
+                .headerLength = 0,
+                .hasPts = false,
+                .pts = 0,
+                .hasDts = false,
+                .dts = 0,
+        };
+        state.sectionStart += length;
+        state.lostData = false;
+        mStats.units++;
+        if (!onUnit(unit)) {
+            return false;
+        }
+    }
+
+    // Move the partial section to the front, so the buffer doesn't grow across packets
+    if (state.sectionStart > 0) {
+        state.data.erase(state.data.begin(), state.data.begin() + state.sectionStart);
+        state.sectionStart = 0;
+    }
+    return true;
+}
+
+void TsParser::dropUnit(PidState& state, bool isMalformed) {
+    // Even if no unit is in progress, the dropped data may have started one
+    state.lostData = true;
+    if (isMalformed) {
+        mStats.malformedUnits++;
+    }
+    state.isAssembling = false;
+    state.isPesLengthKnown = false;
+    state.pesLength = 0;
+    state.data.clear();
+    state.sectionStart = 0;
+}
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
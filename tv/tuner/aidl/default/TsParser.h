@@ -0,0 +1,157 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+
+/**
+ * Header of a transport stream packet as defined in ISO/IEC 13818-1 Section 2.4.3.2, with the
+ * location of its payload after the adaptation field.
+ */
+struct TsPacketHeader {
+    static constexpr size_t kPacketSize = 188;
+
+    uint16_t pid;
+    bool transportError;
+    bool payloadUnitStart;
+    uint8_t scramblingControl;
+    uint8_t continuityCounter;
+    bool hasPayload;
+    // The discontinuity_indicator of the adaptation field
+    bool discontinuity;
+    size_t payloadOffset;
+
+    /**
+     * Parses the header of a 188 bytes packet.
+     *
+     * Return false if the packet is not a valid TS packet.
+     */
+    static bool parse(std::span<const int8_t> packet, TsPacketHeader* header);
+};
+
+/**
+ * Incremental parser of the PES packets (ISO/IEC 13818-1 Section 2.4.3.6) or PSI sections
+ * (Section 2.4.4) carried in TS packets.
+ *
+ * Each PID is parsed independently. The continuity counter is checked on every packet: duplicate
+ * packets are dropped, and a unit which lost a packet is discarded and the next one is flagged.
+ * Units are assembled into a buffer kept per PID, which is reused from one unit to the next.
+ */
+class TsParser {
+  public:
+    enum class Mode {
+        PES,
+        SECTION,
+    };
+
+    // A PES packet or a section
+    struct Unit {
+        uint16_t pid;
+        // The whole PES packet or section, valid until the callback returns
+        std::span<const int8_t> data;
+        // Data has been lost on the PID since the previous unit
+        bool discontinuity;
+
+        // PES only
+        uint8_t streamId;
+        size_t headerLength;
+        bool hasPts;
+        int64_t pts;
+        bool hasDts;
+        int64_t dts;
+
+        std::span<const int8_t> payload() const { return data.subspan(headerLength); }
+    };
+    // Return false to stop the parsing
+    using UnitCallback = std::function<bool(const Unit& unit)>;
+
+    struct Stats {
+        uint64_t packets;
+        uint64_t units;
+        // Packets without a sync byte or with an invalid adaptation field
+        uint64_t invalidPackets;
+        uint64_t transportErrors;
+        uint64_t scrambledPackets;
+        uint64_t duplicatePackets;
+        uint64_t continuityErrors;
+        uint64_t malformedUnits;
+    };
+
+    explicit TsParser(Mode mode);
+
+    /**
+     * Parses a sequence of 188 bytes packets, calling onUnit for each completed unit. A unit
+     * spanning several calls is carried over in the state of its PID.
+     *
+     * Return false if onUnit stopped the parsing.
+     */
+    bool parse(std::span<const int8_t> packets, const UnitCallback& onUnit);
+
+    // Drops the partial units and the continuity state of all the PIDs
+    void reset();
+
+    Mode getMode() const { return mMode; }
+    const Stats& getStats() const { return mStats; }
+
+  private:
+    struct PidState {
+        bool hasContinuityCounter = false;
+        uint8_t continuityCounter = 0;
+        // A unit is in progress in data
+        bool isAssembling = false;
+        bool lostData = false;
+        // PES only, the size of the complete PES packet, 0 while unknown or unbounded
+        size_t pesLength = 0;
+        bool isPesLengthKnown = false;
+        // SECTION only, the start of the section in progress in data
+        size_t sectionStart = 0;
+        std::vector<int8_t> data;
+    };
+
+    PidState& getPidState(uint16_t pid);
+    bool checkContinuity(PidState& state, const TsPacketHeader& header);
+    bool parsePesPayload(PidState& state, uint16_t pid, bool unitStart,
+                         std::span<const int8_t> payload, const UnitCallback& onUnit);
+    bool parseSectionPayload(PidState& state, uint16_t pid, bool unitStart,
+                             std::span<const int8_t> payload, const UnitCallback& onUnit);
+    bool emitPes(PidState& state, uint16_t pid, size_t length, const UnitCallback& onUnit);
+    bool emitSections(PidState& state, uint16_t pid, const UnitCallback& onUnit);
+    void dropUnit(PidState& state, bool isMalformed);
+
+    Mode mMode;
+    std::unordered_map<uint16_t, PidState> mPidStates;
+    // Most streams given to a parser are on one PID, so the last state is cached
+    PidState* mLastPidState = nullptr;
+    uint16_t mLastPid = 0;
+    Stats mStats = {};
+};
+
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -247,6 +247,17 @@ std::shared_ptr<Frontend> Tuner::getFrontendById(int32_t frontendId) {
     return mFrontends[frontendId];
 }
 
+vector<std::shared_ptr<Frontend>> Tuner::getIdleFrontends(FrontendType type) {
+    vector<std::shared_ptr<Frontend>> frontends;
+    for (const auto& [frontendId, frontend] : mFrontends) {
+        if (frontend != nullptr && frontend->getFrontendType() == type && !frontend->isLocked() &&
+            !frontend->isScanning()) {
+            frontends.push_back(frontend);
+        }
+    }
+    return frontends;
+}
+
 ::ndk::ScopedAStatus Tuner::openLnbByName(const std::string& /* in_lnbName */,
                                           std::vector<int32_t>* out_lnbId,
                                           std::shared_ptr<ILnb>* _aidl_return) {
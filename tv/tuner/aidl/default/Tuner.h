@@ -70,6 +70,8 @@ class Tuner : public BnTuner {
     binder_status_t dump(int fd, const char** args, uint32_t numArgs) override;
 
     std::shared_ptr<Frontend> getFrontendById(int32_t frontendId);
+    // The frontends of the type which are neither locked nor scanning
+    vector<std::shared_ptr<Frontend>> getIdleFrontends(FrontendType type);
     void setFrontendAsDemuxSource(int32_t frontendId, int32_t demuxId);
     void frontendStartTune(int32_t frontendId);
     void frontendStopTune(int32_t frontendId);
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <span>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DemuxFixture.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+namespace {
+
+constexpr size_t kSyntheticPacketCount = 20000;
+
+void setPacketRate(benchmark::State& state, const std::vector<int8_t>& ts) {
+    state.counters["packets"] = benchmark::Counter(
+            static_cast<double>(state.iterations() * (ts.size() / bench::kTsPacketSize)),
+            benchmark::Counter::kIsRate);
+    state.SetBytesProcessed(state.iterations() * ts.size());
+}
+
+// Dispatch one packet at a time through the PID table.
+void BM_Demux_PidTable(benchmark::State& state) {
+    std::vector<int8_t> ts = bench::loadTs(kSyntheticPacketCount);
+    bench::DemuxFixture fixture(ts, state.range(0));
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < ts.size(); i += bench::kTsPacketSize) {
+            fixture.mDemux->startBroadcastTsFilter(
+                    fixture.mTable,
+                    std::span<const int8_t>(ts.data() + i, bench::kTsPacketSize));
+        }
+        state.PauseTiming();
+        fixture.flush();
+        state.ResumeTiming();
+    }
+    setPacketRate(state, ts);
+}
+
+// The previous dispatch, comparing every packet against the PID of each playback filter.
+void BM_Demux_LinearScan(benchmark::State& state) {
+    std::vector<int8_t> ts = bench::loadTs(kSyntheticPacketCount);
+    bench::DemuxFixture fixture(ts, state.range(0));
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < ts.size(); i += bench::kTsPacketSize) {
+            std::span<const int8_t> packet(ts.data() + i, bench::kTsPacketSize);
+            uint16_t pid = bench::getPid(packet.data());
+            for (auto& [id, filter] : fixture.mFilters) {
+                if (filter->getTpid() == pid) {
+                    filter->updateFilterOutput(packet);
+                }
+            }
+        }
+        state.PauseTiming();
+        fixture.flush();
+        state.ResumeTiming();
+    }
+    setPacketRate(state, ts);
+}
+
+}  // namespace
+
+BENCHMARK(BM_Demux_PidTable)->Arg(1)->Arg(8)->Arg(32)->Arg(64);
+BENCHMARK(BM_Demux_LinearScan)->Arg(1)->Arg(8)->Arg(32)->Arg(64);
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <aidl/android/hardware/tv/tuner/BnFilterCallback.h>
+
+#include "../Demux.h"
+#include "../Filter.h"
+#include "TsStream.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+namespace bench {
+
+// The filters are never started, so their FMQs stay empty
+constexpr uint32_t kFilterBufferSize = 64 * 1024;
+
+class NullFilterCallback : public BnFilterCallback {
+  public:
+    ::ndk::ScopedAStatus onFilterEvent(const std::vector<DemuxFilterEvent>&) override {
+        return ::ndk::ScopedAStatus::ok();
+    }
+    ::ndk::ScopedAStatus onFilterStatus(DemuxFilterStatus) override {
+        return ::ndk::ScopedAStatus::ok();
+    }
+};
+
+// A demux with filterCount section filters, spread over the busiest PIDs of the stream. Filters
+// beyond the number of PIDs in the stream share a PID with an earlier one.
+class DemuxFixture {
+  public:
+    DemuxFixture(const std::vector<int8_t>& ts, int filterCount) {
+        mDemux = ndk::SharedRefBase::make<Demux>(0, 0);
+        std::shared_ptr<IFilterCallback> callback =
+                ndk::SharedRefBase::make<NullFilterCallback>();
+        std::vector<uint16_t> pids = getPidsByFrequency(ts);
+
+        DemuxFilterType type{
+                .mainType = DemuxFilterMainType::TS,
+                .subType = DemuxFilterSubType::make<DemuxFilterSubType::Tag::tsFilterType>(
+                        DemuxTsFilterType::SECTION),
+        };
+        for (int i = 0; i < filterCount; i++) {
+            auto filter = ndk::SharedRefBase::make<Filter>(type, i, kFilterBufferSize, callback,
+                                                           mDemux);
+            filter->createFilterMQ();
+
+            DemuxTsFilterSettings tsSettings{.tpid = pids[i % pids.size()]};
+            tsSettings.filterSettings
+                    .set<DemuxTsFilterSettingsFilterSettings::Tag::section>(
+                            DemuxFilterSectionSettings{});
+            DemuxFilterSettings settings;
+            settings.set<DemuxFilterSettings::Tag::ts>(tsSettings);
+            filter->configure(settings);
+
+            mTable.add(filter->getTpid(), filter);
+            mFilters[i] = filter;
+        }
+    }
+
+    void flush() {
+        for (auto& [id, filter] : mFilters) {
+            filter->flush();
+        }
+    }
+
+    std::shared_ptr<Demux> mDemux;
+    PidFilterTable mTable;
+    std::map<int64_t, std::shared_ptr<Filter>> mFilters;
+};
+
+}  // namespace bench
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <span>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../Dvr.h"
+#include "DemuxFixture.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+namespace {
+
+constexpr size_t kSyntheticPacketCount = 40000;
+constexpr size_t kDvrBufferSize = 8 * 1024 * 1024;
+// Written per iteration, not a multiple of the FMQ size so that packets wrap around its end
+constexpr size_t kChunkSize = 3 * 1024 * 1024;
+
+// The playback FMQ and the filters, with the stream in the DVR packet format.
+class PlaybackFixture : public bench::DemuxFixture {
+  public:
+    PlaybackFixture(const std::vector<int8_t>& ts, int packetSize, int filterCount)
+        : DemuxFixture(ts, filterCount), mDvrMQ(kDvrBufferSize), mPacketSize(packetSize) {
+        mStream = bench::repacketizeTs(ts, packetSize);
+    }
+
+    // Queues the next chunk of the stream for playback, returns its size
+    size_t writeChunk() {
+        size_t size = std::min(kChunkSize / mPacketSize * mPacketSize, mStream.size());
+        for (size_t written = 0; written < size;) {
+            size_t length = std::min(size - written, mStream.size() - mStreamOffset);
+            mDvrMQ.write(mStream.data() + mStreamOffset, length);
+            written += length;
+            mStreamOffset = (mStreamOffset + length) % mStream.size();
+        }
+        return size;
+    }
+
+    DvrMQ mDvrMQ;
+    int mPacketSize;
+    std::vector<int8_t> mStream;
+    size_t mStreamOffset = 0;
+};
+
+void setBitRate(benchmark::State& state, size_t bytes) {
+    state.counters["bits"] = benchmark::Counter(static_cast<double>(bytes) * 8,
+                                                benchmark::Counter::kIsRate,
+                                                benchmark::Counter::kIs1000);
+    state.SetBytesProcessed(bytes);
+}
+
+// Batched in place reading, as Dvr::readPlaybackFMQ does.
+void BM_Playback_Batched(benchmark::State& state) {
+    PlaybackFixture fixture(bench::loadTs(kSyntheticPacketCount), state.range(0),
+                            state.range(1));
+    PlaybackReader reader;
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        fixture.flush();
+        bytes += fixture.writeChunk();
+        state.ResumeTiming();
+
+        reader.read(fixture.mDvrMQ, fixture.mPacketSize, fixture.mTable);
+    }
+    setBitRate(state, bytes);
+}
+
+// The previous reading, copying each packet out of the FMQ before dispatching it.
+void BM_Playback_PerPacket(benchmark::State& state) {
+    PlaybackFixture fixture(bench::loadTs(kSyntheticPacketCount), state.range(0),
+                            state.range(1));
+    size_t syncOffset = fixture.mPacketSize == 192 ? 4 : 0;
+    std::vector<int8_t> packet(fixture.mPacketSize);
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        fixture.flush();
+        bytes += fixture.writeChunk();
+        state.ResumeTiming();
+
+        size_t size = fixture.mDvrMQ.availableToRead();
+        for (size_t i = 0; i < size / fixture.mPacketSize; i++) {
+            fixture.mDvrMQ.read(packet.data(), fixture.mPacketSize);
+            fixture.mDemux->startBroadcastTsFilter(
+                    fixture.mTable,
+                    std::span<const int8_t>(packet.data() + syncOffset, bench::kTsPacketSize));
+        }
+    }
+    setBitRate(state, bytes);
+}
+
+}  // namespace
+
+BENCHMARK(BM_Playback_Batched)->ArgsProduct({{188, 192, 204}, {1, 8, 32}});
+BENCHMARK(BM_Playback_PerPacket)->ArgsProduct({{188, 192, 204}, {1, 8, 32}});
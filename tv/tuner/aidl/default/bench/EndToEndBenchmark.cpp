@@ -0,0 +1,730 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs the whole default implementation in-process: a Tuner opens a Demux, a playback Dvr and
+// filters through their AIDL interfaces, and the benchmark acts as the client, writing a stream
+// into the playback FMQ and reading the filter FMQs and events as the framework does.
+//
+// Each filter event is matched to the stream unit it carries, by the content of a section or by
+// the PTS of a PES packet, media frame or record index. Its latency runs from the write of the
+// chunk holding that unit to the delivery of the event. Set TUNER_BENCH_VERBOSE to print the
+// latency percentiles of each filter.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <aidl/android/hardware/tv/tuner/BnDvrCallback.h>
+#include <aidl/android/hardware/tv/tuner/BnFilterCallback.h>
+#include <aidl/android/hardware/tv/tuner/DemuxQueueNotifyBits.h>
+#include <benchmark/benchmark.h>
+
+#include "../Tuner.h"
+#include "../TsParser.h"
+#include "TsStream.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kSyntheticPacketCount = 40000;
+// Written at once into the playback FMQ, as a client reading a file would
+constexpr size_t kChunkPackets = 64;
+constexpr int32_t kDvrBufferSize = 8 * 1024 * 1024;
+constexpr int32_t kFilterBufferSize = 1024 * 1024;
+// Units written longer ago are no longer expected to get an event
+constexpr auto kMatchWindow = std::chrono::seconds(2);
+// Time left to the events of the last chunk once the playback FMQ is empty
+constexpr auto kDrainTime = std::chrono::milliseconds(100);
+constexpr auto kRecordWaitTimeout = std::chrono::milliseconds(10);
+
+enum class FilterKind { SECTION, PES, MEDIA, RECORD };
+
+const char* getKindName(FilterKind kind) {
+    switch (kind) {
+        case FilterKind::SECTION:
+            return "sec";
+        case FilterKind::PES:
+            return "pes";
+        case FilterKind::MEDIA:
+            return "media";
+        case FilterKind::RECORD:
+            return "rec";
+    }
+    return "";
+}
+
+uint64_t hashBytes(std::span<const int8_t> data) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (int8_t byte : data) {
+        hash = (hash ^ static_cast<uint8_t>(byte)) * 0x100000001b3;
+    }
+    return hash;
+}
+
+// Reads the PTS of a PES header, return false if it has none
+bool getPesPts(std::span<const int8_t> pes, int64_t* pts) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pes.data());
+    if (pes.size() < 14 || bytes[0] != 0 || bytes[1] != 0 || bytes[2] != 1 ||
+        (bytes[7] & 0x80) == 0) {
+        return false;
+    }
+    *pts = static_cast<int64_t>(bytes[9] & 0x0e) << 29 | static_cast<int64_t>(bytes[10]) << 22 |
+           static_cast<int64_t>(bytes[11] & 0xfe) << 14 | static_cast<int64_t>(bytes[12]) << 7 |
+           bytes[13] >> 1;
+    return true;
+}
+
+// The payload of a TS packet, empty if it has none
+std::span<const int8_t> getPayload(const int8_t* packet) {
+    size_t offset = 4;
+    if (packet[3] & 0x20) {
+        offset += 1 + static_cast<uint8_t>(packet[4]);
+    }
+    if ((packet[3] & 0x10) == 0 || offset >= bench::kTsPacketSize) {
+        return {};
+    }
+    return std::span<const int8_t>(packet + offset, bench::kTsPacketSize - offset);
+}
+
+// A unit of the stream an event is expected for, with the packet it is found in
+struct StreamUnit {
+    size_t packetIndex;
+    uint64_t key;
+};
+
+// The sections of the PID, keyed by their content, at the packet completing them
+std::vector<StreamUnit> findSections(const std::vector<int8_t>& ts, uint16_t pid) {
+    std::vector<StreamUnit> units;
+    TsParser parser(TsParser::Mode::SECTION);
+    for (size_t i = 0; i < ts.size() / bench::kTsPacketSize; i++) {
+        std::span<const int8_t> packet(ts.data() + i * bench::kTsPacketSize,
+                                       bench::kTsPacketSize);
+        if (bench::getPid(packet.data()) != pid) {
+            continue;
+        }
+        parser.parse(packet, [&](const TsParser::Unit& section) {
+            units.push_back({i, hashBytes(section.data)});
+            return true;
+        });
+    }
+    return units;
+}
+
+// The PES packets of the PID with a PTS, keyed by it, at the packet starting them
+std::vector<StreamUnit> findPesStarts(const std::vector<int8_t>& ts, uint16_t pid) {
+    std::vector<StreamUnit> units;
+    for (size_t i = 0; i < ts.size() / bench::kTsPacketSize; i++) {
+        const int8_t* packet = ts.data() + i * bench::kTsPacketSize;
+        int64_t pts;
+        if (bench::getPid(packet) == pid && (packet[1] & 0x40) &&
+            getPesPts(getPayload(packet), &pts)) {
+            units.push_back({i, static_cast<uint64_t>(pts)});
+        }
+    }
+    return units;
+}
+
+// Return true if the PUSI packets of the PID start PES packets rather than sections
+bool isPesPid(const std::vector<int8_t>& ts, uint16_t pid) {
+    for (size_t i = 0; i < ts.size() / bench::kTsPacketSize; i++) {
+        const int8_t* packet = ts.data() + i * bench::kTsPacketSize;
+        if (bench::getPid(packet) == pid && (packet[1] & 0x40)) {
+            std::span<const int8_t> payload = getPayload(packet);
+            return payload.size() >= 3 && payload[0] == 0 && payload[1] == 0 && payload[2] == 1;
+        }
+    }
+    return false;
+}
+
+int64_t getPercentile(std::vector<uint32_t>& samples, double percentile) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(samples.size() * percentile));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+class NullDvrCallback : public BnDvrCallback {
+  public:
+    ::ndk::ScopedAStatus onPlaybackStatus(PlaybackStatus) override {
+        return ::ndk::ScopedAStatus::ok();
+    }
+    ::ndk::ScopedAStatus onRecordStatus(RecordStatus) override {
+        return ::ndk::ScopedAStatus::ok();
+    }
+};
+
+/**
+ * The client of one filter: reads its FMQ and releases its AV memory as events come, and matches
+ * the events to the units the writer announced.
+ */
+class FilterProbe : public BnFilterCallback {
+  public:
+    FilterProbe(FilterKind kind, uint16_t pid, std::vector<StreamUnit> units)
+        : mKind(kind), mPid(pid), mUnits(std::move(units)) {}
+
+    ~FilterProbe() {
+        if (mEventFlag != nullptr) {
+            EventFlag::deleteEventFlag(&mEventFlag);
+        }
+    }
+
+    void setFilter(std::shared_ptr<IFilter> filter) {
+        mFilter = filter;
+        MQDescriptor<int8_t, SynchronizedReadWrite> desc;
+        if (mKind == FilterKind::SECTION || mKind == FilterKind::PES) {
+            mFilter->getQueueDesc(&desc);
+            mFilterMQ = std::make_unique<FilterMQ>(desc, false /* resetPointers */);
+            EventFlag::createEventFlag(mFilterMQ->getEventFlagWord(), &mEventFlag);
+        }
+    }
+
+    // Announces the units of the packets [begin, end) of the stream, about to be written
+    void onChunkWritten(size_t begin, size_t end, Clock::time_point time) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mIsStreaming = true;
+        if (begin == 0) {
+            mNextUnit = 0;
+        }
+        for (; mNextUnit < mUnits.size() && mUnits[mNextUnit].packetIndex < end; mNextUnit++) {
+            mPending.push_back({mUnits[mNextUnit].key, time});
+        }
+        while (!mPending.empty() && mPending.front().time < time - kMatchWindow) {
+            mPending.pop_front();
+        }
+    }
+
+    ::ndk::ScopedAStatus onFilterEvent(const std::vector<DemuxFilterEvent>& events) override {
+        Clock::time_point now = Clock::now();
+        for (const DemuxFilterEvent& event : events) {
+            onEvent(event, now);
+        }
+        if (mEventFlag != nullptr) {
+            mEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_CONSUMED));
+        }
+        return ::ndk::ScopedAStatus::ok();
+    }
+
+    ::ndk::ScopedAStatus onFilterStatus(DemuxFilterStatus status) override {
+        if (status == DemuxFilterStatus::OVERFLOW) {
+            mOverflows++;
+        }
+        return ::ndk::ScopedAStatus::ok();
+    }
+
+    FilterKind getKind() const { return mKind; }
+    uint16_t getPid() const { return mPid; }
+    uint64_t getEvents() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mEvents;
+    }
+    uint64_t getUnmatched() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mUnmatched;
+    }
+    uint64_t getOverflows() const { return mOverflows; }
+    std::vector<uint32_t> getLatenciesUs() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mLatenciesUs;
+    }
+
+  private:
+    struct PendingUnit {
+        uint64_t key;
+        Clock::time_point time;
+    };
+
+    void onEvent(const DemuxFilterEvent& event, Clock::time_point now) {
+        uint64_t key = 0;
+        bool hasKey = false;
+        switch (event.getTag()) {
+            case DemuxFilterEvent::Tag::section: {
+                std::span<const int8_t> data =
+                        readData(event.get<DemuxFilterEvent::Tag::section>().dataLength);
+                key = hashBytes(data);
+                hasKey = !data.empty();
+                break;
+            }
+            case DemuxFilterEvent::Tag::pes: {
+                int64_t pts;
+                hasKey = getPesPts(readData(event.get<DemuxFilterEvent::Tag::pes>().dataLength),
+                                   &pts);
+                key = static_cast<uint64_t>(pts);
+                break;
+            }
+            case DemuxFilterEvent::Tag::media: {
+                const DemuxFilterMediaEvent& media = event.get<DemuxFilterEvent::Tag::media>();
+                mFilter->releaseAvHandle(media.avMemory, media.avDataId);
+                key = static_cast<uint64_t>(media.pts);
+                hasKey = media.isPtsPresent;
+                break;
+            }
+            case DemuxFilterEvent::Tag::tsRecord: {
+                // The start codes found later in a PES packet are indexed with its PTS too,
+                // only the entry of its first packet is matched
+                const DemuxFilterTsRecordEvent& record =
+                        event.get<DemuxFilterEvent::Tag::tsRecord>();
+                key = static_cast<uint64_t>(record.pts);
+                hasKey = record.tsIndexMask &
+                         static_cast<int32_t>(DemuxTsIndex::PAYLOAD_UNIT_START_INDICATOR);
+                break;
+            }
+            default:
+                return;
+        }
+
+        std::lock_guard<std::mutex> lock(mLock);
+        // The test events of start() come before the stream
+        if (!mIsStreaming) {
+            return;
+        }
+        mEvents++;
+        if (!hasKey) {
+            return;
+        }
+        auto it = std::find_if(mPending.begin(), mPending.end(),
+                               [key](const PendingUnit& unit) { return unit.key == key; });
+        if (it == mPending.end()) {
+            mUnmatched++;
+            return;
+        }
+        // The events of a filter follow the stream, the units before had none
+        mLatenciesUs.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - it->time).count()));
+        mPending.erase(mPending.begin(), it + 1);
+    }
+
+    std::span<const int8_t> readData(int64_t length) {
+        if (mFilterMQ == nullptr || length <= 0) {
+            return {};
+        }
+        mData.resize(length);
+        if (!mFilterMQ->read(mData.data(), length)) {
+            return {};
+        }
+        return mData;
+    }
+
+    FilterKind mKind;
+    uint16_t mPid;
+    std::vector<StreamUnit> mUnits;
+    std::shared_ptr<IFilter> mFilter;
+    std::unique_ptr<FilterMQ> mFilterMQ;
+    EventFlag* mEventFlag = nullptr;
+    // Only used by the callbacks, which are serialized
+    std::vector<int8_t> mData;
+    std::atomic<uint64_t> mOverflows = 0;
+
+    // mLock protects all the members below
+    std::mutex mLock;
+    bool mIsStreaming = false;
+    size_t mNextUnit = 0;
+    std::deque<PendingUnit> mPending;
+    std::vector<uint32_t> mLatenciesUs;
+    uint64_t mEvents = 0;
+    uint64_t mUnmatched = 0;
+};
+
+// Reads the record FMQ as the framework does, so that the record engine never runs out of space
+class RecordReader {
+  public:
+    explicit RecordReader(std::shared_ptr<IDvr> dvr) {
+        MQDescriptor<int8_t, SynchronizedReadWrite> desc;
+        dvr->getQueueDesc(&desc);
+        mRecordMQ = std::make_unique<DvrMQ>(desc, true /* resetPointers */);
+        EventFlag::createEventFlag(mRecordMQ->getEventFlagWord(), &mEventFlag);
+        mThread = std::thread(&RecordReader::threadLoop, this);
+    }
+
+    ~RecordReader() {
+        mIsRunning = false;
+        mThread.join();
+        EventFlag::deleteEventFlag(&mEventFlag);
+    }
+
+    uint64_t getRecordedBytes() const { return mRecordedBytes; }
+
+  private:
+    void threadLoop() {
+        std::vector<int8_t> buffer;
+        while (mIsRunning) {
+            uint32_t efState = 0;
+            mEventFlag->wait(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY), &efState,
+                             std::chrono::nanoseconds(kRecordWaitTimeout).count(),
+                             true /* retry on spurious wake */);
+            size_t size = mRecordMQ->availableToRead();
+            if (size == 0) {
+                continue;
+            }
+            buffer.resize(size);
+            if (mRecordMQ->read(buffer.data(), size)) {
+                mRecordedBytes += size;
+                mEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_CONSUMED));
+            }
+        }
+    }
+
+    std::unique_ptr<DvrMQ> mRecordMQ;
+    EventFlag* mEventFlag = nullptr;
+    std::thread mThread;
+    std::atomic<bool> mIsRunning = true;
+    std::atomic<uint64_t> mRecordedBytes = 0;
+};
+
+// CPU time of the process and of each core, from getrusage() and /proc/stat
+struct CpuSample {
+    std::chrono::microseconds processTime;
+    // Busy and total jiffies of each core
+    std::vector<std::pair<uint64_t, uint64_t>> cores;
+
+    static CpuSample take() {
+        CpuSample sample;
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        sample.processTime =
+                std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+
+        std::ifstream stat("/proc/stat");
+        std::string line;
+        while (std::getline(stat, line)) {
+            if (line.compare(0, 3, "cpu") != 0 || line.size() < 4 || line[3] == ' ') {
+                continue;
+            }
+            std::istringstream fields(line.substr(line.find(' ')));
+            uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0;
+            fields >> user >> nice >> system >> idle >> iowait >> irq >> softirq;
+            uint64_t busy = user + nice + system + irq + softirq;
+            sample.cores.push_back({busy, busy + idle + iowait});
+        }
+        return sample;
+    }
+};
+
+// Starts a new peak of the resident set size, if the kernel allows it
+void resetPeakRss() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+int64_t getPeakRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return strtoll(line.c_str() + 6, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+/**
+ * A Tuner with a demux, its playback Dvr and the filters, plus a record Dvr for the record
+ * filters. While a record Dvr runs the playback only feeds the record filters, as on devices.
+ */
+class EndToEndFixture {
+  public:
+    EndToEndFixture(const std::vector<int8_t>& ts, int sectionCount, int pesCount,
+                    int mediaCount, int recordCount)
+        : mTs(ts) {
+        mTuner = ndk::SharedRefBase::make<Tuner>();
+        mTuner->init();
+        std::vector<int32_t> demuxIds;
+        mTuner->openDemux(&demuxIds, &mDemux);
+
+        std::shared_ptr<IDvrCallback> dvrCallback = ndk::SharedRefBase::make<NullDvrCallback>();
+        mDemux->openDvr(DvrType::PLAYBACK, kDvrBufferSize, dvrCallback, &mPlayback);
+        mPlayback->configure(DvrSettings::make<DvrSettings::Tag::playback>(PlaybackSettings{
+                .statusMask = 0x0f,
+                .lowThreshold = kDvrBufferSize / 4,
+                .highThreshold = kDvrBufferSize * 3 / 4,
+                .dataFormat = DataFormat::TS,
+                .packetSize = bench::kTsPacketSize,
+        }));
+        MQDescriptor<int8_t, SynchronizedReadWrite> desc;
+        mPlayback->getQueueDesc(&desc);
+        mPlaybackMQ = std::make_unique<DvrMQ>(desc, true /* resetPointers */);
+        EventFlag::createEventFlag(mPlaybackMQ->getEventFlagWord(), &mPlaybackEventFlag);
+
+        std::vector<uint16_t> sectionPids;
+        std::vector<uint16_t> pesPids;
+        for (uint16_t pid : bench::getPidsByFrequency(ts)) {
+            if (pid != 0x1fff) {
+                (isPesPid(ts, pid) ? pesPids : sectionPids).push_back(pid);
+            }
+        }
+        for (int i = 0; i < sectionCount && !sectionPids.empty(); i++) {
+            openFilter(FilterKind::SECTION, sectionPids[i % sectionPids.size()]);
+        }
+        for (int i = 0; i < pesCount && !pesPids.empty(); i++) {
+            openFilter(FilterKind::PES, pesPids[i % pesPids.size()]);
+        }
+        for (int i = 0; i < mediaCount && !pesPids.empty(); i++) {
+            openFilter(FilterKind::MEDIA, pesPids[i % pesPids.size()]);
+        }
+        if (recordCount > 0 && !pesPids.empty()) {
+            mDemux->openDvr(DvrType::RECORD, kDvrBufferSize, dvrCallback, &mRecord);
+            mRecord->configure(DvrSettings::make<DvrSettings::Tag::record>(RecordSettings{
+                    .statusMask = 0x0f,
+                    .lowThreshold = kDvrBufferSize / 4,
+                    .highThreshold = kDvrBufferSize * 3 / 4,
+                    .dataFormat = DataFormat::TS,
+                    .packetSize = bench::kTsPacketSize,
+            }));
+            for (int i = 0; i < recordCount; i++) {
+                openFilter(FilterKind::RECORD, pesPids[i % pesPids.size()]);
+            }
+            mRecordReader = std::make_unique<RecordReader>(mRecord);
+            mRecord->start();
+        }
+        mPlayback->start();
+    }
+
+    ~EndToEndFixture() {
+        mPlayback->stop();
+        if (mRecord != nullptr) {
+            mRecord->stop();
+        }
+        for (auto& [filter, probe] : mFilters) {
+            filter->close();
+        }
+        mRecordReader.reset();
+        if (mRecord != nullptr) {
+            mRecord->close();
+        }
+        mPlayback->close();
+        mDemux->close();
+        EventFlag::deleteEventFlag(&mPlaybackEventFlag);
+    }
+
+    /**
+     * Writes the whole stream into the playback FMQ, at bitRate if not 0, and returns once the
+     * Dvr has read all of it.
+     */
+    size_t writeStream(int64_t bitRate) {
+        size_t packetCount = mTs.size() / bench::kTsPacketSize;
+        Clock::time_point start = Clock::now();
+        for (size_t begin = 0; begin < packetCount; begin += kChunkPackets) {
+            size_t end = std::min(begin + kChunkPackets, packetCount);
+            size_t size = (end - begin) * bench::kTsPacketSize;
+            if (bitRate > 0) {
+                std::this_thread::sleep_until(
+                        start + std::chrono::microseconds(begin * bench::kTsPacketSize * 8 *
+                                                          1000000 / bitRate));
+            }
+            while (mPlaybackMQ->availableToWrite() < size) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            Clock::time_point now = Clock::now();
+            for (auto& [filter, probe] : mFilters) {
+                probe->onChunkWritten(begin, end, now);
+            }
+            mPlaybackMQ->write(mTs.data() + begin * bench::kTsPacketSize, size);
+            mPlaybackEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_READY));
+        }
+        while (mPlaybackMQ->availableToRead() > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return mTs.size();
+    }
+
+    const std::vector<std::pair<std::shared_ptr<IFilter>, std::shared_ptr<FilterProbe>>>&
+    getFilters() const {
+        return mFilters;
+    }
+
+  private:
+    void openFilter(FilterKind kind, uint16_t pid) {
+        DemuxTsFilterType tsType = DemuxTsFilterType::SECTION;
+        DemuxTsFilterSettings tsSettings{.tpid = pid};
+        std::vector<StreamUnit> units;
+        switch (kind) {
+            case FilterKind::SECTION:
+                tsSettings.filterSettings
+                        .set<DemuxTsFilterSettingsFilterSettings::Tag::section>(
+                                DemuxFilterSectionSettings{.isRepeat = true});
+                units = findSections(mTs, pid);
+                break;
+            case FilterKind::PES:
+                tsType = DemuxTsFilterType::PES;
+                tsSettings.filterSettings
+                        .set<DemuxTsFilterSettingsFilterSettings::Tag::pesData>(
+                                DemuxFilterPesDataSettings{});
+                units = findPesStarts(mTs, pid);
+                break;
+            case FilterKind::MEDIA:
+                tsType = DemuxTsFilterType::VIDEO;
+                tsSettings.filterSettings.set<DemuxTsFilterSettingsFilterSettings::Tag::av>(
+                        DemuxFilterAvSettings{});
+                units = findPesStarts(mTs, pid);
+                break;
+            case FilterKind::RECORD: {
+                tsType = DemuxTsFilterType::RECORD;
+                DemuxFilterRecordSettings recordSettings{
+                        .tsIndexMask = static_cast<int32_t>(
+                                DemuxTsIndex::PAYLOAD_UNIT_START_INDICATOR),
+                        .scIndexType = DemuxRecordScIndexType::SC,
+                };
+                recordSettings.scIndexMask.set<DemuxFilterScIndexMask::Tag::scIndex>(
+                        static_cast<int32_t>(DemuxScIndex::I_FRAME) |
+                        static_cast<int32_t>(DemuxScIndex::P_FRAME) |
+                        static_cast<int32_t>(DemuxScIndex::B_FRAME));
+                tsSettings.filterSettings.set<DemuxTsFilterSettingsFilterSettings::Tag::record>(
+                        recordSettings);
+                units = findPesStarts(mTs, pid);
+                break;
+            }
+        }
+
+        auto probe = ndk::SharedRefBase::make<FilterProbe>(kind, pid, std::move(units));
+        DemuxFilterType type{
+                .mainType = DemuxFilterMainType::TS,
+                .subType = DemuxFilterSubType::make<DemuxFilterSubType::Tag::tsFilterType>(tsType),
+        };
+        std::shared_ptr<IFilter> filter;
+        if (!mDemux->openFilter(type, kFilterBufferSize, probe, &filter).isOk()) {
+            return;
+        }
+        DemuxFilterSettings settings;
+        settings.set<DemuxFilterSettings::Tag::ts>(tsSettings);
+        filter->configure(settings);
+        probe->setFilter(filter);
+        if (kind == FilterKind::RECORD) {
+            mRecord->attachFilter(filter);
+        }
+        filter->start();
+        mFilters.push_back({filter, probe});
+    }
+
+    std::vector<int8_t> mTs;
+    std::shared_ptr<Tuner> mTuner;
+    std::shared_ptr<IDemux> mDemux;
+    std::shared_ptr<IDvr> mPlayback;
+    std::unique_ptr<DvrMQ> mPlaybackMQ;
+    EventFlag* mPlaybackEventFlag = nullptr;
+    std::shared_ptr<IDvr> mRecord;
+    std::unique_ptr<RecordReader> mRecordReader;
+    std::vector<std::pair<std::shared_ptr<IFilter>, std::shared_ptr<FilterProbe>>> mFilters;
+};
+
+// Reports the latency percentiles of each kind of filter, and the worst p99 among its filters
+void setLatencyCounters(benchmark::State& state, const EndToEndFixture& fixture) {
+    const char* verbose = getenv("TUNER_BENCH_VERBOSE");
+    std::map<FilterKind, std::vector<uint32_t>> latencies;
+    std::map<FilterKind, int64_t> worstP99;
+    uint64_t events = 0;
+    uint64_t unmatched = 0;
+    uint64_t overflows = 0;
+    for (const auto& [filter, probe] : fixture.getFilters()) {
+        std::vector<uint32_t> samples = probe->getLatenciesUs();
+        FilterKind kind = probe->getKind();
+        latencies[kind].insert(latencies[kind].end(), samples.begin(), samples.end());
+        int64_t p99 = getPercentile(samples, 0.99);
+        worstP99[kind] = std::max(worstP99[kind], p99);
+        events += probe->getEvents();
+        unmatched += probe->getUnmatched();
+        overflows += probe->getOverflows();
+        if (verbose != nullptr) {
+            int64_t filterId = 0;
+            filter->getId64Bit(&filterId);
+            fprintf(stderr,
+                    "filter %" PRId64 " %s pid 0x%04x: %" PRIu64 " events, latency p50 %" PRId64
+                    " us, p90 %" PRId64 " us, p99 %" PRId64 " us\n",
+                    filterId, getKindName(kind), probe->getPid(), probe->getEvents(),
+                    getPercentile(samples, 0.5), getPercentile(samples, 0.9), p99);
+        }
+    }
+    for (auto& [kind, samples] : latencies) {
+        std::string name = getKindName(kind);
+        state.counters[name + "_p50_us"] = getPercentile(samples, 0.5);
+        state.counters[name + "_p99_us"] = getPercentile(samples, 0.99);
+        state.counters[name + "_worst_p99_us"] = worstP99[kind];
+    }
+    state.counters["events"] = events;
+    state.counters["unmatched"] = unmatched;
+    state.counters["overflows"] = overflows;
+}
+
+void setCpuCounters(benchmark::State& state, const CpuSample& start, const CpuSample& end,
+                    std::chrono::duration<double> wallTime) {
+    std::chrono::duration<double> processTime = end.processTime - start.processTime;
+    state.counters["cpu_cores"] = processTime / wallTime;
+    double maxCore = 0;
+    for (size_t i = 0; i < std::min(start.cores.size(), end.cores.size()); i++) {
+        uint64_t total = end.cores[i].second - start.cores[i].second;
+        if (total > 0) {
+            maxCore = std::max(maxCore, 100.0 * (end.cores[i].first - start.cores[i].first) /
+                                                total);
+        }
+    }
+    state.counters["max_core%"] = maxCore;
+}
+
+// Args: section, PES, media and record filters, then the bit rate in Mbit/s or 0 to write the
+// stream as fast as the playback reads it
+void BM_EndToEnd(benchmark::State& state) {
+    std::vector<int8_t> ts = bench::loadTs(kSyntheticPacketCount);
+    resetPeakRss();
+    EndToEndFixture fixture(ts, state.range(0), state.range(1), state.range(2), state.range(3));
+    int64_t bitRate = state.range(4) * 1000 * 1000;
+
+    CpuSample cpuStart = CpuSample::take();
+    Clock::time_point start = Clock::now();
+    size_t bytes = 0;
+    for (auto _ : state) {
+        bytes += fixture.writeStream(bitRate);
+    }
+    std::chrono::duration<double> wallTime = Clock::now() - start;
+    CpuSample cpuEnd = CpuSample::take();
+    std::this_thread::sleep_for(kDrainTime);
+
+    state.counters["bits"] = benchmark::Counter(static_cast<double>(bytes) * 8,
+                                                benchmark::Counter::kIsRate,
+                                                benchmark::Counter::kIs1000);
+    state.SetBytesProcessed(bytes);
+    setCpuCounters(state, cpuStart, cpuEnd, wallTime);
+    state.counters["rss_hwm_MB"] = getPeakRssKb() / 1024.0;
+    setLatencyCounters(state, fixture);
+}
+
+}  // namespace
+
+BENCHMARK(BM_EndToEnd)
+        ->Args({8, 0, 0, 0, 0})
+        ->Args({8, 4, 2, 0, 0})
+        ->Args({32, 8, 4, 0, 0})
+        ->Args({0, 0, 0, 4, 0})
+        ->Args({8, 4, 2, 0, 40})
+        ->Args({0, 0, 0, 4, 40})
+        ->Iterations(4)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../IptvIngest.h"
+#include "TsStream.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+namespace {
+
+// 7 TS packets per datagram, as the IPTV streams usually are
+constexpr size_t kPayloadSize = 7 * bench::kTsPacketSize;
+constexpr size_t kRtpHeaderSize = 12;
+constexpr double kBitRate = 80e6;
+constexpr auto kSendPeriod = std::chrono::milliseconds(1);
+// Each iteration replays this much of the stream
+constexpr auto kReplayDuration = std::chrono::milliseconds(200);
+// The RTP packets of one pair in this many are swapped, as a network may do
+constexpr uint32_t kSwapInterval = 64;
+// The size of the IPTV DVR FMQ the payloads are copied into
+constexpr size_t kDvrSize = 188 * 7 * 8;
+
+const char* kMulticastGroup = "239.255.0.1";
+const char* kLoopbackAddress = "127.0.0.1";
+
+double getThreadCpuSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+std::vector<int8_t> makeDatagram(const std::vector<int8_t>& ts, uint32_t index, bool isRtp) {
+    std::vector<int8_t> datagram(isRtp ? kRtpHeaderSize : 0);
+    if (isRtp) {
+        uint8_t* header = reinterpret_cast<uint8_t*>(datagram.data());
+        header[0] = 0x80;
+        header[1] = IptvIngest::kRtpPayloadTypeMp2t;
+        header[2] = static_cast<uint8_t>(index >> 8);
+        header[3] = static_cast<uint8_t>(index);
+        header[8] = 0x12;
+        header[9] = 0x34;
+        header[10] = 0x56;
+        header[11] = 0x78;
+    }
+    size_t offset = index * kPayloadSize % ts.size();
+    datagram.insert(datagram.end(), ts.begin() + offset, ts.begin() + offset + kPayloadSize);
+    return datagram;
+}
+
+// Sends the stream at kBitRate, in bursts of one kSendPeriod
+void sendStream(int fd, const struct sockaddr_in& address, bool isRtp, uint32_t count) {
+    size_t datagramsPerPeriod = static_cast<size_t>(
+            kBitRate / 8 / kPayloadSize *
+            std::chrono::duration<double>(kSendPeriod).count());
+    const std::vector<int8_t> ts = bench::synthesizeTs(7 * kSwapInterval);
+    auto deadline = std::chrono::steady_clock::now();
+    uint32_t index = 0;
+    while (index < count) {
+        for (size_t i = 0; i < datagramsPerPeriod && index < count; i++, index++) {
+            uint32_t sequence = index;
+            if (isRtp && index % kSwapInterval == kSwapInterval / 2 && index + 1 < count) {
+                sequence = index + 1;
+            } else if (isRtp && index % kSwapInterval == kSwapInterval / 2 + 1) {
+                sequence = index - 1;
+            }
+            std::vector<int8_t> datagram = makeDatagram(ts, sequence, isRtp);
+            sendto(fd, datagram.data(), datagram.size(), 0,
+                   reinterpret_cast<const struct sockaddr*>(&address), sizeof(address));
+        }
+        deadline += kSendPeriod;
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+// Args: batch size, and whether the stream is sent over RTP
+void BM_IptvIngest_Replay(benchmark::State& state) {
+    size_t batchSize = static_cast<size_t>(state.range(0));
+    bool isRtp = state.range(1) != 0;
+    int port = 40000 + static_cast<int>(batchSize) + (isRtp ? 100 : 0);
+
+    // A local multicast group when the host can join one, loopback unicast otherwise
+    const char* host = kMulticastGroup;
+    std::unique_ptr<IptvIngest> ingest =
+            IptvIngest::open("udp://" + std::string(host) + ":" + std::to_string(port), batchSize);
+    if (ingest == nullptr) {
+        host = kLoopbackAddress;
+        ingest = IptvIngest::open("udp://" + std::string(host) + ":" + std::to_string(port),
+                                  batchSize);
+    }
+    if (ingest == nullptr) {
+        state.SkipWithError("Can't open the receiving socket");
+        return;
+    }
+    int sender = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    unsigned char loop = 1;
+    setsockopt(sender, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, host, &address.sin_addr);
+
+    uint32_t datagramsPerReplay = static_cast<uint32_t>(
+            kBitRate / 8 / kPayloadSize * std::chrono::duration<double>(kReplayDuration).count());
+    std::vector<int8_t> dvr(kDvrSize);
+    size_t dvrOffset = 0;
+    uint64_t receivedBytes = 0;
+    IptvIngest::Sink sink = [&](std::span<const std::span<const int8_t>> payloads) {
+        for (const auto& payload : payloads) {
+            size_t length = std::min(payload.size(), dvr.size() - dvrOffset);
+            memcpy(dvr.data() + dvrOffset, payload.data(), length);
+            memcpy(dvr.data(), payload.data() + length, payload.size() - length);
+            dvrOffset = (dvrOffset + payload.size()) % dvr.size();
+            receivedBytes += payload.size();
+        }
+        return payloads.size();
+    };
+
+    double cpuSeconds = 0;
+    uint64_t sentBytes = 0;
+    for (auto _ : state) {
+        std::atomic<bool> isSent = false;
+        std::thread sendThread([&] {
+            sendStream(sender, address, isRtp, datagramsPerReplay);
+            isSent = true;
+        });
+        double cpuStart = getThreadCpuSeconds();
+        while (ingest->receive(5, sink) > 0 || !isSent) {
+        }
+        cpuSeconds += getThreadCpuSeconds() - cpuStart;
+        sendThread.join();
+        sentBytes += static_cast<uint64_t>(datagramsPerReplay) * kPayloadSize;
+    }
+    close(sender);
+
+    const IptvIngest::Stats& stats = ingest->getStats();
+    double seconds = static_cast<double>(state.iterations()) *
+                     std::chrono::duration<double>(kReplayDuration).count();
+    state.counters["loss%"] =
+            sentBytes > 0 ? 100.0 * (1.0 - static_cast<double>(receivedBytes) / sentBytes) : 0;
+    state.counters["cpu%"] = seconds > 0 ? 100.0 * cpuSeconds / seconds : 0;
+    state.counters["Mbps"] = seconds > 0 ? receivedBytes * 8 / seconds / 1e6 : 0;
+    state.counters["batch"] =
+            stats.batches > 0 ? static_cast<double>(stats.datagrams) / stats.batches : 0;
+    state.counters["reordered"] = static_cast<double>(stats.rtpReordered);
+    state.SetLabel(host == kMulticastGroup ? "multicast" : "loopback");
+}
+
+}  // namespace
+
+BENCHMARK(BM_IptvIngest_Replay)
+        ->Args({1, 0})
+        ->Args({32, 0})
+        ->Args({1, 1})
+        ->Args({32, 1})
+        ->Iterations(10)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
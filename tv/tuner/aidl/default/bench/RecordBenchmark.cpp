@@ -0,0 +1,284 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/tv/tuner/DemuxScAvcIndex.h>
+#include <aidl/android/hardware/tv/tuner/DemuxTsIndex.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../RecordEngine.h"
+#include "TsStream.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+namespace {
+
+// A mux of six HD services, four of which are recorded
+constexpr int kServiceCount = 6;
+constexpr int kRecordedServiceCount = 4;
+constexpr int kFramesPerSecond = 25;
+constexpr int kGopLength = 25;
+constexpr int kSeconds = 2;
+constexpr size_t kAudioFrameSize = 576;
+// The playback reader hands the packets over in reads of this size
+constexpr size_t kReadSize = 348 * bench::kTsPacketSize;
+// The size of the record FMQ the consumer reads from
+constexpr size_t kDvrSize = 4 * 1024 * 1024;
+
+uint16_t getVideoPid(int service) {
+    return static_cast<uint16_t>(0x100 * (service + 1));
+}
+
+uint16_t getAudioPid(int service) {
+    return static_cast<uint16_t>(0x100 * (service + 1) + 1);
+}
+
+// An H.264 access unit: an AUD, the SPS and PPS before an IDR picture, and one slice whose
+// header starts with first_mb_in_slice 0 and the slice_type.
+std::vector<uint8_t> makeAvcFrame(int frame, uint32_t* seed) {
+    std::vector<uint8_t> es = {0x00, 0x00, 0x00, 0x01, 0x09, 0xf0};
+    bool isIdr = frame % kGopLength == 0;
+    bool isReference = isIdr || frame % 3 == 0;
+    size_t sliceSize = isIdr ? 120000 : isReference ? 40000 : 20000;
+    if (isIdr) {
+        es.insert(es.end(), {0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x28, 0xac, 0xd9, 0x40,
+                             0x78, 0x02, 0x27, 0xe5, 0xc0, 0x44});
+        es.insert(es.end(), {0x00, 0x00, 0x00, 0x01, 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0});
+    }
+    // ue(0) then ue(7) for I, ue(5) for P and ue(6) for B slices
+    uint8_t nalHeader = isIdr ? 0x65 : isReference ? 0x41 : 0x01;
+    uint8_t sliceHeader = isIdr ? 0x88 : isReference ? 0x98 : 0x9c;
+    es.insert(es.end(), {0x00, 0x00, 0x01, nalHeader, sliceHeader});
+    for (size_t i = 0; i < sliceSize; i++) {
+        *seed = *seed * 1103515245 + 12345;
+        // Without zero bytes, so that the slice data has no start code
+        es.push_back(static_cast<uint8_t>(*seed >> 16) | 0x10);
+    }
+    return es;
+}
+
+// Splits a PES packet with a PTS into TS packets, the last one stuffed with an adaptation field
+void packetizePes(uint16_t pid, uint8_t streamId, int64_t pts, const std::vector<uint8_t>& es,
+                  uint8_t* continuityCounter, std::vector<std::vector<int8_t>>* packets) {
+    std::vector<uint8_t> pes = {0x00,
+                                0x00,
+                                0x01,
+                                streamId,
+                                0x00,
+                                0x00,
+                                0x80,
+                                0x80,
+                                0x05,
+                                static_cast<uint8_t>(0x21 | ((pts >> 29) & 0x0e)),
+                                static_cast<uint8_t>(pts >> 22),
+                                static_cast<uint8_t>(0x01 | ((pts >> 14) & 0xfe)),
+                                static_cast<uint8_t>(pts >> 7),
+                                static_cast<uint8_t>(0x01 | ((pts << 1) & 0xfe))};
+    pes.insert(pes.end(), es.begin(), es.end());
+    size_t offset = 0;
+    while (offset < pes.size()) {
+        std::vector<int8_t> packet(bench::kTsPacketSize, static_cast<int8_t>(0xff));
+        size_t length = std::min(pes.size() - offset, size_t{bench::kTsPacketSize - 4});
+        size_t stuffing = bench::kTsPacketSize - 4 - length;
+        packet[0] = 0x47;
+        packet[1] = static_cast<int8_t>((offset == 0 ? 0x40 : 0) | pid >> 8);
+        packet[2] = static_cast<int8_t>(pid & 0xff);
+        uint8_t adaptationFieldControl = stuffing > 0 ? 0x30 : 0x10;
+        packet[3] = static_cast<int8_t>(adaptationFieldControl | ((*continuityCounter)++ & 0x0f));
+        if (stuffing > 0) {
+            packet[4] = static_cast<int8_t>(stuffing - 1);
+            if (stuffing > 1) {
+                // The first packet of an IDR picture is a random access point
+                packet[5] = offset == 0 && streamId == 0xe0 ? 0x40 : 0x00;
+            }
+        }
+        memcpy(packet.data() + 4 + stuffing, pes.data() + offset, length);
+        offset += length;
+        packets->push_back(std::move(packet));
+    }
+}
+
+// Interleaves the packets of the services evenly over kSeconds
+const std::vector<int8_t>& getMux() {
+    static const std::vector<int8_t> ts = [] {
+        struct TimedPacket {
+            double time;
+            const std::vector<int8_t>* packet;
+        };
+        std::vector<std::vector<std::vector<int8_t>>> pidPackets;
+        uint32_t seed = 1;
+        for (int service = 0; service < kServiceCount; service++) {
+            std::vector<std::vector<int8_t>> video;
+            std::vector<std::vector<int8_t>> audio;
+            uint8_t videoCounter = 0;
+            uint8_t audioCounter = 0;
+            for (int frame = 0; frame < kSeconds * kFramesPerSecond; frame++) {
+                int64_t pts = frame * 90000 / kFramesPerSecond;
+                packetizePes(getVideoPid(service), 0xe0, pts, makeAvcFrame(frame, &seed),
+                             &videoCounter, &video);
+                packetizePes(getAudioPid(service), 0xc0, pts,
+                             std::vector<uint8_t>(kAudioFrameSize, 0x55), &audioCounter, &audio);
+            }
+            pidPackets.push_back(std::move(video));
+            pidPackets.push_back(std::move(audio));
+        }
+        std::vector<TimedPacket> timed;
+        for (const auto& packets : pidPackets) {
+            for (size_t i = 0; i < packets.size(); i++) {
+                timed.push_back({static_cast<double>(i) / packets.size(), &packets[i]});
+            }
+        }
+        auto isEarlier = [](const TimedPacket& a, const TimedPacket& b) { return a.time < b.time; };
+        std::stable_sort(timed.begin(), timed.end(), isEarlier);
+        std::vector<int8_t> ts;
+        for (const auto& packet : timed) {
+            ts.insert(ts.end(), packet.packet->begin(), packet.packet->end());
+        }
+        return ts;
+    }();
+    return ts;
+}
+
+// Reads the record FMQ as fast as it is written, or only mSpace bytes per read of the input
+class Consumer {
+  public:
+    Consumer() : mDvr(kDvrSize) {}
+
+    size_t write(std::span<const int8_t> data) {
+        size_t size = std::min(data.size(), mSpace);
+        mSpace -= size;
+        size_t length = std::min(size, mDvr.size() - mOffset);
+        memcpy(mDvr.data() + mOffset, data.data(), length);
+        memcpy(mDvr.data(), data.data() + length, size - length);
+        mOffset = (mOffset + size) % mDvr.size();
+        mWrites++;
+        mBytes += size;
+        return size;
+    }
+
+    std::vector<int8_t> mDvr;
+    size_t mSpace = SIZE_MAX;
+    size_t mOffset = 0;
+    uint64_t mWrites = 0;
+    uint64_t mBytes = 0;
+};
+
+// What the filters did before the engine: each packet is copied into a vector, which each
+// record filter appends, and each filter writes its output after a read. The index is left out.
+void BM_Record_Legacy(benchmark::State& state) {
+    const std::vector<int8_t>& ts = getMux();
+    Consumer consumer;
+    std::vector<std::vector<int8_t>> filterOutputs(kRecordedServiceCount * 2);
+    for (auto _ : state) {
+        for (size_t read = 0; read < ts.size(); read += kReadSize) {
+            size_t end = std::min(read + kReadSize, ts.size());
+            for (size_t offset = read; offset < end; offset += bench::kTsPacketSize) {
+                std::vector<int8_t> data(ts.begin() + offset,
+                                         ts.begin() + offset + bench::kTsPacketSize);
+                for (auto& output : filterOutputs) {
+                    output.insert(output.end(), data.begin(), data.end());
+                }
+            }
+            for (auto& output : filterOutputs) {
+                consumer.write(output);
+                output.clear();
+            }
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * ts.size());
+    state.counters["writeKB"] =
+            consumer.mWrites > 0 ? consumer.mBytes / 1024.0 / consumer.mWrites : 0;
+}
+
+// Records the audio and video of kRecordedServiceCount services with the AVC start codes index.
+// Arg: the most the consumer takes per read of the input, 0 for no limit. A slower consumer makes
+// the reads wait for the engine to have space, as the playback reader does.
+void BM_Record_Engine(benchmark::State& state) {
+    const std::vector<int8_t>& ts = getMux();
+    size_t consumerSpace = state.range(0) > 0 ? state.range(0) : SIZE_MAX;
+    Consumer consumer;
+    RecordEngine engine;
+    std::vector<std::pair<int64_t, RecordEngine::StreamSettings>> streams;
+    for (int service = 0; service < kRecordedServiceCount; service++) {
+        streams.push_back({service * 2,
+                           {
+                                   .pid = getVideoPid(service),
+                                   .tsIndexMask = static_cast<int32_t>(
+                                           DemuxTsIndex::PAYLOAD_UNIT_START_INDICATOR) |
+                                                  static_cast<int32_t>(
+                                                          DemuxTsIndex::RANDOM_ACCESS_INDICATOR),
+                                   .scIndexType = DemuxRecordScIndexType::SC_AVC,
+                                   .scIndexMask = 0x1f,
+                           }});
+        streams.push_back({service * 2 + 1,
+                           {
+                                   .pid = getAudioPid(service),
+                                   .tsIndexMask = 0,
+                                   .scIndexType = DemuxRecordScIndexType::NONE,
+                                   .scIndexMask = 0,
+                           }});
+    }
+    engine.setStreams(streams);
+
+    RecordEngine::Writer writer = [&](std::span<const int8_t> data) {
+        return consumer.write(data);
+    };
+    uint64_t iSlices = 0;
+    RecordEngine::IndexSink sink = [&](const RecordEngine::IndexEntry& entry) {
+        if (entry.scIndexMask & static_cast<int32_t>(DemuxScAvcIndex::I_SLICE)) {
+            iSlices++;
+        }
+    };
+    // Reads shortened by the back-pressure
+    uint64_t throttledReads = 0;
+    for (auto _ : state) {
+        size_t read = 0;
+        while (read < ts.size()) {
+            size_t size = std::min(kReadSize, ts.size() - read);
+            if (engine.getAvailableSpace() < size) {
+                size = engine.getAvailableSpace() / bench::kTsPacketSize * bench::kTsPacketSize;
+                throttledReads++;
+            }
+            for (size_t offset = read; offset < read + size; offset += bench::kTsPacketSize) {
+                engine.recordPacket(
+                        std::span<const int8_t>(ts.data() + offset, bench::kTsPacketSize));
+            }
+            read += size;
+            consumer.mSpace = consumerSpace;
+            engine.write(writer, sink, false);
+        }
+        while (engine.hasPendingData()) {
+            consumer.mSpace = consumerSpace;
+            engine.write(writer, sink, true);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * ts.size());
+    const RecordEngine::Stats& stats = engine.getStats();
+    state.counters["writeKB"] =
+            consumer.mWrites > 0 ? consumer.mBytes / 1024.0 / consumer.mWrites : 0;
+    state.counters["recorded%"] = 100.0 * stats.recordedBytes / (state.iterations() * ts.size());
+    state.counters["iSlices"] = static_cast<double>(iSlices) / state.iterations();
+    state.counters["throttled"] = static_cast<double>(throttledReads) / state.iterations();
+    state.counters["dropped"] = static_cast<double>(stats.droppedBytes);
+}
+
+}  // namespace
+
+BENCHMARK(BM_Record_Legacy)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Record_Engine)->Arg(0)->Arg(32 * 1024)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../ScanEngine.h"
+#include "TsStream.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+namespace {
+
+// The UHF band with 8 MHz channels, of which a city typically receives about a dozen
+constexpr int64_t kStartFrequency = 474000000;
+constexpr int64_t kEndFrequency = 858000000;
+constexpr int64_t kStep = 8000000;
+constexpr int kChannelIndexes[] = {0, 1, 2, 4, 6, 9, 12, 15, 25, 26, 37, 45};
+// Lock times in the range of DVB-T demodulators, scaled down by 10 to keep the runs short
+constexpr VirtualScanTuner::Timing kTiming = {
+        .lockTime = std::chrono::milliseconds(30),
+        .probeTime = std::chrono::milliseconds(5),
+};
+constexpr auto kLockTimeout = std::chrono::milliseconds(100);
+
+// Without the signal power measurement, every frequency gets a lock attempt
+class UnprobedScanTuner : public ScanTuner {
+  public:
+    explicit UnprobedScanTuner(std::shared_ptr<ScanTuner> tuner) : mTuner(std::move(tuner)) {}
+
+    int32_t getId() override { return mTuner->getId(); }
+    bool hasSignal(int64_t, int64_t) override { return true; }
+    bool tryLock(int64_t frequency, int64_t searchRange, std::chrono::milliseconds timeout,
+                 int64_t* lockedFrequency) override {
+        return mTuner->tryLock(frequency, searchRange, timeout, lockedFrequency);
+    }
+
+  private:
+    std::shared_ptr<ScanTuner> mTuner;
+};
+
+// Writes one TS file per channel, named after its frequency
+const std::string& getChannelDirectory() {
+    static const std::string directory = [] {
+        char path[] = "/data/local/tmp/tuner_scan_XXXXXX";
+        char fallbackPath[] = "/tmp/tuner_scan_XXXXXX";
+        const char* created = mkdtemp(path);
+        if (created == nullptr) {
+            created = mkdtemp(fallbackPath);
+        }
+        std::string directory = created != nullptr ? created : ".";
+        const std::vector<int8_t> ts = bench::synthesizeTs(64);
+        for (int index : kChannelIndexes) {
+            std::ofstream file(directory + "/" + std::to_string(kStartFrequency + index * kStep) +
+                                       ".ts",
+                               std::ios::binary);
+            file.write(reinterpret_cast<const char*>(ts.data()), ts.size());
+        }
+        return directory;
+    }();
+    return directory;
+}
+
+// Args: number of frontends, and whether the segments are probed for signal first
+void BM_Scan_Uhf(benchmark::State& state) {
+    size_t tunerCount = static_cast<size_t>(state.range(0));
+    bool isProbed = state.range(1) != 0;
+    std::map<int64_t, std::string> channels =
+            VirtualScanTuner::loadChannels(getChannelDirectory());
+    std::vector<std::shared_ptr<ScanTuner>> tuners;
+    for (size_t i = 0; i < tunerCount; i++) {
+        std::shared_ptr<ScanTuner> tuner =
+                std::make_shared<VirtualScanTuner>(static_cast<int32_t>(i), channels, kTiming);
+        if (!isProbed) {
+            tuner = std::make_shared<UnprobedScanTuner>(tuner);
+        }
+        tuners.push_back(tuner);
+    }
+    ScanEngine engine(tuners);
+    ScanEngine::Settings settings = {
+            .bands = {{kStartFrequency, kEndFrequency, kStep}},
+            .lockTimeout = kLockTimeout,
+    };
+
+    size_t foundChannels = 0;
+    double utilization = 0;
+    double skipped = 0;
+    for (auto _ : state) {
+        foundChannels = engine.scan(settings, nullptr, nullptr).size();
+        ScanEngine::Stats stats = engine.getStats();
+        double scanSeconds = std::chrono::duration<double>(stats.scanTime).count();
+        double busySeconds = 0;
+        for (const auto& tuner : stats.tuners) {
+            busySeconds += std::chrono::duration<double>(tuner.busyTime).count();
+        }
+        utilization += busySeconds / scanSeconds / tunerCount;
+        skipped += stats.skippedFrequencies;
+    }
+    if (foundChannels != channels.size()) {
+        state.SkipWithError("Channels missed");
+    }
+    state.counters["channels"] = static_cast<double>(foundChannels);
+    state.counters["skipped"] = skipped / state.iterations();
+    state.counters["util%"] = 100.0 * utilization / state.iterations();
+}
+
+}  // namespace
+
+BENCHMARK(BM_Scan_Uhf)
+        ->Args({1, 0})
+        ->Args({1, 1})
+        ->Args({2, 1})
+        ->Args({4, 1})
+        ->Iterations(3)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
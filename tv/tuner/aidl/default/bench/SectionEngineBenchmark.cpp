@@ -0,0 +1,199 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../SectionEngine.h"
+#include "../TsParser.h"
+#include "TsStream.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+namespace {
+
+constexpr uint16_t kEitPid = 0x0012;
+constexpr int kServiceCount = 32;
+// EIT schedule tables 0x50 and 0x51, with 8 sections of about 1KB each per service
+constexpr uint8_t kFirstTableId = 0x50;
+constexpr int kTableCount = 2;
+constexpr int kSectionsPerTable = 8;
+// Times the carousel is repeated, one service gets a new version on each repetition
+constexpr int kCarouselCycles = 16;
+
+std::vector<int8_t> makeEitSection(uint8_t tableId, uint16_t serviceId, uint8_t version,
+                                   uint8_t sectionNumber) {
+    // Long header, transport_stream_id, original_network_id, segment_last_section_number,
+    // last_table_id, events and the CRC_32
+    size_t payloadSize = 600 + (serviceId * 37 + sectionNumber * 101) % 400;
+    size_t sectionLength = 5 + 6 + payloadSize + SectionHeader::kCrcSize;
+    std::vector<int8_t> section(3 + sectionLength);
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(section.data());
+    bytes[0] = tableId;
+    bytes[1] = 0xf0 | static_cast<uint8_t>(sectionLength >> 8);
+    bytes[2] = static_cast<uint8_t>(sectionLength);
+    bytes[3] = static_cast<uint8_t>(serviceId >> 8);
+    bytes[4] = static_cast<uint8_t>(serviceId);
+    bytes[5] = 0xc1 | static_cast<uint8_t>(version << 1);
+    bytes[6] = sectionNumber;
+    bytes[7] = kSectionsPerTable - 1;
+    bytes[13] = kSectionsPerTable - 1;
+    bytes[14] = kFirstTableId + kTableCount - 1;
+    for (size_t i = 15; i < section.size() - SectionHeader::kCrcSize; i++) {
+        bytes[i] = static_cast<uint8_t>(i * 7 + serviceId + version);
+    }
+    uint32_t crc = crc32Mpeg2(
+            std::span<const int8_t>(section.data(), section.size() - SectionHeader::kCrcSize));
+    for (size_t i = 0; i < SectionHeader::kCrcSize; i++) {
+        section[section.size() - SectionHeader::kCrcSize + i] =
+                static_cast<int8_t>(crc >> (24 - 8 * i));
+    }
+    return section;
+}
+
+// Splits a section into packets of the EIT PID, the section starting right after the
+// pointer_field of the first one and the last one stuffed.
+void packetizeSection(const std::vector<int8_t>& section, uint8_t* continuityCounter,
+                      std::vector<int8_t>* ts) {
+    size_t written = 0;
+    while (written < section.size()) {
+        bool isStart = written == 0;
+        size_t packetStart = ts->size();
+        ts->resize(packetStart + bench::kTsPacketSize, static_cast<int8_t>(0xff));
+        int8_t* packet = ts->data() + packetStart;
+        packet[0] = 0x47;
+        packet[1] = static_cast<int8_t>((isStart ? 0x40 : 0) | kEitPid >> 8);
+        packet[2] = static_cast<int8_t>(kEitPid & 0xff);
+        packet[3] = static_cast<int8_t>(0x10 | ((*continuityCounter)++ & 0x0f));
+        size_t offset = 4;
+        if (isStart) {
+            packet[offset++] = 0;
+        }
+        size_t length = std::min(section.size() - written, bench::kTsPacketSize - offset);
+        memcpy(packet + offset, section.data() + written, length);
+        written += length;
+    }
+}
+
+// The EIT PID of a mux, which repeats the same schedule sections over and over.
+const std::vector<int8_t>& getEitStream() {
+    static const std::vector<int8_t> ts = [] {
+        std::vector<int8_t> ts;
+        std::vector<uint8_t> versions(kServiceCount, 0);
+        uint8_t continuityCounter = 0;
+        for (int cycle = 0; cycle < kCarouselCycles; cycle++) {
+            versions[cycle % kServiceCount] = (versions[cycle % kServiceCount] + 1) & 0x1f;
+            for (int service = 0; service < kServiceCount; service++) {
+                for (int table = 0; table < kTableCount; table++) {
+                    for (int number = 0; number < kSectionsPerTable; number++) {
+                        packetizeSection(makeEitSection(kFirstTableId + table, 0x100 + service,
+                                                        versions[service], number),
+                                         &continuityCounter, &ts);
+                    }
+                }
+            }
+        }
+        return ts;
+    }();
+    return ts;
+}
+
+// What the filter did before the engine: every assembled section is delivered
+void BM_Sections_Eit_ParseOnly(benchmark::State& state) {
+    const std::vector<int8_t>& ts = getEitStream();
+    TsParser parser(TsParser::Mode::SECTION);
+    size_t sections = 0;
+    size_t deliveredBytes = 0;
+    for (auto _ : state) {
+        parser.parse(ts, [&](const TsParser::Unit& section) {
+            sections++;
+            deliveredBytes += section.data.size();
+            return true;
+        });
+    }
+    benchmark::DoNotOptimize(deliveredBytes);
+    state.counters["sections"] =
+            benchmark::Counter(static_cast<double>(sections), benchmark::Counter::kIsRate);
+    state.counters["delivered"] = 1.0;
+    state.SetBytesProcessed(state.iterations() * ts.size());
+}
+
+// Arg: whether the CRC is checked
+void BM_Sections_Eit_Engine(benchmark::State& state) {
+    const std::vector<int8_t>& ts = getEitStream();
+    TsParser parser(TsParser::Mode::SECTION);
+    SectionEngine engine;
+    SectionEngine::Settings settings;
+    settings.isCheckCrc = state.range(0) != 0;
+    engine.configure(settings);
+    size_t sections = 0;
+    size_t delivered = 0;
+    for (auto _ : state) {
+        // Each iteration starts from a fresh filter, as the whole stream would be repeated
+        engine.reset();
+        parser.parse(ts, [&](const TsParser::Unit& section) {
+            SectionHeader header;
+            sections++;
+            if (engine.filter(section.data, &header) == SectionEngine::Verdict::DELIVER) {
+                engine.commit(section.data, header);
+                delivered++;
+            }
+            return true;
+        });
+    }
+    state.counters["sections"] =
+            benchmark::Counter(static_cast<double>(sections), benchmark::Counter::kIsRate);
+    state.counters["delivered"] = sections > 0 ? static_cast<double>(delivered) / sections : 0;
+    state.SetBytesProcessed(state.iterations() * ts.size());
+}
+
+uint32_t crc32Bitwise(std::span<const int8_t> data) {
+    uint32_t crc = 0xffffffff;
+    for (int8_t byte : data) {
+        crc ^= static_cast<uint32_t>(static_cast<uint8_t>(byte)) << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// Arg: section size
+void BM_Crc32_Bitwise(benchmark::State& state) {
+    std::vector<int8_t> section = makeEitSection(kFirstTableId, 0x100, 0, 0);
+    section.resize(state.range(0), 0x5a);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crc32Bitwise(section));
+    }
+    state.SetBytesProcessed(state.iterations() * section.size());
+}
+
+void BM_Crc32_SlicingBy8(benchmark::State& state) {
+    std::vector<int8_t> section = makeEitSection(kFirstTableId, 0x100, 0, 0);
+    section.resize(state.range(0), 0x5a);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crc32Mpeg2(section));
+    }
+    state.SetBytesProcessed(state.iterations() * section.size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_Sections_Eit_ParseOnly);
+BENCHMARK(BM_Sections_Eit_Engine)->Arg(0)->Arg(1);
+BENCHMARK(BM_Crc32_Bitwise)->Arg(16)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_Crc32_SlicingBy8)->Arg(16)->Arg(1024)->Arg(4096);
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../TsParser.h"
+#include "TsStream.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+namespace {
+
+constexpr size_t kSyntheticPacketCount = 40000;
+
+// The packets of the stream split by PID, as each filter gets them, and grouped by whether the
+// PID carries PES packets or sections.
+struct PidStreams {
+    std::vector<std::vector<int8_t>> pes;
+    std::vector<std::vector<int8_t>> sections;
+    size_t packetCount = 0;
+};
+
+const PidStreams& getPidStreams() {
+    static const PidStreams streams = [] {
+        std::vector<int8_t> ts = bench::loadTs(kSyntheticPacketCount);
+        std::map<uint16_t, std::vector<int8_t>> packetsByPid;
+        std::map<uint16_t, bool> isPesByPid;
+        for (size_t i = 0; i + bench::kTsPacketSize <= ts.size(); i += bench::kTsPacketSize) {
+            const int8_t* packet = ts.data() + i;
+            uint16_t pid = bench::getPid(packet);
+            if (pid == 0x1fff) {
+                continue;
+            }
+            packetsByPid[pid].insert(packetsByPid[pid].end(), packet,
+                                     packet + bench::kTsPacketSize);
+            // Classify the PID on its first unit start, PES packets begin with a start code
+            TsPacketHeader header;
+            if (!isPesByPid.contains(pid) &&
+                TsPacketHeader::parse(std::span<const int8_t>(packet, bench::kTsPacketSize),
+                                      &header) &&
+                header.payloadUnitStart && header.payloadOffset + 3 <= bench::kTsPacketSize) {
+                const int8_t* payload = packet + header.payloadOffset;
+                isPesByPid[pid] = payload[0] == 0 && payload[1] == 0 && payload[2] == 1;
+            }
+        }
+
+        PidStreams streams;
+        for (auto& [pid, packets] : packetsByPid) {
+            streams.packetCount += packets.size() / bench::kTsPacketSize;
+            if (isPesByPid[pid]) {
+                streams.pes.push_back(std::move(packets));
+            } else {
+                streams.sections.push_back(std::move(packets));
+            }
+        }
+        return streams;
+    }();
+    return streams;
+}
+
+void parseStreams(benchmark::State& state, TsParser::Mode mode,
+                  const std::vector<std::vector<int8_t>>& streams) {
+    std::vector<TsParser> parsers(streams.size(), TsParser(mode));
+    size_t packetCount = 0;
+    size_t unitBytes = 0;
+    TsParser::UnitCallback onUnit = [&](const TsParser::Unit& unit) {
+        unitBytes += unit.data.size();
+        return true;
+    };
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < streams.size(); i++) {
+            parsers[i].parse(streams[i], onUnit);
+            packetCount += streams[i].size() / bench::kTsPacketSize;
+        }
+    }
+    benchmark::DoNotOptimize(unitBytes);
+    state.counters["packets"] =
+            benchmark::Counter(static_cast<double>(packetCount), benchmark::Counter::kIsRate);
+    state.SetBytesProcessed(packetCount * bench::kTsPacketSize);
+}
+
+void BM_TsParser_Pes(benchmark::State& state) {
+    parseStreams(state, TsParser::Mode::PES, getPidStreams().pes);
+}
+
+void BM_TsParser_Sections(benchmark::State& state) {
+    parseStreams(state, TsParser::Mode::SECTION, getPidStreams().sections);
+}
+
+}  // namespace
+
+BENCHMARK(BM_TsParser_Pes);
+BENCHMARK(BM_TsParser_Sections);
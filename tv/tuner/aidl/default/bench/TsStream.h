@@ -0,0 +1,174 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace tv {
+namespace tuner {
+namespace bench {
+
+constexpr int kTsPacketSize = 188;
+
+// The transport stream pushed to the device by the tuner VTS, used unless the TUNER_BENCH_TS
+// environment variable names another recording.
+constexpr char kDefaultTsPath[] = "/data/local/tmp/segment000000.ts";
+
+inline uint16_t getPid(const int8_t* packet) {
+    return ((packet[1] & 0x1f) << 8) | (packet[2] & 0xff);
+}
+
+// Writes the 5 bytes PTS field of a PES header with PTS_DTS_flags '10'
+inline void writePts(int8_t* field, int64_t pts) {
+    field[0] = static_cast<int8_t>(0x21 | ((pts >> 29) & 0x0e));
+    field[1] = static_cast<int8_t>(pts >> 22);
+    field[2] = static_cast<int8_t>(((pts >> 14) & 0xfe) | 0x01);
+    field[3] = static_cast<int8_t>(pts >> 7);
+    field[4] = static_cast<int8_t>(((pts << 1) & 0xfe) | 0x01);
+}
+
+// Builds a stream resembling a DVB-T2 mux: a few services of video, audio and PSI/SI sections,
+// padded with null packets. PIDs 0x0100 to 0x0fff carry unbounded PES packets starting every 16
+// packets, PIDs below 0x0100 and above 0x0fff carry one section per packet.
+inline std::vector<int8_t> synthesizeTs(size_t packetCount) {
+    struct PidShare {
+        uint16_t pid;
+        int weight;
+    };
+    static const PidShare kShares[] = {
+            {0x0000, 1},  {0x0010, 1},  {0x0011, 1},  {0x0012, 6},  {0x0014, 1},
+            {0x0100, 60}, {0x0101, 6},  {0x0102, 3},  {0x0200, 45}, {0x0201, 6},
+            {0x0300, 40}, {0x0301, 6},  {0x0400, 35}, {0x0401, 6},  {0x1000, 1},
+            {0x1001, 1},  {0x1002, 1},  {0x1003, 1},  {0x1fff, 20},
+    };
+    std::vector<uint16_t> schedule;
+    for (const auto& share : kShares) {
+        schedule.insert(schedule.end(), share.weight, share.pid);
+    }
+
+    std::vector<int8_t> ts(packetCount * kTsPacketSize);
+    std::map<uint16_t, uint8_t> continuity;
+    std::map<uint16_t, int64_t> pesCounts;
+    uint32_t seed = 1;
+    for (size_t i = 0; i < packetCount; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint16_t pid = schedule[(seed >> 16) % schedule.size()];
+        int8_t* packet = ts.data() + i * kTsPacketSize;
+        packet[0] = 0x47;
+        packet[1] = static_cast<int8_t>((pid >> 8) & 0x1f);
+        packet[2] = static_cast<int8_t>(pid & 0xff);
+        uint8_t counter = continuity[pid]++;
+        packet[3] = static_cast<int8_t>(0x10 | (counter & 0x0f));
+        for (int j = 4; j < kTsPacketSize; j++) {
+            packet[j] = static_cast<int8_t>(seed >> (j % 24));
+        }
+        if (pid == 0x1fff) {
+            continue;
+        }
+        if (pid >= 0x0100 && pid < 0x1000) {
+            if (counter % 16 == 0) {
+                // PES header with no PES_packet_length and a PTS 40ms after the previous one
+                static const uint8_t kPesHeader[] = {0x00, 0x00, 0x01, 0xe0, 0x00,
+                                                     0x00, 0x80, 0x80, 0x05};
+                packet[1] |= 0x40;
+                memcpy(packet + 4, kPesHeader, sizeof(kPesHeader));
+                writePts(packet + 4 + sizeof(kPesHeader), pesCounts[pid]++ * 3600);
+            }
+        } else {
+            // pointer_field, then a 180 bytes section and stuffing
+            packet[1] |= 0x40;
+            packet[4] = 0;
+            packet[5] = static_cast<int8_t>(pid == 0 ? 0x00 : 0x42);
+            packet[6] = static_cast<int8_t>(0xb0);
+            packet[7] = 177;
+            memset(packet + 185, 0xff, 3);
+        }
+    }
+    return ts;
+}
+
+// Loads the recorded stream, or synthesizes packetCount packets if there is none.
+inline std::vector<int8_t> loadTs(size_t packetCount) {
+    const char* path = getenv("TUNER_BENCH_TS");
+    std::ifstream file(path != nullptr ? path : kDefaultTsPath, std::ios::binary);
+    if (file) {
+        std::vector<int8_t> ts((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+        ts.resize(ts.size() - ts.size() % kTsPacketSize);
+        if (!ts.empty()) {
+            return ts;
+        }
+    }
+    return synthesizeTs(packetCount);
+}
+
+// Converts a stream of 188 bytes packets to the given DVR packet size: 192 bytes packets get a
+// 4 bytes arrival timestamp prefix, larger ones are padded with parity bytes.
+inline std::vector<int8_t> repacketizeTs(const std::vector<int8_t>& ts, int packetSize) {
+    if (packetSize == kTsPacketSize) {
+        return ts;
+    }
+    size_t prefix = packetSize == 192 ? 4 : 0;
+    std::vector<int8_t> out;
+    out.reserve(ts.size() / kTsPacketSize * packetSize);
+    uint32_t timestamp = 0;
+    for (size_t i = 0; i + kTsPacketSize <= ts.size(); i += kTsPacketSize) {
+        for (size_t j = 0; j < prefix; j++) {
+            out.push_back(static_cast<int8_t>(timestamp >> (24 - 8 * j)));
+        }
+        timestamp += 1000;
+        out.insert(out.end(), ts.begin() + i, ts.begin() + i + kTsPacketSize);
+        out.insert(out.end(), packetSize - kTsPacketSize - prefix, static_cast<int8_t>(0xff));
+    }
+    return out;
+}
+
+// Returns the PIDs of the stream, most frequent first.
+inline std::vector<uint16_t> getPidsByFrequency(const std::vector<int8_t>& ts) {
+    std::map<uint16_t, size_t> counts;
+    for (size_t i = 0; i + kTsPacketSize <= ts.size(); i += kTsPacketSize) {
+        counts[getPid(ts.data() + i)]++;
+    }
+    std::vector<std::pair<size_t, uint16_t>> sorted;
+    for (const auto& [pid, count] : counts) {
+        sorted.push_back({count, pid});
+    }
+    std::sort(sorted.rbegin(), sorted.rend());
+    std::vector<uint16_t> pids;
+    for (const auto& [count, pid] : sorted) {
+        pids.push_back(pid);
+    }
+    return pids;
+}
+
+}  // namespace bench
+}  // namespace tuner
+}  // namespace tv
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fuzzer/FuzzedDataProvider.h>
+
+#include "../SectionEngine.h"
+#include "../TsParser.h"
+
+using namespace aidl::android::hardware::tv::tuner;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    FuzzedDataProvider provider(data, size);
+    TsParser parser(provider.ConsumeBool() ? TsParser::Mode::PES : TsParser::Mode::SECTION);
+    // A few PIDs so that the per PID states interleave
+    uint16_t pidMask = provider.ConsumeIntegralInRange<uint16_t>(0, 3);
+    bool stopEarly = provider.ConsumeBool();
+    // The sections go through a section engine, as in a section filter
+    SectionEngine engine;
+    SectionEngine::Settings settings;
+    settings.isCheckCrc = provider.ConsumeBool();
+    settings.isRepeat = provider.ConsumeBool();
+    settings.hasTableCondition = provider.ConsumeBool();
+    settings.tableId = provider.ConsumeIntegral<uint8_t>();
+    settings.filter = provider.ConsumeBytes<uint8_t>(provider.ConsumeIntegralInRange<size_t>(0, 4));
+    settings.mask = provider.ConsumeBytes<uint8_t>(settings.filter.size());
+    settings.mode = provider.ConsumeBytes<uint8_t>(settings.filter.size());
+    engine.configure(settings);
+
+    while (provider.remaining_bytes() > 0) {
+        std::vector<uint8_t> packets = provider.ConsumeBytes<uint8_t>(
+                TsPacketHeader::kPacketSize * provider.ConsumeIntegralInRange<size_t>(1, 8));
+        packets.resize(packets.size() - packets.size() % TsPacketHeader::kPacketSize);
+        // Most packets are kept in sync, otherwise the parser rarely gets past the header
+        for (size_t i = 0; i < packets.size(); i += TsPacketHeader::kPacketSize) {
+            if (packets[i + 1] & 0x20) {
+                packets[i] = 0x47;
+                packets[i + 1] &= 0xe0 | pidMask;
+                packets[i + 2] = 0;
+            }
+        }
+
+        size_t unitCount = 0;
+        parser.parse(std::span<const int8_t>(reinterpret_cast<const int8_t*>(packets.data()),
+                                             packets.size()),
+                     [&](const TsParser::Unit& unit) {
+                         // Touch the whole unit so that out of bounds spans are caught
+                         volatile int8_t sum = 0;
+                         for (int8_t byte : unit.data) {
+                             sum = sum + byte;
+                         }
+                         for (int8_t byte : unit.payload()) {
+                             sum = sum + byte;
+                         }
+                         SectionHeader header;
+                         if (engine.filter(unit.data, &header) ==
+                             SectionEngine::Verdict::DELIVER) {
+                             engine.commit(unit.data, header);
+                         }
+                         return !stopEarly || ++unitCount < 2;
+                     });
+        if (provider.ConsumeBool()) {
+            parser.reset();
+        }
+    }
+    return 0;
+}